@@ -0,0 +1,108 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "config.h"
+#include "board_hal.h"
+#include "perf_stats.h"
+#include "spsc_queue.h"
+
+// Acquisition / IO split (ACQ_TASK).
+// 取得タスク（ACQ_CORE、sample_clock.h）は IMU を読んで acq_push() でリングに積むだけ。
+// IO コアのパイプラインタスクが ACQ_DRAIN_MS ごとにリングを空にし、1件ずつ消費関数
+// （間引き～ログバッファ）に渡す。flash 書き込みや LCD/シリアルが長引いてもリングが
+// ACQ_QUEUE_LEN 件まで吸収し、取得のタイミングは変わらない。
+// 満杯で積めなかった読み出しは取得側で数えておき、次に積めた項目の gaps に足す
+// （記録上は欠損マーカー。サンプル番号はずれない）。
+
+static_assert(!ACQ_TASK || SAMPLE_TIMER_MODE, "ACQ_TASK needs SAMPLE_TIMER_MODE");
+static_assert(ACQ_CORE != ACQ_IO_CORE, "ACQ_CORE and ACQ_IO_CORE must differ");
+
+// One IMU read (or a missing one), preceded by `gaps` missing reads
+struct AcqItem {
+    ImuSample s;
+    uint32_t t_us;   // read time (micros)
+    uint32_t gaps;   // missed ticks, FIFO overflow or queue overflow before this read
+    bool ok;         // false: this read is missing as well
+};
+
+typedef void (*AcqConsumeFn)(const AcqItem& it);
+
+static SpscQueue<AcqItem, ACQ_QUEUE_LEN> s_acq_q;
+static AcqConsumeFn s_acq_fn = nullptr;
+static TaskHandle_t s_acq_pipe_task = nullptr;
+static volatile bool s_acq_on = false;
+static std::atomic<bool> s_acq_pipe_busy{false};
+static uint32_t s_acq_lost = 0;  // producer: reads not queued yet
+
+// Acquisition side: never blocks. gaps: missing reads before this one, s == nullptr: failed read.
+inline bool acq_push(const ImuSample* s, uint32_t gaps, uint32_t t_us) {
+    AcqItem it;
+    if (s) it.s = *s;
+    it.t_us = t_us;
+    it.gaps = s_acq_lost + gaps;
+    it.ok = (s != nullptr);
+    if (s_acq_q.push(it)) {
+        s_acq_lost = 0;
+        return true;
+    }
+    s_acq_lost = it.gaps + 1;
+    perf_on_acq_overflow();
+    return false;
+}
+
+inline void _acq_drain() {
+    AcqItem it;
+    perf_on_acq_depth(s_acq_q.size());
+    while (s_acq_q.pop(it)) s_acq_fn(it);
+}
+
+inline void _acq_pipe_task(void*) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, s_acq_on ? pdMS_TO_TICKS(ACQ_DRAIN_MS) : portMAX_DELAY);
+        // busy is raised before the queue is looked at, so acq_end() never sees it idle mid-item
+        s_acq_pipe_busy = true;
+        if (s_acq_on && s_acq_fn) _acq_drain();
+        s_acq_pipe_busy = false;
+    }
+}
+
+// Before the sampler starts: empty ring, consumer fn. Creates the pipeline task on first use.
+inline bool acq_begin(AcqConsumeFn fn) {
+    if (!ACQ_TASK) return true;
+    s_acq_fn = fn;
+    s_acq_q.clear();
+    s_acq_lost = 0;
+    s_acq_on = true;
+    if (!s_acq_pipe_task) {
+        if (xTaskCreatePinnedToCore(_acq_pipe_task, "acqpipe", 4096, nullptr, ACQ_PIPE_PRIO,
+                                    &s_acq_pipe_task, ACQ_IO_CORE) != pdPASS) {
+            s_acq_pipe_task = nullptr;
+            s_acq_on = false;
+            return false;
+        }
+    }
+    xTaskNotifyGive(s_acq_pipe_task);
+    return true;
+}
+
+// After sample_clock_stop(): wait for the pipeline to consume everything queued, then hand
+// reads lost to a full ring at the very end to fn from the caller's task. The pipeline is idle on return.
+inline void acq_end() {
+    if (!ACQ_TASK || !s_acq_on) return;
+    while (s_acq_pipe_task && (!s_acq_q.empty() || s_acq_pipe_busy)) {
+        xTaskNotifyGive(s_acq_pipe_task);
+        delay(1);
+    }
+    s_acq_on = false;
+    while (s_acq_pipe_busy) delay(1);
+    if (s_acq_lost && s_acq_fn) {
+        AcqItem it = {};
+        it.t_us = micros();
+        it.gaps = s_acq_lost - 1;
+        it.ok = false;
+        s_acq_fn(it);
+        s_acq_lost = 0;
+    }
+}
@@ -1,8 +1,9 @@
 #pragma once
 
-// Minimal board/IMU abstraction.
-// - SH200Q 搭載デバイス: M5StickC 系など。レジスタ直叩きを行う。
+// Minimal board abstraction (screen, power, buttons, I2C pins).
+// - SH200Q 搭載デバイス: M5StickC 系など。M5StickC ライブラリを利用する。
 // - 非SH200Q (例: MPU6886/Core2): M5Unified を利用する。
+// IMU 自体のアクセスは imu_driver.h のコンパイル時ドライバ（ImuDriver）が担う。
 
 #include <Arduino.h>
 #include "config.h"
@@ -19,6 +20,20 @@
 #define IMU_TYPE_UNKNOWN 0
 #define IMU_TYPE_SH200Q 1
 #define IMU_TYPE_MPU6886 2
+#define IMU_TYPE_MOCK 0xFF
+
+// --- IMU 1サンプル（生値 int16、ジャイロはバイアス補正後の生カウント） ---
+struct ImuSample {
+    int16_t ax, ay, az;
+    int16_t gx, gy, gz;
+};
+
+// Saturate to int16 (bias-subtracted counts may exceed the raw range)
+inline int16_t imu_clamp16(int32_t v) {
+    if (v > 32767) return 32767;
+    if (v < -32768) return -32768;
+    return (int16_t)v;
+}
 
 // --- デバイスモデルID（例示。未知は0） ---
 #define DEVICE_MODEL_UNKNOWN 0
@@ -39,7 +54,6 @@
 
 #if HAL_IMU_IS_SH200Q
   #include <M5StickC.h>
-  #define HAL_IMU_TYPE IMU_TYPE_SH200Q
   // Board推定（わからなければUNKNOWN）
   #if defined(ARDUINO_M5Stick_C_PLUS2)
     #define HAL_DEVICE_MODEL DEVICE_MODEL_STICKC_PLUS2
@@ -52,7 +66,6 @@
   #endif
 #else
   #include <M5Unified.h>
-  #define HAL_IMU_TYPE IMU_TYPE_MPU6886
   // Core2 を既定とし、それ以外は UNKNOWN
   #if defined(ARDUINO_M5STACK_Core2) || defined(M5STACK_CORE2) || defined(M5STACK_M5Core2)
     #define HAL_DEVICE_MODEL DEVICE_MODEL_CORE2_16MB
@@ -164,14 +177,7 @@ inline auto& hal_lcd() {
 #endif
 }
 
-// --- I2Cピン/IMUアドレス取得 (M5Unifiedのデフォルトに揃える) ---
-inline uint8_t hal_imu_addr() {
-#if HAL_IMU_IS_SH200Q
-    return 0x6C; // SH200Q default (M5Unifiedと同じ)
-#else
-    return 0x68; // MPU6886 default
-#endif
-}
+// --- 内部I2Cピン取得 (M5Unifiedのデフォルトに揃える) ---
 
 inline int hal_i2c_sda_pin() {
 #if HAL_IMU_IS_SH200Q
@@ -190,11 +196,3 @@ inline int hal_i2c_scl_pin() {
   return (pin >= 0) ? pin : SCL;
 #endif
 }
-
-inline const char* hal_i2c_bus_name() {
-#if HAL_IMU_IS_SH200Q
-    return "Wire1";
-#else
-    return "In_I2C";
-#endif
-}
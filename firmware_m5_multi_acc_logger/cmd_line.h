@@ -0,0 +1,76 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Incremental command-line assembler (no Arduino dependency, no heap).
+// 受信したバイトを1つずつ cmd_line_feed() に渡し、'\n' / '\r' で1行が完成したら
+// 前後の空白を除いた NUL 終端文字列を buf に残す。空行は無視。N-1 文字を超える行は
+// 改行まで読み捨てて CMD_TOOLONG を1回返す。NUL・制御文字（タブ以外）・非 ASCII が混じった行は
+// CMD_GARBAGE（ノイズや別プロトコルのバイナリを命令として解釈しない）。
+// cmd_line_split() は行を "NAME" と引数に分ける（区切りは最初の空白）。
+
+enum CmdLineResult : uint8_t {
+    CMD_NONE = 0,    // line not complete yet
+    CMD_LINE,        // buf holds a command
+    CMD_TOOLONG,     // a line longer than N - 1 was dropped
+    CMD_GARBAGE      // a line with control / non-ASCII bytes was dropped
+};
+
+template <size_t N>
+struct CmdLine {
+    static_assert(N >= 2 && N <= 256, "CmdLine size must be 2..256");
+    char buf[N];
+    uint8_t len;
+    bool overlong;
+    bool garbage;
+};
+
+template <size_t N>
+inline void cmd_line_reset(CmdLine<N>& l) {
+    l.len = 0;
+    l.overlong = false;
+    l.garbage = false;
+    l.buf[0] = '\0';
+}
+
+template <size_t N>
+inline CmdLineResult cmd_line_feed(CmdLine<N>& l, char c) {
+    if (c == '\n' || c == '\r') {
+        CmdLineResult r = l.overlong ? CMD_TOOLONG : l.garbage ? CMD_GARBAGE : CMD_LINE;
+        if (r == CMD_LINE) {
+            size_t b = 0, e = l.len;
+            while (b < e && l.buf[b] == ' ') ++b;
+            while (e > b && l.buf[e - 1] == ' ') --e;
+            if (b == e) {
+                r = CMD_NONE;  // empty line (or the '\n' of "\r\n")
+            } else {
+                if (b) memmove(l.buf, l.buf + b, e - b);
+                l.buf[e - b] = '\0';
+            }
+        }
+        l.len = 0;
+        l.overlong = false;
+        l.garbage = false;
+        return r;
+    }
+    if (l.overlong) return CMD_NONE;
+    if (l.len >= N - 1) {
+        l.overlong = true;
+        return CMD_NONE;
+    }
+    const uint8_t u = (uint8_t)c;
+    if ((u < 0x20 && c != '\t') || u >= 0x7F) l.garbage = true;
+    l.buf[l.len++] = (c == '\t') ? ' ' : c;
+    return CMD_NONE;
+}
+
+// Split a complete line in place: returns the arguments ("" if none), line keeps the name
+inline const char* cmd_line_split(char* line) {
+    char* p = line;
+    while (*p && *p != ' ') ++p;
+    if (!*p) return p;
+    *p++ = '\0';
+    while (*p == ' ') ++p;
+    return p;
+}
@@ -3,27 +3,200 @@
 // Configuration constants for logging
 
 // Output data rate in Hz.
-// SH200Q側の実機設定は離散値のみ対応のため、最も近い値に丸めて設定します。
-// 目安: Accel ODR = {8,16,32,64,128,256,512,1024} Hz, Gyro ODR = {64,128,256,500,1000} Hz
+// ODR_HZ / RANGE_G / GYRO_RANGE_DPS / IMU_DLPF_HZ は既定値。シリアルの `CONFIG SET` で実行時に変更でき、
+// NVS に保存されて次回起動時も使われる（dev_config.h、検査はドライバの対応表、適用は init() の再実行）。
+// IMUの実機設定は離散値のみ対応のため、最も近い値に丸めて設定します（imu_driver.h）。
+// 目安: SH200Q Accel ODR = {8,16,32,64,128,256,512,1024} Hz, Gyro ODR = {64,128,256,500,1000} Hz
+//       MPU6886 = 1000 / (1 + SMPLRT_DIV) Hz
 // 推奨: 128Hz（Accel=128Hz, Gyro≈128Hzに設定されます）
 constexpr uint16_t ODR_HZ = 128;
-// Accelerometer range in g (2,4,8,16)
+// Accelerometer range in g (MPU6886: 2,4,8,16 / SH200Q: 4,8,16; unsupported values fail to build)
 constexpr uint16_t RANGE_G = 8;
-// Gyroscope range in dps (250, 500, 1000, 2000)
+// Gyroscope range in dps (250, 500, 1000, 2000; SH200Q also 125)
 constexpr uint16_t GYRO_RANGE_DPS = 2000;
-// Log file name stored in LittleFS
+// IMU low-pass bandwidth in Hz, 0 = automatic (MPU6886: off, or below the read rate's Nyquist with
+// decimation / FIFO; SH200Q: gyro 50 Hz). Otherwise the nearest one the IMU supports.
+constexpr uint16_t IMU_DLPF_HZ = 0;
+// Fastest ODR `CONFIG SET` accepts. Buffers that hold a time span (trigger pre-roll) are sized for it.
+constexpr uint16_t ODR_HZ_MAX = 1024;
+// Log file name stored in LittleFS (single-file layout of older firmware; adopted
+// as the newest session by the session store on first boot)
 constexpr const char* LOG_FILE_NAME = "/ACCLOG.BIN";
+// Session store: one file per recording, index kept in SESSION_INDEX_FILE.
+// 新規記録時、件数が SESSION_MAX に達しているか空きが SESSION_MIN_FREE_BYTES 未満なら古い順に削除。
+constexpr uint16_t SESSION_MAX = 32;
+constexpr const char* SESSION_INDEX_FILE = "/SESSIONS.IDX";
+constexpr uint32_t SESSION_MIN_FREE_BYTES = 64UL * 1024UL;
+// Log storage backend.
+// false: one LittleFS file per session.
+// true:  sessions go straight to the raw data partition RAW_LOG_PARTITION_LABEL, written as a
+//        circular log of 4KB sectors (raw_log.h); LittleFS keeps only the session index and checkpoint.
+//        Needs a partition table with that partition (tools/partitions_core2_16mb_rawlog.csv).
+constexpr bool LOG_RAW_PARTITION = false;
+constexpr const char* RAW_LOG_PARTITION_LABEL = "rawlog";
+// Sectors kept erased ahead of the raw write position (at most one is erased per sector written)
+constexpr uint16_t RAW_LOG_ERASE_AHEAD = 4;
+// fs_used_bytes() resync period (LittleFS.usedBytes() walks the allocation table;
+// in between, usage follows the bytes appended to the log)
+// (build flag -DFS_USAGE_CACHE_MS_OVERRIDE=MS replaces it; the host LCD cost comparison uses the former 5000)
+#if defined(FS_USAGE_CACHE_MS_OVERRIDE)
+constexpr uint32_t FS_USAGE_CACHE_MS = FS_USAGE_CACHE_MS_OVERRIDE;
+#else
+constexpr uint32_t FS_USAGE_CACHE_MS = 60000;
+#endif
 // Enable on-device debug overlay (IMU/I2C info) on LCD
 constexpr bool DEBUG_MODE = false;
 // Interval for Serial debug printing of raw IMU data when DEBUG_MODE is true (milliseconds)
 constexpr uint32_t DEBUG_RAW_PRINT_INTERVAL_MS = 200;
 // Serial baud rate for communication
 // High-speed for faster dump. Stable values on ESP32/CP210x: 921600 or 1500000.
+// SERIAL_BAUD は初回起動時の値。`BAUD <rate>` で切り替え、新しいレートでホストが
+// SERIAL_BAUD_CONFIRM_MS 以内に `BAUD OK` を返せば確定して NVS に保存（次回起動もそのレート）、
+// 返らなければ元のレートに戻す。
 constexpr unsigned long SERIAL_BAUD = 115200;
+constexpr uint32_t SERIAL_BAUD_RATES[] = { 115200, 230400, 460800, 921600, 1500000 };
+constexpr uint32_t SERIAL_BAUD_CONFIRM_MS = 2000;
+// NVS namespace of persistent settings (nv_settings.h)
+constexpr const char* NV_NAMESPACE = "acclog";
+// Serial command lines (cmd_line.h): longest line + 1 (longer ones get "ERR TOOLONG"),
+// received bytes taken per serial_proto_poll() call, and how long an unterminated line is kept
+constexpr uint8_t SERIAL_LINE_MAX = 64;
+constexpr uint8_t SERIAL_POLL_MAX_BYTES = 64;
+constexpr uint32_t SERIAL_LINE_TIMEOUT_MS = 1000;
 
-// Calibration behavior
-// Delay after long-press before starting calibration (seconds)
-constexpr uint8_t CALIB_DELAY_SEC = 2;
+// Anti-aliasing decimation (decim.h)
+// DECIM_FACTOR > 1: IMU を ODR_HZ * DECIM_FACTOR で読み、固定小数点 FIR で ODR_HZ に間引いて記録する
+// （ODR_HZ/2 を超える振動の折り返しを防ぐ）。FIR は Hamming 窓 sinc、DECIM_FACTOR * DECIM_TAPS_PER_PHASE
+// タップ（<= 255）、-6dB 点は出力ナイキスト (ODR_HZ/2) の DECIM_CUTOFF_PCT %。係数はコンパイル時に生成。
+// 1 で無効（従来どおり ODR_HZ で直接サンプリング）。高ODRでは IMU_FIFO_MODE との併用を推奨。
+// (build flag -DDECIM_FACTOR_OVERRIDE=N replaces the factor; the host test_decim / bench_decim use 4)
+#if defined(DECIM_FACTOR_OVERRIDE)
+constexpr uint8_t DECIM_FACTOR = DECIM_FACTOR_OVERRIDE;
+#else
+constexpr uint8_t DECIM_FACTOR = 1;
+#endif
+constexpr uint8_t DECIM_TAPS_PER_PHASE = 16;
+constexpr uint8_t DECIM_CUTOFF_PCT = 80;
+// Rate the IMU is configured for and read at (default configuration; runtime: imu_sample_hz())
+constexpr uint16_t IMU_SAMPLE_HZ = ODR_HZ * DECIM_FACTOR;
+
+// Motion-triggered logging (trigger.h, needs LOG_FRAMED; format 0x0306/0x0307)
+// 記録中は常にサンプリングし、動きを検出した区間（セグメント）だけをログに書く。
+// | |a| - 1g | > TRIG_ACC_MG または |ω| > TRIG_GYRO_DPS で開始し、直前 TRIG_PRE_MS 分も書く。
+// 両方が閾値の TRIG_RELEASE_PCT % 未満の状態が TRIG_POST_MS 続いたら終了。
+// (build flags -DTRIGGER_MODE_OVERRIDE=1 -DLOG_FRAMED_OVERRIDE=1 turn it on; the host test_trigger does)
+#if defined(TRIGGER_MODE_OVERRIDE)
+constexpr bool TRIGGER_MODE = TRIGGER_MODE_OVERRIDE;
+#else
+constexpr bool TRIGGER_MODE = false;
+#endif
+constexpr uint16_t TRIG_ACC_MG = 150;
+constexpr uint16_t TRIG_GYRO_DPS = 30;
+constexpr uint8_t TRIG_RELEASE_PCT = 50;
+constexpr uint16_t TRIG_PRE_MS = 1000;
+constexpr uint16_t TRIG_POST_MS = 2000;
+
+// Windowed feature summaries (summary.h, format 0x0400)
+// SUMMARY_WINDOW_MS ごとに軸別の平均/最小/最大/RMS/平均交差回数を1レコード（68byte）にまとめ、
+// セッションごとの /L<id>.SUM（LittleFS）に書く（SUMMARY_RING レコード分を loop() まで保持）。
+// SUMMARY_ONLY: 生データを書かず、セッションのログ自体をサマリーレコード列にする（LOG_COMPRESS/LOG_FRAMED 不可）。
+constexpr bool SUMMARY_ENABLE = false;
+constexpr bool SUMMARY_ONLY = false;
+constexpr uint16_t SUMMARY_WINDOW_MS = 1000;
+constexpr uint8_t SUMMARY_RING = 16;  // power of two (SpscQueue)
+
+// Sample pacing
+// true: esp_timer でODRティックごとにサンプリング（loop()の処理時間に左右されない）
+// false: 従来どおり loop() で micros() をポーリング
+// どちらも取りこぼしたティックは欠損マーカーとして記録し dropped_samples に計上する。
+constexpr bool SAMPLE_TIMER_MODE = true;
+
+// Acquisition / IO split (acq_queue.h, needs SAMPLE_TIMER_MODE)
+// true: esp_timer は ACQ_CORE 上の高優先度タスクを起こすだけで、そのタスクは IMU 読み出しのみ行い
+// サンプルをロックフリー SPSC リング（ACQ_QUEUE_LEN 件、2のべき乗）に積む。間引き・トリガ・圧縮・
+// サマリー・STREAM は IO コア（ACQ_IO_CORE、loop() とライタタスクと同じ core 1）のパイプラインタスクが行う。
+// リング満杯で積めなかったサンプルは欠損マーカーとして記録し、`PERF` の acq に数える。
+// false: 従来どおり esp_timer タスクの中で読み出しからパッキングまで行う。
+constexpr bool ACQ_TASK = true;
+constexpr uint8_t ACQ_CORE = 0;
+constexpr uint8_t ACQ_PRIO = 20;          // below esp_timer (22), above everything else
+constexpr uint8_t ACQ_IO_CORE = 1;
+constexpr uint8_t ACQ_PIPE_PRIO = 3;      // above the writer task
+constexpr uint16_t ACQ_QUEUE_LEN = 512;   // 4 s at 128 Hz, 0.5 s at 1 kHz
+constexpr uint8_t ACQ_DRAIN_MS = 2;       // pipeline wake-up period while recording
+
+// Hot-path stage counters (stage_stats.h): cycle-counter timing of I2C read / packing / flash
+// write / LCD / serial poll with log2 histograms, ODR jitter and missed ticks; serial `STATS`.
+// false で計測コードはコンパイル時に消える。
+constexpr bool STATS_ENABLE = true;
+
+// Read accel+gyro in one I2C burst per sample (false: separate accel/gyro reads for comparison)
+constexpr bool IMU_COMBINED_READ = true;
+
+// IMU FIFO burst mode
+// true: IMUのFIFOにODRでためて IMU_FIFO_DRAIN_MS ごとに一括読み出し（1kHz記録向け）。
+// ヘッダ odr_hz にはセンサの実効ODRを書く。FIFOオーバーフロー分は欠損マーカーで記録。
+// MPU6886 とモックのみ（MPU6886 の読み出しはホストの test_mpu_fifo で検査）。SH200Q は FIFO の
+// 状態レジスタが未確認で HAS_FIFO=false のため、true にするとビルドエラー（SH200Q の最大レートは直接読み出しで）。
+constexpr bool IMU_FIFO_MODE = false;
+constexpr uint16_t IMU_FIFO_DRAIN_MS = 25;
+
+// Log write pipeline
+// サンプリングは1つのバッファに詰め、満杯のバッファはライタタスクがflashへ書き出す。
+// LOG_WRITER_TASK=false なら従来どおりloop()内で同期書き込み（バッファは1つのみ使用）。
+constexpr bool LOG_WRITER_TASK = true;
+// Buffer size in bytes (one flash write per buffer)
+constexpr size_t LOG_BUF_SIZE = 4096;
+// Number of buffers (>=2). 空きが無い場合はサンプルを破棄しoverflowとして数える。
+constexpr uint8_t LOG_BUF_COUNT = 4;
+// Writer task placement (Arduino loop() runs on core 1; core 0 is left to acquisition)
+constexpr uint8_t LOG_WRITER_CORE = 1;
+constexpr uint8_t LOG_WRITER_PRIO = 2;
+
+// Compressed block payload (format 0x0301): delta + zigzag varint, LOG_BUF_SIZE bytes per block.
+// 静止時は1サンプル 6〜8byte 程度（生データは12byte）。false なら従来の生データ (0x0202)。
+constexpr bool LOG_COMPRESS = false;
+
+// Framed block payload (format 0x0302, or 0x0303 together with LOG_COMPRESS).
+// 各ブロック先頭に sync/CRC32/先頭サンプル番号/micros()/サンプル数 を付け、破損後の再同期・
+// 実ODRの測定・時刻でのシークを可能にする（ブロックあたり20byte）。
+#if defined(LOG_FRAMED_OVERRIDE)
+constexpr bool LOG_FRAMED = LOG_FRAMED_OVERRIDE;
+#else
+constexpr bool LOG_FRAMED = false;
+#endif
+
+// Power-loss safety: every LOG_CHECKPOINT_MS the writer flushes the log (LittleFS metadata
+// commit) and stores sample count / flushed size in LOG_CKPT_FILE_NAME. 起動時に未終了の
+// ログ（total_samples == 0xFFFFFFFF）を見つけたらヘッダを修復する。0 で無効。
+constexpr uint32_t LOG_CHECKPOINT_MS = 5000;
+constexpr const char* LOG_CKPT_FILE_NAME = "/ACCLOG.CKP";
+
+// DUMPX (framed, ranged, resumable dump): payload bytes per frame, unacknowledged frames in
+// flight, resend of the oldest unacked frame after DUMPX_RETRY_MS, give up after DUMPX_ABORT_MS
+// without any host reply (the host resumes from what it has).
+constexpr uint16_t DUMPX_FRAME_SIZE = 1024;
+constexpr uint8_t DUMPX_WINDOW = 8;
+constexpr uint32_t DUMPX_RETRY_MS = 500;
+constexpr uint32_t DUMPX_ABORT_MS = 10000;
+
+// STREAM: frames buffered between the sampler and the UART (dropped and counted when full)
+constexpr uint16_t STREAM_RING_FRAMES = 64;
+
+// Calibration (imu_calib.h): gyro bias estimated in the background while idle and still, kept in NVS.
+// 記録していない間 CALIB_POLL_MS ごとに IMU を読み、CALIB_WINDOW サンプルの窓で静止判定する
+// （全軸の標準偏差がジャイロ CALIB_GYRO_STD_DPS・加速度 CALIB_ACC_STD_MG 以下）。静止窓が
+// CALIB_MIN_WINDOWS 続くと最初のバイアスが決まり、以降は静止窓ごとに 1/2^CALIB_TRACK_SHIFT で追従。
+// 保存値から CALIB_SAVE_DELTA_DPS 以上ずれたら NVS に書き直す（最短 CALIB_SAVE_MIN_MS 間隔）。
+constexpr bool CALIB_BG_ENABLE = true;
+constexpr uint16_t CALIB_POLL_MS = 10;
+constexpr uint16_t CALIB_WINDOW = 50;
+constexpr uint16_t CALIB_MIN_WINDOWS = 4;
+constexpr uint8_t CALIB_TRACK_SHIFT = 3;
+constexpr float CALIB_GYRO_STD_DPS = 0.5f;
+constexpr uint16_t CALIB_ACC_STD_MG = 10;
+constexpr float CALIB_SAVE_DELTA_DPS = 0.1f;
+constexpr uint32_t CALIB_SAVE_MIN_MS = 10UL * 60UL * 1000UL;
 
 // LSB per g for ±4g on SH200Q (datasheet value)
 constexpr float LSB_PER_G = 8192.0f;
@@ -32,3 +205,11 @@ constexpr float LSB_PER_G = 8192.0f;
 // LCD backlight brightness (M5StickC AXP192 ScreenBreath 0..12)
 constexpr uint8_t LCD_BRIGHT_ACTIVE = 100;  // brightness when screen is on
 constexpr uint8_t LCD_BRIGHT_OFF    = 0;   // brightness when screen is off
+// Status screen redraw. false: only the FS text lines / usage-bar span whose contents changed, nothing while
+// the screen is off. true: both lines and the whole bar every second, and the state screen also while off
+// (the former renderer; -DLCD_FULL_REDRAW_OVERRIDE=1 builds it for the host before/after comparison)
+#if defined(LCD_FULL_REDRAW_OVERRIDE)
+constexpr bool LCD_FULL_REDRAW = LCD_FULL_REDRAW_OVERRIDE;
+#else
+constexpr bool LCD_FULL_REDRAW = false;
+#endif
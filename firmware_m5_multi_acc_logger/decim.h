@@ -0,0 +1,159 @@
+#pragma once
+#include <Arduino.h>
+#include <type_traits>
+#include "config.h"
+#include "board_hal.h"
+#include "perf_stats.h"
+
+// Anti-aliasing decimator (DECIM_FACTOR > 1).
+// IMU を IMU_SAMPLE_HZ (= ODR_HZ * DECIM_FACTOR) で読み、DECIM_FACTOR 入力ごとに1出力（ODR_HZ）を
+// 固定小数点 FIR で求めて記録する。ODR_HZ/2 を超える振動が記録に折り返さない。
+// 係数は Hamming 窓付き sinc（DECIM_TAPS タップ、-6dB 点 = 出力ナイキストの DECIM_CUTOFF_PCT %）を
+// constexpr で設計して Q15 に丸めたもの。実行時の設計コストは無い。丸め誤差は中央のタップ（偶数タップなら
+// 中央の2つに等分）で吸収し、対称（直線位相）のまま DC ゲインをちょうど 1 にする（重力成分がずれない）。
+// 出力を出す時だけ積和するので、演算量はポリフェーズ分解と同じ 1出力あたり DECIM_TAPS x 6ch。
+// 履歴は長さ 2*DECIM_TAPS のリングに二重書きし、窓を常に連続領域として読む。
+// 欠損入力（読み出し失敗・取りこぼしたティック）は直前値で埋め、それが窓に残る間の出力は
+// 欠損マーカーにする。群遅延は (DECIM_TAPS - 1) / 2 入力サンプル。
+
+constexpr uint16_t DECIM_TAPS = (uint16_t)DECIM_FACTOR * DECIM_TAPS_PER_PHASE;
+static_assert(DECIM_FACTOR >= 1, "DECIM_FACTOR must be >= 1");
+static_assert(DECIM_TAPS >= 2 && DECIM_TAPS <= 255, "DECIM_TAPS must fit in LogHeader::decim_taps");
+static_assert(DECIM_CUTOFF_PCT > 0 && DECIM_CUTOFF_PCT <= 100, "DECIM_CUTOFF_PCT out of range");
+static_assert((uint32_t)ODR_HZ * DECIM_FACTOR == IMU_SAMPLE_HZ, "ODR_HZ * DECIM_FACTOR must fit in uint16_t");
+
+// --- Compile-time filter design (C++11 constexpr: recursion only) ---
+constexpr double DECIM_PI = 3.14159265358979323846;
+// -6 dB cutoff as a fraction of the input rate
+constexpr double DECIM_FC = 0.5 * DECIM_CUTOFF_PCT / 100.0 / DECIM_FACTOR;
+
+constexpr double _decim_wrap(double x) {
+    return (x > DECIM_PI) ? _decim_wrap(x - 2.0 * DECIM_PI)
+         : (x < -DECIM_PI) ? _decim_wrap(x + 2.0 * DECIM_PI) : x;
+}
+// Taylor series on [-pi, pi]; 12 terms are exact to double precision there
+constexpr double _decim_sin_series(double x2, double term, int k) {
+    return (k > 12) ? term
+         : term + _decim_sin_series(x2, -term * x2 / ((2.0 * k) * (2.0 * k + 1.0)), k + 1);
+}
+constexpr double _decim_sin_r(double r) { return _decim_sin_series(r * r, r, 1); }
+constexpr double _decim_sin(double x) { return _decim_sin_r(_decim_wrap(x)); }
+constexpr double _decim_cos(double x) { return _decim_sin(x + DECIM_PI / 2.0); }
+constexpr double _decim_sinc(double x) {
+    return (x == 0.0) ? 1.0 : _decim_sin(DECIM_PI * x) / (DECIM_PI * x);
+}
+
+// Tap i before normalization (symmetric around (DECIM_TAPS - 1) / 2)
+constexpr double _decim_tap(int i) {
+    return 2.0 * DECIM_FC * _decim_sinc(2.0 * DECIM_FC * (i - (DECIM_TAPS - 1) / 2.0))
+         * (0.54 - 0.46 * _decim_cos(2.0 * DECIM_PI * i / (DECIM_TAPS - 1)));
+}
+constexpr double _decim_tap_sum(int i) { return (i < 0) ? 0.0 : _decim_tap(i) + _decim_tap_sum(i - 1); }
+constexpr int32_t _decim_round(double v) { return (int32_t)((v < 0.0) ? v - 0.5 : v + 0.5); }
+constexpr int32_t _decim_q15_raw(int i) {
+    return _decim_round(_decim_tap(i) * 32768.0 / _decim_tap_sum(DECIM_TAPS - 1));
+}
+constexpr int32_t _decim_q15_sum(int i) { return (i < 0) ? 0 : _decim_q15_raw(i) + _decim_q15_sum(i - 1); }
+constexpr int32_t _decim_q15_fix() { return 32768 - _decim_q15_sum(DECIM_TAPS - 1); }
+// Rounding error on the middle tap, or split over the middle pair (even length) to keep the taps symmetric
+constexpr int32_t _decim_q15(int i) {
+    return _decim_q15_raw(i)
+         + ((DECIM_TAPS % 2) ? ((i == DECIM_TAPS / 2) ? _decim_q15_fix() : 0)
+          : (i == DECIM_TAPS / 2 - 1) ? _decim_q15_fix() / 2
+          : (i == DECIM_TAPS / 2) ? _decim_q15_fix() - _decim_q15_fix() / 2 : 0);
+}
+constexpr int32_t _decim_q15_abs_sum(int i) {
+    return (i < 0) ? 0 : ((_decim_q15(i) < 0) ? -_decim_q15(i) : _decim_q15(i)) + _decim_q15_abs_sum(i - 1);
+}
+// 32-bit accumulator whenever |sum q * x| fits for any int16 input (always for short filters)
+typedef std::conditional<(_decim_q15_abs_sum(DECIM_TAPS - 1) <= 65535), int32_t, int64_t>::type DecimAcc;
+
+template <int... I> struct _DecimSeq {};
+template <int N, int... I> struct _DecimMakeSeq : _DecimMakeSeq<N - 1, N - 1, I...> {};
+template <int... I> struct _DecimMakeSeq<0, I...> { typedef _DecimSeq<I...> type; };
+
+template <typename S> struct DecimCoeffs;
+template <int... I> struct DecimCoeffs<_DecimSeq<I...>> {
+    static constexpr int16_t q15[sizeof...(I)] = { (int16_t)_decim_q15(I)... };
+};
+template <int... I> constexpr int16_t DecimCoeffs<_DecimSeq<I...>>::q15[sizeof...(I)];
+typedef DecimCoeffs<_DecimMakeSeq<DECIM_TAPS>::type> DecimFir;
+
+// --- Runtime ---
+enum DecimResult : uint8_t {
+    DECIM_NONE = 0,  // no output for this input
+    DECIM_OUT,       // `out` holds the next ODR_HZ sample
+    DECIM_GAP,       // an output is due but its window holds a filled-in input
+};
+
+static int16_t s_dec_hist[6][2 * DECIM_TAPS];
+static uint16_t s_dec_pos = 0;      // next history slot
+static uint8_t s_dec_phase = 0;     // inputs since the last output
+static uint16_t s_dec_taint = 0;    // inputs until the last filled-in value leaves the window
+static bool s_dec_primed = false;
+static int16_t s_dec_last[6];
+
+inline void decim_reset() {
+    s_dec_pos = 0;
+    s_dec_phase = 0;
+    s_dec_taint = 0;
+    s_dec_primed = false;
+    memset(s_dec_last, 0, sizeof(s_dec_last));
+}
+
+inline int16_t _decim_dot(const int16_t* w) {
+    const int16_t* q = DecimFir::q15;
+    DecimAcc acc = 1 << 14;
+    for (uint16_t k = 0; k < DECIM_TAPS; ++k) acc += (DecimAcc)q[k] * w[k];
+    acc >>= 15;
+    // never emit the gap marker (INT16_MIN)
+    if (acc > 32767) acc = 32767;
+    if (acc < -32767) acc = -32767;
+    return (int16_t)acc;
+}
+
+// Push one input at IMU_SAMPLE_HZ; in == nullptr for a missing one
+inline DecimResult decim_push(const ImuSample* in, ImuSample& out) {
+    int16_t v[6];
+    if (in) {
+        v[0] = in->ax; v[1] = in->ay; v[2] = in->az;
+        v[3] = in->gx; v[4] = in->gy; v[5] = in->gz;
+        if (!s_dec_primed) {
+            // Start from a settled filter instead of a step from zero
+            for (int ch = 0; ch < 6; ++ch) {
+                for (uint16_t k = 0; k < 2 * DECIM_TAPS; ++k) s_dec_hist[ch][k] = v[ch];
+            }
+            s_dec_primed = true;
+            s_dec_taint = 0;
+        }
+    } else {
+        memcpy(v, s_dec_last, sizeof(v));
+        s_dec_taint = DECIM_TAPS;
+    }
+    memcpy(s_dec_last, v, sizeof(v));
+    for (int ch = 0; ch < 6; ++ch) {
+        s_dec_hist[ch][s_dec_pos] = v[ch];
+        s_dec_hist[ch][s_dec_pos + DECIM_TAPS] = v[ch];
+    }
+    s_dec_pos = (s_dec_pos + 1 == DECIM_TAPS) ? 0 : s_dec_pos + 1;
+    DecimResult r = DECIM_NONE;
+    if (++s_dec_phase >= DECIM_FACTOR) {
+        s_dec_phase = 0;
+        if (s_dec_taint) {
+            r = DECIM_GAP;
+        } else {
+            // Window = the last DECIM_TAPS inputs, oldest first (taps are symmetric)
+            const uint32_t c0 = ESP.getCycleCount();
+            out.ax = _decim_dot(&s_dec_hist[0][s_dec_pos]);
+            out.ay = _decim_dot(&s_dec_hist[1][s_dec_pos]);
+            out.az = _decim_dot(&s_dec_hist[2][s_dec_pos]);
+            out.gx = _decim_dot(&s_dec_hist[3][s_dec_pos]);
+            out.gy = _decim_dot(&s_dec_hist[4][s_dec_pos]);
+            out.gz = _decim_dot(&s_dec_hist[5][s_dec_pos]);
+            perf_on_decim(ESP.getCycleCount() - c0);
+            r = DECIM_OUT;
+        }
+    }
+    if (s_dec_taint) s_dec_taint--;
+    return r;
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Runtime device configuration (serial `CONFIG`), checked against the IMU driver's tables.
+// Arduino に依存しない検査・解析部分。適用（ドライバの init() 再実行）と NVS 保存は imu_driver.h /
+// serial_proto.h が行う。
+// - odr: 記録レート。IMU は odr * decim で読む。0 や max_sample_hz を超えるものはエラー。
+//   FIFO モード（odr_fn あり）はセンサ自身のレートが時間軸なので、odr_fn が返す実レートに丸める
+//   （MPU6886 は SMPLRT_DIV の割り切り。コンパイル時の既定値と同じ規則）。実レートが整数 Hz に
+//   ならない（odr_fn が 0）か decim で割り切れないものは、ヘッダの odr が嘘になるのでエラー。
+// - range_g / gyro_dps: ドライバの表にある値だけ（ヘッダの lsb_per_g とスケールがずれないように）。
+// - dlpf: 帯域幅 Hz、0 = 自動（従来どおり）。表の最も近い値に丸める。
+// 検査が通らなければ DevConfig は変えない。
+
+struct DevConfig {
+    uint16_t odr_hz;     // logged rate (after decimation)
+    uint16_t range_g;
+    uint16_t gyro_dps;
+    uint16_t dlpf_hz;    // 0 = automatic
+};
+
+enum DevConfigErr : uint8_t {
+    DEVCFG_OK = 0,
+    DEVCFG_ODR,
+    DEVCFG_RANGE_G,
+    DEVCFG_GYRO_DPS,
+    DEVCFG_DLPF,
+    DEVCFG_SYNTAX      // unknown key or not "key=<0..65535>"
+};
+
+// Keys of CONFIG SET, in DevConfigErr order (index 0 unused)
+static const char* const DEVCFG_KEYS[] = { "", "odr", "range_g", "gyro_dps", "dlpf", "syntax" };
+
+// What the IMU driver (and the firmware) supports
+struct DevConfigLimits {
+    const uint16_t* acc_ranges;
+    size_t n_acc;
+    const uint16_t* gyro_ranges;
+    size_t n_gyro;
+    const uint16_t* dlpf_hz;           // bandwidths (n_dlpf == 0: only automatic)
+    size_t n_dlpf;
+    uint32_t max_sample_hz;            // fastest IMU read rate (odr * decim)
+    uint16_t max_odr_hz;               // fastest logged rate (buffers sized for it)
+    uint16_t decim;
+    uint16_t (*odr_fn)(uint16_t hz);   // rate the sensor produces for hz (0: none exact); nullptr: paced by the sample clock
+};
+
+// Index of the entry nearest to v (the earlier one on a tie), n > 0
+inline size_t dev_config_nearest(const uint16_t* t, size_t n, uint16_t v) {
+    size_t best = 0;
+    for (size_t i = 1; i < n; ++i) {
+        const uint32_t d = (t[i] > v) ? t[i] - v : v - t[i];
+        const uint32_t db = (t[best] > v) ? t[best] - v : v - t[best];
+        if (d < db) best = i;
+    }
+    return best;
+}
+
+inline bool dev_config_has(const uint16_t* t, size_t n, uint16_t v) {
+    for (size_t i = 0; i < n; ++i) {
+        if (t[i] == v) return true;
+    }
+    return false;
+}
+
+// Validate c and round odr / dlpf to what will actually run. c is left unchanged on error.
+inline DevConfigErr dev_config_check(DevConfig& c, const DevConfigLimits& l) {
+    const uint32_t in_hz = (uint32_t)c.odr_hz * l.decim;
+    if (c.odr_hz == 0 || c.odr_hz > l.max_odr_hz || in_hz > l.max_sample_hz || in_hz > 0xFFFF) return DEVCFG_ODR;
+    uint16_t odr = c.odr_hz;
+    if (l.odr_fn) {
+        const uint16_t sensor_hz = l.odr_fn((uint16_t)in_hz);
+        if (sensor_hz == 0 || sensor_hz % l.decim != 0) return DEVCFG_ODR;
+        odr = (uint16_t)(sensor_hz / l.decim);
+        if (odr > l.max_odr_hz) return DEVCFG_ODR;
+    }
+    if (!dev_config_has(l.acc_ranges, l.n_acc, c.range_g)) return DEVCFG_RANGE_G;
+    if (!dev_config_has(l.gyro_ranges, l.n_gyro, c.gyro_dps)) return DEVCFG_GYRO_DPS;
+    uint16_t dlpf = 0;
+    if (c.dlpf_hz) {
+        if (!l.n_dlpf) return DEVCFG_DLPF;
+        dlpf = l.dlpf_hz[dev_config_nearest(l.dlpf_hz, l.n_dlpf, c.dlpf_hz)];
+    }
+    c.odr_hz = odr;
+    c.dlpf_hz = dlpf;
+    return DEVCFG_OK;
+}
+
+// "key=value [key=value ...]" over c (keys: odr, range_g, gyro_dps, dlpf). Values are not checked here.
+inline DevConfigErr dev_config_parse(DevConfig& c, const char* args) {
+    DevConfig n = c;
+    const char* p = args;
+    bool any = false;
+    while (*p) {
+        while (*p == ' ') ++p;
+        if (!*p) break;
+        const char* eq = p;
+        while (*eq && *eq != '=' && *eq != ' ') ++eq;
+        if (*eq != '=') return DEVCFG_SYNTAX;
+        const size_t klen = (size_t)(eq - p);
+        const char* v = eq + 1;
+        uint32_t val = 0;
+        const char* q = v;
+        while (*q >= '0' && *q <= '9') {
+            val = val * 10 + (uint32_t)(*q - '0');
+            if (val > 0xFFFF) return DEVCFG_SYNTAX;
+            ++q;
+        }
+        if (q == v || (*q && *q != ' ')) return DEVCFG_SYNTAX;
+        uint16_t* dst = nullptr;
+        for (uint8_t k = DEVCFG_ODR; k <= DEVCFG_DLPF; ++k) {
+            if (strlen(DEVCFG_KEYS[k]) == klen && strncmp(p, DEVCFG_KEYS[k], klen) == 0) {
+                dst = (k == DEVCFG_ODR) ? &n.odr_hz : (k == DEVCFG_RANGE_G) ? &n.range_g
+                    : (k == DEVCFG_GYRO_DPS) ? &n.gyro_dps : &n.dlpf_hz;
+            }
+        }
+        if (!dst) return DEVCFG_SYNTAX;
+        *dst = (uint16_t)val;
+        any = true;
+        p = q;
+    }
+    if (!any) return DEVCFG_SYNTAX;
+    c = n;
+    return DEVCFG_OK;
+}
@@ -1,4 +1,4 @@
-// Build Marker: 2025-12-02 16:02:00 (Local, Last Updated)
+// Build Marker: 2026-10-17 03:55:05 (Local, Last Updated)
 // Note: Update this timestamp whenever agents modifies this file.
 
 #include <LittleFS.h>
@@ -8,19 +8,26 @@
 #include "config.h"
 #include "board_hal.h"
 #include "fs_format.h"
-#if HAL_IMU_IS_SH200Q
-#include "imu_sh200q.h"
-#else
-#include "imu_mpu6886_unified.h"
-#endif
+#include "perf_stats.h"
+#include "stage_stats.h"
+#include "log_writer.h"
+#include "log_codec.h"
+#include "sample_clock.h"
+#include "decim.h"
+#include "trigger.h"
+#include "summary.h"
+#include "stream_out.h"
+#include "session_store.h"
+#include "imu_driver.h"
+#include "imu_calib.h"
+#include "acq_queue.h"
 
 bool recording = false;
 static bool screen_on = true;
 static uint32_t screen_on_until_ms = 0;
-File logFile;
-static uint8_t ring_buf[4096];
-static size_t ring_pos = 0;
+uint32_t rec_session = 0;              // session being (or last) recorded
 static uint32_t total_samples = 0;
+static uint32_t dropped_samples = 0; // gap markers written for missed ticks / failed reads
 static uint32_t last_idle_ms = 0; // for auto power-off when idle
 static int16_t dbg_ax = 0, dbg_ay = 0, dbg_az = 0;
 static int16_t dbg_gx = 0, dbg_gy = 0, dbg_gz = 0;
@@ -29,6 +36,10 @@ static bool dbg_has_sample = false;
 // forward declaration for serial protocol
 void start_logging();
 void stop_logging();
+static void sample_tick(uint32_t due);
+static void sample_fifo_burst(uint32_t due);
+static void acq_consume(const AcqItem& it);
+static void log_summary(const SummaryRecord& rec);
 #include "serial_proto.h"
 
 // Ensure exact 64-byte layout without padding
@@ -48,8 +59,28 @@ struct __attribute__((packed)) LogHeader {
     float lsb_per_dps;
     uint32_t total_samples;
     uint32_t dropped_samples;
-    uint8_t reserved[64 - 8 - 2 - 8 - 8 - 2 - 2 - 2 - 2 - 2 - 4 - 4 - 4 - 4];
+    // New in v2.2: gyro column is bias-subtracted raw counts on every IMU;
+    // the subtracted calibration bias (raw counts) is kept here.
+    int16_t gyro_bias_x;
+    int16_t gyro_bias_y;
+    int16_t gyro_bias_z;
+    // New in v3 (0x03xx): payload block size in bytes
+    uint16_t block_size;
+    // Anti-aliasing decimation (0 = none): IMU read at odr_hz * decim_factor,
+    // decim_taps-tap FIR with -6 dB point at decim_cutoff_pct % of odr_hz / 2
+    uint8_t decim_factor;
+    uint8_t decim_taps;
+    uint8_t decim_cutoff_pct;
+    // IMU low-pass bandwidth in Hz (CONFIG dlpf; 0 = unknown / older firmware)
+    uint8_t dlpf_hz;
 };
+static_assert(sizeof(LogHeader) == 64, "LogHeader must be 64 bytes");
+static_assert(offsetof(LogHeader, total_samples) == FS_LOG_TOTALS_OFS
+              && offsetof(LogHeader, dropped_samples) == FS_LOG_TOTALS_OFS + 4, "fs_log_set_totals layout");
+
+// Gap marker: a sample slot whose six channels are all INT16_MIN.
+// 取りこぼしたティックの位置に書き込み、PC側の t = n / odr_hz を保つ。
+static const int16_t LOG_GAP_WORD = (int16_t)0x8000;
 
 void lcd_draw_debug_overlay(uint16_t bg) {
     if (!DEBUG_MODE) return;
@@ -66,16 +97,7 @@ void lcd_draw_debug_overlay(uint16_t bg) {
     hal_lcd().fillRect(0, y, hal_lcd().width(), overlay_h, bg);
     hal_lcd().setTextColor(TFT_YELLOW, bg);
     hal_lcd().setCursor(0, y);
-#if HAL_IMU_IS_SH200Q
-    const char* imu_name = "SH200Q";
-    const uint8_t imu_addr = hal_imu_addr();
-    const char* bus_name = hal_i2c_bus_name();
-#else
-    const char* imu_name = "MPU6886";
-    const uint8_t imu_addr = hal_imu_addr();
-    const char* bus_name = hal_i2c_bus_name();
-#endif
-    hal_lcd().printf("IMU:%s 0x%02X %s", imu_name, imu_addr, bus_name);
+    hal_lcd().printf("IMU:%s 0x%02X %s", ImuDriver::NAME, ImuDriver::ADDR, ImuDriver::BUS_NAME);
     hal_lcd().setCursor(0, y + line_h + line_gap);
     hal_lcd().printf("SDA:%d SCL:%d cal:%c rec:%c", hal_i2c_sda_pin(), hal_i2c_scl_pin(), imu_is_calibrated() ? 'Y' : 'N', recording ? 'Y' : 'N');
     hal_lcd().setCursor(0, y + (line_h + line_gap) * 2);
@@ -92,28 +114,64 @@ void lcd_draw_debug_overlay(uint16_t bg) {
     }
 }
 
+// What lcd_draw_fs_usage() last put on screen; it repaints only the lines / bar span that
+// changed. Anything that clears the screen (lcd_show_state) must reset it.
+struct LcdFsView {
+    bool valid;
+    uint16_t bg;
+    int bar_fill;
+    char usage[48];
+    char eta[48];
+};
+static LcdFsView s_lcd_fs = {};
+
 void lcd_show_state() {
+    // Screen off: nothing to draw; ui_wake_for() repaints everything when it comes back on
+    if (!screen_on && !LCD_FULL_REDRAW) return;
+    const uint32_t c0 = stats_now();
     uint16_t bg = recording ? TFT_RED : TFT_BLACK;
     hal_lcd().fillScreen(bg);
+    s_lcd_fs.valid = false;
     hal_lcd().setCursor(0, 0);
     hal_lcd().setTextColor(TFT_WHITE, bg);
     if (recording) {
-        hal_lcd().print("REC");
+        hal_lcd().print(TRIGGER_MODE ? "REC (TRIGGER)" : "REC");
     } else if (!imu_is_calibrated()) {
-        hal_lcd().print("CALIBRATION STANDBY\n");
-        hal_lcd().print("Hold button to start\n");
-        hal_lcd().printf("Starts %us after hold\n", (unsigned)CALIB_DELAY_SEC);
+        // imu_calib_poll() finishes by itself once the device lies still
+        hal_lcd().print("CALIBRATING\n");
+        hal_lcd().print("Keep device still\n");
     } else {
         hal_lcd().print("IDLE");
     }
     lcd_draw_debug_overlay(bg);
+    stats_add(STAT_LCD, c0);
+}
+
+// One text line at y, repainted only when it differs from what `last` holds
+static void lcd_draw_line(char* last, size_t n, const char* text, int y, uint16_t fg, uint16_t bg) {
+    if (strcmp(last, text) == 0) return;
+    // Clear the line with sufficient height to avoid overlap
+    int th = hal_lcd().fontHeight();
+    if (th <= 0) th = 16;
+    hal_lcd().fillRect(0, y - 2, hal_lcd().width(), th + 4, bg);
+    hal_lcd().setCursor(0, y);
+    // Use background color to overwrite previous text fully
+    hal_lcd().setTextColor(fg, bg);
+    hal_lcd().print(text);
+    snprintf(last, n, "%s", text);
 }
 
 void lcd_draw_fs_usage() {
     if (!screen_on) return; // skip drawing when screen is off
+    const uint32_t c0 = stats_now();
     // Determine background color by state
     uint16_t bg = recording ? TFT_RED : TFT_BLACK;
     uint16_t fg = TFT_WHITE;
+    if (LCD_FULL_REDRAW || !s_lcd_fs.valid || s_lcd_fs.bg != bg) {
+        s_lcd_fs = {};
+        s_lcd_fs.bg = bg;
+        s_lcd_fs.bar_fill = -1;
+    }
     // Layout
     const int margin = 2;
     const int text_y = 12; // second line
@@ -122,52 +180,58 @@ void lcd_draw_fs_usage() {
     const int bar_x = margin;
     const int bar_w = hal_lcd().width() - margin * 2;
 
-    // Compute FS stats
-    uint8_t pct = fs_used_pct();
-    size_t used = fs_used_bytes();
-    size_t total = fs_total_bytes();
+    // Compute FS stats (one usage lookup; between scans it follows the bytes written)
+    const size_t total = fs_total_bytes();
+    const size_t used = fs_used_bytes();
+    const size_t free_b = (used <= total) ? total - used : 0;
+    const uint8_t pct = total ? (uint8_t)((uint64_t)used * 100 / total) : 0;
 
-    // Clear text area line with sufficient height to avoid overlap
-    int th = hal_lcd().fontHeight();
-    if (th <= 0) th = 16;
-    hal_lcd().fillRect(0, text_y - 2, hal_lcd().width(), th + 4, bg);
-    hal_lcd().setCursor(0, text_y);
-    // Use background color to overwrite previous text fully
-    hal_lcd().setTextColor(fg, bg);
     // Display bytes with B (bytes) unit per request
-    hal_lcd().printf("FS: %3u%%(%uB / %uB) used", pct, (unsigned)used, (unsigned)total);
+    char line[48];
+    snprintf(line, sizeof(line), "FS: %3u%%(%uB / %uB) used", pct, (unsigned)used, (unsigned)total);
+    lcd_draw_line(s_lcd_fs.usage, sizeof(s_lcd_fs.usage), line, text_y, fg, bg);
 
     // Third line: ODR and estimated remaining time based on free space
     int th2 = hal_lcd().fontHeight();
     if (th2 <= 0) th2 = 16;
     int text2_y = text_y + th2 + 4;
-    hal_lcd().fillRect(0, text2_y - 2, hal_lcd().width(), th2 + 4, bg);
-    hal_lcd().setCursor(0, text2_y);
-    hal_lcd().setTextColor(fg, bg);
-    // Data rate: 6 channels * int16 = 12 bytes per sample at ODR_HZ
-    const float bytes_per_sec = 12.0f * (float)ODR_HZ;
+    // Data rate: 6 channels * int16 = 12 bytes per sample at the running ODR (CONFIG),
+    // scaled by the live block ratio (compression/framing overhead) in block mode
+    const unsigned odr = imu_config().odr_hz;
+    float bytes_per_sec = SUMMARY_ONLY ? 0.0f : 12.0f * (float)odr;
+    if (LOG_BLOCK_MODE) bytes_per_sec *= log_codec_ratio();
+    if (SUMMARY_ENABLE) bytes_per_sec += (float)sizeof(SummaryRecord) * 1000.0f / (float)SUMMARY_WINDOW_MS;
     float eta_sec = 0.0f;
     if (bytes_per_sec > 0.0f) {
-        eta_sec = (float)fs_free_bytes() / bytes_per_sec;
+        eta_sec = (float)free_b / bytes_per_sec;
     }
     // Compact human-readable ETA
     if (eta_sec >= 3600.0f) {
         float hrs = eta_sec / 3600.0f;
-        hal_lcd().printf("ODR:%uHz ETA: %.1fhour", (unsigned)ODR_HZ, hrs);
+        snprintf(line, sizeof(line), "ODR:%uHz ETA: %.1fhour", odr, hrs);
     } else if (eta_sec >= 60.0f) {
         float mins = eta_sec / 60.0f;
-        hal_lcd().printf("ODR:%uHz ETA: %.1fmin", (unsigned)ODR_HZ, mins);
+        snprintf(line, sizeof(line), "ODR:%uHz ETA: %.1fmin", odr, mins);
     } else {
-        hal_lcd().printf("ODR:%uHz ETA: %usec", (unsigned)ODR_HZ, (unsigned)eta_sec);
+        snprintf(line, sizeof(line), "ODR:%uHz ETA: %usec", odr, (unsigned)eta_sec);
     }
+    lcd_draw_line(s_lcd_fs.eta, sizeof(s_lcd_fs.eta), line, text2_y, fg, bg);
 
-    // Draw usage bar background and fill
-    hal_lcd().fillRect(bar_x, bar_y, bar_w, bar_h, TFT_DARKGREY);
+    // Usage bar: full draw after a clear, afterwards only the span between the old and new fill
     int fill_w = (int)((uint32_t)bar_w * pct / 100);
-    if (fill_w > 0) {
-        hal_lcd().fillRect(bar_x, bar_y, fill_w, bar_h, TFT_RED);
+    const int old_w = s_lcd_fs.bar_fill;
+    if (old_w < 0) {
+        hal_lcd().fillRect(bar_x, bar_y, bar_w, bar_h, TFT_DARKGREY);
+        if (fill_w > 0) hal_lcd().fillRect(bar_x, bar_y, fill_w, bar_h, TFT_RED);
+    } else if (fill_w > old_w) {
+        hal_lcd().fillRect(bar_x + old_w, bar_y, fill_w - old_w, bar_h, TFT_RED);
+    } else if (fill_w < old_w) {
+        hal_lcd().fillRect(bar_x + fill_w, bar_y, old_w - fill_w, bar_h, TFT_DARKGREY);
     }
+    s_lcd_fs.bar_fill = fill_w;
+    s_lcd_fs.valid = true;
     lcd_draw_debug_overlay(bg);
+    stats_add(STAT_LCD, c0);
 }
 
 // Screen power/brightness control helpers
@@ -193,35 +257,57 @@ void ui_wake_for(uint32_t ms) {
 }
 
 void start_logging() {
-    // Ensure a fresh file is created
-    LittleFS.remove(LOG_FILE_NAME);
-    logFile = fs_create_log();
-    if (!logFile) return;
+    // Effective sample rate: in FIFO mode the sensor's own ODR drives the timeline.
+    // The IMU is read at in_hz, the decimator logs every DECIM_FACTOR-th filtered sample.
+    const DevConfig& cfg = imu_config();
+    const uint16_t in_hz = IMU_FIFO_MODE ? imu_fifo_odr_hz() : imu_sample_hz();
+    const uint16_t odr = in_hz / DECIM_FACTOR;
+    // New session log; earlier sessions are kept (oldest reclaimed when full)
+    log_ckpt_clear();
+    rec_session = session_create(millis(), LOG_FORMAT_VER);
     LogHeader hdr = {};
     // Write full 8-byte magic explicitly
     memcpy(hdr.magic, "ACCLOG\0\0", 8);
-    // Bump format version: 0x0201 adds IMU meta
-    hdr.format_ver = 0x0201;
+    // Bump format version: 0x0201 adds IMU meta, 0x0202 gyro counts + bias,
+    // 0x0301 compressed blocks (LOG_COMPRESS), 0x0302/0x0303 framed blocks (LOG_FRAMED),
+    // 0x0306/0x0307 framed trigger segments (TRIGGER_MODE), 0x0400 summary records (SUMMARY_ONLY)
+    hdr.format_ver = LOG_FORMAT_VER;
     hdr.device_uid = ESP.getEfuseMac();
     // Use device monotonic millis at start for later PC-side alignment
     hdr.start_unix_ms = millis();
-    hdr.odr_hz = ODR_HZ;
-    hdr.range_g = RANGE_G;
-    hdr.gyro_range_dps = GYRO_RANGE_DPS;
-    hdr.imu_type = HAL_IMU_TYPE;
+    hdr.odr_hz = odr;
+    hdr.range_g = cfg.range_g;
+    hdr.gyro_range_dps = cfg.gyro_dps;
+    hdr.imu_type = ImuDriver::TYPE;
     hdr.device_model = HAL_DEVICE_MODEL;
-    hdr.lsb_per_g = (float)(32768.0f / (float)RANGE_G);
-    hdr.lsb_per_dps = (float)(32768.0f / (float)GYRO_RANGE_DPS);
+    hdr.lsb_per_g = (float)(32768.0f / (float)cfg.range_g);
+    hdr.lsb_per_dps = (float)(32768.0f / (float)cfg.gyro_dps);
     hdr.total_samples = 0xFFFFFFFF;
     hdr.dropped_samples = 0;
-    logFile.seek(0);
-    logFile.write(reinterpret_cast<uint8_t*>(&hdr), sizeof(hdr));
-    logFile.flush();
+    int16_t gbx, gby, gbz;
+    imu_gyro_bias(gbx, gby, gbz);
+    hdr.gyro_bias_x = gbx;
+    hdr.gyro_bias_y = gby;
+    hdr.gyro_bias_z = gbz;
+    hdr.block_size = LOG_BLOCK_MODE ? LOG_BUF_SIZE : 0;
+    if (DECIM_FACTOR > 1) {
+        hdr.decim_factor = DECIM_FACTOR;
+        hdr.decim_taps = (uint8_t)DECIM_TAPS;
+        hdr.decim_cutoff_pct = DECIM_CUTOFF_PCT;
+    }
+    const uint16_t dlpf = ImuDriver::dlpf_hz(IMU_FIFO_MODE);
+    hdr.dlpf_hz = (uint8_t)((dlpf > 255) ? 255 : dlpf);
+    if (!fs_log_create(rec_session, reinterpret_cast<uint8_t*>(&hdr), sizeof(hdr))) {
+        Serial.println("HDRCHK create failed");
+        session_erase(rec_session);
+        return;
+    }
     // Debug: verify header just written
     {
         uint8_t chk[16] = {0};
-        logFile.seek(0);
-        logFile.read(chk, sizeof(chk));
+        FsLogReader r;
+        if (fs_log_open(r, rec_session)) fs_log_read(r, 0, chk, sizeof(chk));
+        fs_log_close(r);
         Serial.print("HDRCHK ");
         const char hex[] = "0123456789abcdef";
         for (size_t i = 0; i < sizeof(chk); ++i) {
@@ -231,48 +317,126 @@ void start_logging() {
         }
         Serial.print('\n');
     }
-    // Reopen for append to ensure subsequent payload is not overwriting header
-    logFile.close();
-    logFile = LittleFS.open(LOG_FILE_NAME, "a");
-    if (!logFile) {
-        Serial.println("HDRCHK reopen failed");
+    if (!log_writer_begin()) {
+        Serial.println("HDRCHK writer start failed");
+        // Close the empty log and drop its session, so no index entry is left unterminated (0xFFFFFFFF)
+        fs_log_finish(0, 0);
+        session_erase(rec_session);
         recording = false;
         return;
     }
-    ring_pos = 0;
+    log_codec_begin();
+    decim_reset();
+    trigger_reset(odr, cfg.range_g, cfg.gyro_dps);
+    summary_reset(odr);
+    if (SUMMARY_ENABLE && !SUMMARY_ONLY
+        && !summary_begin(rec_session, reinterpret_cast<const uint8_t*>(&hdr), sizeof(hdr))) {
+        Serial.println("HDRCHK summary create failed");
+    }
     total_samples = 0;
+    dropped_samples = 0;
+    perf_reset(in_hz);
+    stats_tick_restart();
     recording = true;
+    if (!acq_begin(acq_consume)) {
+        Serial.println("HDRCHK acq pipeline start failed");
+    }
+    bool clk_ok;
+    if (IMU_FIFO_MODE) {
+        // Drain every IMU_FIFO_DRAIN_MS, well before the FIFO fills
+        uint32_t batch = (uint32_t)in_hz * IMU_FIFO_DRAIN_MS / 1000;
+        if (batch > IMU_FIFO_MAX_FRAMES * 3 / 4) batch = IMU_FIFO_MAX_FRAMES * 3 / 4;
+        if (batch < 1) batch = 1;
+        imu_fifo_begin();
+        clk_ok = sample_clock_start(sample_fifo_burst, in_hz, (uint16_t)batch);
+    } else {
+        clk_ok = sample_clock_start(sample_tick, in_hz);
+    }
+    if (!clk_ok) {
+        Serial.println("HDRCHK sample clock start failed");
+    }
     lcd_show_state();
     lcd_draw_fs_usage();
 }
 
 void stop_logging() {
     if (!recording) return;
-    if (ring_pos > 0) {
-        logFile.write(ring_buf, ring_pos);
-        ring_pos = 0;
-    }
-    if (logFile) {
-        logFile.flush();
-        logFile.close();
-        // Update total_samples in header
-        File f = LittleFS.open(LOG_FILE_NAME, "r+");
-        if (f) {
-            LogHeader hdr;
-            f.seek(0);
-            f.read(reinterpret_cast<uint8_t*>(&hdr), sizeof(hdr));
-            hdr.total_samples = total_samples;
-            f.seek(0);
-            f.write(reinterpret_cast<uint8_t*>(&hdr), sizeof(hdr));
-            f.flush();
-            f.close();
-        }
+    sample_clock_stop();
+    // Pack what acquisition queued before flushing the codec / summary from this task
+    acq_end();
+    if (IMU_FIFO_MODE) imu_fifo_end();
+    if (SUMMARY_ENABLE) {
+        SummaryRecord rec;
+        if (summary_flush(rec)) log_summary(rec);
     }
+    // Drain pending buffers before touching the log from this task
+    if (LOG_BLOCK_MODE) log_codec_end();
+    log_writer_end();
+    summary_end();
+    // Final counts: header patch (LittleFS) or closing sector (raw partition)
+    const uint32_t size = fs_log_bytes();
+    fs_log_finish(total_samples, dropped_samples + log_writer_overflow());
+    session_close(rec_session, total_samples, size);
+    log_ckpt_clear();
     recording = false;
     lcd_show_state();
     lcd_draw_fs_usage();
 }
 
+// Boot-time repair of a log left unterminated by a power cut (total_samples == 0xFFFFFFFF).
+// 生データはファイルサイズから、ブロック形式は最後のチェックポイント以降のブロック
+// ヘッダだけを辿ってサンプル数を求め、ヘッダを書き戻す。
+static void recover_log() {
+    // Only the newest session can have been cut off
+    const uint32_t id = session_latest();
+    const SessionEntry* e = session_find(id);
+    if (!e || e->samples != 0xFFFFFFFF) {
+        log_ckpt_clear();
+        return;
+    }
+    const uint32_t t0 = micros();
+    FsLogReader f;
+    if (!fs_log_open(f, id)) {
+        // Power cut before the log was created
+        session_erase(id);
+        log_ckpt_clear();
+        return;
+    }
+    LogHeader hdr = {};
+    if (fs_log_read(f, 0, reinterpret_cast<uint8_t*>(&hdr), sizeof(hdr)) != sizeof(hdr)
+        || memcmp(hdr.magic, "ACCLOG", 6) != 0 || hdr.total_samples != 0xFFFFFFFF) {
+        // Header already final (cut between header patch and index update) or not a log
+        session_close(id, (memcmp(hdr.magic, "ACCLOG", 6) == 0) ? hdr.total_samples : 0, f.size);
+        fs_log_close(f);
+        log_ckpt_clear();
+        return;
+    }
+    const size_t size = f.size;
+    LogCheckpoint ck;
+    const bool have_ck = log_ckpt_read(ck) && ck.bytes >= sizeof(hdr) && ck.bytes <= size;
+    uint32_t samples = 0;
+    if (hdr.format_ver < 0x0300 || hdr.block_size == 0) {
+        // Fixed-size records: samples, or windows of summary records (0x0400)
+        samples = (size - sizeof(hdr)) / ((hdr.format_ver >= SUMMARY_FORMAT_VER) ? sizeof(SummaryRecord) : 12);
+    } else {
+        size_t pos = have_ck ? ck.bytes : sizeof(hdr);
+        samples = have_ck ? ck.records : 0;
+        uint8_t bh[20];
+        while (pos + hdr.block_size <= size) {
+            uint16_t cnt = log_block_count(bh, fs_log_read(f, pos, bh, sizeof(bh)), hdr.format_ver);
+            if (cnt == 0) break;
+            samples += cnt;
+            pos += hdr.block_size;
+        }
+    }
+    fs_log_close(f);
+    fs_log_set_totals(id, samples, have_ck ? ck.overflow : 0);
+    session_close(id, samples, size);
+    log_ckpt_clear();
+    Serial.printf("RECOVER session:%u samples:%u bytes:%u ckpt:%d us:%u\n",
+                  (unsigned)id, (unsigned)samples, (unsigned)size, (int)have_ck, (unsigned)(micros() - t0));
+}
+
 void setup() {
     hal_begin();
     WiFi.mode(WIFI_OFF);
@@ -284,16 +448,26 @@ void setup() {
     Serial.setTxBufferSize(1024);
     Serial.setRxBufferSize(1024);
     #endif
-    Serial.begin(SERIAL_BAUD);
+    serial_proto_begin();
     bool fs_ok = fs_init();
+    if (fs_ok) {
+        session_init();
+        recover_log();
+    }
     Serial.printf(
-        "BOOT fs_ok:%d total:%u used:%u imu_type:%u addr:0x%02X bus:%s SDA:%d SCL:%d\n",
+        "BOOT fs_ok:%d total:%u used:%u imu_type:%u addr:0x%02X bus:%s SDA:%d SCL:%d baud:%u\n",
         (int)fs_ok, (unsigned)fs_total_bytes(), (unsigned)fs_used_bytes(),
-        (unsigned)HAL_IMU_TYPE, (unsigned)hal_imu_addr(), hal_i2c_bus_name(),
-        hal_i2c_sda_pin(), hal_i2c_scl_pin()
+        (unsigned)ImuDriver::TYPE, (unsigned)ImuDriver::ADDR, ImuDriver::BUS_NAME,
+        hal_i2c_sda_pin(), hal_i2c_scl_pin(), (unsigned)serial_baud()
     );
+    // Configuration saved by CONFIG SET (else config.h), before the IMU registers are set from it
+    imu_config_load();
     bool imu_ok = imu_init();
     Serial.printf("IMU_INIT %d\n", (int)imu_ok);
+    config_print("");
+    // Stored calibration: recording can start right away
+    imu_calib_load();
+    imu_calib_print(Serial);
     lcd_show_state();
     screen_on = true;
     screen_on_until_ms = millis() + 5000; // initial wake period
@@ -303,43 +477,31 @@ void setup() {
 
 void loop() {
     hal_update();
-    // State: handle calibration-first workflow
-    static bool calib_pending = false;
-    static uint32_t calib_due_ms = 0;
-
     // Long press behavior:
-    //  - Before first calibration: schedule calibration after CALIB_DELAY_SEC
+    //  - Before the first calibration (none stored, device not still yet): show the calibration screen
     //  - After calibration: toggle recording
     const uint32_t LONG_MS = 800;
     if (hal_btn_long(LONG_MS)) {
-        if (!imu_is_calibrated()) {
-            calib_pending = true;
-            calib_due_ms = millis() + (uint32_t)CALIB_DELAY_SEC * 1000UL;
-            screen_set(true);
-            hal_lcd().fillScreen(TFT_BLACK);
-            hal_lcd().setTextColor(TFT_WHITE, TFT_BLACK);
-            hal_lcd().setCursor(0, 0);
-            hal_lcd().print("Calibration scheduled\n");
-            hal_lcd().printf("Starting in %us...\n", (unsigned)CALIB_DELAY_SEC);
-            hal_lcd().print("Keep device still");
-        } else {
+        if (imu_is_calibrated()) {
             if (recording) stop_logging();
             else start_logging();
-            ui_wake_for(10000);
         }
+        ui_wake_for(10000);
     } else if (hal_btn_short_released()) {
         // Short press
         ui_wake_for(10000);
     }
-    // Kick calibration when due
-    if (calib_pending && (int32_t)(millis() - calib_due_ms) >= 0) {
-        calib_pending = false;
-        imu_calibrate_once();
-        lcd_show_state();
-        lcd_draw_fs_usage();
-    }
+    const uint32_t t_serial = stats_now_us();
     serial_proto_poll();
+    stats_add_us(STAT_SERIAL, t_serial);
+    stream_poll();
+    summary_poll();
     if (!recording) {
+        // Background calibration while idle; the first estimate replaces the calibration screen
+        if (imu_calib_poll()) {
+            lcd_show_state();
+            lcd_draw_fs_usage();
+        }
         static uint32_t last_lcd_ms = 0;
         uint32_t now_ms = millis();
         if (imu_is_calibrated() && now_ms - last_lcd_ms >= 1000) {
@@ -358,48 +520,182 @@ void loop() {
         return;
     }
 
-    static uint32_t last_us = micros();
-    uint32_t now = micros();
-    if (now - last_us < (1000000UL / ODR_HZ)) {
-        // Update LCD FS usage at ~1 Hz while recording as well
-        static uint32_t last_lcd_ms_rec = 0;
-        uint32_t now_ms = millis();
-        if (now_ms - last_lcd_ms_rec >= 1000) {
-            last_lcd_ms_rec = now_ms;
-            lcd_draw_fs_usage();
-        }
-        // Auto screen off during recording
-        if (screen_on && (int32_t)(millis() - screen_on_until_ms) > 0) {
-            screen_set(false);
-        }
+    // Polling mode: take the sample when a tick is due (timer mode samples from esp_timer)
+    if (sample_clock_poll()) return;
+    // Update LCD FS usage at ~1 Hz while recording as well
+    static uint32_t last_lcd_ms_rec = 0;
+    uint32_t now_ms = millis();
+    if (now_ms - last_lcd_ms_rec >= 1000) {
+        last_lcd_ms_rec = now_ms;
+        lcd_draw_fs_usage();
+    }
+    // Auto screen off during recording
+    if (screen_on && (int32_t)(millis() - screen_on_until_ms) > 0) {
+        screen_set(false);
+    }
+    if (SAMPLE_TIMER_MODE) delay(1);
+}
+
+// Append one sample read at t_us: raw big-endian record, or a compressed/framed block (LOG_BLOCK_MODE).
+// A false return means the writer had no free buffer (overflow).
+static bool log_put(const ImuSample& smp, uint32_t t_us) {
+    if (LOG_BLOCK_MODE) return log_codec_put(smp, t_us);
+    // Write big-endian (MSB first) like accel
+    uint8_t rec[12];
+    rec[0] = smp.ax >> 8; rec[1] = smp.ax & 0xFF;
+    rec[2] = smp.ay >> 8; rec[3] = smp.ay & 0xFF;
+    rec[4] = smp.az >> 8; rec[5] = smp.az & 0xFF;
+    rec[6] = smp.gx >> 8; rec[7] = smp.gx & 0xFF;
+    rec[8] = smp.gy >> 8; rec[9] = smp.gy & 0xFF;
+    rec[10] = smp.gz >> 8; rec[11] = smp.gz & 0xFF;
+    // Full buffers are written by the writer task. Records carry no time: records dropped on overflow
+    // become gap markers ahead of this one, counted like the other gap markers.
+    static const uint8_t gap_rec[12] = { 0x80, 0, 0x80, 0, 0x80, 0, 0x80, 0, 0x80, 0, 0x80, 0 };
+    uint32_t filled = 0;
+    const bool ok = log_writer_put_filled(rec, gap_rec, sizeof(rec), filled);
+    total_samples += filled;
+    dropped_samples += filled;
+    return ok;
+}
+
+// Count a sample the writer accepted (gap: it was a gap marker)
+static void log_count(bool ok, bool gap) {
+    if (!ok) return;
+    total_samples++;
+    if (gap) dropped_samples++;
+}
+
+// A finished summary window: the log payload (SUMMARY_ONLY) or the .SUM file
+static void log_summary(const SummaryRecord& rec) {
+    if (SUMMARY_ONLY) log_count(log_writer_put(reinterpret_cast<const uint8_t*>(&rec), sizeof(rec)), false);
+    else summary_queue(rec);
+}
+
+// Log one ODR_HZ sample or gap marker. Summaries see every sample. In TRIGGER_MODE only trigger
+// segments reach the log: a segment starts with the pre-trigger ring (at its own sample numbers and times).
+static void log_record(const ImuSample& smp, bool gap, uint32_t t_us) {
+    if (SUMMARY_ENABLE) {
+        SummaryRecord rec;
+        if (summary_feed(smp, gap, rec)) log_summary(rec);
+        if (SUMMARY_ONLY) return;
+    }
+    if (!TRIGGER_MODE) {
+        log_count(log_put(smp, t_us), gap);
         return;
     }
-    last_us += 1000000UL / ODR_HZ;
+    const TrigAction a = trigger_feed(smp, gap, t_us);
+    if (a == TRIG_HOLD) return;
+    if (a == TRIG_START) {
+        log_codec_seek(trig_pre_first());
+        for (uint32_t i = 0; i < trig_pre_count(); ++i) {
+            const TrigEntry& e = trig_pre(i);
+            log_count(log_codec_put(e.s, e.t_us), e.gap);
+        }
+        trigger_pre_clear();
+    }
+    log_count(log_codec_put(smp, t_us), gap);
+    if (a == TRIG_END) log_codec_break();
+}
+
+// Write n gap markers (missed ticks or failed IMU reads)
+static void log_gap(uint32_t n, uint32_t t_us) {
+    const ImuSample gap = { LOG_GAP_WORD, LOG_GAP_WORD, LOG_GAP_WORD, LOG_GAP_WORD, LOG_GAP_WORD, LOG_GAP_WORD };
+    while (n--) log_record(gap, true, t_us);
+}
 
-    int16_t ax, ay, az, gx, gy, gz;
-    if (!imu_read_accel_raw(ax, ay, az)) return;
-    if (!imu_read_gyro_raw(gx, gy, gz)) return;
-    dbg_ax = ax; dbg_ay = ay; dbg_az = az;
-    dbg_gx = gx; dbg_gy = gy; dbg_gz = gz;
+// Record one sample (also kept for the debug overlay)
+static void log_sample(const ImuSample& smp, uint32_t t_us) {
+    dbg_ax = smp.ax; dbg_ay = smp.ay; dbg_az = smp.az;
+    dbg_gx = smp.gx; dbg_gy = smp.gy; dbg_gz = smp.gz;
     dbg_has_sample = true;
     if (DEBUG_MODE) {
         static uint32_t last_dbg_ms = 0;
         uint32_t now_ms = millis();
         if (now_ms - last_dbg_ms >= DEBUG_RAW_PRINT_INTERVAL_MS) {
             last_dbg_ms = now_ms;
-            Serial.printf("DBG_RAW ax:%d ay:%d az:%d gx:%d gy:%d gz:%d\n", ax, ay, az, gx, gy, gz);
+            Serial.printf("DBG_RAW ax:%d ay:%d az:%d gx:%d gy:%d gz:%d\n", smp.ax, smp.ay, smp.az, smp.gx, smp.gy, smp.gz);
         }
     }
-    // Write big-endian (MSB first) like accel
-    ring_buf[ring_pos++] = ax >> 8; ring_buf[ring_pos++] = ax & 0xFF;
-    ring_buf[ring_pos++] = ay >> 8; ring_buf[ring_pos++] = ay & 0xFF;
-    ring_buf[ring_pos++] = az >> 8; ring_buf[ring_pos++] = az & 0xFF;
-    ring_buf[ring_pos++] = gx >> 8; ring_buf[ring_pos++] = gx & 0xFF;
-    ring_buf[ring_pos++] = gy >> 8; ring_buf[ring_pos++] = gy & 0xFF;
-    ring_buf[ring_pos++] = gz >> 8; ring_buf[ring_pos++] = gz & 0xFF;
-    total_samples++;
-    if (ring_pos >= sizeof(ring_buf)) {
-        logFile.write(ring_buf, sizeof(ring_buf));
-        ring_pos = 0;
+    log_record(smp, false, t_us);
+    stream_push(smp);
+}
+
+// One IMU reading at imu_sample_hz() taken at t_us (nullptr = missed / failed). Without decimation it is
+// logged as is; otherwise it feeds the FIR, which yields an ODR_HZ sample every DECIM_FACTOR inputs.
+static void log_input(const ImuSample* smp, uint32_t t_us) {
+    if (DECIM_FACTOR == 1) {
+        if (smp) log_sample(*smp, t_us);
+        else log_gap(1, t_us);
+        return;
+    }
+    ImuSample out;
+    switch (decim_push(smp, out)) {
+        case DECIM_OUT: log_sample(out, t_us); break;
+        case DECIM_GAP: log_gap(1, t_us); break;
+        default: break;
+    }
+}
+
+// n IMU readings missing (missed ticks, FIFO or queue overflow)
+static void log_missing(uint32_t n, uint32_t t_us) {
+    if (DECIM_FACTOR == 1) log_gap(n, t_us);
+    else while (n--) log_input(nullptr, t_us);
+}
+
+// ACQ_TASK: one queued reading, packed on the IO core by the pipeline task (acq_queue.h)
+static void acq_consume(const AcqItem& it) {
+    const uint32_t c0 = stats_now();
+    if (it.gaps) log_missing(it.gaps, it.t_us);
+    log_input(it.ok ? &it.s : nullptr, it.t_us);
+    stats_add(STAT_PACK, c0);
+}
+
+// One IMU tick. due > 1 means the previous (due - 1) ticks were missed.
+static void sample_tick(uint32_t due) {
+    const uint32_t c0 = stats_now();
+    if (due > 1 && !ACQ_TASK) log_missing(due - 1, micros());
+    const uint32_t t_sample_us = micros();
+    ImuSample smp;
+    const uint32_t c_read = stats_now();
+    bool ok = IMU_COMBINED_READ
+        ? imu_read_sample_raw(smp)
+        : (imu_read_accel_raw(smp.ax, smp.ay, smp.az) && imu_read_gyro_raw(smp.gx, smp.gy, smp.gz));
+    const uint32_t i2c_cyc = stats_add(STAT_I2C, c_read);
+    // ACQ_TASK: missed ticks travel with the reading and are packed by acq_consume()
+    if (ACQ_TASK) acq_push(ok ? &smp : nullptr, due - 1, t_sample_us);
+    else log_input(ok ? &smp : nullptr, t_sample_us);
+    if (STATS_ENABLE) {
+        const uint32_t busy = stats_now() - c0;
+        const uint32_t period_us = sample_clock_period_us();
+        if (!ACQ_TASK) stats_record(STAT_PACK, busy - i2c_cyc);
+        stats_on_tick(t_sample_us, due * period_us, period_us, due - 1, busy);
+    }
+    if (ok) perf_on_sample(t_sample_us);
+}
+
+// FIFO mode: `due` ticks elapsed since the last burst. Samples lost to a FIFO
+// overflow are the newest ones, so their gap markers follow the drained samples.
+static void sample_fifo_burst(uint32_t due) {
+    static ImuSample fifo_buf[IMU_FIFO_MAX_FRAMES];
+    const uint32_t t_burst_us = micros();
+    const uint32_t c0 = stats_now();
+    bool overflow = false;
+    size_t n = imu_fifo_read(fifo_buf, IMU_FIFO_MAX_FRAMES, overflow);
+    const uint32_t i2c_cyc = stats_add(STAT_I2C, c0);
+    const uint32_t lost = (overflow && due > n) ? due - (uint32_t)n : 0;
+    if (ACQ_TASK) {
+        for (size_t i = 0; i < n; ++i) acq_push(&fifo_buf[i], 0, t_burst_us);
+        if (lost) acq_push(nullptr, lost - 1, t_burst_us);
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            log_input(&fifo_buf[i], t_burst_us);
+        }
+        if (lost) log_missing(lost, t_burst_us);
+    }
+    if (STATS_ENABLE) {
+        const uint32_t busy = stats_now() - c0;
+        const uint32_t period_us = sample_clock_period_us();
+        if (!ACQ_TASK) stats_record(STAT_PACK, busy - i2c_cyc);
+        stats_on_tick(t_burst_us, due * period_us, due * period_us, lost, busy);
     }
 }
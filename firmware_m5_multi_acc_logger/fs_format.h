@@ -1,32 +1,62 @@
 #pragma once
 #include <LittleFS.h>
+#include <atomic>
 #include "config.h"
+#include "raw_log.h"
 
-// Initialize LittleFS; format if mounting fails
+// Initialize LittleFS; format if mounting fails.
+// LOG_RAW_PARTITION: also scan the raw log partition (LittleFS keeps the session index / checkpoint)
 inline bool fs_init() {
-    if (!LittleFS.begin(false)) {
-        return LittleFS.begin(true);
+    if (!LittleFS.begin(false) && !LittleFS.begin(true)) {
+        return false;
     }
-    return true;
+    return !LOG_RAW_PARTITION || raw_log_mount();
 }
 
-// Format LittleFS explicitly
-inline bool fs_format() {
-    return LittleFS.format();
+// File system capacity helpers.
+// LittleFS.usedBytes() はブロック割り当てを走査するため満杯に近いほど遅い。
+// 走査は起動後の初回、ファイル作成/削除時（fs_usage_invalidate()）と FS_USAGE_CACHE_MS ごとの
+// 再同期だけにし、その間は走査値に追記したバイト数（fs_usage_add()）を足して返す。
+static size_t s_fs_total = 0;
+static size_t s_fs_used = 0;
+static uint32_t s_fs_used_ms = 0;
+static bool s_fs_used_valid = false;
+static std::atomic<uint32_t> s_fs_appended{0};  // bytes appended to LittleFS files (writer task and loop)
+static uint32_t s_fs_appended_scan = 0;         // s_fs_appended at the last scan
+
+inline void fs_usage_invalidate() {
+    s_fs_used_valid = false;
 }
 
-// Create log file for writing; existing file will be truncated
-inline File fs_create_log() {
-    return LittleFS.open(LOG_FILE_NAME, "w");
+// n bytes appended to an open LittleFS file
+inline void fs_usage_add(size_t n) {
+    s_fs_appended.fetch_add((uint32_t)n, std::memory_order_relaxed);
 }
 
-// File system capacity helpers
+// Capacity of the log storage (the raw partition when LOG_RAW_PARTITION)
 inline size_t fs_total_bytes() {
-    return LittleFS.totalBytes();
+    if (LOG_RAW_PARTITION) return raw_log_total_bytes();
+    if (s_fs_total == 0) s_fs_total = LittleFS.totalBytes();
+    return s_fs_total;
 }
 
 inline size_t fs_used_bytes() {
-    return LittleFS.usedBytes();
+    if (LOG_RAW_PARTITION) return raw_log_used_bytes();
+    const uint32_t now_ms = millis();
+    if (!s_fs_used_valid || now_ms - s_fs_used_ms >= FS_USAGE_CACHE_MS) {
+        // Appends racing with the scan are counted twice at most until the next one
+        s_fs_appended_scan = s_fs_appended.load(std::memory_order_relaxed);
+        s_fs_used = LittleFS.usedBytes();
+        s_fs_used_ms = now_ms;
+        s_fs_used_valid = true;
+    }
+    return s_fs_used + (s_fs_appended.load(std::memory_order_relaxed) - s_fs_appended_scan);
+}
+
+// Format LittleFS explicitly
+inline bool fs_format() {
+    fs_usage_invalidate();
+    return LittleFS.format();
 }
 
 inline size_t fs_free_bytes() {
@@ -40,3 +70,162 @@ inline uint8_t fs_used_pct() {
     if (total == 0) return 0;
     return (uint8_t)((fs_used_bytes() * 100) / total);
 }
+
+// --- Log storage: one log per session id ---
+// LittleFS: /L<id>.BIN, LOG_RAW_PARTITION: raw_log.h. どちらも同じバイト列（LogHeader + payload）
+// として読めるので DUMP/DUMPX/HEAD/INFO はバックエンドを意識しない。
+// 記録中のログへの追記はライタ（log_writer.h）だけが行う。
+static const size_t FS_LOG_TOTALS_OFS = 44; // LogHeader::total_samples, dropped_samples follows
+static const size_t FS_PATH_MAX = 20;        // "/L" + up to 10 digits + ".BIN" + NUL
+
+static File s_fs_log;                // LittleFS: log being appended
+static uint32_t s_fs_log_id = 0;
+static uint32_t s_fs_log_bytes = 0;
+static bool s_fs_log_full = false;   // an append failed: later ones are refused (no hole in the log)
+
+inline void fs_log_path(uint32_t id, char* out, size_t n) {
+    snprintf(out, n, "/L%06u.BIN", (unsigned)id);
+}
+
+// Create log `id` holding the header and keep it open for appending
+inline bool fs_log_create(uint32_t id, const uint8_t* hdr, size_t n) {
+    fs_usage_invalidate();
+    s_fs_log_id = id;
+    s_fs_log_bytes = n;
+    s_fs_log_full = false;
+    if (LOG_RAW_PARTITION) {
+        return raw_log_open(id) && raw_log_append(hdr, n);
+    }
+    char path[FS_PATH_MAX];
+    fs_log_path(id, path, sizeof(path));
+    File f = LittleFS.open(path, "w");
+    if (!f) return false;
+    f.write(hdr, n);
+    f.close();
+    // Reopen for append to ensure subsequent payload is not overwriting header
+    s_fs_log = LittleFS.open(path, "a");
+    return (bool)s_fs_log;
+}
+
+// False if the bytes did not (all) reach the log, e.g. the filesystem / raw partition is full.
+// fs_log_bytes() only counts what was written; after a failure every later append fails too.
+inline bool fs_log_append(const uint8_t* data, size_t n) {
+    if (s_fs_log_full) return false;
+    size_t done = 0;
+    if (LOG_RAW_PARTITION) {
+        if (raw_log_append(data, n)) done = n;
+    } else if (s_fs_log) {
+        done = s_fs_log.write(data, n);
+        fs_usage_add(done);
+    }
+    s_fs_log_bytes += done;
+    if (done != n) s_fs_log_full = true;
+    return done == n;
+}
+
+// Make the appended bytes power-loss safe (raw sectors are final once programmed)
+inline void fs_log_commit() {
+    if (!LOG_RAW_PARTITION && s_fs_log) s_fs_log.flush();
+}
+
+// Size of the log being appended
+inline uint32_t fs_log_bytes() {
+    return s_fs_log_bytes;
+}
+
+// Store the final counts of log `id` (LogHeader::total_samples / dropped_samples)
+inline bool fs_log_set_totals(uint32_t id, uint32_t total, uint32_t dropped) {
+    if (LOG_RAW_PARTITION) return raw_log_set_totals(id, total, dropped);
+    char path[FS_PATH_MAX];
+    fs_log_path(id, path, sizeof(path));
+    File f = LittleFS.open(path, "r+");
+    if (!f) return false;
+    const uint32_t v[2] = { total, dropped };
+    f.seek(FS_LOG_TOTALS_OFS);
+    f.write(reinterpret_cast<const uint8_t*>(v), sizeof(v));
+    f.close();
+    return true;
+}
+
+// Close the log being appended and store its final counts
+inline void fs_log_finish(uint32_t total, uint32_t dropped) {
+    if (LOG_RAW_PARTITION) {
+        raw_log_finish(total, dropped);
+    } else if (s_fs_log) {
+        s_fs_log.close();
+        fs_log_set_totals(s_fs_log_id, total, dropped);
+    }
+    fs_usage_invalidate();
+}
+
+// Summary stream of session `id` (summary.h). Always a LittleFS file, also with LOG_RAW_PARTITION.
+inline void fs_sum_path(uint32_t id, char* out, size_t n) {
+    snprintf(out, n, "/L%06u.SUM", (unsigned)id);
+}
+
+inline void fs_sum_remove(uint32_t id) {
+    char path[FS_PATH_MAX];
+    fs_sum_path(id, path, sizeof(path));
+    if (LittleFS.exists(path)) LittleFS.remove(path);
+}
+
+inline bool fs_log_exists(uint32_t id) {
+    if (LOG_RAW_PARTITION) return raw_log_exists(id);
+    char path[FS_PATH_MAX];
+    fs_log_path(id, path, sizeof(path));
+    return LittleFS.exists(path);
+}
+
+inline void fs_log_remove(uint32_t id) {
+    if (LOG_RAW_PARTITION) {
+        raw_log_remove(id);
+    } else {
+        char path[FS_PATH_MAX];
+        fs_log_path(id, path, sizeof(path));
+        LittleFS.remove(path);
+    }
+    fs_sum_remove(id);
+    fs_usage_invalidate();
+}
+
+// Random-access reader of a stored log
+struct FsLogReader {
+    uint32_t id;
+    uint32_t size;
+    File f;
+};
+
+inline bool fs_log_open(FsLogReader& r, uint32_t id) {
+    r.id = id;
+    if (LOG_RAW_PARTITION) {
+        r.size = raw_log_size(id);
+        return raw_log_exists(id);
+    }
+    char path[FS_PATH_MAX];
+    fs_log_path(id, path, sizeof(path));
+    r.f = LittleFS.open(path, "r");
+    r.size = r.f ? r.f.size() : 0;
+    return (bool)r.f;
+}
+
+inline size_t fs_log_read(FsLogReader& r, uint32_t off, uint8_t* buf, size_t n) {
+    if (!LOG_RAW_PARTITION) {
+        if (!r.f || !r.f.seek(off)) return 0;
+        return r.f.read(buf, n);
+    }
+    n = raw_log_read(r.id, off, buf, n);
+    // The header on flash still says "recording"; overlay the counts from the closing sector
+    uint32_t v[2];
+    if (off < FS_LOG_TOTALS_OFS + sizeof(v) && raw_log_totals(r.id, v[0], v[1])) {
+        const uint8_t* src = reinterpret_cast<const uint8_t*>(v);
+        for (size_t i = 0; i < sizeof(v); ++i) {
+            const uint32_t p = FS_LOG_TOTALS_OFS + i;
+            if (p >= off && p < off + n) buf[p - off] = src[i];
+        }
+    }
+    return n;
+}
+
+inline void fs_log_close(FsLogReader& r) {
+    if (r.f) r.f.close();
+}
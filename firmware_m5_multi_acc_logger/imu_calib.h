@@ -0,0 +1,235 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "imu_driver.h"
+#include "nv_settings.h"
+#include "still_calib.h"
+
+// IMU calibration kept across reboots (NVS), serial `CALIB`.
+// 起動時に imu_calib_load() が NVS の値を読めれば、校正を待たずにすぐ記録を始められる。
+// 記録していない間は imu_calib_poll() がバックグラウンドで IMU を読み、静止していればジャイロの
+// バイアスを推定・追従する（still_calib.h）。記録中は止まるので、1つのログのバイアスは一定。
+// 加速度のオフセット/スケールは任意の6姿勢手順：各軸を +1g / -1g の向きにして静止させ `CALIB ACC` を
+// 送る。6姿勢そろうと軸ごとに offset = (p + n) / 2、1g = (p - n) / 2（生カウント）を求めて保存する。
+// ログの加速度は生カウントのまま（ヘッダに空きが無い）で、値は CALIB / INFO から PC 側で使う。
+// NVS のキーは efuse MAC から作る（別の個体にコピーされた値は使わない）。IMU 種別やレンジが
+// 変わった保存値は捨てる（バイアスはレンジごとのカウント）。`CONFIG SET` でレンジを変えたときは
+// imu_calib_on_config() が保存値を新しいレンジのカウントに換算して書き直す。
+
+constexpr uint16_t IMU_CALIB_VER = 1;
+
+struct __attribute__((packed)) ImuCalibBlob {
+    uint16_t version;       // IMU_CALIB_VER
+    uint16_t imu_type;
+    uint16_t range_g;
+    uint16_t gyro_range_dps;
+    uint8_t gyro_valid;
+    uint8_t acc_valid;
+    int32_t gyro_bias[3];   // raw counts
+    int16_t acc_offset[3];  // raw counts
+    int16_t acc_one_g[3];   // raw counts per 1 g
+};
+
+enum ImuCalSrc : uint8_t {
+    IMU_CAL_NONE = 0,   // not calibrated
+    IMU_CAL_NVS,        // stored value from an earlier boot
+    IMU_CAL_STILL       // background estimate of this boot
+};
+static const char* const IMU_CAL_SRC_NAMES[] = { "none", "nvs", "still" };
+static const char* const IMU_CAL_POSE_NAMES[6] = { "+x", "-x", "+y", "-y", "+z", "-z" };
+
+// Thresholds in raw counts of the given ranges (the running configuration: _imu_calib_params())
+constexpr StillCalibParams imu_still_params(uint16_t range_g, uint16_t gyro_dps) {
+    return StillCalibParams{
+        CALIB_WINDOW, CALIB_MIN_WINDOWS, CALIB_TRACK_SHIFT,
+        (uint32_t)(CALIB_GYRO_STD_DPS * 32768.0f / (float)gyro_dps + 0.5f),
+        (uint32_t)(32768UL * CALIB_ACC_STD_MG / (1000UL * range_g)),
+    };
+}
+constexpr int32_t imu_calib_save_delta(uint16_t gyro_dps) {
+    return (int32_t)(CALIB_SAVE_DELTA_DPS * 32768.0f / (float)gyro_dps + 0.5f);
+}
+static_assert(CALIB_WINDOW >= 2 && CALIB_WINDOW <= 4096, "CALIB_WINDOW must be 2..4096");
+static_assert(CALIB_MIN_WINDOWS >= 1 && CALIB_TRACK_SHIFT < 16, "CALIB_MIN_WINDOWS / CALIB_TRACK_SHIFT out of range");
+static_assert(imu_calib_save_delta(2000) >= 1, "CALIB_SAVE_DELTA_DPS is below one count");
+// Longer without a read (recording, dump, slow loop) and the window in progress is dropped
+constexpr uint32_t IMU_CALIB_GAP_MS = (CALIB_POLL_MS * 4u > 100u) ? CALIB_POLL_MS * 4u : 100u;
+
+static StillCalib s_cal;
+static StillCalibParams s_cal_params = imu_still_params(RANGE_G, GYRO_RANGE_DPS);
+static int32_t s_cal_save_delta = imu_calib_save_delta(GYRO_RANGE_DPS);
+static ImuCalibBlob s_cal_saved = {};  // what NVS holds (version 0: nothing)
+static uint8_t s_cal_src = IMU_CAL_NONE;
+static uint32_t s_cal_read_ms = 0;     // last background read
+static uint32_t s_cal_saved_ms = 0;    // last write of this boot
+static bool s_cal_wrote = false;
+static int32_t s_cal_pose[6][3];       // CALIB ACC: accel means per orientation
+static uint8_t s_cal_pose_mask = 0;
+
+inline void _imu_calib_key(char (&key)[16]) {
+    snprintf(key, sizeof(key), "cal%012llx", (unsigned long long)(ESP.getEfuseMac() & 0xFFFFFFFFFFFFULL));
+}
+
+inline void _imu_calib_params() {
+    const DevConfig& c = imu_config();
+    s_cal_params = imu_still_params(c.range_g, c.gyro_dps);
+    s_cal_save_delta = imu_calib_save_delta(c.gyro_dps);
+}
+
+// Current calibration as stored (accel part kept from the stored value)
+inline ImuCalibBlob _imu_calib_blob() {
+    ImuCalibBlob b = s_cal_saved;
+    b.version = IMU_CALIB_VER;
+    b.imu_type = ImuDriver::TYPE;
+    b.range_g = imu_config().range_g;
+    b.gyro_range_dps = imu_config().gyro_dps;
+    b.gyro_valid = imu_is_calibrated() ? 1 : 0;
+    if (b.gyro_valid) {
+        int16_t bx, by, bz;
+        imu_gyro_bias(bx, by, bz);
+        b.gyro_bias[0] = bx; b.gyro_bias[1] = by; b.gyro_bias[2] = bz;
+    }
+    return b;
+}
+
+inline bool _imu_calib_store(const ImuCalibBlob& b) {
+    char key[16];
+    _imu_calib_key(key);
+    if (!nv_put_bytes(key, &b, sizeof(b))) return false;
+    s_cal_saved = b;
+    s_cal_saved_ms = millis();
+    s_cal_wrote = true;
+    return true;
+}
+
+// setup(), after imu_init(). True when a stored calibration for this device / IMU / ranges was applied.
+inline bool imu_calib_load() {
+    still_calib_reset(s_cal);
+    _imu_calib_params();
+    char key[16];
+    _imu_calib_key(key);
+    ImuCalibBlob b;
+    if (!nv_get_bytes(key, &b, sizeof(b)) || b.version != IMU_CALIB_VER || b.imu_type != ImuDriver::TYPE
+        || b.range_g != imu_config().range_g || b.gyro_range_dps != imu_config().gyro_dps) {
+        s_cal_saved = {};
+        return false;
+    }
+    s_cal_saved = b;
+    if (!b.gyro_valid) return false;
+    imu_set_gyro_bias(b.gyro_bias[0], b.gyro_bias[1], b.gyro_bias[2]);
+    still_calib_seed(s_cal, b.gyro_bias[0], b.gyro_bias[1], b.gyro_bias[2]);
+    s_cal_src = IMU_CAL_NVS;
+    return true;
+}
+
+// loop() while not recording: one read every CALIB_POLL_MS. Returns true when the device has
+// just become calibrated (first estimate without a stored value).
+inline bool imu_calib_poll() {
+    if (!CALIB_BG_ENABLE) return false;
+    const uint32_t now = millis();
+    const uint32_t dt = now - s_cal_read_ms;
+    if (dt < CALIB_POLL_MS) return false;
+    s_cal_read_ms = now;
+    // A pause in the trace (recording, dump) must not end up inside one window
+    if (dt > IMU_CALIB_GAP_MS) still_calib_restart(s_cal);
+    ImuSample s;
+    if (!ImuDriver::read_sample(s, nullptr)) {
+        still_calib_restart(s_cal);
+        return false;
+    }
+    if (!still_calib_feed(s_cal, s_cal_params, s.ax, s.ay, s.az, s.gx, s.gy, s.gz)) return false;
+    const bool first = !imu_is_calibrated();
+    const int32_t b[3] = { still_calib_bias(s_cal, 0), still_calib_bias(s_cal, 1), still_calib_bias(s_cal, 2) };
+    imu_set_gyro_bias(b[0], b[1], b[2]);
+    s_cal_src = IMU_CAL_STILL;
+    // Rewrite NVS only for a real change, and not more often than CALIB_SAVE_MIN_MS
+    bool moved = !s_cal_saved.version || !s_cal_saved.gyro_valid;
+    for (uint8_t k = 0; k < 3 && !moved; ++k) moved = abs(b[k] - s_cal_saved.gyro_bias[k]) >= s_cal_save_delta;
+    if (moved && (!s_cal_wrote || now - s_cal_saved_ms >= CALIB_SAVE_MIN_MS)) _imu_calib_store(_imu_calib_blob());
+    return first;
+}
+
+// `CALIB ACC`: record the accel mean of the last still window for the orientation it shows.
+// Returns the pose (0..5 = +x,-x,+y,-y,+z,-z), -1 when the device is not still right now.
+// The sixth pose computes and stores offset / 1 g for each axis.
+inline int imu_calib_acc_capture() {
+    if (!s_cal.still || millis() - s_cal_read_ms > IMU_CALIB_GAP_MS) return -1;
+    uint8_t axis = 0;
+    for (uint8_t k = 1; k < 3; ++k) {
+        if (abs(s_cal.acc_mean[k]) > abs(s_cal.acc_mean[axis])) axis = k;
+    }
+    const int pose = axis * 2 + (s_cal.acc_mean[axis] < 0 ? 1 : 0);
+    for (uint8_t k = 0; k < 3; ++k) s_cal_pose[pose][k] = s_cal.acc_mean[k];
+    s_cal_pose_mask |= (uint8_t)(1u << pose);
+    if (s_cal_pose_mask == 0x3F) {
+        ImuCalibBlob b = _imu_calib_blob();
+        for (uint8_t k = 0; k < 3; ++k) {
+            const int32_t p = s_cal_pose[k * 2][k], n = s_cal_pose[k * 2 + 1][k];
+            b.acc_offset[k] = imu_clamp16((p + n) / 2);
+            b.acc_one_g[k] = imu_clamp16((p - n) / 2);
+        }
+        b.acc_valid = 1;
+        _imu_calib_store(b);
+        s_cal_pose_mask = 0;
+    }
+    return pose;
+}
+
+inline uint8_t imu_calib_pose_count() {
+    return (uint8_t)__builtin_popcount(s_cal_pose_mask);
+}
+
+// `CALIB CLEAR`: forget the stored and the estimated calibration
+inline void imu_calib_clear() {
+    char key[16];
+    _imu_calib_key(key);
+    nv_remove(key);
+    s_cal_saved = {};
+    s_cal_wrote = false;
+    still_calib_reset(s_cal);
+    imu_clear_gyro_bias();
+    s_cal_src = IMU_CAL_NONE;
+    s_cal_pose_mask = 0;
+}
+
+// After imu_config_set() changed the ranges (the gyro bias is already rescaled): thresholds for the new
+// counts, the estimate restarts from the rescaled bias and the stored value is rewritten for the new ranges
+inline void imu_calib_on_config(uint16_t old_range_g, uint16_t old_gyro_dps) {
+    const DevConfig& c = imu_config();
+    if (c.range_g == old_range_g && c.gyro_dps == old_gyro_dps) return;
+    _imu_calib_params();
+    still_calib_reset(s_cal);
+    s_cal_pose_mask = 0;
+    if (imu_is_calibrated()) {
+        int16_t bx, by, bz;
+        imu_gyro_bias(bx, by, bz);
+        still_calib_seed(s_cal, bx, by, bz);
+    }
+    if (!s_cal_saved.version) return;
+    ImuCalibBlob b = _imu_calib_blob();
+    for (uint8_t k = 0; k < 3; ++k) {
+        b.acc_offset[k] = imu_clamp16((int32_t)b.acc_offset[k] * old_range_g / c.range_g);
+        b.acc_one_g[k] = imu_clamp16((int32_t)b.acc_one_g[k] * old_range_g / c.range_g);
+    }
+    _imu_calib_store(b);
+}
+
+inline uint8_t imu_calib_src() { return s_cal_src; }
+
+// "CALIB src:<none|nvs|still> gyro:<bx>,<by>,<bz> still:<still windows>/<windows> saved:<0|1>
+//  acc:<ox>,<oy>,<oz>/<1g x>,<1g y>,<1g z> poses:<n>/6"   (raw counts, acc:- when not calibrated)
+inline void imu_calib_print(Print& out) {
+    int16_t bx, by, bz;
+    imu_gyro_bias(bx, by, bz);
+    out.printf("CALIB src:%s gyro:%d,%d,%d still:%u/%u saved:%u acc:", IMU_CAL_SRC_NAMES[s_cal_src],
+               (int)bx, (int)by, (int)bz, (unsigned)s_cal.still_windows, (unsigned)s_cal.windows,
+               (unsigned)(s_cal_saved.version != 0));
+    if (s_cal_saved.acc_valid) {
+        out.printf("%d,%d,%d/%d,%d,%d", (int)s_cal_saved.acc_offset[0], (int)s_cal_saved.acc_offset[1],
+                   (int)s_cal_saved.acc_offset[2], (int)s_cal_saved.acc_one_g[0], (int)s_cal_saved.acc_one_g[1],
+                   (int)s_cal_saved.acc_one_g[2]);
+    } else {
+        out.print("-");
+    }
+    out.printf(" poses:%u/6\n", (unsigned)imu_calib_pose_count());
+}
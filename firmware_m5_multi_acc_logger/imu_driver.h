@@ -0,0 +1,208 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "board_hal.h"
+#include "dev_config.h"
+#include "nv_settings.h"
+
+// Compile-time IMU driver interface.
+// IMU ごとの差分は static メンバだけの struct 1つ（ドライバ）にまとめ、ここで ImuDriver として1回だけ選ぶ。
+// サンプリング経路の呼び出しはすべて ImuDriver:: への静的呼び出し（inline）なので実行時の分岐は無い。
+// ODR/レンジの対応表は constexpr。既定値（config.h）で対応していない RANGE_G / GYRO_RANGE_DPS
+// （ヘッダの lsb_per_g と実際のスケールがずれる）や、センサより速い IMU_SAMPLE_HZ（同じ値を重複して
+// 読む）は static_assert で止める。実行時の設定（`CONFIG SET`、dev_config.h）は同じ表で
+// imu_config_set() が検査し、init() を再実行して適用する。init() はレジスタ値（最も近い ODR への
+// 丸めを含む）を imu_config() から求めるので、サンプリング経路には設定の分岐も割り算も増えない。
+//
+// Driver concept (imu_sh200q.h, imu_mpu6886_unified.h, imu_mock.h; included from here only):
+//   static constexpr uint16_t TYPE;                     LogHeader::imu_type (IMU_TYPE_*)
+//   static constexpr const char* NAME; BUS_NAME;        BOOT / debug overlay
+//   static constexpr uint8_t ADDR;                      7-bit I2C address
+//   static constexpr uint16_t ACC_RANGES_G[];           supported ranges (RANGE_G must match one)
+//   static constexpr uint16_t GYRO_RANGES_DPS[];        supported ranges (GYRO_RANGE_DPS must match one)
+//   static constexpr uint16_t MAX_ODR_HZ;               fastest rate of new samples
+//   static constexpr uint16_t DLPF_HZ[];                selectable low-pass bandwidths (CONFIG dlpf, nearest)
+//   static constexpr uint16_t odr_hz(uint16_t hz);      rate the sensor runs at when configured for hz (0: not a whole Hz)
+//   static constexpr bool HAS_FIFO;  static constexpr size_t FIFO_MAX_FRAMES;
+//   static bool init();                                 configures imu_config() (re-run on CONFIG SET)
+//   static uint16_t dlpf_hz(bool fifo);                 bandwidth init() / fifo_begin() set (0: unknown)
+//   static bool read_sample(ImuSample& s, int16_t* temp_raw);     one burst, raw counts (temp_raw optional)
+//   static bool read_accel(int16_t& x, int16_t& y, int16_t& z);
+//   static bool read_gyro(int16_t& x, int16_t& y, int16_t& z);
+//   static bool fifo_begin();  static void fifo_end();
+//   static size_t fifo_read(ImuSample* out, size_t max, bool& overflow);
+//   static void print_regs(Print& out);                 REGS command
+// ジャイロのバイアス補正はこのファイルの共通部分が行う（ドライバは生カウントを返す）。
+// 新しい IMU は同じ形の struct を imu_<name>.h に書き、下の選択に分岐を1つ足す。
+
+// --- constexpr table helpers (C++11 constexpr: recursion only) ---
+template <size_t N>
+constexpr bool imu_table_has(const uint16_t (&t)[N], uint16_t v, size_t i = 0) {
+    return (i < N) && (t[i] == v || imu_table_has(t, v, i + 1));
+}
+// Index of v (N if absent)
+template <size_t N>
+constexpr size_t imu_table_index(const uint16_t (&t)[N], uint16_t v, size_t i = 0) {
+    return (i >= N || t[i] == v) ? i : imu_table_index(t, v, i + 1);
+}
+constexpr uint32_t imu_abs_diff(uint32_t a, uint32_t b) { return (a > b) ? a - b : b - a; }
+// Index of the entry nearest to hz (the earlier one on a tie)
+template <size_t N>
+constexpr size_t imu_table_nearest(const uint16_t (&t)[N], uint16_t hz, size_t i = 1, size_t best = 0) {
+    return (i >= N) ? best
+         : imu_table_nearest(t, hz, i + 1, (imu_abs_diff(hz, t[i]) < imu_abs_diff(hz, t[best])) ? i : best);
+}
+
+// Runtime configuration, read by the drivers' init(). Only changed while not recording.
+static DevConfig s_imu_cfg = { ODR_HZ, RANGE_G, GYRO_RANGE_DPS, IMU_DLPF_HZ };
+
+inline const DevConfig& imu_config() { return s_imu_cfg; }
+// Rate the IMU is configured for and read at (odr * DECIM_FACTOR)
+inline uint16_t imu_sample_hz() { return (uint16_t)(s_imu_cfg.odr_hz * DECIM_FACTOR); }
+
+// --- Driver selection (the only IMU #if) ---
+#if defined(IMU_DRIVER_MOCK)
+#include "imu_mock.h"
+typedef MockImuDriver ImuDriver;
+#elif HAL_IMU_IS_SH200Q
+#include "imu_sh200q.h"
+typedef Sh200qDriver ImuDriver;
+#else
+#include "imu_mpu6886_unified.h"
+typedef Mpu6886Driver ImuDriver;
+#endif
+
+constexpr size_t IMU_FIFO_MAX_FRAMES = ImuDriver::FIFO_MAX_FRAMES;
+
+static_assert(imu_table_has(ImuDriver::ACC_RANGES_G, RANGE_G), "RANGE_G is not supported by this IMU");
+static_assert(imu_table_has(ImuDriver::GYRO_RANGES_DPS, GYRO_RANGE_DPS), "GYRO_RANGE_DPS is not supported by this IMU");
+static_assert(IMU_SAMPLE_HZ >= 1 && IMU_SAMPLE_HZ <= ImuDriver::MAX_ODR_HZ, "ODR_HZ * DECIM_FACTOR is faster than this IMU samples");
+static_assert(ODR_HZ <= ODR_HZ_MAX, "ODR_HZ is above ODR_HZ_MAX");
+
+static_assert(!IMU_FIFO_MODE || ImuDriver::HAS_FIFO, "IMU_FIFO_MODE needs an IMU with a FIFO");
+static_assert(!IMU_FIFO_MODE || IMU_FIFO_MAX_FRAMES >= 2, "IMU FIFO too small");
+static_assert(!IMU_FIFO_MODE || (ImuDriver::odr_hz(IMU_SAMPLE_HZ) != 0 && ImuDriver::odr_hz(IMU_SAMPLE_HZ) % DECIM_FACTOR == 0),
+              "IMU_FIFO_MODE: the sensor cannot run at a whole-Hz rate for ODR_HZ * DECIM_FACTOR");
+
+// --- Common part: gyro bias, bias-corrected reads (calibration: imu_calib.h) ---
+
+static int32_t s_gbias_x = 0, s_gbias_y = 0, s_gbias_z = 0;
+static bool s_imu_calibrated = false;
+
+inline bool imu_init() { return ImuDriver::init(); }
+inline bool imu_is_calibrated() { return s_imu_calibrated; }
+
+// Set by imu_calib.h (stored calibration or background estimate); only while not recording,
+// so one log uses one bias (recorded in its header)
+inline void imu_set_gyro_bias(int32_t bx, int32_t by, int32_t bz) {
+    s_gbias_x = bx; s_gbias_y = by; s_gbias_z = bz;
+    s_imu_calibrated = true;
+}
+
+inline void imu_clear_gyro_bias() {
+    s_gbias_x = s_gbias_y = s_gbias_z = 0;
+    s_imu_calibrated = false;
+}
+
+// Calibration bias in raw counts (recorded in the log header)
+inline void imu_gyro_bias(int16_t& bx, int16_t& by, int16_t& bz) {
+    bx = imu_clamp16(s_gbias_x); by = imu_clamp16(s_gbias_y); bz = imu_clamp16(s_gbias_z);
+}
+
+// Subtract bias, keeping full-resolution counts (format 0x0202+); dps は PC 側で lsb_per_dps から換算
+inline void imu_gyro_correct(int16_t& gx, int16_t& gy, int16_t& gz) {
+    gx = imu_clamp16((int32_t)gx - s_gbias_x);
+    gy = imu_clamp16((int32_t)gy - s_gbias_y);
+    gz = imu_clamp16((int32_t)gz - s_gbias_z);
+}
+
+inline bool imu_read_accel_raw(int16_t& ax, int16_t& ay, int16_t& az) {
+    return ImuDriver::read_accel(ax, ay, az);
+}
+
+inline bool imu_read_gyro_raw(int16_t& gx, int16_t& gy, int16_t& gz) {
+    if (!ImuDriver::read_gyro(gx, gy, gz)) return false;
+    imu_gyro_correct(gx, gy, gz);
+    return true;
+}
+
+// Accel and gyro of the same sensor update in one burst. temp_raw is optional.
+inline bool imu_read_sample_raw(ImuSample& s, int16_t* temp_raw = nullptr) {
+    if (!ImuDriver::read_sample(s, temp_raw)) return false;
+    imu_gyro_correct(s.gx, s.gy, s.gz);
+    return true;
+}
+
+// --- FIFO burst mode ---
+// Rate the sensor actually produces for imu_sample_hz() (FIFO mode timeline)
+inline uint16_t imu_fifo_odr_hz() { return ImuDriver::odr_hz(imu_sample_hz()); }
+inline bool imu_fifo_begin() { return ImuDriver::fifo_begin(); }
+inline void imu_fifo_end() { ImuDriver::fifo_end(); }
+
+// Drain up to max samples. overflow=true if the FIFO filled since the last call.
+inline size_t imu_fifo_read(ImuSample* out, size_t max, bool& overflow) {
+    const size_t n = ImuDriver::fifo_read(out, max, overflow);
+    for (size_t i = 0; i < n; ++i) imu_gyro_correct(out[i].gx, out[i].gy, out[i].gz);
+    return n;
+}
+
+// --- Runtime configuration (serial CONFIG) ---
+inline uint16_t _imu_odr_fn(uint16_t hz) { return ImuDriver::odr_hz(hz); }
+
+// What CONFIG SET may choose on this IMU. FIFO mode logs at the sensor's own rate.
+inline DevConfigLimits imu_config_limits() {
+    DevConfigLimits l;
+    l.acc_ranges = ImuDriver::ACC_RANGES_G;
+    l.n_acc = sizeof(ImuDriver::ACC_RANGES_G) / sizeof(ImuDriver::ACC_RANGES_G[0]);
+    l.gyro_ranges = ImuDriver::GYRO_RANGES_DPS;
+    l.n_gyro = sizeof(ImuDriver::GYRO_RANGES_DPS) / sizeof(ImuDriver::GYRO_RANGES_DPS[0]);
+    l.dlpf_hz = ImuDriver::DLPF_HZ;
+    l.n_dlpf = sizeof(ImuDriver::DLPF_HZ) / sizeof(ImuDriver::DLPF_HZ[0]);
+    l.max_sample_hz = ImuDriver::MAX_ODR_HZ;
+    l.max_odr_hz = ODR_HZ_MAX;
+    l.decim = DECIM_FACTOR;
+    l.odr_fn = IMU_FIFO_MODE ? _imu_odr_fn : nullptr;
+    return l;
+}
+
+// Validate c (rounded in place) and make it the running configuration: init() runs again with it.
+// A gyro bias follows a new gyro range (counts scale with 1/range). Not while recording.
+inline DevConfigErr imu_config_set(DevConfig& c, bool* init_ok = nullptr) {
+    const DevConfigErr e = dev_config_check(c, imu_config_limits());
+    if (e != DEVCFG_OK) return e;
+    if (c.gyro_dps != s_imu_cfg.gyro_dps && s_imu_calibrated) {
+        const int32_t from = s_imu_cfg.gyro_dps, to = c.gyro_dps;
+        s_gbias_x = (s_gbias_x * from + (s_gbias_x < 0 ? -to : to) / 2) / to;
+        s_gbias_y = (s_gbias_y * from + (s_gbias_y < 0 ? -to : to) / 2) / to;
+        s_gbias_z = (s_gbias_z * from + (s_gbias_z < 0 ? -to : to) / 2) / to;
+    }
+    s_imu_cfg = c;
+    const bool ok = ImuDriver::init();
+    if (init_ok) *init_ok = ok;
+    return e;
+}
+
+// NVS: the configuration CONFIG SET saved (key "devcfg"), checked again against this build's tables
+constexpr DevConfig IMU_CONFIG_DEFAULT = { ODR_HZ, RANGE_G, GYRO_RANGE_DPS, IMU_DLPF_HZ };
+
+// setup(), before imu_init(): stored configuration, else the config.h defaults
+inline void imu_config_load() {
+    DevConfig c;
+    if (nv_get_bytes("devcfg", &c, sizeof(c)) && dev_config_check(c, imu_config_limits()) == DEVCFG_OK) {
+        s_imu_cfg = c;
+        return;
+    }
+    c = IMU_CONFIG_DEFAULT;
+    if (dev_config_check(c, imu_config_limits()) == DEVCFG_OK) s_imu_cfg = c;
+}
+
+inline bool imu_config_save() {
+    return nv_put_bytes("devcfg", &s_imu_cfg, sizeof(s_imu_cfg));
+}
+
+// Back to the config.h defaults (forgets the stored configuration); c receives them
+inline DevConfigErr imu_config_reset(DevConfig& c, bool* init_ok = nullptr) {
+    nv_remove("devcfg");
+    c = IMU_CONFIG_DEFAULT;
+    return imu_config_set(c, init_ok);
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "board_hal.h"
+
+// Synthetic IMU (build flag -DIMU_DRIVER_MOCK); driver for imu_driver.h, included from there.
+// I2C を使わず、静止姿勢（+1g on Z）に MOCK_BURST_MS / MOCK_PERIOD_MS ごとの振動（三角波）と
+// 小さな雑音（固定シードの xorshift）を足した値を返す。init() からの読み出し順が同じなら値も同じ。センサ無しで
+// サンプリング～記録パイプラインの負荷を PERF で測ったり、圧縮・トリガ・サマリーを
+// 同じ入力で比べたりする用途。FIFO は前回の読み出しからの経過時間分のフレームを返す。
+
+constexpr uint32_t MOCK_PERIOD_MS = 10000;
+constexpr uint32_t MOCK_BURST_MS = 2000;
+constexpr uint16_t MOCK_VIB_HZ = 8;
+constexpr int32_t MOCK_VIB_MG = 300;
+constexpr int32_t MOCK_NOISE = 8;  // counts (peak)
+
+struct MockImuDriver {
+    static constexpr uint16_t TYPE = IMU_TYPE_MOCK;
+    static constexpr const char* NAME = "MOCK";
+    static constexpr const char* BUS_NAME = "-";
+    static constexpr uint8_t ADDR = 0x00;
+    static constexpr uint16_t ACC_RANGES_G[] = { 2, 4, 8, 16 };
+    static constexpr uint16_t GYRO_RANGES_DPS[] = { 125, 250, 500, 1000, 2000 };
+    static constexpr uint16_t MAX_ODR_HZ = 8000;
+    static constexpr uint16_t DLPF_HZ[] = { 5, 10, 20, 50, 100, 200 };  // reported only
+    static constexpr bool HAS_FIFO = true;
+    static constexpr size_t FIFO_MAX_FRAMES = 64;
+
+    static constexpr uint16_t odr_hz(uint16_t hz) { return hz; }
+
+    static bool init();
+    static uint16_t dlpf_hz(bool) { return imu_config().dlpf_hz; }
+    static bool read_sample(ImuSample& s, int16_t* temp_raw);
+    static bool read_accel(int16_t& x, int16_t& y, int16_t& z);
+    static bool read_gyro(int16_t& x, int16_t& y, int16_t& z);
+    static bool fifo_begin();
+    static void fifo_end();
+    static size_t fifo_read(ImuSample* out, size_t max, bool& overflow);
+    static void print_regs(Print& out);
+};
+constexpr uint16_t MockImuDriver::ACC_RANGES_G[];
+constexpr uint16_t MockImuDriver::GYRO_RANGES_DPS[];
+constexpr uint16_t MockImuDriver::DLPF_HZ[];
+static_assert(MOCK_PERIOD_MS >= 1000, "MOCK_PERIOD_MS too short");
+
+// Scaled to imu_config() by init()
+static int32_t s_mock_one_g = 32768 / RANGE_G;
+static int32_t s_mock_vib = 0;
+static uint32_t s_mock_period = 1;
+static uint32_t s_mock_burst = 0;
+static uint32_t s_mock_vib_period = 2;
+static uint16_t s_mock_hz = IMU_SAMPLE_HZ;
+
+static uint32_t s_mock_n = 0;          // next sample number
+static uint32_t s_mock_rng = 1;
+static uint32_t s_mock_fifo_us = 0;
+static uint64_t s_mock_fifo_acc = 0;   // elapsed us * sample rate not yet returned as frames
+static ImuSample s_mock_last;
+static bool s_mock_accel_read = false;
+
+inline int16_t _mock_noise() {
+    // xorshift32
+    s_mock_rng ^= s_mock_rng << 13;
+    s_mock_rng ^= s_mock_rng >> 17;
+    s_mock_rng ^= s_mock_rng << 5;
+    return (int16_t)((int32_t)(s_mock_rng % (2 * MOCK_NOISE + 1)) - MOCK_NOISE);
+}
+
+inline void _mock_next(ImuSample& s) {
+    int32_t vib = 0;
+    if (s_mock_n % s_mock_period < s_mock_burst) {
+        // Triangle wave in [-vib, vib]
+        const int32_t ph = (int32_t)(s_mock_n % s_mock_vib_period);
+        const int32_t half = (int32_t)s_mock_vib_period / 2;
+        vib = (ph < half) ? -s_mock_vib + 2 * s_mock_vib * ph / half
+                          : s_mock_vib - 2 * s_mock_vib * (ph - half) / ((int32_t)s_mock_vib_period - half);
+    }
+    s.ax = imu_clamp16(vib + _mock_noise());
+    s.ay = imu_clamp16(vib / 2 + _mock_noise());
+    s.az = imu_clamp16(s_mock_one_g + _mock_noise());
+    s.gx = imu_clamp16(vib / 4 + _mock_noise());
+    s.gy = _mock_noise();
+    s.gz = _mock_noise();
+    s_mock_n++;
+}
+
+inline bool MockImuDriver::init() {
+    const DevConfig& c = imu_config();
+    s_mock_hz = imu_sample_hz();
+    s_mock_one_g = 32768 / c.range_g;
+    s_mock_vib = 32768 * MOCK_VIB_MG / (1000 * (int32_t)c.range_g);
+    s_mock_period = (uint32_t)s_mock_hz * MOCK_PERIOD_MS / 1000;
+    s_mock_burst = (uint32_t)s_mock_hz * MOCK_BURST_MS / 1000;
+    s_mock_vib_period = (s_mock_hz / MOCK_VIB_HZ >= 2) ? s_mock_hz / MOCK_VIB_HZ : 2;
+    s_mock_n = 0;
+    s_mock_rng = 1;
+    return true;
+}
+
+inline bool MockImuDriver::read_sample(ImuSample& s, int16_t* temp_raw) {
+    _mock_next(s);
+    if (temp_raw) *temp_raw = 0;
+    return true;
+}
+
+// Separate reads: read_gyro() returns the gyro of the sample read_accel() just produced
+inline bool MockImuDriver::read_accel(int16_t& x, int16_t& y, int16_t& z) {
+    _mock_next(s_mock_last);
+    s_mock_accel_read = true;
+    x = s_mock_last.ax; y = s_mock_last.ay; z = s_mock_last.az;
+    return true;
+}
+
+inline bool MockImuDriver::read_gyro(int16_t& x, int16_t& y, int16_t& z) {
+    if (!s_mock_accel_read) _mock_next(s_mock_last);
+    s_mock_accel_read = false;
+    x = s_mock_last.gx; y = s_mock_last.gy; z = s_mock_last.gz;
+    return true;
+}
+
+inline bool MockImuDriver::fifo_begin() {
+    s_mock_fifo_us = micros();
+    s_mock_fifo_acc = 0;
+    return true;
+}
+
+inline void MockImuDriver::fifo_end() {}
+
+inline size_t MockImuDriver::fifo_read(ImuSample* out, size_t max, bool& overflow) {
+    const uint32_t now = micros();
+    s_mock_fifo_acc += (uint64_t)(now - s_mock_fifo_us) * s_mock_hz;
+    s_mock_fifo_us = now;
+    uint64_t frames = s_mock_fifo_acc / 1000000ULL;
+    uint64_t lost = 0;
+    overflow = frames > FIFO_MAX_FRAMES;
+    if (overflow) {
+        // Stop-when-full like the MPU6886: the newest samples are lost
+        lost = frames - FIFO_MAX_FRAMES;
+        frames = FIFO_MAX_FRAMES;
+        s_mock_fifo_acc = s_mock_fifo_acc % 1000000ULL + frames * 1000000ULL;
+    }
+    if (frames > max) frames = max;
+    for (size_t i = 0; i < frames; ++i) _mock_next(out[i]);
+    s_mock_fifo_acc -= frames * 1000000ULL;
+    s_mock_n += (uint32_t)lost;
+    return (size_t)frames;
+}
+
+inline void MockImuDriver::print_regs(Print& out) {
+    out.printf("REGS MOCK n=%u ODR=%uHz ACC_RANGE=%ug GYRO_RANGE=%udps\n", (unsigned)s_mock_n,
+               (unsigned)s_mock_hz, (unsigned)imu_config().range_g, (unsigned)imu_config().gyro_dps);
+}
@@ -1,14 +1,14 @@
 #pragma once
-// MPU6886 access for M5Unified-based boards (e.g., Core2).
-// After M5.begin() (Unified) we override key registers to match config.h,
-// then read raw int16 samples via I2C. We avoid float conversions for consistency.
+// MPU6886 access for M5Unified-based boards (e.g., Core2); driver for imu_driver.h,
+// included from there. After M5.begin() (Unified) we override key registers to match
+// imu_config() (config.h defaults or CONFIG SET), then read raw int16 samples via I2C. We avoid float conversions for consistency.
 
 #include <Arduino.h>
 #include <Wire.h>
 #include "config.h"
 #include "board_hal.h"
 
-static const uint8_t MPU6886_ADDR = hal_imu_addr();
+constexpr uint8_t MPU6886_ADDR = 0x68;  // MPU6886 default
 
 // Registers
 #define MPU6886_REG_PWR_MGMT_1   0x6B
@@ -21,6 +21,16 @@ static const uint8_t MPU6886_ADDR = hal_imu_addr();
 #define MPU6886_REG_WHOAMI       0x75
 #define MPU6886_REG_ACCEL_XOUT_H 0x3B
 #define MPU6886_REG_GYRO_XOUT_H  0x43
+#define MPU6886_REG_FIFO_EN      0x23
+#define MPU6886_REG_INT_STATUS   0x3A
+#define MPU6886_REG_USER_CTRL    0x6A
+#define MPU6886_REG_FIFO_COUNTH  0x72
+#define MPU6886_REG_FIFO_R_W     0x74
+
+// FIFO packet with accel+gyro enabled: ACCEL(6) TEMP(2) GYRO(6), big-endian
+constexpr size_t MPU6886_FIFO_FRAME = 14;
+// 1024-byte FIFO -> 73 full frames
+constexpr size_t MPU6886_FIFO_FRAMES = 1024 / MPU6886_FIFO_FRAME;
 
 inline void mpu_write_u8(uint8_t reg, uint8_t val) {
     Wire.beginTransmission(MPU6886_ADDR);
@@ -29,6 +39,21 @@ inline void mpu_write_u8(uint8_t reg, uint8_t val) {
     Wire.endTransmission();
 }
 
+inline bool mpu_read_bytes(uint8_t reg, uint8_t* buf, size_t n) {
+    Wire.beginTransmission(MPU6886_ADDR);
+    Wire.write(reg);
+    Wire.endTransmission(false);
+    size_t got = Wire.requestFrom(MPU6886_ADDR, (uint8_t)n);
+    for (size_t i = 0; i < n && Wire.available(); ++i) buf[i] = Wire.read();
+    return got >= n;
+}
+
+inline uint8_t mpu_read_u8(uint8_t reg) {
+    uint8_t v = 0;
+    mpu_read_bytes(reg, &v, 1);
+    return v;
+}
+
 inline bool mpu_read_xyz16(uint8_t start_reg, int16_t& x, int16_t& y, int16_t& z) {
     uint8_t buf[6] = {0};
     Wire.beginTransmission(MPU6886_ADDR);
@@ -52,43 +77,83 @@ inline bool mpu_read_xyz16(uint8_t start_reg, int16_t& x, int16_t& y, int16_t& z
     return true;
 }
 
-inline uint8_t map_acc_range_mpu(uint16_t g) {
-    if (g >= 16) return 0x18; // +/-16g
-    if (g >= 8)  return 0x10; // +/-8g
-    if (g >= 4)  return 0x08; // +/-4g
-    return 0x00;             // +/-2g
+// CONFIG/ACCEL_CONFIG2 DLPF mapping (gyro/accel共通)
+// 0:260Hz/256Hz, 1:184Hz, 2:94Hz, 3:44Hz, 4:21Hz, 5:10Hz, 6:5Hz
+constexpr uint8_t mpu_dlpf_cfg(uint16_t hz) {
+    return (hz >= 180) ? 1 : (hz >= 90) ? 2 : (hz >= 50) ? 3 : (hz >= 20) ? 4
+         : (hz >= 8) ? 5 : (hz >= 5) ? 6 : 0; // 0: off/260Hz
 }
 
-inline uint8_t map_gyro_range_mpu(uint16_t dps) {
-    if (dps >= 2000) return 0x18; // +/-2000 dps
-    if (dps >= 1000) return 0x10; // +/-1000 dps
-    if (dps >= 500)  return 0x08; // +/-500 dps
-    return 0x00;                 // +/-250 dps
+// Gyro output rate: 8kHz when DLPF off, 1kHz when on; ODR = base / (1 + SMPLRT_DIV)
+constexpr uint8_t mpu_smplrt_div(uint16_t odr_hz, uint16_t base) {
+    return (odr_hz >= base) ? 0 : (base / odr_hz - 1 > 255) ? 255 : (uint8_t)(base / odr_hz - 1);
 }
 
-inline uint8_t map_dlpf_cfg(uint16_t hz) {
-    // CONFIG/ACCEL_CONFIG2 DLPF mapping (gyro/accel共通)
-    // 0:260Hz/256Hz, 1:184Hz, 2:94Hz, 3:44Hz, 4:21Hz, 5:10Hz, 6:5Hz
-    if (hz >= 180) return 1;
-    if (hz >= 90) return 2;
-    if (hz >= 50) return 3;
-    if (hz >= 20) return 4;
-    if (hz >= 8)  return 5;
-    if (hz >= 5)  return 6;
-    return 0; // off/260Hz
+// Sensor ODR for odr_hz with DLPF on (1kHz base): 1000 / (1 + SMPLRT_DIV), or 0 when that is not a whole
+// number of Hz (128 Hz -> SMPLRT_DIV 6 -> 142.857 Hz). FIFO モードはこのレートが時間軸なので、ヘッダの
+// 整数 odr_hz が嘘にならないよう丸めずに拒否する（ビルド時は static_assert、実行時は ERR CONFIG odr）。
+constexpr uint16_t mpu_exact_odr_hz(uint16_t odr_hz) {
+    return (1000 % (mpu_smplrt_div(odr_hz, 1000) + 1) == 0) ? (uint16_t)(1000 / (mpu_smplrt_div(odr_hz, 1000) + 1)) : 0;
 }
 
-inline void mpu_set_odr(uint16_t odr_hz, bool dlpf_off) {
-    // Gyro output rate: 8kHz when DLPF off, 1kHz when on.
-    uint16_t base = dlpf_off ? 8000 : 1000;
-    if (odr_hz == 0) odr_hz = 200;
-    uint16_t div = (odr_hz >= base) ? 0 : (uint16_t)((base / odr_hz) - 1);
-    if (div > 255) div = 255;
-    mpu_write_u8(MPU6886_REG_SMPLRT_DIV, (uint8_t)div);
+struct Mpu6886Driver {
+    static constexpr uint16_t TYPE = IMU_TYPE_MPU6886;
+    static constexpr const char* NAME = "MPU6886";
+    static constexpr const char* BUS_NAME = "In_I2C";
+    static constexpr uint8_t ADDR = MPU6886_ADDR;
+    // FS_SEL = table index (ACCEL_CONFIG / GYRO_CONFIG bits 4:3)
+    static constexpr uint16_t ACC_RANGES_G[] = { 2, 4, 8, 16 };
+    static constexpr uint16_t GYRO_RANGES_DPS[] = { 250, 500, 1000, 2000 };
+    // Accel/gyro with DLPF on (decimation, FIFO): 1kHz / (1 + SMPLRT_DIV)
+    static constexpr uint16_t MAX_ODR_HZ = 1000;
+    // Gyro DLPF bandwidth per DLPF_CFG (= table index); accel is close (218/99/45/21/10/5 Hz)
+    static constexpr uint16_t DLPF_HZ[] = { 250, 176, 92, 41, 20, 10, 5 };
+    static constexpr bool HAS_FIFO = true;
+    static constexpr size_t FIFO_MAX_FRAMES = MPU6886_FIFO_FRAMES;
+
+    static constexpr uint16_t odr_hz(uint16_t hz) { return mpu_exact_odr_hz(hz); }
+
+    static bool init();
+    static uint16_t dlpf_hz(bool fifo);
+    static bool read_sample(ImuSample& s, int16_t* temp_raw);
+    static bool read_accel(int16_t& x, int16_t& y, int16_t& z);
+    static bool read_gyro(int16_t& x, int16_t& y, int16_t& z);
+    static bool fifo_begin();
+    static void fifo_end();
+    static size_t fifo_read(ImuSample* out, size_t max, bool& overflow);
+    static void print_regs(Print& out);
+};
+constexpr uint16_t Mpu6886Driver::ACC_RANGES_G[];
+constexpr uint16_t Mpu6886Driver::GYRO_RANGES_DPS[];
+constexpr uint16_t Mpu6886Driver::DLPF_HZ[];
+
+// Register values for imu_config(), set by init() (ranges / dlpf already checked against the tables)
+static uint8_t s_mpu_dlpf = 0, s_mpu_smplrt = 0;
+static uint8_t s_mpu_fifo_dlpf = 1, s_mpu_fifo_smplrt = 0;
+static uint8_t s_mpu_accel_fs = 0, s_mpu_gyro_fs = 0;
+
+inline void _mpu_config_regs() {
+    const DevConfig& c = imu_config();
+    const uint16_t hz = imu_sample_hz();
+    const uint8_t dlpf = (uint8_t)imu_table_nearest(Mpu6886Driver::DLPF_HZ, c.dlpf_hz);
+    // Automatic: DLPF off; with decimation it is set below the internal rate's Nyquist
+    s_mpu_dlpf = c.dlpf_hz ? dlpf : mpu_dlpf_cfg((DECIM_FACTOR > 1) ? hz / 2 : 0);
+    s_mpu_smplrt = mpu_smplrt_div(hz, (s_mpu_dlpf == 0) ? 8000 : 1000);
+    // FIFO sampling needs SMPLRT_DIV to be effective: DLPF must be on (cfg 1..6)
+    s_mpu_fifo_dlpf = c.dlpf_hz ? dlpf : mpu_dlpf_cfg(hz / 2);
+    if (s_mpu_fifo_dlpf == 0) s_mpu_fifo_dlpf = 1;
+    s_mpu_fifo_smplrt = mpu_smplrt_div(hz, 1000);
+    s_mpu_accel_fs = (uint8_t)(imu_table_index(Mpu6886Driver::ACC_RANGES_G, c.range_g) << 3);
+    s_mpu_gyro_fs = (uint8_t)(imu_table_index(Mpu6886Driver::GYRO_RANGES_DPS, c.gyro_dps) << 3);
+}
+
+inline uint16_t Mpu6886Driver::dlpf_hz(bool fifo) {
+    return DLPF_HZ[fifo ? s_mpu_fifo_dlpf : s_mpu_dlpf];
 }
 
-inline bool imu_init() {
+inline bool Mpu6886Driver::init() {
     // Ensure IMU is powered and initialized, then override registers.
+    _mpu_config_regs();
 #if HAS_M5UNIFIED
     bool ok = M5.Imu.begin();
     if (!ok) {
@@ -106,49 +171,110 @@ inline bool imu_init() {
     delay(10);
     mpu_write_u8(MPU6886_REG_PWR_MGMT_2, 0x00); // enable all axes
     delay(1);
-    uint8_t dlpf = map_dlpf_cfg(0); // default off
-    bool dlpf_off = (dlpf == 0);
-    mpu_write_u8(MPU6886_REG_CONFIG, dlpf);
-    mpu_set_odr(ODR_HZ, dlpf_off);
-    mpu_write_u8(MPU6886_REG_GYRO_CONFIG, map_gyro_range_mpu(GYRO_RANGE_DPS));
-    mpu_write_u8(MPU6886_REG_ACCEL_CONFIG, map_acc_range_mpu(RANGE_G));
-    mpu_write_u8(MPU6886_REG_ACCEL_CONFIG2, dlpf);
+    mpu_write_u8(MPU6886_REG_CONFIG, s_mpu_dlpf);
+    mpu_write_u8(MPU6886_REG_SMPLRT_DIV, s_mpu_smplrt);
+    mpu_write_u8(MPU6886_REG_GYRO_CONFIG, s_mpu_gyro_fs);
+    mpu_write_u8(MPU6886_REG_ACCEL_CONFIG, s_mpu_accel_fs);
+    mpu_write_u8(MPU6886_REG_ACCEL_CONFIG2, s_mpu_dlpf);
     return true;
 }
 
-// One-time gyro bias
-static int32_t s_gbias_x = 0, s_gbias_y = 0, s_gbias_z = 0;
-static bool s_imu_calibrated = false;
-inline bool imu_is_calibrated() { return s_imu_calibrated; }
-inline void imu_calibrate_once(uint16_t samples = 512) {
-    if (s_imu_calibrated) return;
-    int64_t sx = 0, sy = 0, sz = 0;
-    for (uint16_t i = 0; i < samples; ++i) {
-        int16_t gx, gy, gz;
-        if (!mpu_read_xyz16(MPU6886_REG_GYRO_XOUT_H, gx, gy, gz)) {
-            delay(10);
-            continue;
-        }
-        sx += gx; sy += gy; sz += gz;
-        delay(1000UL / (ODR_HZ ? ODR_HZ : 200));
-    }
-    s_gbias_x = (int32_t)(sx / (int32_t)samples);
-    s_gbias_y = (int32_t)(sy / (int32_t)samples);
-    s_gbias_z = (int32_t)(sz / (int32_t)samples);
-    s_imu_calibrated = true;
+inline bool Mpu6886Driver::read_accel(int16_t& x, int16_t& y, int16_t& z) {
+    return mpu_read_xyz16(MPU6886_REG_ACCEL_XOUT_H, x, y, z);
+}
+
+inline bool Mpu6886Driver::read_gyro(int16_t& x, int16_t& y, int16_t& z) {
+    return mpu_read_xyz16(MPU6886_REG_GYRO_XOUT_H, x, y, z);
 }
 
-inline bool imu_read_accel_raw(int16_t& ax, int16_t& ay, int16_t& az) {
-    return mpu_read_xyz16(MPU6886_REG_ACCEL_XOUT_H, ax, ay, az);
+// Parse raw FIFO (or 0x3B..0x48 register) bytes into samples (no I2C, no bias). Returns frame count.
+inline size_t mpu_fifo_parse(const uint8_t* buf, size_t n, ImuSample* out) {
+    size_t frames = n / MPU6886_FIFO_FRAME;
+    for (size_t i = 0; i < frames; ++i) {
+        const uint8_t* f = buf + i * MPU6886_FIFO_FRAME;
+        out[i].ax = (int16_t)((f[0] << 8) | f[1]);
+        out[i].ay = (int16_t)((f[2] << 8) | f[3]);
+        out[i].az = (int16_t)((f[4] << 8) | f[5]);
+        // f[6..7]: temperature
+        out[i].gx = (int16_t)((f[8] << 8) | f[9]);
+        out[i].gy = (int16_t)((f[10] << 8) | f[11]);
+        out[i].gz = (int16_t)((f[12] << 8) | f[13]);
+    }
+    return frames;
 }
 
-inline bool imu_read_gyro_raw(int16_t& gx, int16_t& gy, int16_t& gz) {
-    int16_t rx, ry, rz;
-    if (!mpu_read_xyz16(MPU6886_REG_GYRO_XOUT_H, rx, ry, rz)) {
+// One burst of ACCEL_XOUT_H..GYRO_ZOUT_L (0x3B..0x48, includes TEMP) so accel
+// and gyro come from the same sensor update.
+inline bool Mpu6886Driver::read_sample(ImuSample& s, int16_t* temp_raw) {
+    uint8_t buf[MPU6886_FIFO_FRAME];
+    if (!mpu_read_bytes(MPU6886_REG_ACCEL_XOUT_H, buf, sizeof(buf))) {
         return false;
     }
-    gx = (int16_t)(rx - s_gbias_x);
-    gy = (int16_t)(ry - s_gbias_y);
-    gz = (int16_t)(rz - s_gbias_z);
+    mpu_fifo_parse(buf, sizeof(buf), &s);
+    if (temp_raw) *temp_raw = (int16_t)((buf[6] << 8) | buf[7]);
+    return true;
+}
+
+// --- FIFO burst mode ---
+// センサ内FIFOに ODR でためて、まとめて読み出す。FIFO_MODE=1（満杯で停止）なので
+// オーバーフロー時に失われるのは最新側のサンプルで、読み出せた分は連続している。
+
+inline void _mpu_fifo_reset() {
+    mpu_write_u8(MPU6886_REG_USER_CTRL, 0x04); // FIFO_RST
+    delay(1);
+    mpu_write_u8(MPU6886_REG_USER_CTRL, 0x40); // FIFO_EN
+    (void)mpu_read_u8(MPU6886_REG_INT_STATUS); // clear FIFO_OFLOW
+}
+
+inline bool Mpu6886Driver::fifo_begin() {
+    mpu_write_u8(MPU6886_REG_CONFIG, 0x40 | s_mpu_fifo_dlpf); // FIFO_MODE=1: stop when full
+    mpu_write_u8(MPU6886_REG_ACCEL_CONFIG2, s_mpu_fifo_dlpf);
+    mpu_write_u8(MPU6886_REG_SMPLRT_DIV, s_mpu_fifo_smplrt);
+    mpu_write_u8(MPU6886_REG_FIFO_EN, 0x18); // GYRO_FIFO_EN | ACCEL_FIFO_EN
+    _mpu_fifo_reset();
     return true;
 }
+
+inline void Mpu6886Driver::fifo_end() {
+    mpu_write_u8(MPU6886_REG_FIFO_EN, 0x00);
+    mpu_write_u8(MPU6886_REG_USER_CTRL, 0x00);
+    init();
+}
+
+inline size_t Mpu6886Driver::fifo_read(ImuSample* out, size_t max, bool& overflow) {
+    overflow = (mpu_read_u8(MPU6886_REG_INT_STATUS) & 0x10) != 0;
+    uint8_t c[2] = {0};
+    if (!mpu_read_bytes(MPU6886_REG_FIFO_COUNTH, c, 2)) return 0;
+    size_t frames = (((size_t)(c[0] & 0x1F) << 8) | c[1]) / MPU6886_FIFO_FRAME;
+    if (frames > max) frames = max;
+    // Wire buffer is 128 bytes: read up to 9 frames per transaction
+    const size_t CHUNK = 9;
+    uint8_t buf[CHUNK * MPU6886_FIFO_FRAME];
+    size_t got = 0;
+    while (got < frames) {
+        size_t k = frames - got;
+        if (k > CHUNK) k = CHUNK;
+        if (!mpu_read_bytes(MPU6886_REG_FIFO_R_W, buf, k * MPU6886_FIFO_FRAME)) break;
+        got += mpu_fifo_parse(buf, k * MPU6886_FIFO_FRAME, out + got);
+    }
+    // A full FIFO ends with a partial frame; restart to keep frame alignment
+    if (overflow) _mpu_fifo_reset();
+    return got;
+}
+
+// --- REGS: minimal register dump ---
+inline void Mpu6886Driver::print_regs(Print& out) {
+    auto rd = [](uint8_t reg) {
+        uint8_t v = 0xFF;
+        mpu_read_bytes(reg, &v, 1);
+        return v;
+    };
+    Wire.beginTransmission(MPU6886_ADDR);
+    int ack = Wire.endTransmission();
+    out.printf(
+        "REGS ACK=%d CONFIG=0x%02X SMPLRT_DIV=%u GYRO_CONFIG=0x%02X ACCEL_CONFIG=0x%02X ACCEL_CONFIG2=0x%02X PWR_MGMT_1=0x%02X PWR_MGMT_2=0x%02X WHOAMI=0x%02X\n",
+        ack, rd(MPU6886_REG_CONFIG), rd(MPU6886_REG_SMPLRT_DIV), rd(MPU6886_REG_GYRO_CONFIG),
+        rd(MPU6886_REG_ACCEL_CONFIG), rd(MPU6886_REG_ACCEL_CONFIG2), rd(MPU6886_REG_PWR_MGMT_1),
+        rd(MPU6886_REG_PWR_MGMT_2), rd(MPU6886_REG_WHOAMI)
+    );
+}
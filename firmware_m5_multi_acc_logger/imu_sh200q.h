@@ -5,10 +5,13 @@
 #include "config.h"
 #include "board_hal.h"
 
-// Minimal SH200Q access. We avoid M5.IMU read helpers to keep readings raw
-// and prevent any library-side auto-calibration from altering values.
+// Minimal SH200Q access (driver for imu_driver.h, included from there). We avoid
+// M5.IMU read helpers to keep readings raw and prevent any library-side
+// auto-calibration from altering values.
 
 // SH200Q register map (7-bit address from M5Unified defaults)
+#define SH200I_OUTPUT_ACC  0x00
+#define SH200I_OUTPUT_GYRO 0x06
 #define SH200I_ACC_CONFIG  0x0E
 #define SH200I_GYRO_CONFIG 0x0F
 #define SH200I_GYRO_DLPF   0x11
@@ -16,150 +19,166 @@
 #define SH200I_ACC_RANGE   0x16
 #define SH200I_GYRO_RANGE  0x2B
 
+constexpr uint8_t SH200Q_ADDR = 0x6C;  // SH200Q default (M5Unifiedと同じ)
+// FIFO frame: ACC(6) GYRO(6), little-endian
+constexpr size_t SH200Q_FIFO_FRAME = 12;
+
+struct Sh200qDriver {
+    static constexpr uint16_t TYPE = IMU_TYPE_SH200Q;
+    static constexpr const char* NAME = "SH200Q";
+    static constexpr const char* BUS_NAME = "Wire1";
+    static constexpr uint8_t ADDR = SH200Q_ADDR;
+    // Register value = table index (ACC_RANGE: 0x00 ±4g, 0x01 ±8g, 0x02 ±16g)
+    static constexpr uint16_t ACC_RANGES_G[] = { 4, 8, 16 };
+    // GYRO_RANGE: 0x00 is ±2000dps in the M5 driver; the others are best-effort
+    static constexpr uint16_t GYRO_RANGES_DPS[] = { 2000, 1000, 500, 250, 125 };
+    // ACC_CONFIG = 0x81 + 8 * index, GYRO_CONFIG = 0x11 + 2 * index (128/64 Hz are inferred)
+    static constexpr uint16_t ACC_ODRS_HZ[] = { 1024, 512, 256, 128, 64, 32, 16, 8 };
+    static constexpr uint16_t GYRO_ODRS_HZ[] = { 1000, 500, 256, 128, 64 };
+    static constexpr uint16_t MAX_ODR_HZ = 1024;
+    // GYRO_DLPF 0x03 (50 Hz) is the only known setting; accel has no separate filter
+    static constexpr uint16_t DLPF_HZ[] = { 50 };
+    // FIFO の状態レジスタ（フレーム数/オーバーフロー）と深さはデータシートで確認できていないので使わない。
+    // IMU_FIFO_MODE はビルドエラーになる（imu_driver.h）。
+    static constexpr bool HAS_FIFO = false;
+    static constexpr size_t FIFO_MAX_FRAMES = 1;
+
+    // The accel ODR drives the timeline (nearest supported rate)
+    static constexpr uint16_t odr_hz(uint16_t hz) { return ACC_ODRS_HZ[imu_table_nearest(ACC_ODRS_HZ, hz)]; }
+
+    static bool init();
+    static uint16_t dlpf_hz(bool) { return DLPF_HZ[0]; }
+    static bool read_sample(ImuSample& s, int16_t* temp_raw);
+    static bool read_accel(int16_t& x, int16_t& y, int16_t& z);
+    static bool read_gyro(int16_t& x, int16_t& y, int16_t& z);
+    static bool fifo_begin();
+    static void fifo_end();
+    static size_t fifo_read(ImuSample* out, size_t max, bool& overflow);
+    static void print_regs(Print& out);
+};
+constexpr uint16_t Sh200qDriver::ACC_RANGES_G[];
+constexpr uint16_t Sh200qDriver::GYRO_RANGES_DPS[];
+constexpr uint16_t Sh200qDriver::ACC_ODRS_HZ[];
+constexpr uint16_t Sh200qDriver::GYRO_ODRS_HZ[];
+constexpr uint16_t Sh200qDriver::DLPF_HZ[];
+
 inline void sh200q_write(uint8_t reg, uint8_t val) {
-    Wire1.beginTransmission(hal_imu_addr());
+    Wire1.beginTransmission(SH200Q_ADDR);
     Wire1.write(reg);
     Wire1.write(val);
     Wire1.endTransmission();
 }
 
-inline uint8_t sh200q_read_u8(uint8_t reg) {
-    Wire1.beginTransmission(hal_imu_addr());
+inline uint8_t sh200q_read_u8(uint8_t reg, uint8_t fail = 0) {
+    Wire1.beginTransmission(SH200Q_ADDR);
     Wire1.write(reg);
     Wire1.endTransmission(false);
-    Wire1.requestFrom(hal_imu_addr(), (uint8_t)1);
+    Wire1.requestFrom(SH200Q_ADDR, (uint8_t)1);
     if (Wire1.available()) return Wire1.read();
-    return 0;
+    return fail;
 }
 
-inline void sh200q_read_xyz16(uint8_t start_reg, int16_t& x, int16_t& y, int16_t& z) {
-    uint8_t buf[6] = {0};
-    Wire1.beginTransmission(hal_imu_addr());
-    Wire1.write(start_reg);
+inline bool sh200q_read_bytes(uint8_t reg, uint8_t* buf, size_t n) {
+    Wire1.beginTransmission(SH200Q_ADDR);
+    Wire1.write(reg);
     Wire1.endTransmission(false);
-    Wire1.requestFrom(hal_imu_addr(), (uint8_t)6);
-    for (int i = 0; i < 6 && Wire1.available(); ++i) buf[i] = Wire1.read();
+    size_t got = Wire1.requestFrom(SH200Q_ADDR, (uint8_t)n);
+    for (size_t i = 0; i < n && Wire1.available(); ++i) buf[i] = Wire1.read();
+    return got >= n;
+}
+
+inline bool sh200q_read_xyz16(uint8_t start_reg, int16_t& x, int16_t& y, int16_t& z) {
+    uint8_t buf[6] = {0};
+    const bool ok = sh200q_read_bytes(start_reg, buf, sizeof(buf));
     x = (int16_t)((buf[1] << 8) | buf[0]);
     y = (int16_t)((buf[3] << 8) | buf[2]);
     z = (int16_t)((buf[5] << 8) | buf[4]);
+    return ok;
 }
 
-inline uint8_t map_acc_range_value(uint16_t range_g) {
-    // 0x00: ±4g, 0x01: ±8g, 0x02: ±16g
-    if (range_g >= 16) return 0x02;
-    if (range_g >= 8)  return 0x01;
-    return 0x00; // default to ±4g
-}
-
-inline uint8_t map_gyro_range_value(uint16_t dps) {
-    // Datasheet mapping not fully documented here; 0x00 is ±2000dps in M5 lib
-    // Favor widest range to avoid clipping when unsure
-    if (dps >= 2000) return 0x00; // ±2000 dps
-    if (dps >= 1000) return 0x01; // guess mapping
-    if (dps >= 500)  return 0x02;
-    if (dps >= 250)  return 0x03;
-    return 0x04; // 125 dps (guess)
-}
-
-inline uint8_t map_acc_odr_reg(uint16_t odr_hz) {
-    // Supported: 1024, 512, 256, 128, 64, 32, 16, 8 Hz
-    // Register values: 0x81, 0x89, 0x91, 0x99, 0xA1, 0xA9, 0xB1, 0xB9
-    const struct { uint16_t hz; uint8_t reg; } lut[] = {
-        {1024, 0x81}, {512, 0x89}, {256, 0x91}, {128, 0x99},
-        {  64, 0xA1}, { 32, 0xA9}, { 16, 0xB1}, {  8, 0xB9},
-    };
-    // pick nearest
-    uint8_t best = lut[2].reg; // default 256Hz
-    uint32_t best_err = 0xFFFFFFFFu;
-    for (auto &e : lut) {
-        uint32_t err = (odr_hz > e.hz) ? (odr_hz - e.hz) : (e.hz - odr_hz);
-        if (err < best_err) { best_err = err; best = e.reg; }
+// Parse raw FIFO (or 0x00..0x0B register) bytes into samples (no I2C, no bias). Returns frame count.
+inline size_t sh200q_fifo_parse(const uint8_t* buf, size_t n, ImuSample* out) {
+    size_t frames = n / SH200Q_FIFO_FRAME;
+    for (size_t i = 0; i < frames; ++i) {
+        const uint8_t* f = buf + i * SH200Q_FIFO_FRAME;
+        out[i].ax = (int16_t)((f[1] << 8) | f[0]);
+        out[i].ay = (int16_t)((f[3] << 8) | f[2]);
+        out[i].az = (int16_t)((f[5] << 8) | f[4]);
+        out[i].gx = (int16_t)((f[7] << 8) | f[6]);
+        out[i].gy = (int16_t)((f[9] << 8) | f[8]);
+        out[i].gz = (int16_t)((f[11] << 8) | f[10]);
     }
-    return best;
+    return frames;
 }
 
-inline uint8_t map_gyro_odr_reg(uint16_t odr_hz) {
-    // Supported: 1000, 500, 256, 128, 64 Hz (128/64 are inferred)
-    // Register values pattern: 0x11, 0x13, 0x15, 0x17, 0x19 ...
-    const struct { uint16_t hz; uint8_t reg; } lut[] = {
-        {1000, 0x11}, {500, 0x13}, {256, 0x15}, {128, 0x17}, { 64, 0x19},
-    };
-    uint8_t best = lut[1].reg; // default 500Hz
-    uint32_t best_err = 0xFFFFFFFFu;
-    for (auto &e : lut) {
-        uint32_t err = (odr_hz > e.hz) ? (odr_hz - e.hz) : (e.hz - odr_hz);
-        if (err < best_err) { best_err = err; best = e.reg; }
-    }
-    return best;
-}
-
-inline bool imu_init() {
+inline bool Sh200qDriver::init() {
     // Initialize IMU and I2C
     M5.IMU.Init();
 
     // Ensure Wire1 is initialized (M5.IMU.Init usually does this)
-    // Configure ODR and ranges directly on SH200Q to match config.h
-    const uint8_t acc_cfg = map_acc_odr_reg(ODR_HZ);
-    const uint8_t gyr_cfg = map_gyro_odr_reg(ODR_HZ);
-    const uint8_t acc_rng = map_acc_range_value(RANGE_G);
-    const uint8_t gyr_rng = map_gyro_range_value(GYRO_RANGE_DPS);
-
-    sh200q_write(SH200I_ACC_CONFIG, acc_cfg);
-    sh200q_write(SH200I_GYRO_CONFIG, gyr_cfg);
-    // Optional: modest gyro DLPF to reduce noise (50 Hz)
+    // Configure ODR and ranges directly on SH200Q to match imu_config() (ranges already checked)
+    const DevConfig& c = imu_config();
+    const uint16_t hz = imu_sample_hz();
+    sh200q_write(SH200I_ACC_CONFIG, (uint8_t)(0x81 + 8 * imu_table_nearest(ACC_ODRS_HZ, hz)));
+    sh200q_write(SH200I_GYRO_CONFIG, (uint8_t)(0x11 + 2 * imu_table_nearest(GYRO_ODRS_HZ, hz)));
+    // Modest gyro DLPF to reduce noise (50 Hz; also what CONFIG dlpf rounds to)
     sh200q_write(SH200I_GYRO_DLPF, 0x03);
     sh200q_write(SH200I_FIFO_CONFIG, 0x00); // no FIFO buffer
-    sh200q_write(SH200I_ACC_RANGE, acc_rng);
-    sh200q_write(SH200I_GYRO_RANGE, gyr_rng);
-
+    sh200q_write(SH200I_ACC_RANGE, (uint8_t)imu_table_index(ACC_RANGES_G, c.range_g));
+    sh200q_write(SH200I_GYRO_RANGE, (uint8_t)imu_table_index(GYRO_RANGES_DPS, c.gyro_dps));
     return true;
 }
 
-// One-time manual calibration: estimate gyro bias while device is stationary.
-static int32_t s_gbias_x = 0, s_gbias_y = 0, s_gbias_z = 0;
-static bool s_imu_calibrated = false;
-inline bool imu_is_calibrated() { return s_imu_calibrated; }
-inline void imu_calibrate_once(uint16_t samples = 512) {
-    if (s_imu_calibrated) return;
-    // Turn screen on and show calibration screen (full blue background)
-    // Keep UI minimal to avoid timing impact.
-    M5.Axp.SetLDO2(true);
-    M5.Axp.ScreenBreath(LCD_BRIGHT_ACTIVE);
-    M5.Lcd.fillScreen(TFT_BLUE);
-    M5.Lcd.setTextColor(TFT_WHITE, TFT_BLUE);
-    M5.Lcd.setCursor(0, 0);
-    M5.Lcd.print("CALIBRATING...\n");
-    M5.Lcd.print("Keep device still");
-    int64_t sx = 0, sy = 0, sz = 0;
-    for (uint16_t i = 0; i < samples; ++i) {
-        int16_t gx, gy, gz;
-        sh200q_read_xyz16(0x06 /* SH200I_OUTPUT_GYRO */, gx, gy, gz);
-        sx += gx; sy += gy; sz += gz;
-        // Roughly follow ODR pacing to avoid bias from transient startup
-        delay(1000UL / (ODR_HZ ? ODR_HZ : 128));
-    }
-    s_gbias_x = (int32_t)(sx / (int32_t)samples);
-    s_gbias_y = (int32_t)(sy / (int32_t)samples);
-    s_gbias_z = (int32_t)(sz / (int32_t)samples);
-    s_imu_calibrated = true;
+// Read raw accelerometer values directly from device (ADC units)
+inline bool Sh200qDriver::read_accel(int16_t& x, int16_t& y, int16_t& z) {
+    return sh200q_read_xyz16(SH200I_OUTPUT_ACC, x, y, z);
 }
 
-// Read raw accelerometer values directly from device (ADC units)
-inline bool imu_read_accel_raw(int16_t& ax, int16_t& ay, int16_t& az) {
-    sh200q_read_xyz16(0x00 /* SH200I_OUTPUT_ACC */, ax, ay, az);
-    return true;
+inline bool Sh200qDriver::read_gyro(int16_t& x, int16_t& y, int16_t& z) {
+    return sh200q_read_xyz16(SH200I_OUTPUT_GYRO, x, y, z);
 }
 
-// Read gyroscope from device (ADC units), subtract bias, convert to dps and cast
-inline bool imu_read_gyro_raw(int16_t& gx, int16_t& gy, int16_t& gz) {
-    int16_t rx, ry, rz;
-    sh200q_read_xyz16(0x06 /* SH200I_OUTPUT_GYRO */, rx, ry, rz);
-    int32_t bx = rx - s_gbias_x;
-    int32_t by = ry - s_gbias_y;
-    int32_t bz = rz - s_gbias_z;
-    float fx = (float)bx * ((float)GYRO_RANGE_DPS / 32768.0f);
-    float fy = (float)by * ((float)GYRO_RANGE_DPS / 32768.0f);
-    float fz = (float)bz * ((float)GYRO_RANGE_DPS / 32768.0f);
-    gx = (int16_t)fx; gy = (int16_t)fy; gz = (int16_t)fz;
+// One burst of the contiguous output block: ACC(0x00..0x05) GYRO(0x06..0x0B)
+// TEMP(0x0C..0x0D), little-endian.
+inline bool Sh200qDriver::read_sample(ImuSample& s, int16_t* temp_raw) {
+    uint8_t buf[SH200Q_FIFO_FRAME + 2];
+    if (!sh200q_read_bytes(SH200I_OUTPUT_ACC, buf, sizeof(buf))) {
+        return false;
+    }
+    sh200q_fifo_parse(buf, SH200Q_FIFO_FRAME, &s);
+    if (temp_raw) *temp_raw = (int16_t)((buf[13] << 8) | buf[12]);
     return true;
 }
+
+// --- FIFO burst mode: not supported (HAS_FIFO = false) ---
+// The register map for the FIFO level/overflow is unverified; these only satisfy the driver interface.
+
+inline bool Sh200qDriver::fifo_begin() { return false; }
+
+inline void Sh200qDriver::fifo_end() {}
+
+inline size_t Sh200qDriver::fifo_read(ImuSample*, size_t, bool& overflow) {
+    overflow = false;
+    return 0;
+}
+
+// --- REGS: configured registers, decoded with the tables above ---
+inline void Sh200qDriver::print_regs(Print& out) {
+    const uint8_t r0E = sh200q_read_u8(SH200I_ACC_CONFIG, 0xFF);
+    const uint8_t r0F = sh200q_read_u8(SH200I_GYRO_CONFIG, 0xFF);
+    const uint8_t r16 = sh200q_read_u8(SH200I_ACC_RANGE, 0xFF);
+    const uint8_t r2B = sh200q_read_u8(SH200I_GYRO_RANGE, 0xFF);
+    uint16_t a_odr = 0, g_odr = 0, a_rng = 0, g_rng = 0;
+    for (size_t i = 0; i < sizeof(ACC_ODRS_HZ) / sizeof(ACC_ODRS_HZ[0]); ++i) {
+        if (r0E == 0x81 + 8 * i) a_odr = ACC_ODRS_HZ[i];
+    }
+    for (size_t i = 0; i < sizeof(GYRO_ODRS_HZ) / sizeof(GYRO_ODRS_HZ[0]); ++i) {
+        if (r0F == 0x11 + 2 * i) g_odr = GYRO_ODRS_HZ[i];
+    }
+    if ((r16 & 0x03) < sizeof(ACC_RANGES_G) / sizeof(ACC_RANGES_G[0])) a_rng = ACC_RANGES_G[r16 & 0x03];
+    if ((r2B & 0x07) < sizeof(GYRO_RANGES_DPS) / sizeof(GYRO_RANGES_DPS[0])) g_rng = GYRO_RANGES_DPS[r2B & 0x07];
+    out.printf(
+        "REGS 0E=0x%02X 0F=0x%02X 16=0x%02X 2B=0x%02X ACC_ODR=%uHz GYRO_ODR=%uHz ACC_RANGE=%ug GYRO_RANGE=%udps\n",
+        r0E, r0F, r16, r2B, (unsigned)a_odr, (unsigned)g_odr, (unsigned)a_rng, (unsigned)g_rng
+    );
+}
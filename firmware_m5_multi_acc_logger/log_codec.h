@@ -0,0 +1,178 @@
+#pragma once
+#include <Arduino.h>
+#include <rom/crc.h>
+#include "config.h"
+#include "board_hal.h"
+#include "log_writer.h"
+#include "perf_stats.h"
+
+// Block payload (formats 0x03xx: LOG_COMPRESS and/or LOG_FRAMED).
+// ペイロードを LOG_BUF_SIZE 固定長ブロックに区切り（1ブロック = 1回のflash書き込み）、
+// 各ブロックは独立に復号できる。残りはゼロ埋め（最後のブロックのみ短い）。
+//
+// ブロックヘッダ (little-endian):
+//   0x0301:          [uint16 sample_count][uint16 payload_len]
+//   0x0302/0x0303:   [char sync[4]="ABLK"][uint32 crc32][uint32 first_sample]
+//                    [uint32 t_us][uint16 sample_count][uint16 payload_len]
+//     crc32 (IEEE, zlib互換) は first_sample から payload 末尾まで。
+//     first_sample はバッファ溢れで捨てたサンプルも数えた通し番号、t_us は先頭サンプル時の micros()。
+//     0x0306/0x0307 (TRIGGER_MODE): トリガ区間外のサンプルは書かずに番号だけ進め、区間ごとに
+//     ブロックを新しく始める。ブロック間の番号の飛びは欠損ではなく記録しなかった区間。
+// payload:
+//   LOG_COMPRESS: 1サンプルあたり6ch分の varint。値は直前サンプルとの差分（int16で折り返し）を
+//                 zigzag 化したもの。ブロック先頭サンプルは0からの差分（=値そのもの）。
+//                 1サンプルは最悪 6ch x 3byte = 18byte。
+//   それ以外:     従来通り MSB first の int16 x 6 (12byte)
+
+constexpr bool LOG_BLOCK_MODE = LOG_COMPRESS || LOG_FRAMED;
+
+// Payload format written to LogHeader::format_ver / INFO (0x0400: summary records, summary.h)
+constexpr uint16_t LOG_FORMAT_VER = SUMMARY_ONLY ? 0x0400
+                                  : LOG_FRAMED ? ((LOG_COMPRESS ? 0x0303 : 0x0302) | (TRIGGER_MODE ? 0x04 : 0))
+                                  : (LOG_COMPRESS ? 0x0301 : 0x0202);
+
+static const uint32_t LOG_BLOCK_SYNC = 0x4B4C4241; // "ABLK"
+static const size_t LOG_BLOCK_HDR_SIZE = LOG_FRAMED ? 20 : 4;
+static const size_t LOG_CODEC_MAX_SAMPLE = LOG_COMPRESS ? 6 * 3 : 12;
+static_assert(LOG_BUF_SIZE >= LOG_BLOCK_HDR_SIZE + LOG_CODEC_MAX_SAMPLE, "LOG_BUF_SIZE too small for a block");
+
+static int16_t s_codec_prev[6];
+static uint16_t s_codec_count = 0;      // samples in the open block
+static bool s_codec_open = false;
+static bool s_codec_sealed = false;     // open block ended early (log_codec_break), rotate pending
+static uint32_t s_codec_index = 0;      // next sample number (incl. dropped)
+static uint32_t s_codec_first = 0;      // sample number of the open block's first sample
+static uint32_t s_codec_t_us = 0;       // micros() at the open block's first sample
+static uint64_t s_codec_raw_bytes = 0;  // 12 bytes per sample of closed blocks
+static uint64_t s_codec_enc_bytes = 0;  // bytes of closed blocks
+
+inline void log_codec_begin() {
+    s_codec_open = false;
+    s_codec_sealed = false;
+    s_codec_count = 0;
+    s_codec_index = 0;
+    s_codec_raw_bytes = 0;
+    s_codec_enc_bytes = 0;
+}
+
+inline uint8_t* _log_codec_put_varint(uint8_t* p, uint16_t v) {
+    while (v >= 0x80) {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+inline void _log_codec_put_le(uint8_t* p, uint32_t v, size_t n) {
+    for (size_t i = 0; i < n; ++i) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+// Fill in the header of the open block
+inline void _log_codec_close() {
+    uint8_t* blk = log_writer_cur_buf();
+    size_t len = log_writer_cur_pos() - LOG_BLOCK_HDR_SIZE;
+    if (LOG_FRAMED) {
+        _log_codec_put_le(blk + 0, LOG_BLOCK_SYNC, 4);
+        _log_codec_put_le(blk + 8, s_codec_first, 4);
+        _log_codec_put_le(blk + 12, s_codec_t_us, 4);
+        _log_codec_put_le(blk + 16, s_codec_count, 2);
+        _log_codec_put_le(blk + 18, len, 2);
+        _log_codec_put_le(blk + 4, crc32_le(0, blk + 8, 12 + len), 4);
+    } else {
+        _log_codec_put_le(blk + 0, s_codec_count, 2);
+        _log_codec_put_le(blk + 2, len, 2);
+    }
+    s_codec_open = false;
+}
+
+// Close the open block and hand it to the writer. On false it stays open (and unchanged).
+inline bool _log_codec_rotate(bool dropping = true) {
+    _log_codec_close();
+    if (!log_writer_rotate(dropping)) {
+        s_codec_open = true; // still the same (full or sealed) block
+        return false;
+    }
+    s_codec_sealed = false;
+    s_codec_raw_bytes += (uint64_t)s_codec_count * 12;
+    s_codec_enc_bytes += LOG_BUF_SIZE;
+    perf_on_block(s_codec_count, LOG_BUF_SIZE);
+    return true;
+}
+
+// Encode one sample; t_us is its capture time (the block's t_us if it opens a block).
+// Returns false if the writer had no free buffer (overflow).
+inline bool log_codec_put(const ImuSample& smp, uint32_t t_us = micros()) {
+    if (s_codec_open && (s_codec_sealed || log_writer_cur_pos() + LOG_CODEC_MAX_SAMPLE > LOG_BUF_SIZE)) {
+        if (!_log_codec_rotate()) {
+            s_codec_index++;
+            return false;
+        }
+    }
+    if (!s_codec_open) {
+        memset(s_codec_prev, 0, sizeof(s_codec_prev));
+        s_codec_count = 0;
+        s_codec_first = s_codec_index;
+        s_codec_t_us = t_us;
+        s_codec_open = true;
+        log_writer_advance(LOG_BLOCK_HDR_SIZE);
+    }
+    const int16_t v[6] = { smp.ax, smp.ay, smp.az, smp.gx, smp.gy, smp.gz };
+    uint8_t* start = log_writer_cur_buf() + log_writer_cur_pos();
+    uint8_t* p = start;
+    for (int i = 0; i < 6; ++i) {
+        if (LOG_COMPRESS) {
+            int16_t d = (int16_t)(uint16_t)(v[i] - s_codec_prev[i]);
+            uint16_t zz = (uint16_t)(((uint16_t)d << 1) ^ (uint16_t)(d >> 15));
+            p = _log_codec_put_varint(p, zz);
+            s_codec_prev[i] = v[i];
+        } else {
+            *p++ = (uint8_t)((uint16_t)v[i] >> 8);
+            *p++ = (uint8_t)(v[i] & 0xFF);
+        }
+    }
+    log_writer_advance(p - start, 1);
+    s_codec_count++;
+    s_codec_index++;
+    return true;
+}
+
+// End the open block early (trigger segment end) so it reaches flash now; the next sample
+// opens a new block. Without a free buffer the rotation is retried by the next put.
+inline void log_codec_break() {
+    if (!s_codec_open) return;
+    s_codec_sealed = true;
+    _log_codec_rotate(false);
+}
+
+// Continue numbering at sample `index` (> the last one put). Only between blocks, i.e.
+// before the first put or after log_codec_break(); skipped numbers are never written.
+inline void log_codec_seek(uint32_t index) {
+    s_codec_index = index;
+}
+
+// Close the last (partial) block; the writer submits it in log_writer_end()
+inline void log_codec_end() {
+    if (!s_codec_open) return;
+    size_t len = log_writer_cur_pos();
+    _log_codec_close();
+    s_codec_raw_bytes += (uint64_t)s_codec_count * 12;
+    s_codec_enc_bytes += len;
+    perf_on_block(s_codec_count, len);
+}
+
+// Sample count from the first bytes of a block of format `fmt` (0: not a valid block)
+inline uint16_t log_block_count(const uint8_t* h, size_t n, uint16_t fmt) {
+    if (fmt & 0x02) {
+        if (n < 20 || memcmp(h, "ABLK", 4) != 0) return 0;
+        return (uint16_t)(h[16] | (h[17] << 8));
+    }
+    if (n < 4) return 0;
+    return (uint16_t)(h[0] | (h[1] << 8));
+}
+
+// Encoded / raw size so far (1.0 before any block is closed)
+inline float log_codec_ratio() {
+    if (s_codec_raw_bytes == 0 || s_codec_enc_bytes == 0) return 1.0f;
+    return (float)s_codec_enc_bytes / (float)s_codec_raw_bytes;
+}
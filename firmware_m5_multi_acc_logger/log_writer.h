@@ -0,0 +1,248 @@
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+#include <LittleFS.h>
+#include <rom/crc.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include "config.h"
+#include "fs_format.h"
+#include "perf_stats.h"
+#include "stage_stats.h"
+
+// Multi-buffer log writer.
+// サンプリング側は現在のバッファに追記するだけで、満杯になったバッファは
+// キュー経由でライタタスクへ渡し、ライタタスクがログ（fs_log_append）へ書き出す。
+// LittleFS の書き込み（消去を伴うと数十ms）がサンプリング周期を止めないようにする。
+// 空きバッファが無い場合はサンプル単位で破棄し、overflow として数える。log_writer_put_filled() で書く
+// 固定レートのレコードは、破棄した数だけ次に書けたときにギャップレコードを先に埋める（時間軸がずれない）。ログ側が満杯で書けなかった
+// バッファのレコードも同じく欠損として数える（ファイルサイズは書けた分だけ）。
+// LOG_CHECKPOINT_MS ごとにライタ側で flush し、書き込み済みサイズ／レコード数を
+// チェックポイントファイルに残す（電源断からの起動時修復用）。
+
+static_assert(LOG_BUF_COUNT >= 2, "LOG_BUF_COUNT must be >= 2");
+static_assert(LOG_BUF_SIZE > 0 && LOG_BUF_SIZE <= 0xFFFF, "LOG_BUF_SIZE must fit in uint16_t");
+
+struct LogWriterItem {
+    uint8_t idx;
+    uint16_t len;
+    uint32_t records; // complete records up to the end of this buffer
+};
+
+// Checkpoint file contents (little-endian, crc32 over the preceding fields)
+struct LogCheckpoint {
+    uint32_t magic;
+    uint32_t bytes;     // log file size after the checkpoint flush
+    uint32_t records;   // complete records within those bytes
+    uint32_t overflow;  // records dropped so far
+    uint32_t crc;
+};
+static const uint32_t LOG_CKPT_MAGIC = 0x504B4341; // "ACKP"
+
+static uint8_t s_lw_bufs[LOG_BUF_COUNT][LOG_BUF_SIZE];
+static uint8_t s_lw_cur = 0;
+static size_t s_lw_pos = 0;
+static bool s_lw_active = false;
+static uint32_t s_lw_overflow = 0;      // records dropped and not replaced by a gap record
+static uint32_t s_lw_gap_pending = 0;   // dropped since the last accepted log_writer_put_filled()
+static uint32_t s_lw_lost = 0;          // writer: records that did not reach the log (log full)
+static uint32_t s_lw_records = 0;       // complete records put so far
+static uint32_t s_lw_file_bytes = 0;    // written by the writer
+static uint32_t s_lw_file_records = 0;
+static uint32_t s_lw_ckpt_ms = 0;
+static QueueHandle_t s_lw_free_q = nullptr;
+static QueueHandle_t s_lw_full_q = nullptr;
+static TaskHandle_t s_lw_task = nullptr;
+
+inline bool log_ckpt_read(LogCheckpoint& ck) {
+    File f = LittleFS.open(LOG_CKPT_FILE_NAME, "r");
+    if (!f) return false;
+    size_t n = f.read(reinterpret_cast<uint8_t*>(&ck), sizeof(ck));
+    f.close();
+    return n == sizeof(ck) && ck.magic == LOG_CKPT_MAGIC
+        && ck.crc == crc32_le(0, reinterpret_cast<const uint8_t*>(&ck), offsetof(LogCheckpoint, crc));
+}
+
+inline void log_ckpt_clear() {
+    if (LittleFS.exists(LOG_CKPT_FILE_NAME)) LittleFS.remove(LOG_CKPT_FILE_NAME);
+}
+
+// Commit the log to flash, then record how much of it is valid
+inline void _log_writer_checkpoint() {
+    const uint32_t t0 = micros();
+    fs_log_commit();
+    LogCheckpoint ck = { LOG_CKPT_MAGIC, s_lw_file_bytes, s_lw_file_records, s_lw_overflow + s_lw_lost, 0 };
+    ck.crc = crc32_le(0, reinterpret_cast<const uint8_t*>(&ck), offsetof(LogCheckpoint, crc));
+    File f = LittleFS.open(LOG_CKPT_FILE_NAME, "w");
+    if (f) {
+        f.write(reinterpret_cast<const uint8_t*>(&ck), sizeof(ck));
+        f.close();
+    }
+    perf_on_checkpoint(micros() - t0);
+}
+
+inline void _log_writer_write(uint8_t idx, size_t len, uint32_t records) {
+    if (!s_lw_active) return;
+    const uint32_t t0 = micros();
+    const uint32_t c0 = stats_now();
+    const bool ok = fs_log_append(s_lw_bufs[idx], len);
+    stats_add(STAT_FLUSH, c0);
+    perf_on_flush(len, micros() - t0);
+    if (ok) {
+        s_lw_file_bytes += len;
+        s_lw_file_records = records;
+    } else {
+        // This buffer and every later one count as lost (fs_log_append refuses from now on); a partial
+        // LittleFS write stays in the file size
+        s_lw_file_bytes = fs_log_bytes();
+        s_lw_lost = records - s_lw_file_records;
+    }
+    if (LOG_CHECKPOINT_MS && millis() - s_lw_ckpt_ms >= LOG_CHECKPOINT_MS) {
+        s_lw_ckpt_ms = millis();
+        _log_writer_checkpoint();
+    }
+}
+
+inline void _log_writer_task(void*) {
+    LogWriterItem it;
+    for (;;) {
+        if (xQueueReceive(s_lw_full_q, &it, portMAX_DELAY) != pdTRUE) continue;
+        _log_writer_write(it.idx, it.len, it.records);
+        xQueueSend(s_lw_free_q, &it.idx, portMAX_DELAY);
+    }
+}
+
+// Hand the current buffer to the writer (or write it synchronously)
+inline void _log_writer_submit(uint8_t idx, size_t len) {
+    if (LOG_WRITER_TASK) {
+        LogWriterItem it = { idx, (uint16_t)len, s_lw_records };
+        xQueueSend(s_lw_full_q, &it, portMAX_DELAY);
+    } else {
+        _log_writer_write(idx, len, s_lw_records);
+    }
+}
+
+// Attach to the log opened by fs_log_create() and reset buffers. Creates the writer task on first use.
+inline bool log_writer_begin() {
+    s_lw_active = true;
+    s_lw_cur = 0;
+    s_lw_pos = 0;
+    s_lw_overflow = 0;
+    s_lw_gap_pending = 0;
+    s_lw_lost = 0;
+    s_lw_records = 0;
+    s_lw_file_bytes = fs_log_bytes();
+    s_lw_file_records = 0;
+    s_lw_ckpt_ms = millis();
+    if (!LOG_WRITER_TASK) return true;
+    if (!s_lw_free_q) {
+        s_lw_free_q = xQueueCreate(LOG_BUF_COUNT, sizeof(uint8_t));
+        s_lw_full_q = xQueueCreate(LOG_BUF_COUNT, sizeof(LogWriterItem));
+        if (!s_lw_free_q || !s_lw_full_q) return false;
+    }
+    if (!s_lw_task) {
+        if (xTaskCreatePinnedToCore(_log_writer_task, "logwr", 4096, nullptr,
+                                    LOG_WRITER_PRIO, &s_lw_task, LOG_WRITER_CORE) != pdPASS) {
+            s_lw_task = nullptr;
+            return false;
+        }
+    }
+    xQueueReset(s_lw_free_q);
+    xQueueReset(s_lw_full_q);
+    for (uint8_t i = 1; i < LOG_BUF_COUNT; ++i) {
+        xQueueSend(s_lw_free_q, &i, 0);
+    }
+    return true;
+}
+
+// Append one record, or return false if no buffer is free (counted by the callers)
+inline bool _log_writer_append(const uint8_t* data, size_t n) {
+    if (s_lw_pos + n > LOG_BUF_SIZE) {
+        uint8_t next = s_lw_cur;
+        if (LOG_WRITER_TASK && xQueueReceive(s_lw_free_q, &next, 0) != pdTRUE) return false;
+        const size_t head = LOG_BUF_SIZE - s_lw_pos;
+        memcpy(&s_lw_bufs[s_lw_cur][s_lw_pos], data, head);
+        _log_writer_submit(s_lw_cur, LOG_BUF_SIZE);
+        s_lw_cur = next;
+        s_lw_pos = 0;
+        data += head;
+        n -= head;
+    }
+    memcpy(&s_lw_bufs[s_lw_cur][s_lw_pos], data, n);
+    s_lw_pos += n;
+    s_lw_records++;
+    return true;
+}
+
+// Append one record. Returns false (and counts an overflow) if no buffer is free;
+// a record is never split between a written and a dropped part.
+inline bool log_writer_put(const uint8_t* data, size_t n) {
+    if (_log_writer_append(data, n)) return true;
+    s_lw_overflow++;
+    perf_on_overflow();
+    return false;
+}
+
+// Fixed-rate records (raw payload): like log_writer_put(), but first writes one `gap` record (n bytes)
+// for each record dropped since the last accepted one, so record i stays sample i. filled = gap records
+// written by this call; those records leave the overflow count.
+inline bool log_writer_put_filled(const uint8_t* data, const uint8_t* gap, size_t n, uint32_t& filled) {
+    filled = 0;
+    while (s_lw_gap_pending && _log_writer_append(gap, n)) {
+        s_lw_gap_pending--;
+        s_lw_overflow--;
+        filled++;
+    }
+    if (s_lw_gap_pending == 0 && _log_writer_append(data, n)) return true;
+    s_lw_gap_pending++;
+    s_lw_overflow++;
+    perf_on_overflow();
+    return false;
+}
+
+// --- Block mode: the caller formats the current buffer in place ---
+inline uint8_t* log_writer_cur_buf() { return s_lw_bufs[s_lw_cur]; }
+inline size_t log_writer_cur_pos() { return s_lw_pos; }
+// records: complete records contained in those n bytes
+inline void log_writer_advance(size_t n, uint32_t records = 0) {
+    s_lw_pos += n;
+    s_lw_records += records;
+}
+
+// Submit the current buffer zero-padded to LOG_BUF_SIZE and switch to a free one.
+// Returns false (nothing submitted) if no buffer is free; counted as an overflow when
+// the caller drops a sample because of it.
+inline bool log_writer_rotate(bool dropping = true) {
+    uint8_t next = s_lw_cur;
+    if (LOG_WRITER_TASK && xQueueReceive(s_lw_free_q, &next, 0) != pdTRUE) {
+        if (!dropping) return false;
+        s_lw_overflow++;
+        perf_on_overflow();
+        return false;
+    }
+    memset(&s_lw_bufs[s_lw_cur][s_lw_pos], 0, LOG_BUF_SIZE - s_lw_pos);
+    _log_writer_submit(s_lw_cur, LOG_BUF_SIZE);
+    s_lw_cur = next;
+    s_lw_pos = 0;
+    return true;
+}
+
+// Submit the partial buffer and block until everything queued is on flash
+inline void log_writer_end() {
+    uint8_t expect_free = LOG_BUF_COUNT - 1;
+    if (s_lw_pos > 0) {
+        _log_writer_submit(s_lw_cur, s_lw_pos);
+        s_lw_pos = 0;
+        expect_free = LOG_BUF_COUNT;
+    }
+    if (LOG_WRITER_TASK && s_lw_free_q) {
+        while (uxQueueMessagesWaiting(s_lw_free_q) < expect_free) {
+            vTaskDelay(1);
+        }
+    }
+    s_lw_active = false;
+}
+
+// Records dropped: no free buffer (overflow) or not written because the log was full
+inline uint32_t log_writer_overflow() { return s_lw_overflow + s_lw_lost; }
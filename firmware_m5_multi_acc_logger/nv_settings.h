@@ -0,0 +1,52 @@
+#pragma once
+#include <Arduino.h>
+#include <Preferences.h>
+#include "config.h"
+
+// Persistent device settings in NVS (namespace NV_NAMESPACE).
+// LittleFS のファイルと違い FORMAT / ERASE では消えず、キー単位で原子的に書き換わる。
+// 書き込みは設定が変わったときだけ（フラッシュ摩耗を避ける）。読み出しに失敗したら既定値を返す。
+
+inline uint32_t nv_get_u32(const char* key, uint32_t def) {
+    Preferences p;
+    if (!p.begin(NV_NAMESPACE, true)) return def;  // namespace not created yet
+    const uint32_t v = p.getUInt(key, def);
+    p.end();
+    return v;
+}
+
+inline bool nv_put_u32(const char* key, uint32_t v) {
+    Preferences p;
+    if (!p.begin(NV_NAMESPACE, false)) return false;
+    const bool ok = (p.getUInt(key, ~v) == v) || p.putUInt(key, v) == sizeof(v);
+    p.end();
+    return ok;
+}
+
+// Fixed-size blob: true only when exactly len bytes are stored under key
+inline bool nv_get_bytes(const char* key, void* out, size_t len) {
+    Preferences p;
+    if (!p.begin(NV_NAMESPACE, true)) return false;
+    const bool ok = p.isKey(key) && p.getBytesLength(key) == len && p.getBytes(key, out, len) == len;
+    p.end();
+    return ok;
+}
+
+inline bool nv_put_bytes(const char* key, const void* v, size_t len) {
+    Preferences p;
+    if (!p.begin(NV_NAMESPACE, false)) return false;
+    uint8_t cur[64];
+    const bool same = len <= sizeof(cur) && p.isKey(key) && p.getBytesLength(key) == len
+                      && p.getBytes(key, cur, len) == len && memcmp(cur, v, len) == 0;
+    const bool ok = same || p.putBytes(key, v, len) == len;
+    p.end();
+    return ok;
+}
+
+inline bool nv_remove(const char* key) {
+    Preferences p;
+    if (!p.begin(NV_NAMESPACE, false)) return false;
+    const bool ok = !p.isKey(key) || p.remove(key);
+    p.end();
+    return ok;
+}
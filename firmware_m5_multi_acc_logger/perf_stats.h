@@ -0,0 +1,119 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// On-device loop benchmark counters.
+// 記録中の1回のflash書き込みバイト数/時間、実効ODR、バッファ溢れなどを集計し、シリアル `PERF` で参照する。
+// 1サンプルあたりの CPU 時間とティックのジッタは STATS（stage_stats.h）だけが計る。
+// start_logging() でリセットされる。
+
+struct PerfStats {
+    uint32_t first_sample_us;
+    uint32_t last_sample_us;
+    uint32_t samples;
+    // flash writes
+    uint32_t flush_calls;
+    uint64_t flush_bytes;
+    uint32_t flush_us_max;
+    uint64_t flush_us_sum;
+    // samples dropped because no write buffer was free
+    uint32_t overflow;
+    // payload blocks (LOG_COMPRESS / LOG_FRAMED)
+    uint32_t blocks;
+    uint64_t block_samples;
+    uint64_t block_bytes;
+    // checkpoints (flush + checkpoint file, writer task)
+    uint32_t ckpt_calls;
+    uint32_t ckpt_us_max;
+    uint64_t ckpt_us_sum;
+    // decimation FIR, CPU cycles per output sample (6 channels)
+    uint32_t decim_calls;
+    uint32_t decim_cyc_max;
+    uint64_t decim_cyc_sum;
+    // acquisition -> pipeline ring (ACQ_TASK): deepest backlog, reads dropped while it was full
+    uint32_t acq_depth_max;
+    uint32_t acq_overflow;
+    // IMU read rate of the recording (perf_reset())
+    uint32_t rate_hz;
+};
+
+static PerfStats s_perf = {};
+
+inline void perf_reset(uint16_t rate_hz) {
+    s_perf = {};
+    s_perf.rate_hz = rate_hz ? rate_hz : 1;
+}
+
+// t0: sample slot start (before IMU read); span of the achieved ODR
+inline void perf_on_sample(uint32_t t0) {
+    if (s_perf.samples == 0) s_perf.first_sample_us = t0;
+    s_perf.last_sample_us = t0;
+    s_perf.samples++;
+}
+
+inline void perf_on_flush(size_t bytes, uint32_t dur_us) {
+    s_perf.flush_calls++;
+    s_perf.flush_bytes += bytes;
+    s_perf.flush_us_sum += dur_us;
+    if (dur_us > s_perf.flush_us_max) s_perf.flush_us_max = dur_us;
+}
+
+inline void perf_on_overflow() {
+    s_perf.overflow++;
+}
+
+inline void perf_on_block(uint32_t samples, size_t bytes) {
+    s_perf.blocks++;
+    s_perf.block_samples += samples;
+    s_perf.block_bytes += bytes;
+}
+
+inline void perf_on_checkpoint(uint32_t dur_us) {
+    s_perf.ckpt_calls++;
+    s_perf.ckpt_us_sum += dur_us;
+    if (dur_us > s_perf.ckpt_us_max) s_perf.ckpt_us_max = dur_us;
+}
+
+inline void perf_on_decim(uint32_t cycles) {
+    s_perf.decim_calls++;
+    s_perf.decim_cyc_sum += cycles;
+    if (cycles > s_perf.decim_cyc_max) s_perf.decim_cyc_max = cycles;
+}
+
+// Pipeline task: ring backlog when it wakes up
+inline void perf_on_acq_depth(size_t depth) {
+    if (depth > s_perf.acq_depth_max) s_perf.acq_depth_max = (uint32_t)depth;
+}
+
+// Acquisition task: a read that did not fit in the ring
+inline void perf_on_acq_overflow() {
+    s_perf.acq_overflow++;
+}
+
+// One-line summary: "PERF samples:.. flush:calls/bytes_avg/us_avg/us_max odr:achieved/target ovf:n blk:n/avg_samples/ratio ckpt:calls/us_avg/us_max fir:cyc_avg/cyc_max acq:depth_max/capacity/overflow"
+inline void perf_print(Print& out) {
+    const PerfStats& p = s_perf;
+    uint32_t n = p.samples;
+    uint32_t fl_bytes_avg = p.flush_calls ? (uint32_t)(p.flush_bytes / p.flush_calls) : 0;
+    uint32_t fl_us_avg = p.flush_calls ? (uint32_t)(p.flush_us_sum / p.flush_calls) : 0;
+    uint32_t blk_avg = p.blocks ? (uint32_t)(p.block_samples / p.blocks) : 0;
+    uint32_t ck_us_avg = p.ckpt_calls ? (uint32_t)(p.ckpt_us_sum / p.ckpt_calls) : 0;
+    uint32_t fir_avg = p.decim_calls ? (uint32_t)(p.decim_cyc_sum / p.decim_calls) : 0;
+    float ratio = p.block_samples ? (float)p.block_bytes / (float)(p.block_samples * 12) : 0.0f;
+    // achieved ODR over the span between first and last sample
+    float odr = 0.0f;
+    if (n > 1) {
+        uint32_t span = p.last_sample_us - p.first_sample_us;
+        if (span > 0) odr = (float)(n - 1) * 1000000.0f / (float)span;
+    }
+    out.printf(
+        "PERF samples:%u flush:%u/%u/%u/%u odr:%.2f/%u ovf:%u blk:%u/%u/%.3f ckpt:%u/%u/%u fir:%u/%u acq:%u/%u/%u\n",
+        (unsigned)n,
+        (unsigned)p.flush_calls, (unsigned)fl_bytes_avg, (unsigned)fl_us_avg, (unsigned)p.flush_us_max,
+        odr, (unsigned)p.rate_hz, (unsigned)p.overflow,
+        (unsigned)p.blocks, (unsigned)blk_avg, ratio,
+        (unsigned)p.ckpt_calls, (unsigned)ck_us_avg, (unsigned)p.ckpt_us_max,
+        (unsigned)fir_avg, (unsigned)p.decim_cyc_max,
+        (unsigned)p.acq_depth_max, (unsigned)(ACQ_TASK ? ACQ_QUEUE_LEN : 0), (unsigned)p.acq_overflow
+    );
+}
@@ -0,0 +1,313 @@
+#pragma once
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <rom/crc.h>
+#include "config.h"
+
+// Raw-partition circular log (LOG_RAW_PARTITION).
+// LittleFS を通さず、ログ用データパーティション（RAW_LOG_PARTITION_LABEL）を 4KB セクタの
+// リングとして直接書く。ファイルのメタデータ更新もヘッダの書き戻しも無い。
+//   セクタ = [RawSectorHdr 32B][payload 最大 RAW_LOG_PAYLOAD]
+//   payload を先に書き、最後にヘッダを書く（途中で電源断したセクタはヘッダが無効＝未使用扱い）。
+// seq は全セクタ通しの書き込み順。起動時に全セクタのヘッダだけを読み、最大 seq の次を書き込み位置とする。
+// 書き込み位置の先 RAW_LOG_ERASE_AHEAD セクタを消去済みに保つ（1セクタ書くごとに最大1セクタ消去）。
+// リングを順に一周するので全セクタの消去回数は均等になる。
+// 消去が他のセッションのセクタに掛かった時点で、そのセッション（＝最も古いもの）は失われる。
+// 記録中のセッションは自分の先頭には追いつかず、満杯になったら以降のデータを捨てる（追記は失敗を返し、
+// ライタが欠損として数える。閉じるセクタ用に消去済みセクタを1つ残す）。
+// セッションの最終サンプル数は最後のセクタ（RAW_SECT_CLOSE）のヘッダに持つ。
+//
+// Each session reads back as one contiguous byte stream (the same bytes a LittleFS
+// file would hold): sector k of the session holds bytes [k * RAW_LOG_PAYLOAD, ...).
+// The writer task appends while loop() reads, sizes and removes sessions (DUMP / LIST / ERASE):
+// every raw_log_* call holds s_raw_mu, so a reader never sees a sector half handed over from the
+// stage or a session dropped by the erase-ahead in the middle of a read.
+
+struct RawSectorHdr {
+    uint32_t magic;
+    uint32_t seq;             // write order over the whole partition
+    uint32_t session;
+    uint32_t index;           // sector number within the session
+    uint16_t len;             // payload bytes
+    uint16_t flags;
+    uint32_t total_samples;   // RAW_SECT_CLOSE only
+    uint32_t dropped_samples; // RAW_SECT_CLOSE only
+    uint32_t crc;             // crc32 of the fields above
+};
+
+static const uint32_t RAW_SECT_MAGIC = 0x474F4C52; // "RLOG"
+static const uint16_t RAW_SECT_CLOSE = 0x0001;
+static const size_t RAW_LOG_SECTOR = 4096;
+static const size_t RAW_LOG_PAYLOAD = RAW_LOG_SECTOR - sizeof(RawSectorHdr);
+static_assert(sizeof(RawSectorHdr) == 32, "RawSectorHdr layout");
+
+struct RawSession {
+    uint32_t id;              // 0 = unused
+    uint32_t first;           // sector holding index 0
+    uint32_t first_seq;
+    uint32_t sectors;
+    uint32_t bytes;           // payload bytes on flash
+    uint32_t total_samples;   // 0xFFFFFFFF until closed
+    uint32_t dropped_samples;
+};
+
+static const esp_partition_t* s_raw_part = nullptr;
+static uint32_t s_raw_nsec = 0;
+static uint32_t s_raw_head = 0;     // next sector to write
+static uint32_t s_raw_seq = 1;      // seq of the next sector
+static uint32_t s_raw_erased = 0;   // sectors from s_raw_head known to be erased
+static RawSession s_raw_sess[SESSION_MAX];
+static RawSession* s_raw_cur = nullptr;   // session being appended
+static uint8_t s_raw_stage[RAW_LOG_PAYLOAD];
+static size_t s_raw_stage_len = 0;
+static SemaphoreHandle_t s_raw_mu = nullptr;   // created by the first raw_log_mount()
+
+struct RawLock {
+    RawLock() { if (s_raw_mu) xSemaphoreTake(s_raw_mu, portMAX_DELAY); }
+    ~RawLock() { if (s_raw_mu) xSemaphoreGive(s_raw_mu); }
+    RawLock(const RawLock&) = delete;
+    RawLock& operator=(const RawLock&) = delete;
+};
+
+inline bool _raw_read_hdr(uint32_t sec, RawSectorHdr& h) {
+    if (esp_partition_read(s_raw_part, sec * RAW_LOG_SECTOR, &h, sizeof(h)) != ESP_OK) return false;
+    return h.magic == RAW_SECT_MAGIC
+        && h.crc == crc32_le(0, reinterpret_cast<const uint8_t*>(&h), offsetof(RawSectorHdr, crc));
+}
+
+inline RawSession* _raw_find(uint32_t id) {
+    if (id == 0) return nullptr;
+    RawSession& e = s_raw_sess[id % SESSION_MAX];
+    return (e.id == id) ? &e : nullptr;
+}
+
+// Scan all sector headers once at boot: write position and the sessions on flash
+inline bool raw_log_mount() {
+    if (!s_raw_mu) s_raw_mu = xSemaphoreCreateMutex();
+    RawLock lock;
+    s_raw_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                          RAW_LOG_PARTITION_LABEL);
+    if (!s_raw_part) return false;
+    s_raw_nsec = s_raw_part->size / RAW_LOG_SECTOR;
+    if (s_raw_nsec < (uint32_t)RAW_LOG_ERASE_AHEAD + 2) {
+        s_raw_part = nullptr;
+        return false;
+    }
+    memset(s_raw_sess, 0, sizeof(s_raw_sess));
+    uint32_t max_seq = 0;
+    uint32_t max_sec = 0;
+    for (uint32_t sec = 0; sec < s_raw_nsec; ++sec) {
+        RawSectorHdr h;
+        if (!_raw_read_hdr(sec, h) || h.session == 0) continue;
+        if (h.seq > max_seq) {
+            max_seq = h.seq;
+            max_sec = sec;
+        }
+        RawSession& e = s_raw_sess[h.session % SESSION_MAX];
+        if (e.id != h.session) {
+            if (e.id > h.session) continue; // keep the newer one
+            e = {};
+            e.id = h.session;
+            e.first = UINT32_MAX;
+            e.total_samples = 0xFFFFFFFF;
+        }
+        if (h.index == 0) {
+            e.first = sec;
+            e.first_seq = h.seq;
+        }
+        e.sectors++;
+        e.bytes += h.len;
+        if (h.flags & RAW_SECT_CLOSE) {
+            e.total_samples = h.total_samples;
+            e.dropped_samples = h.dropped_samples;
+        }
+    }
+    // A session is usable only if it still starts at index 0 and ends where its count says
+    for (RawSession& e : s_raw_sess) {
+        if (!e.id) continue;
+        RawSectorHdr h;
+        const bool ok = e.first != UINT32_MAX
+            && _raw_read_hdr((e.first + e.sectors - 1) % s_raw_nsec, h)
+            && h.session == e.id && h.index == e.sectors - 1;
+        if (!ok) e = {};
+    }
+    s_raw_head = max_seq ? (max_sec + 1) % s_raw_nsec : 0;
+    s_raw_seq = max_seq + 1;
+    s_raw_erased = 0;
+    s_raw_cur = nullptr;
+    s_raw_stage_len = 0;
+    return true;
+}
+
+// Erase the next sector of the erase-ahead window. Whatever session still owns it is
+// the oldest one and is dropped. False if it belongs to the session being written (full).
+inline bool _raw_erase_next() {
+    const uint32_t sec = (s_raw_head + s_raw_erased) % s_raw_nsec;
+    RawSectorHdr h;
+    if (_raw_read_hdr(sec, h)) {
+        if (s_raw_cur && h.session == s_raw_cur->id && h.seq >= s_raw_cur->first_seq) return false;
+        RawSession* e = _raw_find(h.session);
+        if (e && h.seq >= e->first_seq) *e = {};
+    }
+    if (esp_partition_erase_range(s_raw_part, sec * RAW_LOG_SECTOR, RAW_LOG_SECTOR) != ESP_OK) return false;
+    s_raw_erased++;
+    return true;
+}
+
+// Program the staged payload as the next sector of the current session
+inline bool _raw_write_sector(uint16_t flags) {
+    RawSession& e = *s_raw_cur;
+    if (s_raw_erased == 0 && !_raw_erase_next()) return false; // partition full of this session
+    if (e.sectors == 0) {
+        e.first = s_raw_head;
+        e.first_seq = s_raw_seq;
+    }
+    RawSectorHdr h = { RAW_SECT_MAGIC, s_raw_seq, e.id, e.sectors, (uint16_t)s_raw_stage_len, flags,
+                       e.total_samples, e.dropped_samples, 0 };
+    h.crc = crc32_le(0, reinterpret_cast<const uint8_t*>(&h), offsetof(RawSectorHdr, crc));
+    const size_t base = s_raw_head * RAW_LOG_SECTOR;
+    if (s_raw_stage_len) esp_partition_write(s_raw_part, base + sizeof(h), s_raw_stage, s_raw_stage_len);
+    esp_partition_write(s_raw_part, base, &h, sizeof(h));
+    s_raw_head = (s_raw_head + 1) % s_raw_nsec;
+    s_raw_seq++;
+    s_raw_erased--;
+    e.sectors++;
+    e.bytes += s_raw_stage_len;
+    s_raw_stage_len = 0;
+    if (s_raw_erased < RAW_LOG_ERASE_AHEAD) _raw_erase_next();
+    return true;
+}
+
+// Start appending session `id` at the write position
+inline bool raw_log_open(uint32_t id) {
+    RawLock lock;
+    if (!s_raw_part || id == 0) return false;
+    RawSession& e = s_raw_sess[id % SESSION_MAX];
+    e = {};
+    e.id = id;
+    e.first = s_raw_head;
+    e.first_seq = s_raw_seq;
+    e.total_samples = 0xFFFFFFFF;
+    s_raw_cur = &e;
+    s_raw_stage_len = 0;
+    return true;
+}
+
+// Writer side: stage bytes, program every full sector. All or nothing: the sectors these bytes
+// complete, plus one kept for the closing sector, are erased first. False (nothing staged) once the
+// partition is full of this session; the caller counts the bytes as lost.
+inline bool raw_log_append(const uint8_t* data, size_t n) {
+    RawLock lock;
+    if (!s_raw_cur) return false;
+    const uint32_t need = (uint32_t)((s_raw_stage_len + n) / RAW_LOG_PAYLOAD) + 1;
+    while (s_raw_erased < need) {
+        if (!_raw_erase_next()) return false;
+    }
+    size_t done = 0;
+    while (done < n) {
+        size_t k = RAW_LOG_PAYLOAD - s_raw_stage_len;
+        if (k > n - done) k = n - done;
+        memcpy(s_raw_stage + s_raw_stage_len, data + done, k);
+        s_raw_stage_len += k;
+        done += k;
+        if (s_raw_stage_len == RAW_LOG_PAYLOAD) _raw_write_sector(0);
+    }
+    return true;
+}
+
+// Program the staged tail as the closing sector carrying the final counts
+inline bool _raw_finish(uint32_t total, uint32_t dropped) {
+    if (!s_raw_cur) return false;
+    s_raw_cur->total_samples = total;
+    s_raw_cur->dropped_samples = dropped;
+    const bool ok = _raw_write_sector(RAW_SECT_CLOSE);
+    s_raw_cur = nullptr;
+    return ok;
+}
+
+inline bool raw_log_finish(uint32_t total, uint32_t dropped) {
+    RawLock lock;
+    return _raw_finish(total, dropped);
+}
+
+// Boot recovery: close the newest session (cut by power loss) with an empty closing sector
+inline bool raw_log_set_totals(uint32_t id, uint32_t total, uint32_t dropped) {
+    RawLock lock;
+    RawSession* e = _raw_find(id);
+    if (!e || s_raw_cur || e->sectors == 0) return false;
+    if ((e->first + e->sectors) % s_raw_nsec != s_raw_head) return false;
+    s_raw_cur = e;
+    s_raw_stage_len = 0;
+    return _raw_finish(total, dropped);
+}
+
+inline bool raw_log_exists(uint32_t id) {
+    RawLock lock;
+    return _raw_find(id) != nullptr;
+}
+
+// Readable size (the open session includes its staged tail)
+inline uint32_t _raw_size(const RawSession* e) {
+    if (!e) return 0;
+    return e->bytes + ((e == s_raw_cur) ? s_raw_stage_len : 0);
+}
+
+inline uint32_t raw_log_size(uint32_t id) {
+    RawLock lock;
+    return _raw_size(_raw_find(id));
+}
+
+// Final counts of a closed session; false while open / cut off
+inline bool raw_log_totals(uint32_t id, uint32_t& total, uint32_t& dropped) {
+    RawLock lock;
+    const RawSession* e = _raw_find(id);
+    if (!e || e->total_samples == 0xFFFFFFFF) return false;
+    total = e->total_samples;
+    dropped = e->dropped_samples;
+    return true;
+}
+
+inline size_t raw_log_read(uint32_t id, uint32_t off, uint8_t* buf, size_t n) {
+    RawLock lock;
+    const RawSession* e = _raw_find(id);
+    const uint32_t size = _raw_size(e);
+    if (!e || off >= size) return 0;
+    if (n > size - off) n = size - off;
+    size_t done = 0;
+    while (done < n) {
+        const uint32_t idx = (off + done) / RAW_LOG_PAYLOAD;
+        const uint32_t within = (off + done) % RAW_LOG_PAYLOAD;
+        size_t k = RAW_LOG_PAYLOAD - within;
+        if (k > n - done) k = n - done;
+        if (idx >= e->sectors) {
+            memcpy(buf + done, s_raw_stage + within, k);
+        } else {
+            const uint32_t sec = (e->first + idx) % s_raw_nsec;
+            esp_partition_read(s_raw_part, sec * RAW_LOG_SECTOR + sizeof(RawSectorHdr) + within, buf + done, k);
+        }
+        done += k;
+    }
+    return n;
+}
+
+// Drop a session; its first sector is erased so it stays gone after reboot
+inline void raw_log_remove(uint32_t id) {
+    RawLock lock;
+    RawSession* e = _raw_find(id);
+    if (!e || e == s_raw_cur) return;
+    if (e->sectors) esp_partition_erase_range(s_raw_part, e->first * RAW_LOG_SECTOR, RAW_LOG_SECTOR);
+    *e = {};
+}
+
+inline size_t raw_log_total_bytes() {
+    return (size_t)s_raw_nsec * RAW_LOG_SECTOR;
+}
+
+inline size_t raw_log_used_bytes() {
+    RawLock lock;
+    size_t n = 0;
+    for (const RawSession& e : s_raw_sess) if (e.id) n += e.sectors;
+    return n * RAW_LOG_SECTOR;
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "config.h"
+
+// Sample pacing.
+// ODR_HZ のティック時刻を整数の端数累積で刻み（1e6/ODR_HZ が割り切れなくてもドリフトしない）、
+// 前回から経過したティック数を返す。2以上なら古いティックは取りこぼし（missed）。
+// - SAMPLE_TIMER_MODE=false: loop() から sample_clock_poll() で消費
+// - SAMPLE_TIMER_MODE=true : esp_timer のワンショットを次ティック時刻に再設定し、
+//   コールバック（esp_timer タスク）からサンプリング処理を直接呼ぶ
+//   （ACQ_TASK: コールバックは ACQ_CORE に固定した優先度 ACQ_PRIO の取得タスクを起こすだけで、
+//   ティックの処理と再設定はそのタスクが行う。esp_timer タスクを共有する他のタイマを待たせない）
+// batch>1 の場合は batch ティック分たまるまで呼び出さない（FIFO一括読み出し用）。
+
+typedef void (*SampleTickFn)(uint32_t due);
+
+static uint32_t s_sc_rate_hz = ODR_HZ;
+static uint32_t s_sc_period_us = 1000000UL / ODR_HZ;
+static uint32_t s_sc_period_rem = 1000000UL % ODR_HZ;
+static uint32_t s_sc_batch = 1;
+static uint32_t s_sc_pending = 0;
+static int64_t s_sc_next_us = 0;
+static uint32_t s_sc_frac = 0;
+static SampleTickFn s_sc_fn = nullptr;
+static esp_timer_handle_t s_sc_timer = nullptr;
+static std::atomic<bool> s_sc_running{false};
+static std::atomic<bool> s_sc_in_cb{false};   // seq_cst with s_sc_running: stop and a tick never both miss each other
+static TaskHandle_t s_sc_task = nullptr;
+
+inline void _sample_clock_advance() {
+    s_sc_next_us += s_sc_period_us;
+    s_sc_frac += s_sc_period_rem;
+    if (s_sc_frac >= s_sc_rate_hz) {
+        s_sc_frac -= s_sc_rate_hz;
+        s_sc_next_us += 1;
+    }
+}
+
+// Consume all ticks up to now; returns how many elapsed once at least
+// s_sc_batch are pending (0 = not due yet)
+inline uint32_t _sample_clock_take(int64_t now_us) {
+    while (now_us >= s_sc_next_us) {
+        s_sc_pending++;
+        _sample_clock_advance();
+    }
+    if (s_sc_pending < s_sc_batch) return 0;
+    uint32_t due = s_sc_pending;
+    s_sc_pending = 0;
+    return due;
+}
+
+inline void _sample_clock_run() {
+    s_sc_in_cb = true;
+    if (!s_sc_running) {
+        s_sc_in_cb = false;
+        return;
+    }
+    uint32_t due = _sample_clock_take(esp_timer_get_time());
+    if (due && s_sc_fn) s_sc_fn(due);
+    if (s_sc_running) {
+        int64_t wait = s_sc_next_us - esp_timer_get_time()
+                     + (int64_t)(s_sc_batch - 1 - s_sc_pending) * s_sc_period_us;
+        esp_timer_start_once(s_sc_timer, (wait > 0) ? (uint64_t)wait : 1);
+    }
+    s_sc_in_cb = false;
+}
+
+inline void _sample_clock_cb(void*) {
+    if (ACQ_TASK) xTaskNotifyGive(s_sc_task);
+    else _sample_clock_run();
+}
+
+inline void _sample_clock_task(void*) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        _sample_clock_run();
+    }
+}
+
+// First tick is one period after start (same as the previous polling loop).
+// rate_hz: tick rate, batch: ticks per call of fn
+inline bool sample_clock_start(SampleTickFn fn, uint16_t rate_hz = ODR_HZ, uint16_t batch = 1) {
+    s_sc_fn = fn;
+    s_sc_rate_hz = rate_hz ? rate_hz : ODR_HZ;
+    s_sc_period_us = 1000000UL / s_sc_rate_hz;
+    s_sc_period_rem = 1000000UL % s_sc_rate_hz;
+    s_sc_batch = batch ? batch : 1;
+    s_sc_pending = 0;
+    s_sc_frac = 0;
+    s_sc_next_us = esp_timer_get_time();
+    _sample_clock_advance();
+    s_sc_running = true;
+    if (!SAMPLE_TIMER_MODE) return true;
+    if (ACQ_TASK && !s_sc_task) {
+        if (xTaskCreatePinnedToCore(_sample_clock_task, "acq", 4096, nullptr, ACQ_PRIO,
+                                    &s_sc_task, ACQ_CORE) != pdPASS) {
+            s_sc_task = nullptr;
+            s_sc_running = false;
+            return false;
+        }
+    }
+    if (!s_sc_timer) {
+        esp_timer_create_args_t args = {};
+        args.callback = &_sample_clock_cb;
+        args.dispatch_method = ESP_TIMER_TASK;
+        args.name = "sample";
+        if (esp_timer_create(&args, &s_sc_timer) != ESP_OK) {
+            s_sc_timer = nullptr;
+            s_sc_running = false;
+            return false;
+        }
+    }
+    esp_timer_stop(s_sc_timer);  // not armed unless a previous stop was skipped (ESP_ERR_INVALID_STATE then)
+    return esp_timer_start_once(s_sc_timer, (uint64_t)s_sc_period_us * s_sc_batch) == ESP_OK;
+}
+
+// Whole microseconds per tick of the running clock (the remainder is carried in s_sc_frac)
+inline uint32_t sample_clock_period_us() { return s_sc_period_us; }
+
+// Stop and wait for an in-flight timer callback to finish.
+// A tick that passed its s_sc_running check just before the first esp_timer_stop() re-arms the
+// timer afterwards (ACQ_TASK: the acquisition task runs on the other core), so stop it again
+// once no tick is running; a restart would otherwise fail in esp_timer_start_once().
+inline void sample_clock_stop() {
+    s_sc_running = false;
+    if (SAMPLE_TIMER_MODE && s_sc_timer) {
+        esp_timer_stop(s_sc_timer);
+        while (s_sc_in_cb) delay(1);
+        esp_timer_stop(s_sc_timer);
+    }
+}
+
+// Polling mode: call from loop(); returns true if a tick was handled
+inline bool sample_clock_poll() {
+    if (SAMPLE_TIMER_MODE || !s_sc_running) return false;
+    uint32_t due = _sample_clock_take(esp_timer_get_time());
+    if (!due) return false;
+    if (s_sc_fn) s_sc_fn(due);
+    return true;
+}
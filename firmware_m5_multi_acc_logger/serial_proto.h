@@ -1,199 +1,526 @@
 #pragma once
 #include <Arduino.h>
 #include <LittleFS.h>
+#include <rom/crc.h>
 #include "config.h"
 #include "board_hal.h"
 #include "fs_format.h"
-// For IMU register access
+#include "perf_stats.h"
+#include "stage_stats.h"
+#include "log_codec.h"
+#include "stream_out.h"
+#include "session_store.h"
+#include "trigger.h"
+#include "summary.h"
+#include "imu_driver.h"
+#include "imu_calib.h"
+#include "cmd_line.h"
+#include "nv_settings.h"
+// For I2CSCAN
 #include <Wire.h>
-#if !HAL_IMU_IS_SH200Q
-#include "imu_mpu6886_unified.h"
-#endif
 
 // start/stop functions provided by main sketch
 void start_logging();
 void stop_logging();
 extern bool recording;
+extern uint32_t rec_session;
 
-#if HAL_IMU_IS_SH200Q
-// --- IMU register dump helpers (SH200Q) ---
-// These are inline to keep header-only and avoid separate TU.
-inline uint8_t _sh200q_read_u8(uint8_t reg) {
-    Wire1.beginTransmission(hal_imu_addr());
-    Wire1.write(reg);
-    Wire1.endTransmission(false);
-    Wire1.requestFrom(hal_imu_addr(), (uint8_t)1);
-    if (Wire1.available()) return Wire1.read();
-    return 0xFF;
-}
-inline uint16_t _decode_acc_odr(uint8_t v) {
-    struct E { uint8_t reg; uint16_t hz; } lut[] = {
-        {0x81,1024}, {0x89,512}, {0x91,256}, {0x99,128}, {0xA1,64}, {0xA9,32}, {0xB1,16}, {0xB9,8},
-    };
-    for (auto &e : lut) if (e.reg == v) return e.hz;
-    return 0;
-}
-inline uint16_t _decode_gyro_odr(uint8_t v) {
-    // Known values from M5 driver; 0x17/0x19 are best-effort
-    struct E { uint8_t reg; uint16_t hz; } lut[] = {
-        {0x11,1000}, {0x13,500}, {0x15,256}, {0x17,128}, {0x19,64},
-    };
-    for (auto &e : lut) if (e.reg == v) return e.hz;
-    return 0;
-}
-inline uint16_t _decode_acc_range_g(uint8_t v) {
-    switch (v & 0x03) { // 0x00:±4g, 0x01:±8g, 0x02:±16g
-        case 0x00: return 4;
-        case 0x01: return 8;
-        case 0x02: return 16;
-    }
-    return 0;
-}
-inline uint16_t _decode_gyro_range_dps(uint8_t v) {
-    // 0x00:±2000dps in M5 driver. Others mapped best-effort.
-    switch (v & 0x07) {
-        case 0x00: return 2000;
-        case 0x01: return 1000;
-        case 0x02: return 500;
-        case 0x03: return 250;
-        case 0x04: return 125;
-    }
-    return 0;
-}
-#endif
+// --- DUMPX: framed, ranged, resumable dump ---
+// "DUMPX <offset> <length> [id]" (length 0 = to the end of file, id 0/omitted = newest session) replies
+//   "OKX <file_size> <offset> <length> <frame_size> <window> <millis>\n"
+// followed by frames (little-endian):
+//   [0xA5 0x5A][uint32 seq][uint16 len][payload][uint32 crc32 of seq..payload]
+// frame seq covers file bytes [offset + seq * frame_size, + len).
+// ホストからの行: "A <n>" = n 未満のフレームを全て受信済み（ウィンドウを進める）、
+// "N <seq>" = そのフレームだけ再送、"X" = 中止。全フレームACK後に "DONEX\n"、
+// 応答が途絶えたら "ABORTX\n" で終わる（ホストは受信済み位置から DUMPX で再開する）。
+static const size_t DUMPX_HDR_SIZE = 2 + 4 + 2;
 
-inline void serial_proto_poll() {
-    if (!Serial.available()) return;
-    String cmd = Serial.readStringUntil('\n');
-    cmd.trim();
-    if (cmd == "PING") {
-        Serial.println("PONG");
-    } else if (cmd == "INFO") {
-        size_t size = 0;
-        bool has_head = false;
-        uint64_t uid = ESP.getEfuseMac();
-        if (LittleFS.exists(LOG_FILE_NAME)) {
-            File f = LittleFS.open(LOG_FILE_NAME, "r");
-            size = f.size();
-            // Check magic
-            uint8_t m[8] = {0};
-            if (f.read(m, 8) == 8) {
-                has_head = (m[0]=='A' && m[1]=='C' && m[2]=='C' && m[3]=='L' && m[4]=='O' && m[5]=='G');
-            }
-            f.close();
+inline void _dumpx_send_frame(FsLogReader& f, uint32_t offset, uint32_t length, uint32_t seq) {
+    static uint8_t frame[DUMPX_HDR_SIZE + DUMPX_FRAME_SIZE + 4];
+    const uint32_t pos = seq * DUMPX_FRAME_SIZE;
+    const uint16_t len = (length - pos < DUMPX_FRAME_SIZE) ? (uint16_t)(length - pos) : DUMPX_FRAME_SIZE;
+    frame[0] = 0xA5;
+    frame[1] = 0x5A;
+    memcpy(frame + 2, &seq, 4);
+    memcpy(frame + 6, &len, 2);
+    fs_log_read(f, offset + pos, frame + DUMPX_HDR_SIZE, len);
+    const uint32_t crc = crc32_le(0, frame + 2, 6 + len);
+    memcpy(frame + DUMPX_HDR_SIZE + len, &crc, 4);
+    Serial.write(frame, DUMPX_HDR_SIZE + len + 4);
+}
+
+inline void _serial_dumpx(uint32_t id, uint32_t offset, uint32_t length) {
+    FsLogReader f;
+    if (!session_open(id, f)) {
+        Serial.println("ERR");
+        return;
+    }
+    const uint32_t size = f.size;
+    if (offset > size) offset = size;
+    if (length == 0 || length > size - offset) length = size - offset;
+    const uint32_t nframes = (length + DUMPX_FRAME_SIZE - 1) / DUMPX_FRAME_SIZE;
+    Serial.printf("OKX %u %u %u %u %u %u\n", (unsigned)size, (unsigned)offset, (unsigned)length,
+                  (unsigned)DUMPX_FRAME_SIZE, (unsigned)DUMPX_WINDOW, (unsigned)millis());
+    uint32_t base = 0;   // oldest unacknowledged frame
+    uint32_t next = 0;   // next frame to send
+    uint32_t last_rx_ms = millis();
+    uint32_t last_progress_ms = last_rx_ms;
+    char line[24];
+    size_t ln = 0;
+    while (base < nframes) {
+        while (next < nframes && next - base < DUMPX_WINDOW) {
+            _dumpx_send_frame(f, offset, length, next++);
         }
-        Serial.printf(
-            "{\"uid\":\"0x%016llX\",\"odr\":%u,\"range_g\":%u,\"gyro_dps\":%u,\"imu_type\":%u,\"device_model\":%u,\"format\":\"0x0201\",\"lsb_per_g\":%.3f,\"lsb_per_dps\":%.3f,\"file_size\":%u,\"fs_total\":%u,\"fs_used\":%u,\"fs_free\":%u,\"fs_used_pct\":%u,\"has_head\":%u}\n",
-            (unsigned long long)uid, ODR_HZ, RANGE_G, GYRO_RANGE_DPS, (unsigned)HAL_IMU_TYPE, (unsigned)HAL_DEVICE_MODEL,
-            (float)(32768.0f / (float)RANGE_G), (float)(32768.0f / (float)GYRO_RANGE_DPS),
-            (unsigned)size, (unsigned)fs_total_bytes(), (unsigned)fs_used_bytes(), (unsigned)fs_free_bytes(), (unsigned)fs_used_pct(),
-            (unsigned)has_head
-        );
-    } else if (cmd == "HEAD") {
-        if (LittleFS.exists(LOG_FILE_NAME)) {
-            File f = LittleFS.open(LOG_FILE_NAME, "r");
-            uint8_t buf[64];
-            size_t n = f.read(buf, sizeof(buf));
-            f.close();
-            // Print as hex
-            Serial.print("HEAD ");
-            const char hex[] = "0123456789abcdef";
-            for (size_t i = 0; i < n; ++i) {
-                uint8_t b = buf[i];
-                Serial.write(hex[(b >> 4) & 0xF]);
-                Serial.write(hex[b & 0xF]);
+        while (Serial.available()) {
+            const int c = Serial.read();
+            if (c != '\n' && c != '\r') {
+                if (ln < sizeof(line) - 1) line[ln++] = (char)c;
+                continue;
             }
-            Serial.print("\n");
-        } else {
-            Serial.println("HEAD");
-        }
-    } else if (cmd == "DUMP") {
-        if (LittleFS.exists(LOG_FILE_NAME)) {
-            File f = LittleFS.open(LOG_FILE_NAME, "r");
-            size_t size = f.size();
-            // Include device current millis in OK line for PC-side timestamping
-            Serial.printf("OK %u %u\n", (unsigned)size, (unsigned)millis());
-            // Larger buffer reduces per-call overhead during transfer
-            static uint8_t buf[1024];
-            while (f.available()) {
-                size_t n = f.read(buf, sizeof(buf));
-                Serial.write(buf, n);
+            if (ln == 0) continue;
+            line[ln] = '\0';
+            ln = 0;
+            last_rx_ms = millis();
+            const uint32_t v = strtoul(line + 1, nullptr, 10);
+            if (line[0] == 'A') {
+                if (v > base && v <= next) {
+                    base = v;
+                    last_progress_ms = last_rx_ms;
+                }
+            } else if (line[0] == 'N') {
+                if (v >= base && v < next) _dumpx_send_frame(f, offset, length, v);
+            } else if (line[0] == 'X') {
+                fs_log_close(f);
+                Serial.print("ABORTX\n");
+                return;
             }
-            f.close();
-            Serial.print("\nDONE\n");
-        } else {
-            Serial.println("ERR");
         }
-    } else if (cmd == "ERASE") {
-        if (LittleFS.exists(LOG_FILE_NAME)) {
-            LittleFS.remove(LOG_FILE_NAME);
+        const uint32_t now_ms = millis();
+        if (now_ms - last_rx_ms > DUMPX_ABORT_MS) {
+            fs_log_close(f);
+            Serial.print("ABORTX\n");
+            return;
         }
+        if (base < next && now_ms - last_progress_ms > DUMPX_RETRY_MS) {
+            _dumpx_send_frame(f, offset, length, base);
+            last_progress_ms = now_ms;
+        }
+        delay(0);
+    }
+    fs_log_close(f);
+    Serial.print("DONEX\n");
+}
+
+// Command line being received (serial_proto_poll)
+static CmdLine<SERIAL_LINE_MAX> s_sp_line = {};
+static uint32_t s_sp_rx_ms = 0;
+
+// --- BAUD: runtime UART rate, switch-and-confirm ---
+// "BAUD <rate>" → "BAUD SWITCH <rate> <confirm_ms>" at the old rate, then the UART switches.
+// The host answers "BAUD OK" at the new rate → "OK BAUD <rate>" (kept in NVS for the next boot);
+// without it the old rate returns after SERIAL_BAUD_CONFIRM_MS → "BAUD REVERT <rate>".
+// "BAUD" → "OK BAUD <rate>". Unsupported rate → "ERR BAUD".
+static uint32_t s_baud = SERIAL_BAUD;
+static uint32_t s_baud_prev = 0;       // rate to go back to while a switch is unconfirmed (0 = none)
+static uint32_t s_baud_deadline_ms = 0;
+
+inline bool serial_baud_supported(uint32_t rate) {
+    for (uint32_t r : SERIAL_BAUD_RATES) if (r == rate) return true;
+    return false;
+}
+
+inline uint32_t serial_baud() { return s_baud; }
+
+// setup(): open the UART at the last confirmed rate
+inline void serial_proto_begin() {
+    const uint32_t saved = nv_get_u32("baud", SERIAL_BAUD);
+    s_baud = serial_baud_supported(saved) ? saved : SERIAL_BAUD;
+    Serial.begin(s_baud);
+}
+
+// Switch the UART once the reply has left; bytes received meanwhile were sent at the old rate
+inline void _serial_baud_apply(uint32_t rate) {
+    Serial.flush();
+    Serial.updateBaudRate(rate);
+    s_baud = rate;
+    while (Serial.available()) Serial.read();
+}
+
+// serial_proto_poll(): revert an unconfirmed switch
+inline void _serial_baud_check() {
+    if (!s_baud_prev || (int32_t)(millis() - s_baud_deadline_ms) < 0) return;
+    _serial_baud_apply(s_baud_prev);
+    s_baud_prev = 0;
+    Serial.printf("BAUD REVERT %u\n", (unsigned)s_baud);
+}
+
+// --- Commands: one handler per name, args = rest of the line after the name ("" if none) ---
+
+inline void _cmd_ping(const char*) {
+    Serial.println("PONG");
+}
+
+inline void _cmd_info(const char*) {
+    size_t size = 0;
+    bool has_head = false;
+    uint64_t uid = ESP.getEfuseMac();
+    // Newest session
+    uint32_t id = 0;
+    FsLogReader f;
+    if (session_open(id, f)) {
+        size = f.size;
+        // Check magic
+        uint8_t m[8] = {0};
+        if (fs_log_read(f, 0, m, 8) == 8) {
+            has_head = (m[0]=='A' && m[1]=='C' && m[2]=='C' && m[3]=='L' && m[4]=='O' && m[5]=='G');
+        }
+        fs_log_close(f);
+    }
+    const DevConfig& cfg = imu_config();
+    char rates[64];
+    size_t rn = 0;
+    for (uint32_t r : SERIAL_BAUD_RATES) {
+        rn += snprintf(rates + rn, sizeof(rates) - rn, "%s%u", rn ? "," : "", (unsigned)r);
+        if (rn >= sizeof(rates)) break;
+    }
+    Serial.printf(
+        "{\"uid\":\"0x%016llX\",\"odr\":%u,\"range_g\":%u,\"gyro_dps\":%u,\"imu_type\":%u,\"device_model\":%u,\"format\":\"0x%04X\",\"lsb_per_g\":%.3f,\"lsb_per_dps\":%.3f,\"file_size\":%u,\"fs_total\":%u,\"fs_used\":%u,\"fs_free\":%u,\"fs_used_pct\":%u,\"has_head\":%u,\"session\":%u,\"sessions\":%u,\"decim\":%u,\"trig\":%u,\"segments\":%u,\"summary\":%u,\"baud\":%u,\"baud_rates\":[%s],\"calib\":\"%s\",\"dlpf\":%u}\n",
+        (unsigned long long)uid, (unsigned)cfg.odr_hz, (unsigned)cfg.range_g, (unsigned)cfg.gyro_dps,
+        (unsigned)ImuDriver::TYPE, (unsigned)HAL_DEVICE_MODEL,
+        (unsigned)LOG_FORMAT_VER, (float)(32768.0f / (float)cfg.range_g), (float)(32768.0f / (float)cfg.gyro_dps),
+        (unsigned)size, (unsigned)fs_total_bytes(), (unsigned)fs_used_bytes(), (unsigned)fs_free_bytes(), (unsigned)fs_used_pct(),
+        (unsigned)has_head, (unsigned)id, (unsigned)session_count(), (unsigned)DECIM_FACTOR,
+        (unsigned)TRIGGER_MODE, (unsigned)trigger_segments(),
+        (unsigned)(SUMMARY_ONLY ? 2 : SUMMARY_ENABLE ? 1 : 0), (unsigned)s_baud, rates,
+        IMU_CAL_SRC_NAMES[imu_calib_src()], (unsigned)ImuDriver::dlpf_hz(IMU_FIFO_MODE)
+    );
+}
+
+inline void _cmd_list(const char*) {
+    // One line per session, oldest first: "S <id> <size> <samples> <start_ms> <format>"
+    uint32_t n = 0;
+    for (uint32_t id = session_oldest(); id && id < s_sess.next_id; ++id) {
+        const SessionEntry* e = session_find(id);
+        if (!e) continue;
+        uint32_t size = e->size;
+        if (e->samples == 0xFFFFFFFF) {
+            // Being recorded: size from the log itself
+            FsLogReader f;
+            if (fs_log_open(f, id)) size = f.size;
+            fs_log_close(f);
+        }
+        Serial.printf("S %u %u %d %u 0x%04X\n", (unsigned)e->id, (unsigned)size,
+                      (e->samples == 0xFFFFFFFF) ? -1 : (int)e->samples, (unsigned)e->start_ms, (unsigned)e->format);
+        n++;
+    }
+    Serial.printf("END %u\n", (unsigned)n);
+}
+
+inline void _cmd_head(const char* args) {
+    uint32_t id = (uint32_t)strtoul(args, nullptr, 10);
+    FsLogReader f;
+    if (session_open(id, f)) {
+        uint8_t buf[64];
+        size_t n = fs_log_read(f, 0, buf, sizeof(buf));
+        fs_log_close(f);
+        // Print as hex
+        Serial.print("HEAD ");
+        const char hex[] = "0123456789abcdef";
+        for (size_t i = 0; i < n; ++i) {
+            uint8_t b = buf[i];
+            Serial.write(hex[(b >> 4) & 0xF]);
+            Serial.write(hex[b & 0xF]);
+        }
+        Serial.print("\n");
+    } else {
+        Serial.println("HEAD");
+    }
+}
+
+inline void _cmd_dump(const char* args) {
+    uint32_t id = (uint32_t)strtoul(args, nullptr, 10);
+    FsLogReader f;
+    if (session_open(id, f)) {
+        size_t size = f.size;
+        // Include device current millis in OK line for PC-side timestamping
+        Serial.printf("OK %u %u\n", (unsigned)size, (unsigned)millis());
+        // Larger buffer reduces per-call overhead during transfer
+        static uint8_t buf[1024];
+        for (size_t pos = 0; pos < size; ) {
+            size_t n = fs_log_read(f, pos, buf, (size - pos < sizeof(buf)) ? size - pos : sizeof(buf));
+            if (n == 0) break;
+            Serial.write(buf, n);
+            pos += n;
+        }
+        fs_log_close(f);
+        Serial.print("\nDONE\n");
+    } else {
+        Serial.println("ERR");
+    }
+}
+
+inline void _cmd_sumdump(const char* args) {
+    // Summary file of a session (SUMMARY_ENABLE), same framing as DUMP
+    uint32_t id = (uint32_t)strtoul(args, nullptr, 10);
+    if (!id) id = session_latest();
+    char path[FS_PATH_MAX];
+    fs_sum_path(id, path, sizeof(path));
+    File f = LittleFS.open(path, "r");
+    if (f) {
+        // While recording, up to the last flush (LOG_CHECKPOINT_MS)
+        const size_t size = f.size();
+        Serial.printf("OK %u %u\n", (unsigned)size, (unsigned)millis());
+        static uint8_t buf[512];
+        for (size_t pos = 0; pos < size; ) {
+            size_t n = f.read(buf, (size - pos < sizeof(buf)) ? size - pos : sizeof(buf));
+            if (n == 0) break;
+            Serial.write(buf, n);
+            pos += n;
+        }
+        f.close();
+        Serial.print("\nDONE\n");
+    } else {
+        Serial.println("ERR");
+    }
+}
+
+inline void _cmd_dumpx(const char* args) {
+    unsigned offset = 0, length = 0, id = 0;
+    sscanf(args, "%u %u %u", &offset, &length, &id);
+    _serial_dumpx(id, offset, length);
+}
+
+inline void _cmd_erase(const char* args) {
+    if (!*args) {
+        // All sessions except the one being recorded
+        session_erase_all(recording ? rec_session : 0);
+        if (!recording) log_ckpt_clear();
         Serial.println("OK");
-    } else if (cmd == "START") {
-        if (!recording) start_logging();
-        Serial.println("OK");
-    } else if (cmd == "STOP") {
-        if (recording) stop_logging();
-        Serial.println("OK");
-    } else if (cmd == "I2CSCAN") {
-        Serial.println("I2C scan start");
-        for (uint8_t addr = 3; addr < 0x78; ++addr) {
-            Wire.beginTransmission(addr);
-            uint8_t err = Wire.endTransmission();
-            if (err == 0) {
-                Serial.printf("I2C found: 0x%02X\n", addr);
-            } else if (err == 4) {
-                Serial.printf("I2C unknown error at 0x%02X\n", addr);
-            }
+        return;
+    }
+    uint32_t id = (uint32_t)strtoul(args, nullptr, 10);
+    if (recording && id == rec_session) {
+        Serial.println("ERR BUSY");
+    } else {
+        Serial.println(session_erase(id) ? "OK" : "ERR");
+    }
+}
+
+inline void _cmd_start(const char*) {
+    if (!recording) start_logging();
+    Serial.println("OK");
+}
+
+inline void _cmd_stop(const char*) {
+    if (recording) stop_logging();
+    Serial.println("OK");
+}
+
+inline void _cmd_stream(const char* args) {
+    if (strcmp(args, "OFF") == 0) {
+        stream_stop();
+        Serial.printf("OK STREAM frames:%u dropped:%u\n", (unsigned)stream_frames(), (unsigned)stream_dropped());
+        return;
+    }
+    unsigned decim = 1, mask = 0x3F;
+    sscanf(args, "%u %x", &decim, &mask);
+    stream_start((uint16_t)decim, (uint8_t)mask);
+    Serial.printf("OK STREAM %u 0x%02X\n", (unsigned)stream_decim(), (unsigned)stream_mask());
+}
+
+inline void _cmd_perf(const char*) {
+    // Loop benchmark of the current/last recording
+    perf_print(Serial);
+}
+
+inline void _cmd_stats(const char* args) {
+    if (strcmp(args, "RESET") == 0) {
+        stats_reset();
+        Serial.println("OK STATS RESET");
+        return;
+    }
+    // Per-stage timing / histograms since the last STATS RESET (stage_stats.h)
+    stats_print(Serial);
+}
+
+inline void _cmd_i2cscan(const char*) {
+    Serial.println("I2C scan start");
+    for (uint8_t addr = 3; addr < 0x78; ++addr) {
+        Wire.beginTransmission(addr);
+        uint8_t err = Wire.endTransmission();
+        if (err == 0) {
+            Serial.printf("I2C found: 0x%02X\n", addr);
+        } else if (err == 4) {
+            Serial.printf("I2C unknown error at 0x%02X\n", addr);
         }
-        Serial.println("I2C scan done");
-    } else if (cmd == "REGS") {
-#if HAL_IMU_IS_SH200Q
-        uint8_t r0E = _sh200q_read_u8(0x0E);
-        uint8_t r0F = _sh200q_read_u8(0x0F);
-        uint8_t r16 = _sh200q_read_u8(0x16);
-        uint8_t r2B = _sh200q_read_u8(0x2B);
-        uint16_t a_odr = _decode_acc_odr(r0E);
-        uint16_t g_odr = _decode_gyro_odr(r0F);
-        uint16_t a_rng = _decode_acc_range_g(r16);
-        uint16_t g_rng = _decode_gyro_range_dps(r2B);
-        Serial.printf(
-            "REGS 0E=0x%02X 0F=0x%02X 16=0x%02X 2B=0x%02X ACC_ODR=%uHz GYRO_ODR=%uHz ACC_RANGE=%ug GYRO_RANGE=%udps\n",
-            r0E, r0F, r16, r2B, (unsigned)a_odr, (unsigned)g_odr, (unsigned)a_rng, (unsigned)g_rng
-        );
-#else
-        // Minimal MPU6886 dump
-        auto mpu_read = [](uint8_t reg) {
-            Wire.beginTransmission(MPU6886_ADDR);
-            Wire.write(reg);
-            Wire.endTransmission(false);
-            Wire.requestFrom((int)MPU6886_ADDR, 1);
-            if (Wire.available()) return Wire.read();
-            return 0xFF;
-        };
-        auto mpu_whoami = [&]() {
-            Wire.beginTransmission(MPU6886_ADDR);
-            Wire.write(0x75);
-            Wire.endTransmission(false);
-            Wire.requestFrom((int)MPU6886_ADDR, 1);
-            if (Wire.available()) return Wire.read();
-            return 0xFF;
-        };
-        Wire.beginTransmission(MPU6886_ADDR);
-        int ack = Wire.endTransmission();
-        uint8_t cfg = mpu_read(MPU6886_REG_CONFIG);
-        uint8_t smpl = mpu_read(MPU6886_REG_SMPLRT_DIV);
-        uint8_t gcfg = mpu_read(MPU6886_REG_GYRO_CONFIG);
-        uint8_t acfg = mpu_read(MPU6886_REG_ACCEL_CONFIG);
-        uint8_t a2 = mpu_read(MPU6886_REG_ACCEL_CONFIG2);
-        uint8_t pm1 = mpu_read(MPU6886_REG_PWR_MGMT_1);
-        uint8_t pm2 = mpu_read(MPU6886_REG_PWR_MGMT_2);
-        Serial.printf(
-            "REGS ACK=%d CONFIG=0x%02X SMPLRT_DIV=%u GYRO_CONFIG=0x%02X ACCEL_CONFIG=0x%02X ACCEL_CONFIG2=0x%02X PWR_MGMT_1=0x%02X PWR_MGMT_2=0x%02X WHOAMI=0x%02X\n",
-            ack, cfg, smpl, gcfg, acfg, a2, pm1, pm2, mpu_whoami()
-        );
-#endif
+    }
+    Serial.println("I2C scan done");
+}
+
+inline void _cmd_baud(const char* args) {
+    if (!*args) {
+        Serial.printf("OK BAUD %u\n", (unsigned)s_baud);
+        return;
+    }
+    if (strcmp(args, "OK") == 0) {
+        if (!s_baud_prev) {
+            Serial.println("ERR BAUD");
+            return;
+        }
+        s_baud_prev = 0;
+        nv_put_u32("baud", s_baud);
+        Serial.printf("OK BAUD %u\n", (unsigned)s_baud);
+        return;
+    }
+    const uint32_t rate = (uint32_t)strtoul(args, nullptr, 10);
+    if (!serial_baud_supported(rate)) {
+        Serial.println("ERR BAUD");
+        return;
+    }
+    Serial.printf("BAUD SWITCH %u %u\n", (unsigned)rate, (unsigned)SERIAL_BAUD_CONFIRM_MS);
+    // A switch during an unconfirmed one still reverts to the last confirmed rate
+    if (!s_baud_prev) s_baud_prev = s_baud;
+    s_baud_deadline_ms = millis() + SERIAL_BAUD_CONFIRM_MS;
+    _serial_baud_apply(rate);
+    cmd_line_reset(s_sp_line);
+}
+
+// "CALIB" → status line (imu_calib_print). "CALIB ACC" → capture one accel orientation
+// ("OK CALIB ACC <pose> <n>/6", "ERR CALIB STILL" when moving). "CALIB CLEAR" → forget all.
+inline void _cmd_calib(const char* args) {
+    if (!*args) {
+        imu_calib_print(Serial);
+        return;
+    }
+    if (recording) {
+        Serial.println("ERR BUSY");
+        return;
+    }
+    if (strcmp(args, "ACC") == 0) {
+        const int pose = imu_calib_acc_capture();
+        if (pose < 0) {
+            Serial.println("ERR CALIB STILL");
+            return;
+        }
+        // The sixth pose completes (and stores) the set, the counter starts over
+        const uint8_t n = imu_calib_pose_count();
+        Serial.printf("OK CALIB ACC %s %u/6\n", IMU_CAL_POSE_NAMES[pose], (unsigned)(n ? n : 6));
+    } else if (strcmp(args, "CLEAR") == 0) {
+        imu_calib_clear();
+        Serial.println("OK CALIB CLEAR");
     } else {
-        Serial.println("UNKNOWN");
+        Serial.println("ERR CALIB");
+    }
+}
+
+inline void config_print(const char* prefix) {
+    const DevConfig& c = imu_config();
+    Serial.printf("%sCONFIG odr:%u range_g:%u gyro_dps:%u dlpf:%u sample_hz:%u\n", prefix, (unsigned)c.odr_hz,
+                  (unsigned)c.range_g, (unsigned)c.gyro_dps, (unsigned)ImuDriver::dlpf_hz(IMU_FIFO_MODE),
+                  (unsigned)(IMU_FIFO_MODE ? imu_fifo_odr_hz() : imu_sample_hz()));
+}
+
+// "CONFIG" / "CONFIG GET" → running configuration. "CONFIG SET odr=<hz> range_g=<g> gyro_dps=<dps> dlpf=<hz>"
+// (any subset; odr / dlpf rounded to what the IMU supports, dlpf=0 automatic) → re-initializes the IMU,
+// saves to NVS, "OK CONFIG ..." with the values in effect; "ERR CONFIG <key>" leaves everything as it was.
+// "CONFIG RESET" → config.h defaults. dlpf is the bandwidth the IMU runs at (0: automatic / unknown).
+inline void _cmd_config(const char* args) {
+    if (!*args || strcmp(args, "GET") == 0) {
+        config_print("");
+        return;
+    }
+    if (recording) {
+        Serial.println("ERR BUSY");
+        return;
+    }
+    const DevConfig old = imu_config();
+    DevConfig c = old;
+    DevConfigErr e;
+    bool init_ok = true;
+    if (strcmp(args, "RESET") == 0) {
+        e = imu_config_reset(c, &init_ok);
+    } else if (strncmp(args, "SET ", 4) == 0) {
+        e = dev_config_parse(c, args + 4);
+        if (e == DEVCFG_OK) e = imu_config_set(c, &init_ok);
+        if (e == DEVCFG_OK) imu_config_save();
+    } else {
+        e = DEVCFG_SYNTAX;
+    }
+    if (e != DEVCFG_OK) {
+        Serial.printf("ERR CONFIG %s\n", DEVCFG_KEYS[e]);
+        return;
+    }
+    imu_calib_on_config(old.range_g, old.gyro_dps);
+    if (!init_ok) Serial.println("IMU_INIT 0");
+    config_print("OK ");
+}
+
+inline void _cmd_regs(const char*) {
+    ImuDriver::print_regs(Serial);
+}
+
+typedef void (*SerialCmdFn)(const char* args);
+
+struct SerialCmd {
+    const char* name;
+    SerialCmdFn fn;
+};
+
+static const SerialCmd SERIAL_CMDS[] = {
+    { "PING", _cmd_ping },
+    { "INFO", _cmd_info },
+    { "LIST", _cmd_list },
+    { "HEAD", _cmd_head },
+    { "DUMP", _cmd_dump },
+    { "SUMDUMP", _cmd_sumdump },
+    { "DUMPX", _cmd_dumpx },
+    { "ERASE", _cmd_erase },
+    { "START", _cmd_start },
+    { "STOP", _cmd_stop },
+    { "STREAM", _cmd_stream },
+    { "PERF", _cmd_perf },
+    { "STATS", _cmd_stats },
+    { "I2CSCAN", _cmd_i2cscan },
+    { "REGS", _cmd_regs },
+    { "BAUD", _cmd_baud },
+    { "CALIB", _cmd_calib },
+    { "CONFIG", _cmd_config },
+};
+
+// Run one complete line (modified in place)
+inline void serial_proto_dispatch(char* line) {
+    const char* args = cmd_line_split(line);
+    for (const SerialCmd& c : SERIAL_CMDS) {
+        if (strcmp(line, c.name) == 0) {
+            c.fn(args);
+            return;
+        }
+    }
+    Serial.println("UNKNOWN");
+}
+
+// Called from loop() every iteration: takes at most SERIAL_POLL_MAX_BYTES already received bytes and
+// runs at most one command. Never waits for the rest of a line and never allocates; a partial
+// line stays in s_sp_line until its newline arrives, or is dropped after SERIAL_LINE_TIMEOUT_MS
+// without bytes (a stray byte must not prefix the next command).
+inline void serial_proto_poll() {
+    _serial_baud_check();
+    int n = Serial.available();
+    if (n <= 0) {
+        if (s_sp_line.len && millis() - s_sp_rx_ms >= SERIAL_LINE_TIMEOUT_MS) cmd_line_reset(s_sp_line);
+        return;
+    }
+    s_sp_rx_ms = millis();
+    if (n > SERIAL_POLL_MAX_BYTES) n = SERIAL_POLL_MAX_BYTES;
+    while (n-- > 0) {
+        const int c = Serial.read();
+        if (c < 0) return;
+        switch (cmd_line_feed(s_sp_line, (char)c)) {
+            case CMD_LINE: serial_proto_dispatch(s_sp_line.buf); return;
+            case CMD_TOOLONG: Serial.println("ERR TOOLONG"); return;
+            case CMD_GARBAGE: Serial.println("UNKNOWN"); return;
+            default: break;
+        }
     }
 }
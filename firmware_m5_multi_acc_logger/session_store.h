@@ -0,0 +1,216 @@
+#pragma once
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <rom/crc.h>
+#include "config.h"
+#include "fs_format.h"
+
+// Multi-session log store.
+// 記録ごとに別ログ（LittleFS なら /L000001.BIN ...、LOG_RAW_PARTITION なら raw_log.h）を作り、RAM上のインデックス（SESSION_INDEX_FILE に保存）
+// で管理する。セッションIDは単調増加で、スロットは id % SESSION_MAX の固定位置なので
+// 検索は O(1)（ディレクトリ走査や LittleFS.exists() を使わない）。
+// 生存中のIDは常に [next_id - SESSION_MAX, next_id) に収まるよう、新規作成時に
+// 件数上限・空き容量不足なら古い順に削除する。
+// インデックスが壊れている／無い場合のみ、起動時に1回ディレクトリを走査して再構築する。
+
+struct SessionEntry {
+    uint32_t id;        // 0 = free slot
+    uint32_t start_ms;  // LogHeader::start_unix_ms
+    uint32_t samples;   // 0xFFFFFFFF while recording (or cut by power loss)
+    uint32_t size;      // file size in bytes
+    uint16_t format;    // LogHeader::format_ver
+    uint16_t reserved;
+};
+
+struct SessionIndex {
+    uint32_t magic;
+    uint32_t next_id;
+    SessionEntry e[SESSION_MAX];
+    uint32_t crc;
+};
+
+static const uint32_t SESSION_INDEX_MAGIC = 0x58444953; // "SIDX"
+static SessionIndex s_sess = {};
+
+inline SessionEntry* session_find(uint32_t id) {
+    if (id == 0) return nullptr;
+    SessionEntry& e = s_sess.e[id % SESSION_MAX];
+    return (e.id == id) ? &e : nullptr;
+}
+
+inline uint16_t session_count() {
+    uint16_t n = 0;
+    for (const SessionEntry& e : s_sess.e) if (e.id) n++;
+    return n;
+}
+
+// Newest / oldest live session (0 if none); bounded by SESSION_MAX slots
+inline uint32_t session_latest() {
+    for (uint32_t k = 1; k <= SESSION_MAX && k < s_sess.next_id; ++k) {
+        if (session_find(s_sess.next_id - k)) return s_sess.next_id - k;
+    }
+    return 0;
+}
+
+inline uint32_t session_oldest() {
+    uint32_t id = (s_sess.next_id > SESSION_MAX) ? s_sess.next_id - SESSION_MAX : 1;
+    for (; id < s_sess.next_id; ++id) {
+        if (session_find(id)) return id;
+    }
+    return 0;
+}
+
+inline void session_save() {
+    s_sess.magic = SESSION_INDEX_MAGIC;
+    s_sess.crc = crc32_le(0, reinterpret_cast<const uint8_t*>(&s_sess), offsetof(SessionIndex, crc));
+    File f = LittleFS.open(SESSION_INDEX_FILE, "w");
+    if (!f) return;
+    f.write(reinterpret_cast<const uint8_t*>(&s_sess), sizeof(s_sess));
+    f.close();
+}
+
+inline bool session_erase(uint32_t id) {
+    SessionEntry* e = session_find(id);
+    if (!e) return false;
+    fs_log_remove(id);
+    *e = {};
+    session_save();
+    return true;
+}
+
+// keep: session to leave alone (the one being recorded), 0 = none
+inline void session_erase_all(uint32_t keep = 0) {
+    for (SessionEntry& e : s_sess.e) {
+        if (!e.id || e.id == keep) continue;
+        fs_log_remove(e.id);
+        e = {};
+    }
+    session_save();
+}
+
+// Drop entries whose log is gone. Only the raw partition loses logs on its own
+// (oldest sessions overwritten by the circular log); LittleFS files go through session_erase().
+inline void session_prune() {
+    if (!LOG_RAW_PARTITION) return;
+    bool changed = false;
+    for (SessionEntry& e : s_sess.e) {
+        if (e.id && !fs_log_exists(e.id)) {
+            fs_sum_remove(e.id);
+            e = {};
+            changed = true;
+        }
+    }
+    if (changed) session_save();
+}
+
+// Add an entry for an existing log (index rebuild)
+inline void _session_adopt(uint32_t id) {
+    FsLogReader r;
+    if (!fs_log_open(r, id)) return;
+    SessionEntry e = {};
+    e.id = id;
+    e.size = r.size;
+    e.samples = 0xFFFFFFFF;
+    uint8_t h[64];
+    if (fs_log_read(r, 0, h, sizeof(h)) == sizeof(h) && memcmp(h, "ACCLOG", 6) == 0) {
+        memcpy(&e.format, h + 8, 2);
+        memcpy(&e.start_ms, h + 18, 4);
+        memcpy(&e.samples, h + FS_LOG_TOTALS_OFS, 4);
+    }
+    fs_log_close(r);
+    SessionEntry& slot = s_sess.e[id % SESSION_MAX];
+    if (slot.id) {
+        // Two logs for one slot: the older one could never be found or reclaimed, so it is deleted
+        const uint32_t older = (slot.id < id) ? slot.id : id;
+        fs_log_remove(older);
+        if (older == id) return;
+    }
+    slot = e;
+    if (id >= s_sess.next_id) s_sess.next_id = id + 1;
+}
+
+// One-time directory scan when the index is missing or corrupt.
+// A single-file log from older firmware (LOG_FILE_NAME) becomes the newest session.
+// LOG_RAW_PARTITION: the sessions found by raw_log_mount() instead.
+// Of two logs sharing a slot (id % SESSION_MAX) the older one is deleted (_session_adopt).
+inline void _session_rebuild() {
+    s_sess = {};
+    s_sess.next_id = 1;
+    if (LOG_RAW_PARTITION) {
+        for (const RawSession& rs : s_raw_sess) {
+            if (rs.id) _session_adopt(rs.id);
+        }
+        session_save();
+        return;
+    }
+    File dir = LittleFS.open("/");
+    if (dir) {
+        for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+            const char* name = f.name();
+            if (*name == '/') name++;
+            unsigned id = 0;
+            const bool match = !f.isDirectory() && sscanf(name, "L%06u.BIN", &id) == 1 && id > 0;
+            f.close();
+            if (match) _session_adopt(id);
+        }
+        dir.close();
+    }
+    if (LittleFS.exists(LOG_FILE_NAME)) {
+        char path[FS_PATH_MAX];
+        fs_log_path(s_sess.next_id, path, sizeof(path));
+        if (LittleFS.rename(LOG_FILE_NAME, path)) _session_adopt(s_sess.next_id);
+    }
+    session_save();
+}
+
+// Load the index at boot (after fs_init)
+inline void session_init() {
+    File f = LittleFS.open(SESSION_INDEX_FILE, "r");
+    bool ok = false;
+    if (f) {
+        ok = f.read(reinterpret_cast<uint8_t*>(&s_sess), sizeof(s_sess)) == sizeof(s_sess)
+            && s_sess.magic == SESSION_INDEX_MAGIC && s_sess.next_id > 0
+            && s_sess.crc == crc32_le(0, reinterpret_cast<const uint8_t*>(&s_sess), offsetof(SessionIndex, crc));
+        f.close();
+    }
+    if (!ok) _session_rebuild();
+    session_prune();
+}
+
+// Reserve a new session: reclaims oldest sessions while the index is full
+// (or the slot is taken) or free space is below SESSION_MIN_FREE_BYTES.
+// Returns the new id; the caller creates the log with fs_log_create(id, ...).
+inline uint32_t session_create(uint32_t start_ms, uint16_t format) {
+    const uint32_t id = s_sess.next_id;
+    if (s_sess.e[id % SESSION_MAX].id) session_erase(s_sess.e[id % SESSION_MAX].id);
+    while (session_count() > 0 && fs_free_bytes() < SESSION_MIN_FREE_BYTES) {
+        session_erase(session_oldest());
+    }
+    SessionEntry& e = s_sess.e[id % SESSION_MAX];
+    e = {};
+    e.id = id;
+    e.start_ms = start_ms;
+    e.samples = 0xFFFFFFFF;
+    e.format = format;
+    s_sess.next_id = id + 1;
+    session_save();
+    return id;
+}
+
+// Record the final sample count / size (stop_logging or boot recovery)
+inline void session_close(uint32_t id, uint32_t samples, uint32_t size) {
+    SessionEntry* e = session_find(id);
+    if (!e) return;
+    e->samples = samples;
+    e->size = size;
+    session_save();
+    fs_usage_invalidate();
+    session_prune();
+}
+
+// Open session `id`, or the newest session when id == 0. False if there is none.
+inline bool session_open(uint32_t& id, FsLogReader& r) {
+    if (id == 0) id = session_latest();
+    if (!session_find(id)) return false;
+    return fs_log_open(r, id);
+}
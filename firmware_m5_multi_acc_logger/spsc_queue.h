@@ -0,0 +1,69 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// Lock-free single-producer / single-consumer ring (no Arduino / FreeRTOS dependency).
+// 生産者（push）と消費者（pop）はそれぞれ1つのタスク／スレッドに限る。別コアで同時に動いてよい。
+// head は push だけ、tail は pop だけが書く自走カウンタで、添字は & (N - 1)。要素を書いてから
+// head を release で進め、消費側は acquire で読んでから要素を読む（volatile だけでは
+// コンパイラ／CPU が要素の書き込みと head の更新を入れ替え得る）。N 個すべて使える（空きスロット不要）。
+// 満杯の push は待たずに false を返し overflow() に数える（呼び出し側が欠損として扱う）。
+
+template <typename T, size_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+    static_assert(N <= 0x80000000u, "SpscQueue size must fit the 32-bit counters");
+
+public:
+    static constexpr size_t CAPACITY = N;
+
+    // Producer side: never blocks
+    bool push(const T& v) {
+        const uint32_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) >= N) {
+            _overflow.store(_overflow.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        _buf[head & (N - 1)] = v;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T& out) {
+        const uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (_head.load(std::memory_order_acquire) == tail) return false;
+        out = _buf[tail & (N - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: the oldest element without removing it (nullptr when empty), valid until pop()
+    const T* front() const {
+        const uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (_head.load(std::memory_order_acquire) == tail) return nullptr;
+        return &_buf[tail & (N - 1)];
+    }
+
+    // Either side; exact only from the consumer (the producer may add more meanwhile)
+    size_t size() const {
+        return (size_t)(_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire));
+    }
+    bool empty() const { return size() == 0; }
+
+    // Pushes refused because the ring was full (since the last clear())
+    uint32_t overflow() const { return _overflow.load(std::memory_order_relaxed); }
+
+    // Only while neither side is running
+    void clear() {
+        _tail.store(_head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        _overflow.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    T _buf[N];
+    std::atomic<uint32_t> _head{0};
+    std::atomic<uint32_t> _tail{0};
+    std::atomic<uint32_t> _overflow{0};
+};
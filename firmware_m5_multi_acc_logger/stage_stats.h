@@ -0,0 +1,180 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// Hot-path stage instrumentation (STATS_ENABLE), serial `STATS` / `STATS RESET`.
+// サンプリング経路の各段（I2C読み出し・パッキング・flash書き込み・LCD描画・シリアル処理）を
+// CPUサイクルカウンタで計測し、段ごとに回数/最小/平均/最大と log2 ヒストグラム
+// （バケット k = [2^k, 2^(k+1)) サイクル）を持つ。加えてサンプリングティックの
+// ODR 周期に対するジッタ（log2 ヒストグラム、µs）、取りこぼしたティック数、
+// 1回の処理（I2C + パッキング）が周期（FIFO モードは1バースト分）を超えた回数を数える。
+// 各段は1つのタスクだけが更新する（サンプラ（ACQ_TASK の pack はパイプライン） / ライタ / loop）。STATS RESET は世代番号を進めるだけで、
+// 各段は次の更新時に自分で0から始め直すので、リセットと更新が競合しない。
+// STATS_ENABLE=false では計測呼び出しが空の inline になってコンパイル時に消え、STATS は "STATS OFF" を返す。
+
+enum StatStage : uint8_t {
+    STAT_I2C = 0,   // IMU read (one sample, or one FIFO burst)
+    STAT_PACK,      // decimation / trigger / codec / stream for the read samples (ACQ_TASK: per queued item)
+    STAT_FLUSH,     // log buffer -> flash (writer task)
+    STAT_LCD,       // LCD redraw
+    STAT_SERIAL,    // serial command poll
+    STAT_COUNT
+};
+
+static const char* const STAT_STAGE_NAMES[STAT_COUNT] = { "i2c", "pack", "flush", "lcd", "serial" };
+
+constexpr uint8_t STAT_HIST_BINS = 32;
+
+struct StageStat {
+    uint32_t epoch;
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t hist[STAT_HIST_BINS];
+};
+
+struct TickStat {
+    uint32_t epoch;
+    uint32_t ticks;       // sampling callbacks
+    uint32_t missed;      // ticks skipped (gap markers)
+    uint32_t overrun;     // callbacks whose I2C + packing outlasted their budget
+    uint32_t last_us;
+    uint32_t budget_us;
+    uint32_t budget_cyc;
+    uint32_t intervals;   // jitter samples (first tick of a recording has none)
+    uint32_t jit_max;
+    uint64_t jit_sum;
+    uint32_t hist[STAT_HIST_BINS];  // |interval - expected interval| in µs
+};
+
+static StageStat s_stats[STATS_ENABLE ? STAT_COUNT : 1];
+static TickStat s_stats_tick;
+static volatile uint32_t s_stats_epoch = 1;
+static volatile bool s_stats_tick_restart = true;
+static uint32_t s_stats_reset_ms = 0;
+
+inline uint8_t _stats_bin(uint32_t v) {
+    return (uint8_t)(31 - __builtin_clz(v | 1));
+}
+
+// Cycle counter at the start of a stage (0 when disabled)
+inline uint32_t stats_now() {
+    return STATS_ENABLE ? ESP.getCycleCount() : 0;
+}
+
+inline void stats_record(StatStage st, uint32_t cyc) {
+    if (!STATS_ENABLE) return;
+    StageStat& s = s_stats[st];
+    const uint32_t epoch = s_stats_epoch;
+    if (s.epoch != epoch) {
+        memset(&s, 0, sizeof(s));
+        s.epoch = epoch;
+        s.min = 0xFFFFFFFFu;
+    }
+    s.count++;
+    s.sum += cyc;
+    if (cyc < s.min) s.min = cyc;
+    if (cyc > s.max) s.max = cyc;
+    s.hist[_stats_bin(cyc)]++;
+}
+
+// End of a stage started at stats_now() == c0; returns its cycles
+inline uint32_t stats_add(StatStage st, uint32_t c0) {
+    if (!STATS_ENABLE) return 0;
+    const uint32_t cyc = ESP.getCycleCount() - c0;
+    stats_record(st, cyc);
+    return cyc;
+}
+
+// Stages that can outlast the 32-bit cycle counter (~17 s at 240 MHz, e.g. a DUMP inside the
+// serial poll): timed with micros() and stored as cycles (µs resolution, saturating at 2^32)
+inline uint32_t stats_now_us() {
+    return STATS_ENABLE ? micros() : 0;
+}
+inline void stats_add_us(StatStage st, uint32_t t0_us) {
+    if (!STATS_ENABLE) return;
+    const uint64_t cyc = (uint64_t)(micros() - t0_us) * getCpuFrequencyMhz();
+    stats_record(st, (cyc > 0xFFFFFFFFu) ? 0xFFFFFFFFu : (uint32_t)cyc);
+}
+
+// One sampling callback at t_us, expect_us after the previous one. missed: ticks lost before it,
+// busy_cyc: its I2C + packing cycles, an overrun when longer than budget_us.
+inline void stats_on_tick(uint32_t t_us, uint32_t expect_us, uint32_t budget_us, uint32_t missed, uint32_t busy_cyc) {
+    if (!STATS_ENABLE) return;
+    TickStat& t = s_stats_tick;
+    const uint32_t epoch = s_stats_epoch;
+    if (t.epoch != epoch) {
+        memset(&t, 0, sizeof(t));
+        t.epoch = epoch;
+    } else if (!s_stats_tick_restart) {
+        // the first tick of a recording has no interval
+        const uint32_t dt = t_us - t.last_us;
+        const uint32_t jit = (dt > expect_us) ? dt - expect_us : expect_us - dt;
+        t.intervals++;
+        t.jit_sum += jit;
+        if (jit > t.jit_max) t.jit_max = jit;
+        t.hist[_stats_bin(jit)]++;
+    }
+    s_stats_tick_restart = false;
+    t.last_us = t_us;
+    t.ticks++;
+    t.missed += missed;
+    if (budget_us != t.budget_us) {
+        t.budget_us = budget_us;
+        t.budget_cyc = budget_us * (uint32_t)getCpuFrequencyMhz();
+    }
+    if (busy_cyc > t.budget_cyc) t.overrun++;
+}
+
+// start_logging(): the sampler is stopped, the next tick starts a new interval chain
+inline void stats_tick_restart() {
+    s_stats_tick_restart = true;
+}
+
+inline void stats_reset() {
+    s_stats_epoch = s_stats_epoch + 1;
+    s_stats_reset_ms = millis();
+}
+
+inline void _stats_print_hist(Print& out, const uint32_t* hist, bool live) {
+    bool first = true;
+    for (uint8_t k = 0; k < STAT_HIST_BINS; ++k) {
+        if (!live || !hist[k]) continue;
+        out.printf("%s%u:%u", first ? "" : ",", (unsigned)k, (unsigned)hist[k]);
+        first = false;
+    }
+    if (first) out.print("-");
+}
+
+// "STATS cpu_mhz:<mhz> since_ms:<ms since reset>"
+// "STAGE <name> n:<count> us:<min>/<mean>/<max> hist:<k>:<count>,..."   (k: log2 of cycles)
+// "TICK n:<ticks> missed:<n> overrun:<n> jitter_us:<mean>/<max> hist:<k>:<count>,..."  (k: log2 of µs)
+// "END <stages>"
+inline void stats_print(Print& out) {
+    if (!STATS_ENABLE) {
+        out.println("STATS OFF");
+        return;
+    }
+    const uint32_t mhz = getCpuFrequencyMhz();
+    const uint32_t epoch = s_stats_epoch;
+    out.printf("STATS cpu_mhz:%u since_ms:%u\n", (unsigned)mhz, (unsigned)(millis() - s_stats_reset_ms));
+    for (uint8_t i = 0; i < STAT_COUNT; ++i) {
+        const StageStat& s = s_stats[i];
+        const bool live = (s.epoch == epoch) && s.count;
+        const uint32_t n = live ? s.count : 0;
+        const float mean = live ? (float)s.sum / (float)n / (float)mhz : 0.0f;
+        out.printf("STAGE %s n:%u us:%.1f/%.1f/%.1f hist:", STAT_STAGE_NAMES[i], (unsigned)n,
+                   live ? (float)s.min / (float)mhz : 0.0f, mean, live ? (float)s.max / (float)mhz : 0.0f);
+        _stats_print_hist(out, s.hist, live);
+        out.print("\n");
+    }
+    const TickStat& t = s_stats_tick;
+    const bool live = (t.epoch == epoch);
+    out.printf("TICK n:%u missed:%u overrun:%u jitter_us:%u/%u hist:",
+               (unsigned)(live ? t.ticks : 0), (unsigned)(live ? t.missed : 0), (unsigned)(live ? t.overrun : 0),
+               (unsigned)((live && t.intervals) ? t.jit_sum / t.intervals : 0), (unsigned)(live ? t.jit_max : 0));
+    _stats_print_hist(out, t.hist, live);
+    out.print("\n");
+    out.printf("END %u\n", (unsigned)STAT_COUNT);
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <stdint.h>
+
+// Stillness detector + gyro bias estimator (no Arduino dependency, no heap).
+// 生カウントのサンプルを still_calib_feed() に1つずつ渡す。window サンプルごとに軸別の分散を求め、
+// ジャイロ全軸の標準偏差が gyro_std_max 以下かつ加速度全軸が acc_std_max 以下ならその窓は静止。
+// 静止窓が min_windows 続いたらその間のジャイロ平均を最初のバイアスとし、以降は静止窓ごとに
+// 1/2^shift の重みで追従する（温度ドリフト）。動いている窓は捨てるだけで推定値は変えない。
+// バイアスは 1/256 カウント単位（Q8）で持つ。window は 4096 以下（64bit の分散計算が溢れない範囲）。
+
+struct StillCalibParams {
+    uint16_t window;        // samples per window (2..4096)
+    uint16_t min_windows;   // consecutive still windows before the first estimate
+    uint8_t shift;          // later still windows move the estimate by 1/2^shift of the difference
+    uint32_t gyro_std_max;  // raw counts
+    uint32_t acc_std_max;   // raw counts
+};
+
+struct StillCalib {
+    int64_t sum[6];         // current window: ax, ay, az, gx, gy, gz
+    uint64_t sq[6];
+    uint16_t n;
+    uint16_t run;           // consecutive still windows so far
+    int64_t run_sum[3];     // gyro sums of that run (first estimate)
+    uint32_t run_n;
+    int32_t bias_q8[3];     // gyro bias estimate, raw counts * 256
+    int32_t acc_mean[3];    // accel mean of the last still window, raw counts
+    bool valid;             // bias_q8 holds an estimate
+    bool still;             // the last complete window was still
+    uint32_t windows;       // complete windows since reset
+    uint32_t still_windows;
+};
+
+inline void still_calib_reset(StillCalib& c) {
+    c = StillCalib();
+}
+
+// Drop the window in progress and the current still run (the estimate stays), e.g. after a pause in the feed
+inline void still_calib_restart(StillCalib& c) {
+    for (uint8_t k = 0; k < 6; ++k) {
+        c.sum[k] = 0;
+        c.sq[k] = 0;
+    }
+    c.n = 0;
+    c.run = 0;
+    c.run_sum[0] = c.run_sum[1] = c.run_sum[2] = 0;
+    c.run_n = 0;
+    c.still = false;
+}
+
+// Start from a known bias (e.g. a stored one); later still windows keep tracking it
+inline void still_calib_seed(StillCalib& c, int32_t bx, int32_t by, int32_t bz) {
+    c.bias_q8[0] = bx * 256;
+    c.bias_q8[1] = by * 256;
+    c.bias_q8[2] = bz * 256;
+    c.valid = true;
+}
+
+// Estimate in raw counts (rounded)
+inline int32_t still_calib_bias(const StillCalib& c, uint8_t axis) {
+    const int32_t q = c.bias_q8[axis];
+    return (q >= 0) ? (q + 128) / 256 : -((-q + 128) / 256);
+}
+
+// Variance of the window <= std_max^2, without division: n * sq - sum^2 <= n^2 * std_max^2
+inline bool _still_calib_quiet(const StillCalib& c, uint8_t k, uint32_t std_max) {
+    const uint64_t n = c.n;
+    const uint64_t s = (uint64_t)(c.sum[k] < 0 ? -c.sum[k] : c.sum[k]);
+    return n * c.sq[k] - s * s <= n * n * (uint64_t)std_max * std_max;
+}
+
+// One raw sample. Returns true when a still window updated the estimate.
+inline bool still_calib_feed(StillCalib& c, const StillCalibParams& p,
+                             int16_t ax, int16_t ay, int16_t az, int16_t gx, int16_t gy, int16_t gz) {
+    const int16_t v[6] = { ax, ay, az, gx, gy, gz };
+    for (uint8_t k = 0; k < 6; ++k) {
+        c.sum[k] += v[k];
+        c.sq[k] += (uint64_t)((int32_t)v[k] * v[k]);
+    }
+    if (++c.n < p.window) return false;
+
+    bool still = true;
+    for (uint8_t k = 0; k < 6 && still; ++k) still = _still_calib_quiet(c, k, (k < 3) ? p.acc_std_max : p.gyro_std_max);
+    c.windows++;
+    c.still = still;
+    bool updated = false;
+    if (!still) {
+        c.run = 0;
+        c.run_sum[0] = c.run_sum[1] = c.run_sum[2] = 0;
+        c.run_n = 0;
+    } else {
+        c.still_windows++;
+        for (uint8_t k = 0; k < 3; ++k) c.acc_mean[k] = (int32_t)(c.sum[k] / (int64_t)c.n);
+        if (!c.valid) {
+            for (uint8_t k = 0; k < 3; ++k) c.run_sum[k] += c.sum[3 + k];
+            c.run_n += c.n;
+            if (c.run < 0xFFFF) c.run++;
+            if (c.run >= p.min_windows) {
+                for (uint8_t k = 0; k < 3; ++k) c.bias_q8[k] = (int32_t)(c.run_sum[k] * 256 / (int64_t)c.run_n);
+                c.valid = true;
+                updated = true;
+            }
+        } else {
+            for (uint8_t k = 0; k < 3; ++k) {
+                const int32_t mean_q8 = (int32_t)(c.sum[3 + k] * 256 / (int64_t)c.n);
+                c.bias_q8[k] += (mean_q8 - c.bias_q8[k]) / (1 << p.shift);
+            }
+            updated = true;
+        }
+    }
+    for (uint8_t k = 0; k < 6; ++k) {
+        c.sum[k] = 0;
+        c.sq[k] = 0;
+    }
+    c.n = 0;
+    return updated;
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "config.h"
+#include "board_hal.h"
+#include "spsc_queue.h"
+
+// Live binary sample stream (STREAM command) while recording.
+// サンプリング側は stream_push() でリングに積むだけで、loop() の stream_poll() が
+// UART 送信バッファの空き分だけ書き出す。リングが満杯ならフレームを捨てて数える
+// （遅いホストがサンプリングを止めない）。
+// Frame (little-endian):
+//   [0xA5][0x5B][uint16 seq][int16 x popcount(mask), ax..gz order][uint8 xor of seq..data]
+//   seq は間引き後のサンプル番号（欠番 = 捨てたフレーム）。
+
+static const uint8_t STREAM_MAX_FRAME = 2 + 2 + 6 * 2 + 1;
+
+struct StreamFrame {
+    uint32_t gen;     // stream_start() generation the frame was built for
+    uint8_t len;
+    uint8_t b[STREAM_MAX_FRAME];
+};
+
+// Sampler (producer) -> loop() (consumer) through SpscQueue. stream_start() runs on the consumer side:
+// it empties the ring by popping and hands decim/mask to the sampler through s_st_gen, and the sampler
+// resets its own divider/sequence when it sees a new generation (neither side writes the other's state).
+// A frame the sampler was building across stream_start() lands after the drain: every frame carries its
+// generation and stream_poll() drops the ones of an earlier stream.
+// dropped = ring overflows since stream_start().
+static SpscQueue<StreamFrame, STREAM_RING_FRAMES> s_st_q;
+static std::atomic<bool> s_st_on{false};
+static std::atomic<uint32_t> s_st_gen{0};
+static uint8_t s_st_mask = 0x3F;          // consumer: requested, published by s_st_gen
+static uint16_t s_st_decim = 1;
+static uint32_t s_st_frames = 0;          // consumer
+static uint32_t s_st_ovf_base = 0;        // consumer: s_st_q.overflow() at stream_start()
+static uint32_t s_st_push_gen = 0;        // producer: generation in use
+static uint8_t s_st_push_mask = 0x3F;
+static uint16_t s_st_push_decim = 1;
+static uint16_t s_st_div = 0;
+static uint16_t s_st_seq = 0;
+
+// decim: send every decim-th sample, mask: bit0..5 = ax,ay,az,gx,gy,gz
+inline void stream_start(uint16_t decim, uint8_t mask) {
+    s_st_on.store(false, std::memory_order_relaxed);
+    s_st_decim = decim ? decim : 1;
+    s_st_mask = (mask & 0x3F) ? (mask & 0x3F) : 0x3F;
+    StreamFrame f;
+    while (s_st_q.pop(f)) {}
+    s_st_frames = 0;
+    s_st_ovf_base = s_st_q.overflow();
+    s_st_gen.store(s_st_gen.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    s_st_on.store(true, std::memory_order_release);
+}
+
+inline void stream_stop() {
+    s_st_on.store(false, std::memory_order_relaxed);
+}
+
+inline bool stream_active() { return s_st_on.load(std::memory_order_relaxed); }
+inline uint16_t stream_decim() { return s_st_decim; }
+inline uint8_t stream_mask() { return s_st_mask; }
+inline uint32_t stream_frames() { return s_st_frames; }
+inline uint32_t stream_dropped() { return s_st_q.overflow() - s_st_ovf_base; }
+
+// Sampler side: never blocks
+inline void stream_push(const ImuSample& smp) {
+    if (!s_st_on.load(std::memory_order_acquire)) return;
+    const uint32_t gen = s_st_gen.load(std::memory_order_acquire);
+    if (gen != s_st_push_gen) {
+        s_st_push_gen = gen;
+        s_st_push_decim = s_st_decim;
+        s_st_push_mask = s_st_mask;
+        s_st_div = 0;
+        s_st_seq = 0;
+    }
+    if (++s_st_div < s_st_push_decim) return;
+    s_st_div = 0;
+    const uint16_t seq = s_st_seq++;
+    StreamFrame f;
+    f.gen = gen;
+    const int16_t v[6] = { smp.ax, smp.ay, smp.az, smp.gx, smp.gy, smp.gz };
+    uint8_t* p = f.b;
+    *p++ = 0xA5;
+    *p++ = 0x5B;
+    *p++ = seq & 0xFF;
+    *p++ = seq >> 8;
+    for (int i = 0; i < 6; ++i) {
+        if (!(s_st_push_mask & (1 << i))) continue;
+        *p++ = (uint8_t)(v[i] & 0xFF);
+        *p++ = (uint8_t)((uint16_t)v[i] >> 8);
+    }
+    uint8_t x = 0;
+    for (uint8_t* q = f.b + 2; q < p; ++q) x ^= *q;
+    *p++ = x;
+    f.len = (uint8_t)(p - f.b);
+    s_st_q.push(f);   // full: counted by the ring (stream_dropped())
+}
+
+// loop() side: write whole frames while the UART TX buffer has room. Nothing after STREAM OFF: its reply
+// is the last word of the stream (what is left in the ring goes at the next stream_start()).
+inline void stream_poll() {
+    if (!stream_active()) return;
+    const uint32_t gen = s_st_gen.load(std::memory_order_relaxed);
+    while (const StreamFrame* f = s_st_q.front()) {
+        if (f->gen == gen) {
+            if (Serial.availableForWrite() < f->len) break;
+            Serial.write(f->b, f->len);
+            s_st_frames++;
+        }
+        StreamFrame done;
+        s_st_q.pop(done);
+    }
+}
@@ -0,0 +1,209 @@
+#pragma once
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <math.h>
+#include "config.h"
+#include "board_hal.h"
+#include "fs_format.h"
+#include "spsc_queue.h"
+
+// Windowed feature summaries (SUMMARY_ENABLE).
+// サンプリング経路で SUMMARY_WINDOW_MS 分のサンプル（欠損マーカー含む）ごとに、軸ごとの
+// 平均・最小・最大・RMS・平均交差回数を O(1)/サンプルで積算し、1窓 = 1レコード（68byte）にする。
+// 交差回数の基準は直前の窓の平均（最初の窓は最初のサンプル）。欠損マーカーは統計から除き gaps に数える。
+// レコードは SPSC リング経由で loop() の summary_poll() が /L<id>.SUM（LogHeader + レコード列、
+// format 0x0400）に書く。SUMMARY_ONLY ではセッションのログ自体がこの形式になり、生データは書かない。
+// Record (little-endian, packed):
+//   [uint32 first_sample][uint16 count][uint16 gaps]
+//   [int16 mean x6][int16 min x6][int16 max x6][uint16 rms x6][uint16 zc x6]   (ax,ay,az,gx,gy,gz)
+//   first_sample は窓の先頭サンプル番号（t = first_sample / odr_hz）、count は有効サンプル数。
+
+constexpr uint16_t SUMMARY_FORMAT_VER = 0x0400;
+// Window in samples at the running ODR (summary_reset()). int32 sums cannot overflow: 32767 * 65535 < 2^31
+static_assert(SUMMARY_WINDOW_MS >= 1 && (uint32_t)ODR_HZ_MAX * SUMMARY_WINDOW_MS / 1000 <= 0xFFFF,
+              "SUMMARY_WINDOW_MS out of range for ODR_HZ_MAX");
+static_assert(!SUMMARY_ONLY || SUMMARY_ENABLE, "SUMMARY_ONLY needs SUMMARY_ENABLE");
+static_assert(!SUMMARY_ONLY || (!LOG_COMPRESS && !LOG_FRAMED), "SUMMARY_ONLY replaces the sample payload");
+
+struct __attribute__((packed)) SummaryRecord {
+    uint32_t first_sample;
+    uint16_t count;
+    uint16_t gaps;
+    int16_t mean[6];
+    int16_t min[6];
+    int16_t max[6];
+    uint16_t rms[6];
+    uint16_t zc[6];
+};
+static_assert(sizeof(SummaryRecord) == 68, "SummaryRecord must be 68 bytes");
+
+struct SummaryAxis {
+    int32_t sum;
+    uint64_t sumsq;
+    int16_t min;
+    int16_t max;
+    int16_t ref;    // crossing reference (previous window's mean)
+    int8_t sign;    // side of ref of the last sample off ref (0: none yet)
+    uint16_t zc;
+};
+
+static SummaryAxis s_sum_ax[6];
+static bool s_sum_have_ref = false;
+static uint32_t s_sum_index = 0;    // sample number of the next input
+static uint32_t s_sum_first = 0;
+static uint16_t s_sum_window = 1;   // inputs per window
+static uint16_t s_sum_n = 0;        // inputs in the window
+static uint16_t s_sum_count = 0;
+static uint16_t s_sum_gaps = 0;
+
+// Finished records for the .SUM file: sampler (producer) -> loop() (consumer); a full ring counts the
+// record as dropped (overflow())
+static SpscQueue<SummaryRecord, SUMMARY_RING> s_sum_q;
+static uint32_t s_sum_records = 0;   // written to the .SUM file
+static uint32_t s_sum_flush_ms = 0;
+static File s_sum_file;
+static uint32_t s_sum_id = 0;
+
+inline void _summary_window_start() {
+    for (SummaryAxis& a : s_sum_ax) {
+        a.sum = 0;
+        a.sumsq = 0;
+        a.min = INT16_MAX;
+        a.max = INT16_MIN;
+        a.sign = 0;
+        a.zc = 0;
+    }
+    s_sum_first = s_sum_index;
+    s_sum_n = 0;
+    s_sum_count = 0;
+    s_sum_gaps = 0;
+}
+
+inline void summary_reset(uint16_t odr_hz) {
+    const uint32_t w = (uint32_t)odr_hz * SUMMARY_WINDOW_MS / 1000;
+    s_sum_window = (uint16_t)(w ? w : 1);
+    s_sum_index = 0;
+    s_sum_have_ref = false;
+    _summary_window_start();
+}
+
+// Close the current window into `out` (also used for the partial window at stop)
+inline void _summary_close(SummaryRecord& out) {
+    out.first_sample = s_sum_first;
+    out.count = s_sum_count;
+    out.gaps = s_sum_gaps;
+    const int32_t c = s_sum_count;
+    for (int i = 0; i < 6; ++i) {
+        SummaryAxis& a = s_sum_ax[i];
+        if (c == 0) {
+            out.mean[i] = out.min[i] = out.max[i] = 0;
+            out.rms[i] = 0;
+        } else {
+            out.mean[i] = (int16_t)((a.sum >= 0 ? a.sum + c / 2 : a.sum - c / 2) / c);
+            out.min[i] = a.min;
+            out.max[i] = a.max;
+            const float r = sqrtf((float)a.sumsq / (float)c) + 0.5f;
+            out.rms[i] = (r >= 65535.0f) ? 65535 : (uint16_t)r;
+            a.ref = out.mean[i];
+        }
+        out.zc[i] = a.zc;
+    }
+    _summary_window_start();
+}
+
+// Feed the next ODR_HZ sample (gap: a gap marker). True when `out` holds a finished window.
+inline bool summary_feed(const ImuSample& s, bool gap, SummaryRecord& out) {
+    s_sum_index++;
+    s_sum_n++;
+    if (gap) {
+        s_sum_gaps++;
+    } else {
+        const int16_t v[6] = { s.ax, s.ay, s.az, s.gx, s.gy, s.gz };
+        if (!s_sum_have_ref) {
+            for (int i = 0; i < 6; ++i) s_sum_ax[i].ref = v[i];
+            s_sum_have_ref = true;
+        }
+        for (int i = 0; i < 6; ++i) {
+            SummaryAxis& a = s_sum_ax[i];
+            const int32_t x = v[i];
+            a.sum += x;
+            a.sumsq += (uint64_t)(x * x);
+            if (v[i] < a.min) a.min = v[i];
+            if (v[i] > a.max) a.max = v[i];
+            const int8_t sg = (x > a.ref) ? 1 : (x < a.ref) ? -1 : 0;
+            if (sg) {
+                if (a.sign && sg != a.sign) a.zc++;
+                a.sign = sg;
+            }
+        }
+        s_sum_count++;
+    }
+    if (s_sum_n < s_sum_window) return false;
+    _summary_close(out);
+    return true;
+}
+
+// The partial window at stop (false if it holds no input)
+inline bool summary_flush(SummaryRecord& out) {
+    if (s_sum_n == 0) return false;
+    _summary_close(out);
+    return true;
+}
+
+// --- .SUM file (SUMMARY_ENABLE && !SUMMARY_ONLY) ---
+
+// Sampler side: never blocks; a full ring drops the record
+inline void summary_queue(const SummaryRecord& rec) {
+    s_sum_q.push(rec);
+}
+
+// hdr: the session's LogHeader (format_ver / block_size are replaced). Before the sampler starts.
+inline bool summary_begin(uint32_t id, const uint8_t* hdr, size_t n) {
+    s_sum_q.clear();
+    s_sum_records = 0;
+    s_sum_flush_ms = millis();
+    s_sum_id = id;
+    uint8_t h[64];
+    if (n > sizeof(h)) return false;
+    memcpy(h, hdr, n);
+    memcpy(h + 8, &SUMMARY_FORMAT_VER, 2);
+    memset(h + 58, 0, 2);
+    char path[FS_PATH_MAX];
+    fs_sum_path(id, path, sizeof(path));
+    s_sum_file = LittleFS.open(path, "w");
+    if (!s_sum_file) return false;
+    s_sum_file.write(h, n);
+    return true;
+}
+
+// loop(): write queued records; flushed every LOG_CHECKPOINT_MS like the log
+inline void summary_poll() {
+    if (!s_sum_file) return;
+    SummaryRecord rec;
+    while (s_sum_q.pop(rec)) {
+        s_sum_file.write(reinterpret_cast<const uint8_t*>(&rec), sizeof(rec));
+        fs_usage_add(sizeof(SummaryRecord));
+        s_sum_records++;
+    }
+    if (LOG_CHECKPOINT_MS && millis() - s_sum_flush_ms >= LOG_CHECKPOINT_MS) {
+        s_sum_flush_ms = millis();
+        s_sum_file.flush();
+    }
+}
+
+// Drain, close and store the record count as total_samples (dropped records as dropped_samples)
+inline void summary_end() {
+    if (!s_sum_file) return;
+    summary_poll();
+    s_sum_file.close();
+    char path[FS_PATH_MAX];
+    fs_sum_path(s_sum_id, path, sizeof(path));
+    File f = LittleFS.open(path, "r+");
+    if (f) {
+        const uint32_t v[2] = { s_sum_records, s_sum_q.overflow() };
+        f.seek(FS_LOG_TOTALS_OFS);
+        f.write(reinterpret_cast<const uint8_t*>(v), sizeof(v));
+        f.close();
+    }
+    fs_usage_invalidate();
+}
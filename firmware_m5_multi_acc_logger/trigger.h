@@ -0,0 +1,133 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "board_hal.h"
+
+// Motion-triggered logging (TRIGGER_MODE).
+// 記録中も常にサンプリングし、直近 TRIG_PRE_MS 分を RAM のリングに保持する（ODR_HZ_MAX 分の容量）。
+// 加速度ノルムの 1g からのずれが TRIG_ACC_MG、またはジャイロノルムが TRIG_GYRO_DPS を超えたら
+// セグメント開始: リングの内容（トリガ前）から記録する。両方が閾値の TRIG_RELEASE_PCT % を
+// 下回る状態が TRIG_POST_MS 続いたらセグメント終了（ヒステリシス）。
+// セグメントごとにフレーム化ブロックを新しく始めるので、ブロックの first_sample（通し番号）と
+// t_us がセグメントの時刻になる。判定は整数の二乗ノルム比較のみで、pc_tools/decoder.py の
+// trigger_segments() が記録済みの連続ログに同じ判定を再現する（閾値の調整用）。
+
+static_assert(!TRIGGER_MODE || LOG_FRAMED, "TRIGGER_MODE needs LOG_FRAMED (segments are framed blocks)");
+static_assert(TRIG_RELEASE_PCT <= 100, "TRIG_RELEASE_PCT out of range");
+
+// Pre-trigger ring capacity in logged samples: sized for the fastest ODR CONFIG SET accepts
+constexpr uint32_t TRIG_RING_SAMPLES = TRIGGER_MODE ? (uint32_t)ODR_HZ_MAX * TRIG_PRE_MS / 1000 : 1;
+
+// Thresholds as squared norms of raw counts (32768 counts = full range)
+constexpr int64_t _trig_sq(int64_t v) { return v * v; }
+constexpr int64_t _trig_acc_lo(int64_t mg, int64_t range_g) { return (mg >= 1000) ? 0 : _trig_sq(32768 * (1000 - mg) / (1000 * range_g)); }
+constexpr int64_t _trig_acc_hi(int64_t mg, int64_t range_g) { return _trig_sq(32768 * (1000 + mg) / (1000 * range_g)); }
+constexpr int64_t _trig_gyro(int64_t dps_x100, int64_t range_dps) { return _trig_sq(32768 * dps_x100 / (100 * range_dps)); }
+
+// Window lengths in logged samples and thresholds for the running configuration (trigger_reset())
+struct TrigParams {
+    uint32_t pre_samples;
+    uint32_t post_samples;
+    int64_t acc_lo, acc_hi, gyro_sq;              // trigger
+    int64_t rel_acc_lo, rel_acc_hi, rel_gyro_sq;  // release
+};
+static TrigParams s_trig_p;
+
+// Activity of one sample: 2 = above the trigger threshold, 1 = above the release threshold, 0 = quiet
+inline uint8_t trig_level(const ImuSample& s) {
+    const int64_t a = (int64_t)s.ax * s.ax + (int64_t)s.ay * s.ay + (int64_t)s.az * s.az;
+    const int64_t g = (int64_t)s.gx * s.gx + (int64_t)s.gy * s.gy + (int64_t)s.gz * s.gz;
+    if (a > s_trig_p.acc_hi || a < s_trig_p.acc_lo || g > s_trig_p.gyro_sq) return 2;
+    if (a > s_trig_p.rel_acc_hi || a < s_trig_p.rel_acc_lo || g > s_trig_p.rel_gyro_sq) return 1;
+    return 0;
+}
+
+enum TrigAction : uint8_t {
+    TRIG_HOLD = 0,  // not logged (kept in the pre-trigger ring)
+    TRIG_START,     // segment starts: log trig_pre(0..trig_pre_count()-1), then this sample
+    TRIG_LOG,       // inside a segment: log this sample
+    TRIG_END,       // log this sample, then close the segment
+};
+
+struct TrigEntry {
+    ImuSample s;
+    uint32_t t_us;
+    bool gap;
+};
+
+static TrigEntry s_trig_ring[TRIG_RING_SAMPLES ? TRIG_RING_SAMPLES : 1];
+static uint32_t s_trig_head = 0;      // next ring slot
+static uint32_t s_trig_fill = 0;      // entries in the ring
+static uint32_t s_trig_index = 0;     // sample number of the sample being fed
+static uint32_t s_trig_quiet = 0;     // consecutive quiet samples inside a segment
+static bool s_trig_active = false;
+static uint32_t s_trig_segments = 0;
+
+// Start of a recording: windows / thresholds for odr_hz and the ranges of that log
+inline void trigger_reset(uint16_t odr_hz, uint16_t range_g, uint16_t gyro_dps) {
+    const uint32_t pre = (uint32_t)odr_hz * TRIG_PRE_MS / 1000;
+    s_trig_p.pre_samples = (pre < TRIG_RING_SAMPLES) ? pre : TRIG_RING_SAMPLES;
+    s_trig_p.post_samples = (uint32_t)odr_hz * TRIG_POST_MS / 1000;
+    s_trig_p.acc_lo = _trig_acc_lo(TRIG_ACC_MG, range_g);
+    s_trig_p.acc_hi = _trig_acc_hi(TRIG_ACC_MG, range_g);
+    s_trig_p.gyro_sq = _trig_gyro((int64_t)TRIG_GYRO_DPS * 100, gyro_dps);
+    s_trig_p.rel_acc_lo = _trig_acc_lo((int64_t)TRIG_ACC_MG * TRIG_RELEASE_PCT / 100, range_g);
+    s_trig_p.rel_acc_hi = _trig_acc_hi((int64_t)TRIG_ACC_MG * TRIG_RELEASE_PCT / 100, range_g);
+    s_trig_p.rel_gyro_sq = _trig_gyro((int64_t)TRIG_GYRO_DPS * TRIG_RELEASE_PCT, gyro_dps);
+    s_trig_head = 0;
+    s_trig_fill = 0;
+    s_trig_index = 0;
+    s_trig_quiet = 0;
+    s_trig_active = false;
+    s_trig_segments = 0;
+}
+
+// Feed the next ODR_HZ sample (gap markers included, never triggering). s_trig_index
+// numbers every sample, logged or not, so it matches the codec's first_sample.
+inline TrigAction trigger_feed(const ImuSample& s, bool gap, uint32_t t_us) {
+    const uint8_t lvl = gap ? 0 : trig_level(s);
+    TrigAction a;
+    if (!s_trig_active) {
+        if (lvl == 2) {
+            s_trig_active = true;
+            s_trig_quiet = 0;
+            s_trig_segments++;
+            a = TRIG_START;
+        } else {
+            if (s_trig_p.pre_samples) {
+                TrigEntry& e = s_trig_ring[s_trig_head];
+                e.s = s;
+                e.t_us = t_us;
+                e.gap = gap;
+                s_trig_head = (s_trig_head + 1 == s_trig_p.pre_samples) ? 0 : s_trig_head + 1;
+                if (s_trig_fill < s_trig_p.pre_samples) s_trig_fill++;
+            }
+            a = TRIG_HOLD;
+        }
+    } else if (lvl) {
+        s_trig_quiet = 0;
+        a = TRIG_LOG;
+    } else if (++s_trig_quiet >= s_trig_p.post_samples) {
+        s_trig_active = false;
+        a = TRIG_END;
+    } else {
+        a = TRIG_LOG;
+    }
+    s_trig_index++;
+    return a;
+}
+
+// Pre-trigger samples after TRIG_START, oldest first; trig_pre_first() is the sample number of
+// trig_pre(0). Valid until the next trigger_feed(); trigger_pre_clear() drops them once logged.
+inline uint32_t trig_pre_count() { return s_trig_fill; }
+inline uint32_t trig_pre_first() { return s_trig_index - 1 - s_trig_fill; }
+inline const TrigEntry& trig_pre(uint32_t i) {
+    uint32_t k = s_trig_head + s_trig_p.pre_samples - s_trig_fill + i;
+    if (k >= s_trig_p.pre_samples) k -= s_trig_p.pre_samples;
+    return s_trig_ring[k];
+}
+inline void trigger_pre_clear() {
+    s_trig_fill = 0;
+}
+
+inline uint32_t trigger_segments() { return s_trig_segments; }
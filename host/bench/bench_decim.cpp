@@ -0,0 +1,64 @@
+// Cost of the anti-aliasing decimator (decim.h) per logged sample, built with DECIM_FACTOR_OVERRIDE=4 like
+// test_decim (512 Hz in, 128 Hz out, 64 taps). decim_push() is fed pseudo-random full-scale inputs; host CPU
+// time and, on x86, TSC cycles are taken over the whole run and divided by the outputs, so each logged sample
+// carries the DECIM_FACTOR history writes that lead up to it. The on-device figure is the
+// firmware's own `PERF ... fir:cyc_avg/cyc_max` (ESP.getCycleCount() around the six dot products).
+//
+//   bench_decim [--outputs N]
+// 出力:
+//   BENCH_DECIM factor:<n> taps:<n> acc_bits:<32|64> outputs:<n> mac_out:<n> ns_out:<host ns> cyc_out:<tsc|0>
+//               check:<output checksum> OK|MISMATCH
+// 出力数が合わなければ終了コード 1。
+#include "decim.h"
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static uint64_t bench_cycles() { return __rdtsc(); }
+#else
+static uint64_t bench_cycles() { return 0; }
+#endif
+
+static uint64_t bench_cpu_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char** argv) {
+    uint32_t outputs = 200000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--outputs") == 0) outputs = (uint32_t)atoi(argv[i + 1]);
+    }
+    // Inputs prepared up front so the loop times decim_push() alone
+    static ImuSample in[4096];
+    uint32_t rng = 1;
+    for (ImuSample& s : in) {
+        int16_t v[6];
+        for (int16_t& x : v) {
+            rng = rng * 1103515245u + 12345u;
+            x = (int16_t)(rng >> 16);
+        }
+        s = { v[0], v[1], v[2], v[3], v[4], v[5] };
+    }
+    decim_reset();
+    ImuSample out;
+    int32_t check = 0;
+    uint32_t got = 0;
+    const uint64_t n_in = (uint64_t)outputs * DECIM_FACTOR;
+    const uint64_t ns0 = bench_cpu_ns();
+    const uint64_t c0 = bench_cycles();
+    for (uint64_t n = 0; n < n_in; ++n) {
+        if (decim_push(&in[n % 4096], out) == DECIM_OUT) {
+            check += out.ax ^ out.gz;
+            got++;
+        }
+    }
+    const uint64_t cyc = bench_cycles() - c0;
+    const uint64_t ns = bench_cpu_ns() - ns0;
+    printf("BENCH_DECIM factor:%u taps:%u acc_bits:%u outputs:%u mac_out:%u ns_out:%.1f cyc_out:%.0f check:%d %s\n",
+           (unsigned)DECIM_FACTOR, (unsigned)DECIM_TAPS, (unsigned)(8 * sizeof(DecimAcc)), (unsigned)got,
+           (unsigned)(6 * DECIM_TAPS), got ? (double)ns / got : 0.0, got ? (double)cyc / got : 0.0, (int)check,
+           (got == outputs) ? "OK" : "MISMATCH");
+    return (got == outputs) ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+// I2C cost of one IMU sample with the MPU6886 driver (imu_mpu6886_unified.h) against a fake sensor on the
+// host Wire bus: separate accel + gyro reads (IMU_COMBINED_READ=false, the old path) against the single
+// 0x3B..0x48 burst of imu_read_sample_raw(). The bus stand-in counts transactions / bytes and takes their
+// bus time on the virtual clock (400 kHz, as init() sets it), so a sample read across a sensor update shows up.
+// 偽センサは SENSOR_ODR_HZ で出力レジスタを更新し、加速度・ジャイロの値に更新番号を埋め込むので、別々の
+// 更新から来たサンプル（torn）を数えられる。SH200Q はホストに M5StickC の代わりが無いので対象外
+// （読み方は同じ: 6+6 バイト2回 → 0x00..0x0D 1回）。
+//
+//   bench_imu_read [--samples N]
+// 出力（読み方ごとに1行）:
+//   BENCH_IMU read:separate|burst samples:<n> tx:<per sample> bytes:<per sample> bus_us:<per sample> torn:<n>
+// 値の復号が合わない、burst で torn がある、または burst のトランザクションが減っていなければ終了コード 1。
+#include "imu_driver.h"
+#include "host_sim.h"
+#include <string.h>
+
+constexpr uint32_t SENSOR_ODR_HZ = 1000;
+
+// Output registers 0x3B..0x48 of the sensor update u: accel axis a = u * 8 + a, temp, gyro axis a = -(u * 8 + a)
+static int16_t fake_val(uint32_t u, int axis) {
+    const int16_t v = (int16_t)((u * 8u + (uint32_t)(axis % 3)) & 0x3FFF);
+    return (axis < 3) ? v : (int16_t)-v;
+}
+
+struct FakeMpuOutput : HostI2cDevice {
+    uint8_t regs[128] = {};
+
+    uint8_t read_reg(uint8_t reg) override {
+        if (reg >= MPU6886_REG_ACCEL_XOUT_H && reg < MPU6886_REG_ACCEL_XOUT_H + MPU6886_FIFO_FRAME) {
+            // The output block as of the start of this transfer
+            return latched[reg - MPU6886_REG_ACCEL_XOUT_H];
+        }
+        return regs[reg & 0x7F];
+    }
+    void write_reg(uint8_t reg, uint8_t v) override { regs[reg & 0x7F] = v; }
+    void select(uint8_t reg) override {
+        ptr = reg;
+        const uint32_t u = (uint32_t)(host_micros64() * SENSOR_ODR_HZ / 1000000u);
+        for (int a = 0; a < 6; ++a) {
+            const uint16_t v = (uint16_t)fake_val(u, a);
+            const int ofs = (a < 3) ? 2 * a : 2 * a + 2;   // TEMP (0x41..0x42) between accel and gyro
+            latched[ofs] = (uint8_t)(v >> 8);
+            latched[ofs + 1] = (uint8_t)v;
+        }
+        latched[6] = 0x0A;
+        latched[7] = 0xBC;
+    }
+    uint8_t latched[MPU6886_FIFO_FRAME] = {};
+};
+
+static FakeMpuOutput s_mpu;
+
+// Sensor update a sample came from (accel / gyro half), or -1 if the values are not a fake_val() set
+static int32_t update_of(const int16_t* v) {
+    const int32_t u = (v[0] & 0x3FFF) / 8;
+    for (int a = 0; a < 3; ++a) {
+        if (v[a] != fake_val((uint32_t)u, a)) return -1;
+    }
+    return u;
+}
+
+struct ReadResult {
+    uint32_t samples;
+    HostI2cStats stats;
+    uint64_t bus_us;
+    uint32_t torn;
+    uint32_t bad;
+};
+
+// n samples, one every 1003 us so the read drifts across the sensor's update phase
+static ReadResult run(bool burst, uint32_t n) {
+    ReadResult r = {};
+    host_i2c_stats_reset(0);
+    for (uint32_t i = 0; i < n; ++i) {
+        delayMicroseconds(1003);
+        const uint64_t t0 = host_micros64();
+        ImuSample s = {};
+        int16_t temp = 0;
+        const bool ok = burst ? imu_read_sample_raw(s, &temp)
+                              : (imu_read_accel_raw(s.ax, s.ay, s.az) && imu_read_gyro_raw(s.gx, s.gy, s.gz));
+        r.bus_us += host_micros64() - t0;
+        const int16_t acc[3] = { s.ax, s.ay, s.az };
+        const int16_t gyr[3] = { (int16_t)-s.gx, (int16_t)-s.gy, (int16_t)-s.gz };
+        const int32_t ua = update_of(acc), ug = update_of(gyr);
+        if (!ok || ua < 0 || ug < 0 || (burst && temp != 0x0ABC)) r.bad++;
+        else if (ua != ug) r.torn++;
+        r.samples++;
+    }
+    r.stats = host_i2c_stats(0);
+    return r;
+}
+
+static void print(const char* name, const ReadResult& r) {
+    const float n = r.samples ? (float)r.samples : 1.0f;
+    printf("BENCH_IMU read:%s samples:%u tx:%.2f bytes:%.2f bus_us:%.1f torn:%u\n", name, (unsigned)r.samples,
+           r.stats.transactions / n, r.stats.bytes / n, (float)r.bus_us / n, (unsigned)r.torn);
+}
+
+int main(int argc, char** argv) {
+    uint32_t n = 10000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--samples") == 0) n = (uint32_t)atoi(argv[i + 1]);
+    }
+    host_i2c_attach(0, MPU6886_ADDR, &s_mpu);
+    imu_init();
+    const ReadResult sep = run(false, n);
+    const ReadResult bst = run(true, n);
+    print("separate", sep);
+    print("burst", bst);
+    const bool ok = sep.bad == 0 && bst.bad == 0 && bst.torn == 0
+                    && bst.stats.transactions < sep.stats.transactions;
+    fflush(stdout);
+    return ok ? 0 : 1;
+}
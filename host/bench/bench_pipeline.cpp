@@ -0,0 +1,334 @@
+// Host benchmark of the recording pipeline: the sketch itself (setup()/loop(), sampling clock, acquisition
+// ring, log writer, serial protocol) built against the host stand-ins with the mock IMU (-DIMU_DRIVER_MOCK).
+// 時計は仮想時計（host_sched.h）なので、記録秒数に関係なく一瞬で終わり、cpu_ns 以外の値は毎回同じになる。
+// シリアルで CONFIG SET / START / STOP を送り、指定秒数だけ loop() を回して記録する。終了後に
+// ファームウェア自身の PERF / STATS を取り、書き込まれたログ（メモリ上の LittleFS）をヘッダと突き合わせる。
+//
+//   bench_pipeline [--seconds S] [--odr HZ] [--cmd-hz N] [--fs-write-us US] [--stall TASK:AT_MS:MS ...]
+//                  [--screen-ms MS] [--cut-ms MS --image DIR]
+//   bench_pipeline --boot DIR --cut-records N
+//     --cmd-hz: 記録中に 1 秒あたり N 行の INFO を送る（serial_proto_poll() の負荷）
+//     --fs-write-us: File::write 1 回に US µs かかる遅いファイルシステム（ライタが詰まり overflow を起こす）
+//     --stall: 記録開始 AT_MS 後にタスク TASK（acq / acqpipe / logwr / esp_timer / main）を MS ミリ秒止める
+//              （host_task_stall()、取りこぼしティック・キュー溢れ・ライタ溢れを起こす）
+//     --screen-ms: 記録開始時に画面を MS ミリ秒点ける（ui_wake_for()、0 なら消す。省略時は起動後 5 秒で消える）
+//     --cut-ms / --image: 記録開始 MS 後に電源を切る。flush / close 済みの内容だけを残した LittleFS を DIR に
+//              保存し（host_fs_power_cut()）、CUT 行（書き込み中だった File::write の数を含む）を出して終了する
+//     --boot: DIR の LittleFS から起動し、setup() の修復（recover_log()）を確かめる（下記 BENCH_RECOVER）
+// 記録中の画面描画（ホストの M5.Display は SPI 転送時間を仮想時計で取る、host_display_stats()）:
+//   BENCH_LCD redraw:<dirty|full> fs_cache_ms:<ms> writes:<n> glyphs:<n> px:<n> lcd_us_s:<us> fs_scans:<n>
+//   lcd_us_s は記録 1 秒あたりの描画時間（loop() の負荷）、fs_scans は LittleFS.usedBytes() の走査回数。
+//   LCD_FULL_REDRAW_OVERRIDE=1 / FS_USAGE_CACHE_MS_OVERRIDE=5000 で作った bench_pipeline_lcd_full が変更前の値。
+// 出力の最後の行:
+//   BENCH odr:<hz> seconds:<s> samples:<n> expected:<n> dropped:<n> overflow:<n> bytes:<n>
+//         flush_calls:<n> bytes_per_flush:<n> odr_achieved:<hz> read_us:<mean>/<max> pack_us:<mean>/<max>
+//         jitter_us:<mean>/<max> serial_us_max:<us> cpu_ns:<ns> OK|MISMATCH
+//   read_us / pack_us / jitter_us はファームウェアの STATS（IMU 読み出し、1 読み出し分のパッキング、ティックのずれ）、
+//   serial_us_max はベンチが計った serial_proto_poll() 1 回の最大時間（いずれも仮想時計）。
+//   cpu_ns は記録中にこのプロセスが使った CPU 時間（全スレッド）のサンプルあたりの値で、唯一ホストの実測。
+// ログとヘッダの不一致、またはサンプル（ログに入った分と overflow で捨てた分）が期待値の 95% 未満なら終了コード 1。
+// ティック単位でも突き合わせる: 記録したティック数（TICK n + missed）= ログのレコード数 + 末尾の overflow、
+// ヘッダの dropped = 取りこぼしティック + 取得キュー溢れ + ライタ溢れ（n / odr_hz の時刻が正しいこと）。
+// raw ペイロードでは、モックのサンプルが順に並び、飛ばしてよいのはその前のギャップレコードの数まで（overflow で
+// 捨てたレコードもギャップで埋まる）であることと、ギャップレコード数が dropped と一致することも確かめる。
+// --boot の出力:
+//   BENCH_RECOVER session:<id> records:<n> cut_records:<n> lost:<n> ckpt:<0|1> read_bytes:<n> recover_us:<us>
+//         boot_wall_us:<us> OK|MISMATCH
+//   ヘッダ・セッション索引・ファイルサイズのレコード数が一致し、チェックポイント済みのレコードが残り、失ったのが
+//   最後のチェックポイント以降（＋バッファ分）だけで、修復がログ本体を読まない（read_bytes が索引・ヘッダ・
+//   チェックポイント・その後のブロックヘッダの分まで）こと。boot_wall_us は setup() 全体のホスト実測（0.5 秒未満）。
+#include "firmware_m5_multi_acc_logger.ino"
+#include "host_sim.h"
+#include <chrono>
+#include <string>
+#include <time.h>
+
+static std::string s_out;
+
+static uint64_t bench_cpu_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Run loop() until the serial output contains token (collected in s_out) or timeout_ms passes
+static bool bench_run_until(const char* token, uint32_t timeout_ms) {
+    const uint32_t t0 = millis();
+    while (s_out.find(token) == std::string::npos) {
+        if (millis() - t0 > timeout_ms) return false;
+        loop();
+        s_out += host_serial_take();
+    }
+    return true;
+}
+
+static bool bench_command(const char* line, const char* token, uint32_t timeout_ms = 2000) {
+    s_out.clear();
+    host_serial_feed(line);
+    host_serial_feed("\n");
+    return bench_run_until(token, timeout_ms);
+}
+
+// Lines of s_out that start with prefix
+static void bench_print_lines(const char* prefix) {
+    size_t pos = 0;
+    while (pos < s_out.size()) {
+        size_t end = s_out.find('\n', pos);
+        if (end == std::string::npos) end = s_out.size();
+        if (s_out.compare(pos, strlen(prefix), prefix) == 0) printf("%s\n", s_out.substr(pos, end - pos).c_str());
+        pos = end + 1;
+    }
+}
+
+// Part `part` of "key:<a>/<b>/.." in the line of s_out that starts with prefix (0 if absent)
+static float bench_field(const char* prefix, const char* key, int part = 0) {
+    size_t line = (s_out.compare(0, strlen(prefix), prefix) == 0) ? 0 : s_out.find(std::string("\n") + prefix);
+    if (line == std::string::npos) return 0.0f;
+    const size_t end = s_out.find('\n', line + 1);
+    size_t k = s_out.find(std::string(" ") + key + ":", line);
+    if (k == std::string::npos || k > end) return 0.0f;
+    k += strlen(key) + 2;
+    for (int i = 0; i < part; ++i) k = s_out.find('/', k) + 1;
+    return (float)atof(s_out.c_str() + k);
+}
+
+// Raw payload against the mock: the records that are not gap markers are the mock's samples in order, and a
+// run of g gap markers skips at most g of them (a record dropped on overflow was read from the mock, a missed
+// tick was not), so a dropped record never shifts the later ones. The first one is looked up: the mock is
+// also read before START (idle reads, e.g. the background gyro calibration).
+static bool bench_check_raw_timeline(const std::vector<uint8_t>& log, uint32_t& gap_records) {
+    const size_t n = (log.size() - sizeof(LogHeader)) / 12;
+    std::vector<ImuSample> rec(n);
+    std::vector<bool> gap(n);
+    for (size_t i = 0; i < n; ++i) {
+        const uint8_t* p = &log[sizeof(LogHeader) + i * 12];
+        int16_t v[6];
+        for (int k = 0; k < 6; ++k) v[k] = (int16_t)((p[2 * k] << 8) | p[2 * k + 1]);
+        rec[i] = { v[0], v[1], v[2], v[3], v[4], v[5] };
+        gap[i] = v[0] == LOG_GAP_WORD && v[1] == LOG_GAP_WORD && v[5] == LOG_GAP_WORD;
+    }
+    // Everything the mock returned since init() (same seed: the same values again)
+    const uint32_t reads = s_mock_n;
+    std::vector<ImuSample> mock(reads);
+    s_mock_n = 0;
+    s_mock_rng = 1;
+    for (ImuSample& m : mock) _mock_next(m);
+    auto same = [](const ImuSample& a, const ImuSample& b) {
+        return a.ax == b.ax && a.ay == b.ay && a.az == b.az && a.gx == b.gx && a.gy == b.gy && a.gz == b.gz;
+    };
+    gap_records = 0;
+    size_t m = 0;         // next mock sample
+    size_t run = reads;   // gap markers since the last sample (any number before the first one)
+    for (size_t i = 0; i < n; ++i) {
+        if (gap[i]) {
+            gap_records++;
+            run++;
+            continue;
+        }
+        size_t k = 0;
+        while (k <= run && m + k < reads && !same(mock[m + k], rec[i])) k++;
+        if (k > run || m + k >= reads) return false;
+        m += k + 1;
+        run = 0;
+    }
+    return true;
+}
+
+// Boot from the flash image a power cut left (--boot): setup() must repair the cut log before serving commands
+static int bench_boot(const char* dir, uint32_t cut_records) {
+    if (!host_fs_load(dir)) {
+        printf("no image in %s\n", dir);
+        return 1;
+    }
+    host_nvs_clear();
+    LogCheckpoint ck = {};
+    const bool have_ck = log_ckpt_read(ck);
+    std::vector<uint8_t> index;
+    host_fs_read(SESSION_INDEX_FILE, index);
+    const uint64_t read0 = host_fs_bytes_read();
+    const auto wall0 = std::chrono::steady_clock::now();
+    setup();
+    const uint32_t wall_us = (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - wall0).count();
+    const uint32_t read_bytes = (uint32_t)(host_fs_bytes_read() - read0);
+    s_out = host_serial_take();
+    bench_print_lines("RECOVER");
+
+    const uint32_t id = (uint32_t)bench_field("RECOVER", "session");
+    const uint32_t records = (uint32_t)bench_field("RECOVER", "samples");
+    char path[FS_PATH_MAX];
+    fs_log_path(id, path, sizeof(path));
+    std::vector<uint8_t> log;
+    LogHeader hdr = {};
+    bool ok = id && host_fs_read(path, log) && log.size() >= sizeof(hdr);
+    if (ok) memcpy(&hdr, log.data(), sizeof(hdr));
+    // One count everywhere: header, session index, file size
+    const SessionEntry* e = session_find(id);
+    ok = ok && hdr.total_samples == records && e && e->samples == records && !LittleFS.exists(LOG_CKPT_FILE_NAME);
+    // (a buffer boundary can cut a record: the committed size need not be whole records)
+    if (ok && !LOG_BLOCK_MODE && !SUMMARY_ONLY) ok = (log.size() - sizeof(hdr)) / 12 == records;
+    // Nothing committed by the last checkpoint is lost, and little after it
+    if (ok && have_ck) ok = records >= ck.records && hdr.dropped_samples == ck.overflow;
+    const uint32_t in_flight = (uint32_t)(LOG_BUF_COUNT * LOG_BUF_SIZE / 12)
+                               + hdr.odr_hz * (LOG_CHECKPOINT_MS + 1000u) / 1000u;
+    ok = ok && records <= cut_records && cut_records - records <= in_flight;
+    // Recovery reads the index, the header and the checkpoint (block logs: the block headers after it) only
+    size_t may_read = index.size() + sizeof(hdr) + sizeof(LogCheckpoint);
+    if (LOG_BLOCK_MODE && hdr.block_size) {
+        may_read += 20 * ((log.size() - (have_ck ? ck.bytes : sizeof(hdr))) / hdr.block_size + 1);
+    }
+    ok = ok && read_bytes <= may_read && wall_us < 500000;
+    printf("BENCH_RECOVER session:%u records:%u cut_records:%u lost:%u ckpt:%d read_bytes:%u recover_us:%u "
+           "boot_wall_us:%u %s\n",
+           (unsigned)id, (unsigned)records, (unsigned)cut_records, (unsigned)(cut_records - records), (int)have_ck,
+           (unsigned)read_bytes, (unsigned)bench_field("RECOVER", "us"), (unsigned)wall_us,
+           ok ? "OK" : "MISMATCH");
+    fflush(stdout);
+    _Exit(ok ? 0 : 1);
+}
+
+int main(int argc, char** argv) {
+    float seconds = 3.0f;
+    unsigned odr = 0;
+    unsigned cmd_hz = 0;
+    uint32_t cut_ms = 0;
+    uint32_t cut_records = 0;
+    const char* image = nullptr;
+    const char* boot = nullptr;
+    int screen_ms = -1;
+    std::vector<std::string> stalls;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--seconds") == 0) seconds = (float)atof(argv[i + 1]);
+        else if (strcmp(argv[i], "--odr") == 0) odr = (unsigned)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--cmd-hz") == 0) cmd_hz = (unsigned)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--fs-write-us") == 0) host_fs_set_write_us((uint32_t)atoi(argv[i + 1]));
+        else if (strcmp(argv[i], "--stall") == 0) stalls.push_back(argv[i + 1]);
+        else if (strcmp(argv[i], "--screen-ms") == 0) screen_ms = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--cut-ms") == 0) cut_ms = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--image") == 0) image = argv[i + 1];
+        else if (strcmp(argv[i], "--boot") == 0) boot = argv[i + 1];
+        else if (strcmp(argv[i], "--cut-records") == 0) cut_records = (uint32_t)atoi(argv[i + 1]);
+    }
+    if (boot) return bench_boot(boot, cut_records);
+    if (cut_ms && !image) {
+        printf("--cut-ms needs --image DIR\n");
+        return 1;
+    }
+    host_fs_reset();
+    host_nvs_clear();
+    setup();
+    s_out = host_serial_take();
+    bench_print_lines("BOOT");
+    if (odr) {
+        char cmd[32];
+        snprintf(cmd, sizeof(cmd), "CONFIG SET odr=%u", odr);
+        if (!bench_command(cmd, "\n")) return 1;
+        bench_print_lines("");
+    }
+    if (!bench_command("START", "OK\n")) {
+        printf("START failed\n");
+        return 1;
+    }
+    if (screen_ms > 0) ui_wake_for((uint32_t)screen_ms);
+    else if (screen_ms == 0) screen_set(false);
+    const HostDisplayStats lcd0 = host_display_stats();
+    const uint32_t scans0 = host_fs_used_scans();
+    const uint32_t run_ms = (uint32_t)(seconds * 1000.0f);
+    const uint64_t cpu0 = bench_cpu_ns();
+    const uint32_t t0 = millis();
+    for (const std::string& st : stalls) {
+        const size_t c1 = st.find(':');
+        const size_t c2 = st.find(':', c1 + 1);
+        if (c1 == std::string::npos || c2 == std::string::npos) {
+            printf("bad --stall %s (TASK:AT_MS:MS)\n", st.c_str());
+            return 1;
+        }
+        host_task_stall(st.substr(0, c1).c_str(), t0 + (uint32_t)atoi(st.c_str() + c1 + 1),
+                        (uint32_t)atoi(st.c_str() + c2 + 1));
+    }
+    uint32_t next_cmd_ms = t0;
+    uint32_t serial_us_max = 0;
+    while (millis() - t0 < run_ms) {
+        if (cut_ms && millis() - t0 >= cut_ms) {
+            // Power cut: what the writer put but had not committed is gone
+            const uint32_t mid_write = host_fs_power_cut();
+            const bool saved = host_fs_save(image);
+            printf("CUT ms:%u records:%u mid_write:%u ckpt:%u/%u/%u %s\n", (unsigned)(millis() - t0),
+                   (unsigned)s_lw_records, (unsigned)mid_write, (unsigned)s_perf.ckpt_calls,
+                   (unsigned)(s_perf.ckpt_calls ? s_perf.ckpt_us_sum / s_perf.ckpt_calls : 0),
+                   (unsigned)s_perf.ckpt_us_max, saved ? "saved" : "SAVE_FAILED");
+            fflush(stdout);
+            _Exit(saved ? 0 : 1);
+        }
+        if (cmd_hz && (int32_t)(millis() - next_cmd_ms) >= 0) {
+            next_cmd_ms += 1000 / cmd_hz;
+            host_serial_feed("INFO\n");
+        }
+        const uint32_t c0 = micros();
+        serial_proto_poll();
+        const uint32_t us = micros() - c0;
+        if (us > serial_us_max) serial_us_max = us;
+        loop();
+        host_serial_take();
+    }
+    const float run_s = (float)(millis() - t0) / 1000.0f;
+    const HostDisplayStats lcd1 = host_display_stats();
+    const uint32_t scans = host_fs_used_scans() - scans0;
+    if (!bench_command("STOP", "OK\n", 60000)) {
+        printf("STOP failed\n");
+        return 1;
+    }
+    const uint64_t cpu_ns = bench_cpu_ns() - cpu0;
+
+    bench_command("PERF", "PERF");
+    bench_print_lines("PERF");
+    bench_command("STATS", "END");
+    bench_print_lines("STAGE");
+    bench_print_lines("TICK");
+    const std::string stats = s_out;
+
+    // The log as written: header totals against the counts kept while recording
+    char path[FS_PATH_MAX];
+    fs_log_path(rec_session, path, sizeof(path));
+    std::vector<uint8_t> log;
+    LogHeader hdr = {};
+    const bool have_log = host_fs_read(path, log) && log.size() >= sizeof(hdr);
+    if (have_log) memcpy(&hdr, log.data(), sizeof(hdr));
+    const unsigned rate = imu_config().odr_hz;
+    const uint32_t expected = (uint32_t)(run_s * (float)rate);
+    bool ok = have_log && hdr.total_samples == total_samples && hdr.dropped_samples == dropped_samples + log_writer_overflow()
+              && total_samples + log_writer_overflow() >= expected * 95 / 100;
+    if (ok && !LOG_BLOCK_MODE && !SUMMARY_ONLY) ok = log.size() == sizeof(hdr) + (size_t)total_samples * 12;
+    s_out = stats;
+    if (ok && STATS_ENABLE && !IMU_FIFO_MODE && DECIM_FACTOR == 1 && !TRIGGER_MODE && !SUMMARY_ONLY) {
+        // Each tick is a record or a counted drop
+        const uint32_t ticks = (uint32_t)bench_field("TICK", "n") + (uint32_t)bench_field("TICK", "missed");
+        ok = ticks == total_samples + log_writer_overflow()
+             && hdr.dropped_samples == (uint32_t)bench_field("TICK", "missed") + s_perf.acq_overflow + s_perf.overflow;
+    }
+    if (ok && !LOG_BLOCK_MODE && !SUMMARY_ONLY && !TRIGGER_MODE && DECIM_FACTOR == 1) {
+        uint32_t gap_records = 0;
+        ok = bench_check_raw_timeline(log, gap_records) && gap_records == dropped_samples;
+    }
+
+    const uint32_t flush_calls = s_perf.flush_calls;
+    const uint32_t per_flush = flush_calls ? (uint32_t)(s_perf.flush_bytes / flush_calls) : 0;
+    const float odr_achieved = (s_perf.samples > 1 && s_perf.last_sample_us != s_perf.first_sample_us)
+        ? (float)(s_perf.samples - 1) * 1e6f / (float)(s_perf.last_sample_us - s_perf.first_sample_us) : 0.0f;
+    printf("BENCH_LCD redraw:%s fs_cache_ms:%u writes:%u glyphs:%u px:%llu lcd_us_s:%.0f fs_scans:%u\n",
+           LCD_FULL_REDRAW ? "full" : "dirty", (unsigned)FS_USAGE_CACHE_MS, (unsigned)(lcd1.writes - lcd0.writes),
+           (unsigned)(lcd1.glyphs - lcd0.glyphs), (unsigned long long)(lcd1.pixels - lcd0.pixels),
+           run_s > 0.0f ? (double)(lcd1.busy_us - lcd0.busy_us) / run_s : 0.0, (unsigned)scans);
+    printf("BENCH odr:%u seconds:%.2f samples:%u expected:%u dropped:%u overflow:%u bytes:%u flush_calls:%u "
+           "bytes_per_flush:%u odr_achieved:%.2f read_us:%.1f/%.1f pack_us:%.1f/%.1f jitter_us:%.0f/%.0f "
+           "serial_us_max:%u cpu_ns:%u %s\n",
+           rate, run_s, (unsigned)total_samples, (unsigned)expected, (unsigned)dropped_samples,
+           (unsigned)log_writer_overflow(), (unsigned)log.size(), (unsigned)flush_calls, (unsigned)per_flush,
+           odr_achieved, bench_field("STAGE i2c", "us", 1), bench_field("STAGE i2c", "us", 2),
+           bench_field("STAGE pack", "us", 1), bench_field("STAGE pack", "us", 2),
+           bench_field("TICK", "jitter_us", 0), bench_field("TICK", "jitter_us", 1),
+           (unsigned)serial_us_max, (unsigned)(total_samples ? cpu_ns / total_samples : 0), ok ? "OK" : "MISMATCH");
+    fflush(stdout);
+    // Tasks and timers never end: leave without joining them
+    _Exit(ok ? 0 : 1);
+}
@@ -0,0 +1,210 @@
+// Raw-partition circular log (raw_log.h, LOG_RAW_PARTITION) on the file-backed partition stand-in
+// (host/stubs/esp_partition.h: NOR flash rules, erase / program time on the virtual clock).
+// Sessions of pseudo-random length are written the way the firmware does (64-byte header, LOG_BUF_SIZE
+// appends from the writer, closing sector) until the ring has wrapped --wraps times, then one session that
+// fills the whole partition and one cut off by a power loss (repaired like recover_log() does).
+// セッションの各バイトは (セッション番号, オフセット) から決まる値なので、読み戻しで取り違え・欠落・
+// 上書きを検出できる。各セッションの後に、残っている全セッションの内容・サイズ・最終カウントと、消えたのが
+// 古い順であること（新しいものは残る）を確かめ、数セッションごとに再マウント（再起動）して同じ結果になるかも見る。
+// The whole time a reader task (loop() dumping over serial) reads the session being written and the oldest
+// one, which the erase-ahead is about to drop: every byte it gets back must still match.
+//
+//   bench_raw_log [--sectors N] [--wraps W]
+// 出力:
+//   BENCH_RAWLOG sectors:<n> wraps:<n> sessions:<n> bytes:<n> kb_s:<write throughput> append_us:<mean>/<max>
+//                erases:<n> reader_kb:<n> OK|MISMATCH
+//   append_us は raw_log_append() 1回（LOG_BUF_SIZE）の仮想時間、最大はセクタの消去と書き込みが重なった回。
+// 読み戻し・再マウントの不一致、消去せずに書いたビット、または一周未満なら終了コード 1。
+#include "raw_log.h"
+#include "host_sim.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <string.h>
+#include <vector>
+
+struct BenchSession {
+    uint32_t size;      // bytes readable
+    uint32_t total;     // final counts (closed sessions)
+    uint32_t dropped;
+    bool closed;
+};
+
+static std::vector<BenchSession> s_exp(1);   // by session id
+static uint32_t s_fail = 0;
+static uint64_t s_bytes = 0;
+static uint64_t s_write_us = 0;
+static uint64_t s_append_us_max = 0;
+static uint32_t s_appends = 0;
+static uint32_t s_rec_id = 0;       // session being recorded
+static uint64_t s_reader_bytes = 0;
+
+static uint8_t bench_byte(uint32_t id, uint32_t off) {
+    return (uint8_t)((off * 131u) ^ (off >> 9) ^ (id * 37u));
+}
+
+static void bench_mismatch(const char* what, uint32_t id) {
+    printf("MISMATCH %s session:%u\n", what, (unsigned)id);
+    s_fail++;
+}
+
+// Session `id` as the writer task records it; stops early when the partition is full of it
+static uint32_t bench_record(uint32_t id, uint32_t size, bool close) {
+    if (!raw_log_open(id)) bench_mismatch("open", id);
+    s_rec_id = id;
+    static uint8_t buf[LOG_BUF_SIZE];
+    uint32_t off = 0;
+    while (off < size) {
+        const uint32_t n = (off == 0) ? 64 : (size - off < LOG_BUF_SIZE ? size - off : (uint32_t)LOG_BUF_SIZE);
+        for (uint32_t i = 0; i < n; ++i) buf[i] = bench_byte(id, off + i);
+        const uint64_t t0 = host_micros64();
+        const bool ok = raw_log_append(buf, n);
+        const uint64_t us = host_micros64() - t0;
+        s_write_us += us;
+        if (us > s_append_us_max) s_append_us_max = us;
+        s_appends++;
+        vTaskDelay(pdMS_TO_TICKS(2));   // the writer waits for its next buffer
+        if (!ok) break;
+        off += n;
+        s_bytes += n;
+    }
+    s_exp.resize(id + 1);
+    s_exp[id] = { off, off / 12, id, close };
+    if (close) {
+        const uint64_t t0 = host_micros64();
+        if (!raw_log_finish(off / 12, id)) bench_mismatch("finish", id);
+        s_write_us += host_micros64() - t0;
+    }
+    return off;
+}
+
+// loop() reading sessions while the writer appends: chunks across sector and stage boundaries
+static void bench_reader_session(uint32_t id) {
+    static uint8_t buf[3 * RAW_LOG_PAYLOAD + 1000];
+    for (uint32_t off = 0;;) {
+        const size_t n = raw_log_read(id, off, buf, sizeof(buf));
+        if (n == 0) return;   // end, or dropped in between
+        for (size_t i = 0; i < n; ++i) {
+            if (buf[i] != bench_byte(id, off + (uint32_t)i)) {
+                bench_mismatch("concurrent read", id);
+                return;
+            }
+        }
+        off += (uint32_t)n;
+        s_reader_bytes += n;
+    }
+}
+
+static void bench_reader(void*) {
+    for (;;) {
+        const uint32_t rec = s_rec_id;
+        for (uint32_t id = (rec > SESSION_MAX) ? rec - SESSION_MAX + 1 : 1; id < rec; ++id) {
+            if (!raw_log_exists(id)) continue;
+            bench_reader_session(id);   // the oldest left: the next erase-ahead drops it
+            break;
+        }
+        if (rec) bench_reader_session(rec);
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+}
+
+// Every session still on flash reads back whole with its counts; the ones gone are the oldest
+static void bench_check(uint32_t newest) {
+    static uint8_t buf[1000];
+    bool dropped_newer = false;
+    size_t sectors = 0;
+    const uint32_t oldest = (newest > SESSION_MAX) ? newest - SESSION_MAX + 1 : 1;
+    for (uint32_t id = newest; id >= oldest; --id) {
+        const BenchSession& x = s_exp[id];
+        if (!raw_log_exists(id)) {
+            if (id == newest) bench_mismatch("newest gone", id);
+            dropped_newer = true;
+            continue;
+        }
+        if (dropped_newer) bench_mismatch("kept after a newer one was dropped", id);
+        if (raw_log_size(id) != x.size) bench_mismatch("size", id);
+        uint32_t total = 0, dropped = 0;
+        const bool closed = raw_log_totals(id, total, dropped);
+        if (closed != x.closed || (closed && (total != x.total || dropped != x.dropped))) bench_mismatch("totals", id);
+        for (uint32_t off = 0; off < x.size; off += sizeof(buf)) {
+            const size_t n = raw_log_read(id, off, buf, sizeof(buf));
+            bool same = n == ((x.size - off < sizeof(buf)) ? x.size - off : sizeof(buf));
+            for (size_t i = 0; same && i < n; ++i) same = buf[i] == bench_byte(id, off + (uint32_t)i);
+            if (!same) {
+                bench_mismatch("data", id);
+                break;
+            }
+        }
+        sectors += x.size / RAW_LOG_PAYLOAD + (x.closed ? 1 : 0);   // + the closing sector
+        if (id == 1) break;
+    }
+    if (raw_log_used_bytes() != sectors * RAW_LOG_SECTOR) bench_mismatch("used bytes", newest);
+}
+
+// Reboot: the sessions are rebuilt from the sector headers alone
+static void bench_remount(uint32_t newest) {
+    if (!raw_log_mount()) bench_mismatch("mount", newest);
+    bench_check(newest);
+}
+
+int main(int argc, char** argv) {
+    uint32_t sectors = 64;
+    uint32_t wraps = 2;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--sectors") == 0) sectors = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--wraps") == 0) wraps = (uint32_t)atoi(argv[i + 1]);
+    }
+    if (!host_partition_create(RAW_LOG_PARTITION_LABEL, (size_t)sectors * RAW_LOG_SECTOR) || !raw_log_mount()) {
+        printf("no partition\n");
+        return 1;
+    }
+    xTaskCreatePinnedToCore(bench_reader, "reader", 4096, nullptr, 1, nullptr, 1);
+    const uint32_t cap = sectors * (uint32_t)RAW_LOG_PAYLOAD;
+    uint32_t id = 0;
+    uint32_t rng = 12345;
+    // Ordinary sessions of 5..55 % of the partition: the oldest ones are overwritten as the ring wraps
+    while (s_raw_seq - 1 < wraps * sectors) {
+        rng = rng * 1103515245u + 12345u;
+        ++id;
+        bench_record(id, cap / 100 * (5 + (rng >> 16) % 51), true);
+        bench_check(id);
+        if (id % 3 == 0) bench_remount(id);
+    }
+    // One session filling the whole partition: it stops short of its own first sector and still closes
+    ++id;
+    const uint32_t full = bench_record(id, 2 * cap, true);
+    if (full < (sectors - RAW_LOG_ERASE_AHEAD - 2) * RAW_LOG_PAYLOAD || full >= cap) bench_mismatch("full size", id);
+    bench_check(id);
+    for (uint32_t k = 1; k < id; ++k) {
+        if (raw_log_exists(k)) bench_mismatch("kept beside a full session", k);
+    }
+    bench_remount(id);
+    // Power cut during a session: the staged tail is lost, the programmed sectors stay; repaired at boot
+    ++id;
+    bench_record(id, 3 * (uint32_t)RAW_LOG_PAYLOAD + 1000, false);
+    s_exp[id].size = s_exp[id].size / RAW_LOG_PAYLOAD * RAW_LOG_PAYLOAD;
+    bench_remount(id);
+    if (!raw_log_set_totals(id, 777, 3)) bench_mismatch("set totals", id);
+    s_exp[id].total = 777;
+    s_exp[id].dropped = 3;
+    s_exp[id].closed = true;
+    bench_check(id);
+    bench_remount(id);
+    // And recording goes on after it
+    ++id;
+    bench_record(id, cap / 4, true);
+    bench_check(id);
+    bench_remount(id);
+
+    const HostFlashStats st = host_partition_stats();
+    const uint32_t wrapped = (s_raw_seq - 1) / sectors;
+    if (st.unerased_writes) bench_mismatch("programmed without an erase", id);
+    if (wrapped < wraps) bench_mismatch("wraps", id);
+    printf("BENCH_RAWLOG sectors:%u wraps:%u sessions:%u bytes:%llu kb_s:%.1f append_us:%.0f/%llu erases:%u "
+           "reader_kb:%llu %s\n",
+           (unsigned)sectors, (unsigned)wrapped, (unsigned)id, (unsigned long long)s_bytes,
+           s_write_us ? (double)s_bytes / 1024.0 / ((double)s_write_us / 1e6) : 0.0,
+           s_appends ? (double)s_write_us / s_appends : 0.0, (unsigned long long)s_append_us_max,
+           (unsigned)st.erases, (unsigned long long)(s_reader_bytes / 1024), s_fail ? "MISMATCH" : "OK");
+    fflush(stdout);
+    _Exit(s_fail ? 1 : 0);   // the reader task never ends
+}
@@ -0,0 +1,319 @@
+// Serial link end to end: the sketch's serial protocol on a pty UART (host_serial_open_pty(): bytes move at the
+// Serial baud rate, both ends at different rates garble, line faults on demand) against the C++ client of
+// pc_tools (acclog_link.h) in a second thread, as a PC would talk to the device. One harness, one scenario per run.
+// 仮想時計は pty を開いた時点から実時間に合わせる（host_sched_realtime()）ので、転送時間・kB/s は実測値。
+// 先にメモリ上のシリアルで CONFIG SET odr=<hz> / START / STOP してログを 1 本作り、pty に切り替えてから
+// クライアントを動かす。main は loop() を回し続け、クライアントが終わったら装置側の状態を確かめる。
+//
+//   bench_serial_link --scenario dumpx|stream|baud [--seconds S] [--odr HZ]
+//     dumpx:  921600 に上げ、raw DUMP と DUMPX の時間を比べる。DUMPX は回線障害（ビット化け・バイト欠落・
+//             フレーム丸ごと欠落・ACK 欠落）の下でも内容が一致し NACK / 再送で回復すること、途中で回線が切れた
+//             （クライアントが閉じた）後に受信済み位置から再開できること、X で ABORTX になること、ホストが
+//             黙ったら DUMPX_ABORT_MS 後に ABORTX になることを確かめる。いずれの後も PING が通る。
+//   stream: 記録しながら 115200 / 921600 / 1500000 で STREAM 1 3F を 2 秒ずつ受ける。
+//   baud:   INFO の baud_rates の各レートで 32 KB の DUMPX 時間、切り替え失敗（ホストが切り替えない / BAUD OK が
+//           届かない / OK BAUD が届かない）の後始末、未対応レート、NVS に残るレートを確かめる。
+// 出力:
+//   LINK_DUMP mode:<raw|dumpx> baud:<rate> bytes:<n> seconds:<s> kB_s:<kB/s> line_eff:<%>
+//   LINK_DUMPX_FAULTS bytes:<n> frames:<n> bad_frames:<n> duplicates:<n> nacks:<n> stalls:<n> seconds:<s>
+//   LINK_DUMPX_RESUME cut_at:<n> resumed_from:<n> bytes:<n>
+//   LINK_DUMPX_ABORT by:<x|silence> seconds:<s>
+//   LINK_STREAM baud:<rate> frames:<n> missing:<n> bad_frames:<n> device_frames:<n> device_dropped:<n>
+//               kB_s:<kB/s> after_off:<bytes>
+//   LINK_BAUD baud:<rate> bytes:<n> seconds:<s> kB_s:<kB/s> line_eff:<%>
+//   LINK_REVERT case:<no_switch|confirm_lost|reply_lost> result:<client result> baud:<client rate> want:<rate>
+//   BENCH_LINK scenario:<name> checks:<n> failed:<n> OK|MISMATCH
+// line_eff は回線の生の速度（10 ビット / バイト）に対する割合。失敗した確認は FAIL 行（stderr）に出る。
+#include "firmware_m5_multi_acc_logger.ino"
+#include "host_sim.h"
+#include "acclog_link.h"
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+static std::string s_out;
+static unsigned s_checks = 0;
+static unsigned s_failed = 0;
+
+static void check(bool ok, const char* what) {
+    s_checks++;
+    if (ok) return;
+    s_failed++;
+    fprintf(stderr, "FAIL %s\n", what);
+}
+
+// Memory-mode serial (before the pty): run loop() until the output contains token
+static bool bench_command(const char* line, const char* token, uint32_t timeout_ms = 60000) {
+    s_out.clear();
+    host_serial_feed(line);
+    host_serial_feed("\n");
+    const uint32_t t0 = millis();
+    while (s_out.find(token) == std::string::npos) {
+        if (millis() - t0 > timeout_ms) return false;
+        loop();
+        s_out += host_serial_take();
+    }
+    return true;
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void print_rate(const char* tag, const char* head, uint32_t baud, size_t bytes, double s) {
+    const double kb_s = s > 0 ? bytes / 1024.0 / s : 0.0;
+    printf("%s %sbaud:%u bytes:%zu seconds:%.3f kB_s:%.1f line_eff:%.0f\n", tag, head, (unsigned)baud, bytes, s,
+           kb_s, baud ? kb_s * 1024.0 * 10.0 / baud * 100.0 : 0.0);
+}
+
+// What the client sees of the device; the client thread never touches the sketch (nor its clock)
+struct LinkRun {
+    std::string port;
+    std::vector<uint8_t> log;       // the session's file on the device
+    uint32_t baud = 0;              // client: last rate the device confirmed
+};
+
+// Next line ending in `tail` (binary output before it on the same line)
+static bool wait_line_end(AcclogLink& l, const char* tail, int timeout_ms) {
+    const auto t0 = std::chrono::steady_clock::now();
+    const size_t n = strlen(tail);
+    std::string line;
+    while (seconds_since(t0) * 1000.0 < timeout_ms) {
+        if (acclog_link_read_line(l, line, 100) != ACCLOG_LINK_OK) continue;
+        if (line.size() >= n && line.compare(line.size() - n, n, tail) == 0) return true;
+    }
+    return false;
+}
+
+// Stop a DUMPX after `frames` frames without a word to the device (a pulled cable)
+struct CutAt {
+    size_t bytes;
+};
+static bool cut_progress(void* ctx, size_t have, size_t) {
+    return have < static_cast<CutAt*>(ctx)->bytes;
+}
+
+static void scenario_dumpx(LinkRun& r) {
+    AcclogLink l;
+    check(acclog_link_open(l, r.port.c_str()) == ACCLOG_LINK_OK && acclog_link_ping(l) == ACCLOG_LINK_OK, "ping");
+    check(acclog_link_baud(l, 921600) == ACCLOG_LINK_OK && l.baud == 921600, "baud 921600");
+
+    // Raw DUMP against DUMPX on a clean line
+    std::vector<uint8_t> data;
+    auto t0 = std::chrono::steady_clock::now();
+    check(acclog_link_dump(l, 0, data) == ACCLOG_LINK_OK && data == r.log, "raw dump");
+    const double raw_s = seconds_since(t0);
+    print_rate("LINK_DUMP", "mode:raw ", l.baud, data.size(), raw_s);
+    AcclogDumpxStats st;
+    data.clear();
+    t0 = std::chrono::steady_clock::now();
+    check(acclog_link_dumpx(l, 0, data, st) == ACCLOG_LINK_OK && data == r.log, "dumpx");
+    const double x_s = seconds_since(t0);
+    print_rate("LINK_DUMP", "mode:dumpx ", l.baud, data.size(), x_s);
+    check(st.nacks == 0 && st.bad_frames == 0 && st.duplicates == 0, "dumpx clean line: no recovery");
+    // Windowed ACKs keep the line busy: within 20 % of the raw dump
+    check(x_s < raw_s * 1.2, "dumpx throughput");
+
+    // Line faults (byte counts from the DUMPX command on): a flipped bit, a burst of lost bytes, a whole frame
+    // lost, and to the device a run of garbled ACK lines longer than the window (the device resends its oldest
+    // frame after DUMPX_RETRY_MS, the client answers the duplicate with its ACK again). Flipped, not dropped:
+    // a drop can splice two ACK lines into one that claims more than the client has.
+    host_serial_fault(true, 5000, 1, false);
+    host_serial_fault(true, 20000, 300, true);
+    host_serial_fault(true, 40000, 1040, true);
+    host_serial_fault(false, 60, 50, false);
+    data.clear();
+    t0 = std::chrono::steady_clock::now();
+    check(acclog_link_dumpx(l, 0, data, st) == ACCLOG_LINK_OK && data == r.log, "dumpx with faults");
+    printf("LINK_DUMPX_FAULTS bytes:%zu frames:%u bad_frames:%u duplicates:%u nacks:%u stalls:%u seconds:%.3f\n",
+           data.size(), (unsigned)st.frames, (unsigned)st.bad_frames, (unsigned)st.duplicates, (unsigned)st.nacks,
+           (unsigned)st.stalls, seconds_since(t0));
+    check(st.bad_frames >= 1 && st.nacks >= 2 && st.duplicates >= 1, "dumpx faults recovered by NACK / resend");
+
+    // Cut half way: the port closes mid-transfer, a new one resyncs and resumes from what arrived in order
+    CutAt cut = { r.log.size() / 2 };
+    data.clear();
+    check(acclog_link_dumpx(l, 0, data, st, 0, cut_progress, &cut) == ACCLOG_LINK_E_CANCELLED, "dumpx cut");
+    const size_t cut_at = data.size();
+    acclog_link_close(l);
+    check(acclog_link_open(l, r.port.c_str(), 921600) == ACCLOG_LINK_OK && acclog_link_resync(l) == ACCLOG_LINK_OK,
+          "resync after cut");
+    check(acclog_link_dumpx(l, 0, data, st) == ACCLOG_LINK_OK && data == r.log, "dumpx resume");
+    printf("LINK_DUMPX_RESUME cut_at:%zu resumed_from:%u bytes:%zu\n", cut_at, (unsigned)st.offset, data.size());
+    check(st.offset == cut_at && cut_at > 0 && st.frames < (r.log.size() + 1023) / 1024, "resume offset");
+
+    // X: the device stops at once
+    cut.bytes = 1;
+    data.clear();
+    acclog_link_dumpx(l, 0, data, st, 0, cut_progress, &cut);
+    t0 = std::chrono::steady_clock::now();
+    acclog_link_send(l, "X");
+    check(wait_line_end(l, "ABORTX", 2000), "X -> ABORTX");
+    printf("LINK_DUMPX_ABORT by:x seconds:%.3f\n", seconds_since(t0));
+    check(acclog_link_ping(l) == ACCLOG_LINK_OK, "ping after X");
+
+    // Silence: the device gives up after DUMPX_ABORT_MS and serves commands again
+    data.clear();
+    acclog_link_dumpx(l, 0, data, st, 0, cut_progress, &cut);
+    t0 = std::chrono::steady_clock::now();
+    check(wait_line_end(l, "ABORTX", DUMPX_ABORT_MS + 3000), "silence -> ABORTX");
+    const double quiet_s = seconds_since(t0);
+    printf("LINK_DUMPX_ABORT by:silence seconds:%.3f\n", quiet_s);
+    check(quiet_s > DUMPX_ABORT_MS / 1000.0 - 1.0, "abort after DUMPX_ABORT_MS");
+    check(acclog_link_ping(l) == ACCLOG_LINK_OK, "ping after abort");
+    r.baud = l.baud;
+    acclog_link_close(l);
+}
+
+static void scenario_stream(LinkRun& r) {
+    AcclogLink l;
+    std::string reply;
+    check(acclog_link_open(l, r.port.c_str()) == ACCLOG_LINK_OK && acclog_link_ping(l) == ACCLOG_LINK_OK, "ping");
+    check(acclog_link_command(l, "START", "OK", reply) == ACCLOG_LINK_OK, "START");
+    for (uint32_t rate : { 115200u, 921600u, 1500000u }) {
+        check(acclog_link_baud(l, rate) == ACCLOG_LINK_OK, "baud");
+        AcclogStreamStats st;
+        check(acclog_link_stream(l, 2.0, 1, 0x3F, st) == ACCLOG_LINK_OK, "stream");
+        // Nothing of the stream after the OFF reply
+        size_t after = 0;
+        while (acclog_link_fill(l, 300) == ACCLOG_LINK_OK) {}
+        after = l.rx.size();
+        l.rx.clear();
+        printf("LINK_STREAM baud:%u frames:%llu missing:%llu bad_frames:%llu device_frames:%u device_dropped:%u "
+               "kB_s:%.1f after_off:%zu\n",
+               (unsigned)rate, (unsigned long long)st.frames, (unsigned long long)st.missing,
+               (unsigned long long)st.bad_frames, (unsigned)st.device_frames, (unsigned)st.device_dropped,
+               st.seconds > 0 ? st.rx_bytes / 1024.0 / st.seconds : 0.0, after);
+        // Every frame sent arrives and every gap is a drop the device counted. Drops after the last frame sent
+        // (the ring overflowing while STREAM OFF is on its way) leave no gap: up to 0.2 s of them.
+        check(st.frames == st.device_frames && st.bad_frames == 0 && st.missing <= st.device_dropped
+              && st.device_dropped - st.missing <= imu_config().odr_hz / 5, "stream frames / drops match the device");
+        check(after == 0, "no frames after STREAM OFF");
+        // 17-byte frames at 1 kHz need 170 kbit/s: dropped at 115200 only
+        const double need = 17.0 * 10.0 * imu_config().odr_hz;
+        check((st.device_dropped > 0) == (need > rate), "backpressure drops only on a slow line");
+        check(st.frames + st.device_dropped >= 1.5 * imu_config().odr_hz, "stream rate");
+    }
+    check(acclog_link_command(l, "STOP", "OK", reply) == ACCLOG_LINK_OK, "STOP");
+    check(acclog_link_ping(l) == ACCLOG_LINK_OK, "ping after stream");
+    r.baud = l.baud;
+    acclog_link_close(l);
+}
+
+static void scenario_baud(LinkRun& r) {
+    AcclogLink l;
+    std::string reply;
+    check(acclog_link_open(l, r.port.c_str()) == ACCLOG_LINK_OK && acclog_link_ping(l) == ACCLOG_LINK_OK, "ping");
+    check(acclog_link_command(l, "INFO", "{", reply) == ACCLOG_LINK_OK, "INFO");
+    std::string rates;
+    for (uint32_t rate : ACCLOG_LINK_RATES) rates += (rates.empty() ? "" : ",") + std::to_string(rate);
+    check(reply.find("\"baud_rates\":[" + rates + "]") != std::string::npos, "INFO baud_rates");
+
+    // The same 32 KB at each rate
+    const uint32_t len = r.log.size() < 32768 ? (uint32_t)r.log.size() : 32768u;
+    const std::vector<uint8_t> want(r.log.begin(), r.log.begin() + len);
+    double prev_s = 1e9;
+    for (uint32_t rate : ACCLOG_LINK_RATES) {
+        check(acclog_link_baud(l, rate) == ACCLOG_LINK_OK && l.baud == rate, "baud switch");
+        std::vector<uint8_t> data;
+        AcclogDumpxStats st;
+        const auto t0 = std::chrono::steady_clock::now();
+        check(acclog_link_dumpx(l, 0, data, st, len) == ACCLOG_LINK_OK && data == want, "dumpx at rate");
+        const double s = seconds_since(t0);
+        print_rate("LINK_BAUD", "", rate, data.size(), s);
+        check(s < prev_s, "faster at a higher rate");
+        prev_s = s;
+    }
+    check(acclog_link_command(l, "BAUD", "OK BAUD", reply) == ACCLOG_LINK_OK
+          && reply == "OK BAUD " + std::to_string(l.baud), "BAUD query");
+    check(acclog_link_command(l, "BAUD 12345", "OK BAUD", reply) == ACCLOG_LINK_E_REPLY, "unsupported rate");
+    const uint32_t top = l.baud;
+
+    // The host never switches: the device comes back by itself and says so at the old rate
+    check(acclog_link_command(l, "BAUD 460800", "BAUD SWITCH", reply) == ACCLOG_LINK_OK, "BAUD SWITCH");
+    const bool reverted = wait_line_end(l, ("BAUD REVERT " + std::to_string(top)).c_str(), SERIAL_BAUD_CONFIRM_MS + 1000);
+    check(reverted && acclog_link_ping(l) == ACCLOG_LINK_OK, "revert when the host stays");
+    printf("LINK_REVERT case:no_switch result:%s baud:%u want:%u\n", reverted ? "revert" : "none",
+           (unsigned)l.baud, (unsigned)top);
+
+    // "BAUD OK" lost on the way (12 bytes of "BAUD 230400\n" first): both ends back at the old rate
+    host_serial_fault(false, 12, 9, true);
+    int err = acclog_link_baud(l, 230400);
+    printf("LINK_REVERT case:confirm_lost result:%s baud:%u want:%u\n", acclog_link_strerror(err), (unsigned)l.baud,
+           (unsigned)top);
+    check(err == ACCLOG_LINK_E_TIMEOUT && l.baud == top && acclog_link_ping(l) == ACCLOG_LINK_OK,
+          "confirmation lost: back at the old rate");
+
+    // "OK BAUD" lost ("BAUD SWITCH 921600 2000\n" first): the device kept the new rate, the client finds it there
+    host_serial_fault(true, 24, 15, true);
+    err = acclog_link_baud(l, 921600);
+    printf("LINK_REVERT case:reply_lost result:%s baud:%u want:921600\n", acclog_link_strerror(err),
+           (unsigned)l.baud);
+    check(err == ACCLOG_LINK_OK && l.baud == 921600 && acclog_link_ping(l) == ACCLOG_LINK_OK,
+          "reply lost: found at the new rate");
+    r.baud = l.baud;
+    acclog_link_close(l);
+}
+
+int main(int argc, char** argv) {
+    const char* scenario = "dumpx";
+    float seconds = 4.0f;
+    unsigned odr = 1000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--scenario") == 0) scenario = argv[i + 1];
+        else if (strcmp(argv[i], "--seconds") == 0) seconds = (float)atof(argv[i + 1]);
+        else if (strcmp(argv[i], "--odr") == 0) odr = (unsigned)atoi(argv[i + 1]);
+    }
+    void (*run)(LinkRun&) = !strcmp(scenario, "dumpx") ? scenario_dumpx
+                          : !strcmp(scenario, "stream") ? scenario_stream
+                          : !strcmp(scenario, "baud") ? scenario_baud : nullptr;
+    if (!run) {
+        printf("unknown scenario %s (dumpx|stream|baud)\n", scenario);
+        return 1;
+    }
+    host_fs_reset();
+    host_nvs_clear();
+    setup();
+    host_serial_take();
+    char cmd[32];
+    snprintf(cmd, sizeof(cmd), "CONFIG SET odr=%u", odr);
+    LinkRun r;
+    bool ok = bench_command(cmd, "\n") && bench_command("START", "OK\n");
+    const uint32_t t0 = millis();
+    while (ok && millis() - t0 < (uint32_t)(seconds * 1000.0f)) {
+        loop();
+        host_serial_take();
+    }
+    char path[FS_PATH_MAX];
+    fs_log_path(rec_session, path, sizeof(path));
+    ok = ok && bench_command("STOP", "OK\n") && host_fs_read(path, r.log) && r.log.size() > sizeof(LogHeader);
+    if (!ok || !host_serial_open_pty(r.port)) {
+        printf("no log / no pty\n");
+        return 1;
+    }
+    const uint32_t dropped0 = dropped_samples;
+
+    std::atomic<bool> done{false};
+    std::thread client([&] {
+        run(r);
+        done = true;
+    });
+    while (!done) loop();
+    client.join();
+
+    // Device side: no sampler drops while streaming; the rate the device keeps is the one last confirmed
+    if (!strcmp(scenario, "stream")) check(dropped_samples == dropped0, "sampler unaffected by the stream");
+    check(serial_baud() == r.baud, "device rate");
+    if (r.baud != SERIAL_BAUD) {
+        check(nv_get_u32("baud", 0) == r.baud, "NVS rate");
+        // Next boot opens the UART at that rate
+        serial_proto_begin();
+        check(serial_baud() == r.baud && Serial.baudRate() == r.baud, "boot rate");
+    }
+    printf("BENCH_LINK scenario:%s checks:%u failed:%u %s\n", scenario, s_checks, s_failed,
+           s_failed ? "MISMATCH" : "OK");
+    fflush(stdout);
+    // Tasks and timers never end: leave without joining them
+    _Exit(s_failed ? 1 : 0);
+}
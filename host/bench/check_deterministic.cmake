@@ -0,0 +1,14 @@
+# Runs bench_pipeline twice with the same arguments: everything but the host CPU time (cpu_ns) must match.
+#   cmake -DBENCH=<bench_pipeline> -DARGS="--seconds;2" -P check_deterministic.cmake
+foreach(run 1 2)
+  execute_process(COMMAND ${BENCH} ${ARGS} OUTPUT_VARIABLE out RESULT_VARIABLE rc)
+  if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "bench_pipeline failed (${rc}):\n${out}")
+  endif()
+  string(REGEX REPLACE "cpu_ns:[0-9]+" "cpu_ns:-" out "${out}")
+  set(out${run} "${out}")
+endforeach()
+if(NOT out1 STREQUAL out2)
+  message(FATAL_ERROR "bench_pipeline output differs between runs:\n${out1}\n---\n${out2}")
+endif()
+message(STATUS "bench_pipeline deterministic")
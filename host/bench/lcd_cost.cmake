@@ -0,0 +1,28 @@
+# Status screen cost while recording (BENCH_LCD of bench_pipeline), before / after the dirty-region renderer.
+# AFTER is bench_pipeline as configured in config.h; BEFORE is built with LCD_FULL_REDRAW_OVERRIDE=1 and the
+# former 5 s FS usage cache. Screen on for the whole recording: the after build must spend at most half the
+# drawing time per second and scan LittleFS no more often. Screen off: the after build draws nothing at all.
+#   cmake -DAFTER=<bench_pipeline> -DBEFORE=<bench_pipeline_lcd_full> -P lcd_cost.cmake
+function(lcd_run bench screen_ms prefix)
+  execute_process(COMMAND ${bench} --seconds 20 --screen-ms ${screen_ms} OUTPUT_VARIABLE out RESULT_VARIABLE rc)
+  if(NOT rc EQUAL 0 OR NOT out MATCHES "BENCH_LCD [^\n]* writes:([0-9]+)[^\n]* lcd_us_s:([0-9]+) fs_scans:([0-9]+)")
+    message(FATAL_ERROR "${bench} --screen-ms ${screen_ms} failed (${rc}):\n${out}")
+  endif()
+  set(${prefix}_writes ${CMAKE_MATCH_1} PARENT_SCOPE)
+  set(${prefix}_us ${CMAKE_MATCH_2} PARENT_SCOPE)
+  set(${prefix}_scans ${CMAKE_MATCH_3} PARENT_SCOPE)
+  string(REGEX MATCH "BENCH_LCD [^\n]*" line "${out}")
+  message(STATUS "screen_ms:${screen_ms} ${line}")
+endfunction()
+
+lcd_run(${BEFORE} 60000 before)
+lcd_run(${AFTER} 60000 after)
+math(EXPR limit "${before_us} / 2")
+if(after_us GREATER limit OR after_scans GREATER before_scans)
+  message(FATAL_ERROR "LCD cost not reduced: ${after_us} us/s, ${after_scans} scans "
+                      "(before ${before_us} us/s, ${before_scans} scans)")
+endif()
+lcd_run(${AFTER} 0 off)
+if(NOT off_writes EQUAL 0 OR NOT off_scans EQUAL 0)
+  message(FATAL_ERROR "screen off: ${off_writes} display writes, ${off_scans} scans")
+endif()
@@ -0,0 +1,38 @@
+# Power cuts at pseudo-random points of a recording (bench_pipeline --cut-ms), each followed by a boot from
+# the flash image it left (--boot): setup() must repair the log (see BENCH_RECOVER in bench_pipeline.cpp).
+# Every other run takes 400 ms per File::write, so some cuts land while a write is in progress.
+#   cmake -DBENCH=<bench_pipeline> -DDIR=<scratch dir> [-DRUNS=12] [-DSEED=1] -P power_cut.cmake
+if(NOT RUNS)
+  set(RUNS 12)
+endif()
+if(NOT SEED)
+  set(SEED 1)
+endif()
+math(EXPR last "${RUNS} - 1")
+foreach(i RANGE ${last})
+  math(EXPR seed "${SEED} * 1000 + ${i}")
+  string(RANDOM LENGTH 5 ALPHABET 123456789 RANDOM_SEED ${seed} r)
+  math(EXPR cut_ms "100 + ${r} % 14000")
+  math(EXPR odd "${i} % 2")
+  if(odd)
+    set(args --odr 1000 --fs-write-us 400000)
+  else()
+    set(args --odr 128)
+  endif()
+  set(image ${DIR}/power_cut_${i})
+  file(REMOVE_RECURSE ${image})
+  execute_process(COMMAND ${BENCH} --seconds 15 ${args} --cut-ms ${cut_ms} --image ${image}
+                  OUTPUT_VARIABLE out RESULT_VARIABLE rc)
+  if(NOT rc EQUAL 0 OR NOT out MATCHES "CUT [^\n]* records:([0-9]+)[^\n]* saved")
+    message(FATAL_ERROR "cut at ${cut_ms} ms failed (${rc}):\n${out}")
+  endif()
+  set(records ${CMAKE_MATCH_1})
+  string(REGEX MATCH "CUT [^\n]*" cut "${out}")
+  execute_process(COMMAND ${BENCH} --boot ${image} --cut-records ${records}
+                  OUTPUT_VARIABLE out RESULT_VARIABLE rc)
+  string(REGEX MATCH "BENCH_RECOVER [^\n]*" recover "${out}")
+  message(STATUS "${cut}\n   ${recover}")
+  if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "recovery after the cut at ${cut_ms} ms failed (${rc}):\n${out}")
+  endif()
+endforeach()
@@ -0,0 +1,121 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+// Host stand-in for the Arduino-ESP32 core (host/ build only).
+// millis()/micros() は仮想時計（host_sched.h）。delay() やタイマ待ちでだけ進むので、同じ入力なら結果も同じ。
+// Serial は送信をメモリに溜め、受信はテスト側が host_serial_feed() で与える（host_sim.h）。
+// host_serial_open_pty() の後は pty 上の UART になり、ボーレートの速さで送受信する（実機のクライアントが繋がる）。
+
+typedef uint8_t byte;
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+#define IRAM_ATTR
+#define SDA 21
+#define SCL 22
+#define ARDUINO_ARCH_ESP32 1
+
+#define TFT_BLACK 0x0000
+#define TFT_WHITE 0xFFFF
+#define TFT_RED 0xF800
+#define TFT_GREEN 0x07E0
+#define TFT_BLUE 0x001F
+#define TFT_YELLOW 0xFFE0
+#define TFT_DARKGREY 0x7BEF
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buf, size_t n) {
+        size_t k = 0;
+        while (k < n && write(buf[k])) ++k;
+        return k;
+    }
+    size_t write(const char* s) { return write(reinterpret_cast<const uint8_t*>(s), strlen(s)); }
+    size_t print(const char* s) { return write(s); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v) { return printf("%d", v); }
+    size_t print(unsigned v) { return printf("%u", v); }
+    size_t println(const char* s = "") { return print(s) + print('\n'); }
+    size_t println(int v) { return print(v) + print('\n'); }
+    // Whole output like the core (a heap buffer past the stack one): INFO is longer than 256 bytes
+    int printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        char buf[256];
+        va_list ap, ap2;
+        va_start(ap, fmt);
+        va_copy(ap2, ap);
+        const int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+        va_end(ap);
+        if (n >= 0 && (size_t)n < sizeof(buf)) {
+            write(reinterpret_cast<const uint8_t*>(buf), (size_t)n);
+        } else if (n >= 0) {
+            std::vector<char> big((size_t)n + 1);
+            vsnprintf(big.data(), big.size(), fmt, ap2);
+            write(reinterpret_cast<const uint8_t*>(big.data()), (size_t)n);
+        }
+        va_end(ap2);
+        return n;
+    }
+    virtual void flush() {}
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    size_t readBytes(uint8_t* buf, size_t n) {
+        size_t k = 0;
+        while (k < n && available() > 0) buf[k++] = (uint8_t)read();
+        return k;
+    }
+    void setTimeout(uint32_t) {}
+};
+
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud) { baud_ = baud; }
+    void end() {}
+    void updateBaudRate(unsigned long baud) { baud_ = baud; }
+    unsigned long baudRate() const { return baud_; }
+    void setTxBufferSize(size_t n) { tx_size_ = n; }
+    void setRxBufferSize(size_t n) { rx_size_ = n; }
+    size_t txBufferSize() const { return tx_size_; }
+    size_t rxBufferSize() const { return rx_size_; }
+    int availableForWrite();
+    using Print::write;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buf, size_t n) override;
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override;   // until the TX buffer has gone out (pty)
+private:
+    unsigned long baud_ = 0;
+    size_t tx_size_ = 0;
+    size_t rx_size_ = 256;
+};
+
+extern HardwareSerial Serial;
+
+uint32_t getCpuFrequencyMhz();
+
+struct EspClass {
+    uint64_t getEfuseMac();
+    uint32_t getCycleCount();   // 240 MHz counter derived from the host clock
+    void restart();
+};
+extern EspClass ESP;
@@ -0,0 +1,43 @@
+#pragma once
+#include <Arduino.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Host stand-in for the Arduino FS API: files live in memory (host_fs.cpp).
+// モード "r" / "w" / "a" / "r+" と、ルートディレクトリの openNextFile() だけを実装する。
+// LittleFS と同じく、書いた内容が電源断を越えて残るのは flush() / close() の後だけ（host_fs_power_cut()）。
+
+struct HostFileImpl;
+
+class File : public Stream {
+public:
+    File() {}
+    explicit File(std::shared_ptr<HostFileImpl> impl) : impl_(impl) {}
+    explicit operator bool() const { return impl_ != nullptr; }
+    using Print::write;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buf, size_t n) override;
+    size_t read(uint8_t* buf, size_t n);
+    int read() override;
+    int peek() override;
+    int available() override;
+    bool seek(uint32_t pos);
+    size_t size() const;
+    size_t position() const;
+    void close();
+    void flush() override;
+    const char* name() const;
+    bool isDirectory() const;
+    File openNextFile();
+private:
+    std::shared_ptr<HostFileImpl> impl_;
+};
+
+class HostFS {
+public:
+    File open(const char* path, const char* mode = "r", bool create = false);
+    bool exists(const char* path);
+    bool remove(const char* path);
+    bool rename(const char* from, const char* to);
+};
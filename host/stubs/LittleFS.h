@@ -0,0 +1,12 @@
+#pragma once
+#include <FS.h>
+
+class LittleFSFS : public HostFS {
+public:
+    bool begin(bool format_on_fail = false);
+    bool format();
+    size_t totalBytes();
+    size_t usedBytes();
+};
+
+extern LittleFSFS LittleFS;
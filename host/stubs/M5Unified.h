@@ -0,0 +1,59 @@
+#pragma once
+#include <Arduino.h>
+
+// Host stand-in for M5Unified (Core2 board): the display discards drawing but counts it and takes the SPI
+// transfer time on the virtual clock (host_display_stats()), the touch panel is never touched, the IMU is
+// whatever host_i2c_attach() put on Wire (M5.Imu.begin() only reports whether something answers)
+namespace m5 {
+enum pin_name_t { in_i2c_sda, in_i2c_scl };
+struct touch_detail_t {
+    bool isPressed() const { return false; }
+};
+}
+
+class HostDisplay : public Print {
+public:
+    using Print::write;
+    size_t write(uint8_t c) override;   // one glyph cell at the cursor
+    void fillScreen(uint16_t) { fillRect(0, 0, width(), height(), 0); }
+    void fillRect(int x, int y, int w, int h, uint16_t);
+    void setCursor(int x, int y) {
+        cursor_x_ = x;
+        cursor_y_ = y;
+    }
+    void setTextColor(uint16_t) {}
+    void setTextColor(uint16_t, uint16_t) {}
+    void setRotation(int) {}
+    void setBrightness(uint8_t) {}
+    int width() const { return 320; }
+    int height() const { return 240; }
+    int fontHeight() const { return 16; }
+private:
+    int cursor_x_ = 0;
+    int cursor_y_ = 0;
+};
+
+struct HostTouch {
+    void update(uint32_t) {}
+    m5::touch_detail_t getDetail() const { return m5::touch_detail_t(); }
+};
+
+struct HostPower {
+    void powerOff() {}
+};
+
+struct HostImu {
+    bool begin();
+};
+
+struct HostM5 {
+    void begin() {}
+    void update() {}
+    int getPin(m5::pin_name_t) const { return -1; }
+    HostDisplay Display;
+    HostTouch Touch;
+    HostPower Power;
+    HostImu Imu;
+};
+
+extern HostM5 M5;
@@ -0,0 +1,20 @@
+#pragma once
+#include <Arduino.h>
+
+// Host stand-in for the ESP32 NVS Preferences API: one in-memory store per namespace (host_arduino.cpp)
+class Preferences {
+public:
+    bool begin(const char* name, bool read_only = false);
+    void end();
+    uint32_t getUInt(const char* key, uint32_t def = 0);
+    size_t putUInt(const char* key, uint32_t v);
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* out, size_t len);
+    size_t putBytes(const char* key, const void* v, size_t len);
+    bool isKey(const char* key);
+    bool remove(const char* key);
+    bool clear();
+private:
+    const char* ns_ = nullptr;
+    bool ro_ = true;
+};
@@ -0,0 +1,8 @@
+#pragma once
+#include <Arduino.h>
+
+enum { WIFI_OFF = 0 };
+struct WiFiClass {
+    void mode(int) {}
+};
+extern WiFiClass WiFi;
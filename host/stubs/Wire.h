@@ -0,0 +1,37 @@
+#pragma once
+#include <Arduino.h>
+#include <vector>
+
+// Host stand-in: an I2C bus with the devices attached by host_i2c_attach() (host_sim.h); other addresses
+// NACK and reads from them return nothing. Like the ESP32 core, a transfer holds at most WIRE_BUFFER_SIZE bytes
+// and blocks the caller for its time on the bus (9 clocks per byte + START/STOP at setClock(), virtual time).
+constexpr size_t WIRE_BUFFER_SIZE = 128;
+
+class TwoWire : public Stream {
+public:
+    explicit TwoWire(int bus) : bus_(bus) {}
+    void begin() {}
+    void begin(int, int) {}
+    void setClock(uint32_t hz) { clock_hz_ = hz ? hz : 100000; }
+    void beginTransmission(uint8_t addr);
+    uint8_t endTransmission(bool stop = true);
+    uint8_t requestFrom(uint8_t addr, uint8_t n);
+    uint8_t requestFrom(int addr, int n) { return requestFrom((uint8_t)addr, (uint8_t)n); }
+    using Print::write;
+    size_t write(uint8_t c) override;
+    int available() override { return (int)(rx_.size() - rx_pos_); }
+    int read() override { return (rx_pos_ < rx_.size()) ? rx_[rx_pos_++] : -1; }
+    int peek() override { return (rx_pos_ < rx_.size()) ? rx_[rx_pos_] : -1; }
+
+private:
+    void bus_wait(size_t bytes);
+    int bus_;
+    uint32_t clock_hz_ = 100000;
+    uint8_t addr_ = 0;
+    std::vector<uint8_t> tx_;
+    std::vector<uint8_t> rx_;
+    size_t rx_pos_ = 0;
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
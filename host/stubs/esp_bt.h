@@ -0,0 +1,2 @@
+#pragma once
+inline bool btStop() { return true; }
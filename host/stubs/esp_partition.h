@@ -0,0 +1,25 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+// Host stand-in for the partition API: data partitions created by host_partition_create() (host_sim.h),
+// each backed by a temp file of its size. Without one, esp_partition_find_first() finds nothing.
+// NOR フラッシュと同じく、消去は 4KB セクタ単位で 0xFF、書き込みはビットを落とすだけ（旧値 AND 新値）。
+// 読み書き・消去は仮想時計上で時間がかかる（host_partition_set_timing()）。
+typedef enum { ESP_PARTITION_TYPE_APP = 0x00, ESP_PARTITION_TYPE_DATA = 0x01 } esp_partition_type_t;
+typedef enum { ESP_PARTITION_SUBTYPE_ANY = 0xff } esp_partition_subtype_t;
+typedef struct {
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    uint32_t address;
+    uint32_t size;
+    char label[17];
+    bool encrypted;
+} esp_partition_t;
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label);
+esp_err_t esp_partition_read(const esp_partition_t* p, size_t off, void* dst, size_t n);
+esp_err_t esp_partition_write(const esp_partition_t* p, size_t off, const void* src, size_t n);
+esp_err_t esp_partition_erase_range(const esp_partition_t* p, size_t off, size_t n);
@@ -0,0 +1,2 @@
+#pragma once
+inline int esp_wifi_stop() { return 0; }
@@ -0,0 +1,20 @@
+#pragma once
+#include <stdint.h>
+
+// Host stand-in for FreeRTOS: tasks run on the host scheduler (host_sched.h), 1 tick = 1 ms (host_rtos.cpp).
+// 優先度とコア固定は無視する（起きた順に1つずつ動く）。
+
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+typedef struct HostTask* TaskHandle_t;
+typedef struct HostQueue* QueueHandle_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY 0xFFFFFFFFu
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define tskNO_AFFINITY 0x7FFFFFFF
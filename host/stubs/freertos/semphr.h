@@ -0,0 +1,9 @@
+#pragma once
+#include "FreeRTOS.h"
+
+// Mutexes only (host_rtos.cpp): a task blocked in xSemaphoreTake() lets the others run
+typedef struct HostMutex* SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+BaseType_t xSemaphoreTake(SemaphoreHandle_t m, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t m);
@@ -0,0 +1,453 @@
+// Host stand-ins: clock, Serial, ESP, NVS, CRC32, board objects
+#include <Arduino.h>
+#include <Preferences.h>
+#include <Wire.h>
+#include <WiFi.h>
+#include <M5Unified.h>
+#include <rom/crc.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "host_sched.h"
+#include "host_sim.h"
+
+// --- Clock: virtual time of host_sched.cpp, moved only by waiting ---
+uint64_t host_micros64() { return host_sched_now(); }
+
+uint32_t millis() { return (uint32_t)(host_sched_now() / 1000u); }
+uint32_t micros() { return (uint32_t)host_sched_now(); }
+void delay(uint32_t ms) {
+    if (ms) host_sched_sleep_until(host_sched_peek() + (uint64_t)ms * 1000u);
+    else host_sched_yield();
+}
+void delayMicroseconds(uint32_t us) { host_sched_sleep_until(host_sched_peek() + us); }
+void yield() { host_sched_yield(); }
+
+uint32_t getCpuFrequencyMhz() { return 240; }
+
+EspClass ESP;
+uint64_t EspClass::getEfuseMac() { return 0x0000A1B2C3D4E5F6ULL; }
+uint32_t EspClass::getCycleCount() { return (uint32_t)(host_sched_peek() * 240u); }
+void EspClass::restart() { abort(); }
+
+// --- Serial ---
+// Memory mode: TX collects in s_ser_tx (host_serial_take()), RX is what host_serial_feed() gave.
+// pty mode (host_serial_open_pty()): the "uart" thread moves s_ser_tx out of the master side at the baud rate,
+// and what the client writes into s_ser_rx. TX holds the Arduino TX buffer plus the 128-byte hardware FIFO
+// (write() blocks when full, like the core); RX overflow beyond the RX buffer is lost.
+static std::mutex s_ser_mu;
+static std::deque<uint8_t> s_ser_rx;
+static std::string s_ser_tx;
+static int s_ser_pty = -1;                  // master side, -1: memory mode
+static const size_t HOST_UART_HW_FIFO = 128;
+static HostSerialStats s_ser_stats;
+
+struct HostSerialFault {
+    bool to_host;
+    uint64_t at;        // byte count in that direction
+    uint32_t n;
+    bool drop;
+};
+static std::vector<HostSerialFault> s_ser_faults;
+static uint64_t s_ser_tx_count = 0;         // bytes written by the firmware
+static uint64_t s_ser_rx_count = 0;         // bytes received from the client
+
+HardwareSerial Serial;
+
+// Line faults: false = byte lost, else *c altered (s_ser_mu held)
+static bool host_serial_fault_apply(bool to_host, uint64_t pos, uint8_t* c) {
+    for (const HostSerialFault& f : s_ser_faults) {
+        if (f.to_host != to_host || pos < f.at || pos >= f.at + f.n) continue;
+        if (f.drop) return false;
+        *c ^= 0x10;
+    }
+    return true;
+}
+
+static size_t host_serial_tx_room() {
+    const size_t cap = Serial.txBufferSize() + HOST_UART_HW_FIFO;
+    return (s_ser_tx.size() < cap) ? cap - s_ser_tx.size() : 0;
+}
+
+size_t HardwareSerial::write(uint8_t c) { return write(&c, 1); }
+
+size_t HardwareSerial::write(const uint8_t* buf, size_t n) {
+    std::unique_lock<std::mutex> lk(s_ser_mu);
+    if (s_ser_pty < 0) {
+        s_ser_tx.append(reinterpret_cast<const char*>(buf), n);
+        return n;
+    }
+    for (size_t k = 0; k < n;) {
+        if (!host_serial_tx_room()) {
+            // Wait for the UART to take some out
+            lk.unlock();
+            host_sched_wait(&s_ser_tx);
+            lk.lock();
+            continue;
+        }
+        uint8_t c = buf[k++];
+        if (host_serial_fault_apply(true, s_ser_tx_count++, &c)) s_ser_tx.push_back((char)c);
+    }
+    return n;
+}
+
+int HardwareSerial::availableForWrite() {
+    std::lock_guard<std::mutex> lk(s_ser_mu);
+    return (s_ser_pty < 0) ? 1024 : (int)host_serial_tx_room();
+}
+
+void HardwareSerial::flush() {
+    std::unique_lock<std::mutex> lk(s_ser_mu);
+    while (s_ser_pty >= 0 && !s_ser_tx.empty()) {
+        lk.unlock();
+        host_sched_wait(&s_ser_tx);
+        lk.lock();
+    }
+}
+
+int HardwareSerial::available() {
+    std::lock_guard<std::mutex> lk(s_ser_mu);
+    return (int)s_ser_rx.size();
+}
+
+int HardwareSerial::read() {
+    std::lock_guard<std::mutex> lk(s_ser_mu);
+    if (s_ser_rx.empty()) return -1;
+    const int c = s_ser_rx.front();
+    s_ser_rx.pop_front();
+    return c;
+}
+
+int HardwareSerial::peek() {
+    std::lock_guard<std::mutex> lk(s_ser_mu);
+    return s_ser_rx.empty() ? -1 : s_ser_rx.front();
+}
+
+void host_serial_feed(const uint8_t* buf, size_t n) {
+    std::lock_guard<std::mutex> lk(s_ser_mu);
+    s_ser_rx.insert(s_ser_rx.end(), buf, buf + n);
+}
+
+void host_serial_feed(const char* s) {
+    host_serial_feed(reinterpret_cast<const uint8_t*>(s), strlen(s));
+}
+
+std::string host_serial_take() {
+    std::lock_guard<std::mutex> lk(s_ser_mu);
+    std::string out;
+    out.swap(s_ser_tx);
+    return out;
+}
+
+// The rate the client set on its end (the master reports the slave's termios)
+static uint32_t host_pty_client_baud() {
+    static const struct { speed_t s; uint32_t baud; } rates[] = {
+        { B9600, 9600 }, { B19200, 19200 }, { B38400, 38400 }, { B57600, 57600 }, { B115200, 115200 },
+        { B230400, 230400 }, { B460800, 460800 }, { B921600, 921600 }, { B1500000, 1500000 },
+        { B2000000, 2000000 },
+    };
+    termios t;
+    if (tcgetattr(s_ser_pty, &t) != 0) return 0;
+    const speed_t sp = cfgetospeed(&t);
+    for (const auto& r : rates) {
+        if (r.s == sp) return r.baud;
+    }
+    return 0;
+}
+
+// Every UART_TICK_US: bytes from the client into RX, then as many TX bytes as the line carried meanwhile.
+// Both ends at different rates: each byte arrives as garbage (framing errors), like a real UART.
+static void host_uart_task() {
+    const uint64_t UART_TICK_US = 1000;
+    uint64_t line_free_ns = host_sched_peek() * 1000u;   // when the line has sent what it was given
+    for (;;) {
+        const uint64_t now_ns = host_sched_peek() * 1000u;
+        const uint32_t baud = (uint32_t)Serial.baudRate();
+        const bool garbled = host_pty_client_baud() != baud;
+        uint8_t buf[4096];
+        const ssize_t got = ::read(s_ser_pty, buf, sizeof(buf));
+        {
+            std::lock_guard<std::mutex> lk(s_ser_mu);
+            for (ssize_t i = 0; i < got; ++i) {
+                uint8_t c = buf[i];
+                if (!host_serial_fault_apply(false, s_ser_rx_count++, &c)) continue;
+                if (garbled) c = (uint8_t)~c;
+                if (s_ser_rx.size() >= Serial.rxBufferSize() + HOST_UART_HW_FIFO) {
+                    s_ser_stats.rx_overflow++;
+                    continue;
+                }
+                s_ser_rx.push_back(c);
+                s_ser_stats.rx_bytes++;
+            }
+            // 10 bits per byte (8N1)
+            const uint64_t byte_ns = baud ? 10000000000ull / baud : 0;
+            if (line_free_ns < now_ns) line_free_ns = now_ns;
+            size_t n = 0;
+            while (n < s_ser_tx.size() && n < sizeof(buf) && line_free_ns + byte_ns <= now_ns + UART_TICK_US * 1000u) {
+                buf[n] = (uint8_t)s_ser_tx[n];
+                if (garbled) buf[n] = (uint8_t)~buf[n];
+                line_free_ns += byte_ns;
+                n++;
+            }
+            // A full pty (client not reading) keeps the rest, like a line held off
+            const ssize_t put = n ? ::write(s_ser_pty, buf, n) : 0;
+            const size_t sent = (put > 0) ? (size_t)put : 0;
+            if (sent < n) line_free_ns -= (n - sent) * byte_ns;
+            s_ser_tx.erase(0, sent);
+            s_ser_stats.tx_bytes += sent;
+        }
+        host_sched_wake(&s_ser_tx);
+        host_sched_sleep_until(host_sched_peek() + UART_TICK_US);
+    }
+}
+
+bool host_serial_open_pty(std::string& client_path) {
+    const int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) return false;
+    const char* name = ptsname(fd);
+    if (!name) return false;
+    client_path = name;
+    termios t;
+    tcgetattr(fd, &t);
+    cfmakeraw(&t);
+    tcsetattr(fd, TCSANOW, &t);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    {
+        std::lock_guard<std::mutex> lk(s_ser_mu);
+        s_ser_pty = fd;
+        s_ser_rx.clear();
+        s_ser_tx.clear();
+    }
+    host_sched_realtime();
+    host_sched_spawn(host_uart_task, "uart");
+    return true;
+}
+
+void host_serial_fault(bool to_host, uint64_t after, uint32_t n, bool drop) {
+    std::lock_guard<std::mutex> lk(s_ser_mu);
+    s_ser_faults.push_back({ to_host, (to_host ? s_ser_tx_count : s_ser_rx_count) + after, n, drop });
+}
+
+HostSerialStats host_serial_stats() {
+    std::lock_guard<std::mutex> lk(s_ser_mu);
+    return s_ser_stats;
+}
+
+// --- NVS (Preferences) ---
+static std::mutex s_nvs_mu;
+static std::map<std::string, std::map<std::string, std::vector<uint8_t>>> s_nvs;
+
+void host_nvs_clear() {
+    std::lock_guard<std::mutex> lk(s_nvs_mu);
+    s_nvs.clear();
+}
+
+bool Preferences::begin(const char* name, bool read_only) {
+    std::lock_guard<std::mutex> lk(s_nvs_mu);
+    // Like NVS, a read-only open of a namespace that was never written fails
+    if (read_only && !s_nvs.count(name)) return false;
+    s_nvs[name];
+    ns_ = name;
+    ro_ = read_only;
+    return true;
+}
+
+void Preferences::end() { ns_ = nullptr; }
+
+uint32_t Preferences::getUInt(const char* key, uint32_t def) {
+    uint32_t v = def;
+    if (getBytesLength(key) == sizeof(v)) getBytes(key, &v, sizeof(v));
+    return v;
+}
+
+size_t Preferences::putUInt(const char* key, uint32_t v) { return putBytes(key, &v, sizeof(v)); }
+
+size_t Preferences::getBytesLength(const char* key) {
+    std::lock_guard<std::mutex> lk(s_nvs_mu);
+    if (!ns_) return 0;
+    auto& m = s_nvs[ns_];
+    auto it = m.find(key);
+    return (it == m.end()) ? 0 : it->second.size();
+}
+
+size_t Preferences::getBytes(const char* key, void* out, size_t len) {
+    std::lock_guard<std::mutex> lk(s_nvs_mu);
+    if (!ns_) return 0;
+    auto& m = s_nvs[ns_];
+    auto it = m.find(key);
+    if (it == m.end() || it->second.size() > len) return 0;
+    memcpy(out, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+size_t Preferences::putBytes(const char* key, const void* v, size_t len) {
+    std::lock_guard<std::mutex> lk(s_nvs_mu);
+    if (!ns_ || ro_) return 0;
+    const uint8_t* p = static_cast<const uint8_t*>(v);
+    s_nvs[ns_][key].assign(p, p + len);
+    return len;
+}
+
+bool Preferences::isKey(const char* key) {
+    std::lock_guard<std::mutex> lk(s_nvs_mu);
+    return ns_ && s_nvs[ns_].count(key);
+}
+
+bool Preferences::remove(const char* key) {
+    std::lock_guard<std::mutex> lk(s_nvs_mu);
+    return ns_ && !ro_ && s_nvs[ns_].erase(key);
+}
+
+bool Preferences::clear() {
+    std::lock_guard<std::mutex> lk(s_nvs_mu);
+    if (!ns_ || ro_) return false;
+    s_nvs[ns_].clear();
+    return true;
+}
+
+// --- CRC32 (ROM crc32_le: reflected 0xEDB88320, init/final inversion done inside) ---
+static std::vector<uint32_t> crc32_table() {
+    std::vector<uint32_t> t(256);
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k) c = (c & 1) ? (c >> 1) ^ 0xEDB88320u : c >> 1;
+        t[i] = c;
+    }
+    return t;
+}
+
+extern "C" uint32_t crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len) {
+    static const std::vector<uint32_t> table = crc32_table();
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; ++i) crc = table[(crc ^ buf[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// --- I2C (Wire / Wire1): devices of host_i2c_attach() ---
+static std::map<uint8_t, HostI2cDevice*> s_i2c_dev[2];
+static HostI2cStats s_i2c_stats[2];
+
+void host_i2c_attach(int bus, uint8_t addr, HostI2cDevice* dev) {
+    if (dev) s_i2c_dev[bus][addr] = dev;
+    else s_i2c_dev[bus].erase(addr);
+}
+
+HostI2cStats host_i2c_stats(int bus) { return s_i2c_stats[bus]; }
+void host_i2c_stats_reset(int bus) { s_i2c_stats[bus] = {}; }
+
+static HostI2cDevice* host_i2c_find(int bus, uint8_t addr) {
+    auto it = s_i2c_dev[bus].find(addr);
+    return (it == s_i2c_dev[bus].end()) ? nullptr : it->second;
+}
+
+void TwoWire::bus_wait(size_t bytes) {
+    const uint64_t clocks = 9u * (uint64_t)bytes + 2u;
+    host_sched_sleep_until(host_sched_peek() + (clocks * 1000000u + clock_hz_ - 1) / clock_hz_);
+}
+
+void TwoWire::beginTransmission(uint8_t addr) {
+    addr_ = addr;
+    tx_.clear();
+}
+
+size_t TwoWire::write(uint8_t c) {
+    if (tx_.size() >= WIRE_BUFFER_SIZE) return 0;
+    tx_.push_back(c);
+    return 1;
+}
+
+uint8_t TwoWire::endTransmission(bool) {
+    s_i2c_stats[bus_].transactions++;
+    s_i2c_stats[bus_].bytes += 1 + (uint32_t)tx_.size();
+    HostI2cDevice* d = host_i2c_find(bus_, addr_);
+    if (!d) {
+        bus_wait(1);
+        return 2;  // address NACK
+    }
+    if (!tx_.empty()) {
+        d->select(tx_[0]);
+        for (size_t i = 1; i < tx_.size(); ++i) {
+            d->write_reg(d->ptr, tx_[i]);
+            d->ptr = d->next_reg(d->ptr);
+        }
+    }
+    bus_wait(1 + tx_.size());
+    return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t addr, uint8_t n) {
+    rx_.clear();
+    rx_pos_ = 0;
+    s_i2c_stats[bus_].transactions++;
+    s_i2c_stats[bus_].bytes += 1;
+    HostI2cDevice* d = host_i2c_find(bus_, addr);
+    if (!d || n > WIRE_BUFFER_SIZE) {
+        bus_wait(1);
+        return 0;
+    }
+    for (uint8_t i = 0; i < n; ++i) {
+        rx_.push_back(d->read_reg(d->ptr));
+        d->ptr = d->next_reg(d->ptr);
+    }
+    s_i2c_stats[bus_].bytes += n;
+    bus_wait(1 + n);
+    return n;
+}
+
+bool HostImu::begin() {
+    return host_i2c_find(0, 0x68) != nullptr;  // MPU6886
+}
+
+// --- Display (M5.Display): drawing only costs its SPI transfer ---
+static std::mutex s_disp_mu;
+static HostDisplayStats s_disp_stats;
+
+static void host_display_write(uint64_t pixels, bool glyph) {
+    const uint64_t us = 10 + pixels * 2 / 5;   // window setup + 16 bpp at 40 MHz
+    {
+        std::lock_guard<std::mutex> lk(s_disp_mu);
+        s_disp_stats.writes++;
+        if (glyph) s_disp_stats.glyphs++;
+        s_disp_stats.pixels += pixels;
+        s_disp_stats.busy_us += us;
+    }
+    host_sched_sleep_until(host_sched_peek() + us);
+}
+
+void HostDisplay::fillRect(int x, int y, int w, int h, uint16_t) {
+    // Clipped to the panel like M5GFX
+    const int x1 = (x + w < width()) ? x + w : width();
+    const int y1 = (y + h < height()) ? y + h : height();
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    if (x1 <= x || y1 <= y) return;
+    host_display_write((uint64_t)(x1 - x) * (uint64_t)(y1 - y), false);
+}
+
+size_t HostDisplay::write(uint8_t c) {
+    if (c == '\n') {
+        cursor_x_ = 0;
+        cursor_y_ += fontHeight();
+        return 1;
+    }
+    if (c == '\r') return 1;
+    host_display_write(8u * (uint64_t)fontHeight(), true);
+    cursor_x_ += 8;
+    return 1;
+}
+
+HostDisplayStats host_display_stats() {
+    std::lock_guard<std::mutex> lk(s_disp_mu);
+    return s_disp_stats;
+}
+
+// --- Board objects ---
+TwoWire Wire(0);
+TwoWire Wire1(1);
+WiFiClass WiFi;
+HostM5 M5;
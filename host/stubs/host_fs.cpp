@@ -0,0 +1,288 @@
+// Host stand-in for LittleFS: a flat in-memory file system (directories: the root only).
+// Each file also keeps its contents as of the last flush() / close(), what a power cut leaves of it.
+#include <LittleFS.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "host_sched.h"
+#include "host_sim.h"
+
+struct HostFileImpl {
+    std::string name;                            // without the leading '/'
+    std::shared_ptr<std::vector<uint8_t>> data;  // nullptr: the root directory
+    size_t pos = 0;
+    bool append = false;
+    bool writable = false;
+    std::vector<std::string> listing;            // directory: names still to return
+    ~HostFileImpl();
+};
+
+static std::recursive_mutex s_fs_mu;
+static std::map<std::string, std::shared_ptr<std::vector<uint8_t>>> s_fs_files;
+static std::map<std::string, std::vector<uint8_t>> s_fs_synced;   // contents as of the last flush / close
+static size_t s_fs_total = 16u * 1024u * 1024u;
+static const size_t HOST_FS_BLOCK = 4096;
+static uint32_t s_fs_write_us = 0;
+static uint32_t s_fs_writing = 0;     // File::write calls between their start and the data landing
+static uint64_t s_fs_bytes_read = 0;
+static uint32_t s_fs_used_scans = 0;
+static const uint32_t HOST_FS_SCAN_US_PER_BLOCK = 20;
+
+LittleFSFS LittleFS;
+
+static std::string host_fs_key(const char* path) {
+    return std::string((*path == '/') ? path + 1 : path);
+}
+
+void host_fs_reset(size_t total) {
+    std::lock_guard<std::recursive_mutex> lk(s_fs_mu);
+    s_fs_files.clear();
+    s_fs_synced.clear();
+    s_fs_total = total;
+}
+
+// Commit a file written through impl (unless it was removed or replaced meanwhile)
+static void host_fs_sync(const HostFileImpl& f) {
+    std::lock_guard<std::recursive_mutex> lk(s_fs_mu);
+    auto it = s_fs_files.find(f.name);
+    if (f.writable && f.data && it != s_fs_files.end() && it->second == f.data) s_fs_synced[f.name] = *f.data;
+}
+
+// The Arduino File closes (and LittleFS syncs) when its last copy goes away
+HostFileImpl::~HostFileImpl() { host_fs_sync(*this); }
+
+uint32_t host_fs_power_cut() {
+    std::lock_guard<std::recursive_mutex> lk(s_fs_mu);
+    for (auto& kv : s_fs_files) *kv.second = s_fs_synced[kv.first];
+    return s_fs_writing;
+}
+
+bool host_fs_save(const char* dir) {
+    std::lock_guard<std::recursive_mutex> lk(s_fs_mu);
+    mkdir(dir, 0755);
+    for (auto& kv : s_fs_synced) {
+        FILE* f = fopen((std::string(dir) + "/" + kv.first).c_str(), "wb");
+        if (!f) return false;
+        const bool ok = fwrite(kv.second.data(), 1, kv.second.size(), f) == kv.second.size();
+        if (fclose(f) != 0 || !ok) return false;
+    }
+    return true;
+}
+
+bool host_fs_load(const char* dir, size_t total) {
+    host_fs_reset(total);
+    DIR* d = opendir(dir);
+    if (!d) return false;
+    std::lock_guard<std::recursive_mutex> lk(s_fs_mu);
+    while (dirent* e = readdir(d)) {
+        if (e->d_name[0] == '.') continue;
+        FILE* f = fopen((std::string(dir) + "/" + e->d_name).c_str(), "rb");
+        if (!f) continue;
+        auto data = std::make_shared<std::vector<uint8_t>>();
+        uint8_t buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data->insert(data->end(), buf, buf + n);
+        fclose(f);
+        s_fs_synced[e->d_name] = *data;
+        s_fs_files[e->d_name] = data;
+    }
+    closedir(d);
+    return true;
+}
+
+uint64_t host_fs_bytes_read() {
+    std::lock_guard<std::recursive_mutex> lk(s_fs_mu);
+    return s_fs_bytes_read;
+}
+
+bool host_fs_read(const char* path, std::vector<uint8_t>& out) {
+    std::lock_guard<std::recursive_mutex> lk(s_fs_mu);
+    auto it = s_fs_files.find(host_fs_key(path));
+    if (it == s_fs_files.end()) return false;
+    out = *it->second;
+    return true;
+}
+
+void host_fs_set_write_us(uint32_t us) { s_fs_write_us = us; }
+
+bool LittleFSFS::begin(bool) { return true; }
+
+bool LittleFSFS::format() {
+    std::lock_guard<std::recursive_mutex> lk(s_fs_mu);
+    s_fs_files.clear();
+    s_fs_synced.clear();
+    return true;
+}
+
+size_t LittleFSFS::totalBytes() { return s_fs_total; }
+
+static size_t host_fs_used() {
+    std::lock_guard<std::recursive_mutex> lk(s_fs_mu);
+    size_t used = 2 * HOST_FS_BLOCK;  // superblocks
+    for (auto& kv : s_fs_files) used += (kv.second->size() + HOST_FS_BLOCK - 1) / HOST_FS_BLOCK * HOST_FS_BLOCK;
+    return used;
+}
+
+size_t LittleFSFS::usedBytes() {
+    const size_t used = host_fs_used();
+    // The walk over the blocks in use (outside the lock: the writer may go on meanwhile)
+    host_sched_sleep_until(host_sched_peek() + used / HOST_FS_BLOCK * HOST_FS_SCAN_US_PER_BLOCK);
+    std::lock_guard<std::recursive_mutex> lk(s_fs_mu);
+    s_fs_used_scans++;
+    return used;
+}
+
+uint32_t host_fs_used_scans() {
+    std::lock_guard<std::recursive_mutex> lk(s_fs_mu);
+    return s_fs_used_scans;
+}
+
+File HostFS::open(const char* path, const char* mode, bool) {
+    std::lock_guard<std::recursive_mutex> lk(s_fs_mu);
+    const std::string key = host_fs_key(path);
+    auto f = std::make_shared<HostFileImpl>();
+    f->name = key;
+    if (key.empty()) {
+        for (auto& kv : s_fs_files) f->listing.push_back(kv.first);
+        return File(f);
+    }
+    auto it = s_fs_files.find(key);
+    const std::string m = mode ? mode : "r";
+    if (m == "r" || m == "r+") {
+        if (it == s_fs_files.end()) return File();
+        f->data = it->second;
+        f->writable = (m == "r+");
+    } else if (m == "w" || m == "a") {
+        if (m == "w" || it == s_fs_files.end()) {
+            // Creating / truncating is a metadata commit of its own
+            s_fs_files[key] = std::make_shared<std::vector<uint8_t>>();
+            s_fs_synced[key].clear();
+        }
+        f->data = s_fs_files[key];
+        f->writable = true;
+        f->append = (m == "a");
+        if (f->append) f->pos = f->data->size();
+    } else {
+        return File();
+    }
+    return File(f);
+}
+
+bool HostFS::exists(const char* path) {
+    std::lock_guard<std::recursive_mutex> lk(s_fs_mu);
+    return s_fs_files.count(host_fs_key(path)) > 0;
+}
+
+bool HostFS::remove(const char* path) {
+    std::lock_guard<std::recursive_mutex> lk(s_fs_mu);
+    s_fs_synced.erase(host_fs_key(path));
+    return s_fs_files.erase(host_fs_key(path)) > 0;
+}
+
+bool HostFS::rename(const char* from, const char* to) {
+    std::lock_guard<std::recursive_mutex> lk(s_fs_mu);
+    auto it = s_fs_files.find(host_fs_key(from));
+    if (it == s_fs_files.end()) return false;
+    auto data = it->second;
+    s_fs_files.erase(it);
+    s_fs_files[host_fs_key(to)] = data;
+    std::vector<uint8_t> synced = std::move(s_fs_synced[host_fs_key(from)]);
+    s_fs_synced.erase(host_fs_key(from));
+    s_fs_synced[host_fs_key(to)] = std::move(synced);
+    return true;
+}
+
+size_t File::write(uint8_t c) { return write(&c, 1); }
+
+size_t File::write(const uint8_t* buf, size_t n) {
+    // The other threads run meanwhile: not while holding s_fs_mu
+    if (s_fs_write_us) {
+        s_fs_writing++;
+        host_sched_sleep_until(host_sched_peek() + s_fs_write_us);
+        s_fs_writing--;
+    }
+    std::lock_guard<std::recursive_mutex> lk(s_fs_mu);
+    if (!impl_ || !impl_->data || !impl_->writable) return 0;
+    std::vector<uint8_t>& d = *impl_->data;
+    if (impl_->append) impl_->pos = d.size();
+    // Fail (partially) when the file system is full, like LittleFS
+    const size_t used = host_fs_used();
+    const size_t grow = (impl_->pos + n > d.size()) ? impl_->pos + n - d.size() : 0;
+    if (grow && used + grow > s_fs_total) {
+        const size_t room = (s_fs_total > used) ? s_fs_total - used : 0;
+        n -= (grow - room < n) ? grow - room : n;
+    }
+    if (impl_->pos + n > d.size()) d.resize(impl_->pos + n);
+    memcpy(d.data() + impl_->pos, buf, n);
+    impl_->pos += n;
+    return n;
+}
+
+size_t File::read(uint8_t* buf, size_t n) {
+    std::lock_guard<std::recursive_mutex> lk(s_fs_mu);
+    if (!impl_ || !impl_->data) return 0;
+    const std::vector<uint8_t>& d = *impl_->data;
+    const size_t k = (impl_->pos < d.size()) ? std::min(n, d.size() - impl_->pos) : 0;
+    memcpy(buf, d.data() + impl_->pos, k);
+    impl_->pos += k;
+    s_fs_bytes_read += k;
+    return k;
+}
+
+int File::read() {
+    uint8_t c;
+    return (read(&c, 1) == 1) ? c : -1;
+}
+
+int File::peek() {
+    std::lock_guard<std::recursive_mutex> lk(s_fs_mu);
+    if (!impl_ || !impl_->data || impl_->pos >= impl_->data->size()) return -1;
+    return (*impl_->data)[impl_->pos];
+}
+
+int File::available() {
+    std::lock_guard<std::recursive_mutex> lk(s_fs_mu);
+    if (!impl_ || !impl_->data) return 0;
+    return (impl_->pos < impl_->data->size()) ? (int)(impl_->data->size() - impl_->pos) : 0;
+}
+
+bool File::seek(uint32_t pos) {
+    std::lock_guard<std::recursive_mutex> lk(s_fs_mu);
+    if (!impl_ || !impl_->data || pos > impl_->data->size()) return false;
+    impl_->pos = pos;
+    return true;
+}
+
+void File::close() { impl_.reset(); }
+
+void File::flush() {
+    if (impl_) host_fs_sync(*impl_);
+}
+
+size_t File::size() const {
+    std::lock_guard<std::recursive_mutex> lk(s_fs_mu);
+    return (impl_ && impl_->data) ? impl_->data->size() : 0;
+}
+
+size_t File::position() const { return impl_ ? impl_->pos : 0; }
+
+const char* File::name() const { return impl_ ? impl_->name.c_str() : ""; }
+
+bool File::isDirectory() const { return impl_ && !impl_->data; }
+
+File File::openNextFile() {
+    std::lock_guard<std::recursive_mutex> lk(s_fs_mu);
+    if (!isDirectory()) return File();
+    while (!impl_->listing.empty()) {
+        const std::string n = impl_->listing.front();
+        impl_->listing.erase(impl_->listing.begin());
+        File f = LittleFS.open(("/" + n).c_str(), "r");
+        if (f) return f;
+    }
+    return File();
+}
@@ -0,0 +1,112 @@
+// Host stand-in for esp_partition: data partitions on temp files with NOR flash rules and timing
+#include <esp_partition.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+#include "host_sched.h"
+#include "host_sim.h"
+
+static const size_t HOST_FLASH_SECTOR = 4096;
+static const size_t HOST_FLASH_PAGE = 256;
+
+struct HostPartition {
+    esp_partition_t part;
+    FILE* file;
+};
+
+static std::vector<HostPartition*> s_parts;
+static HostFlashTiming s_flash_timing = { 45000, 500, 25 };
+static HostFlashStats s_flash_stats = {};
+
+// The flash operation takes us: the other threads run meanwhile
+static void host_flash_busy(uint64_t us) {
+    if (us) host_sched_sleep_until(host_sched_peek() + us);
+}
+
+static HostPartition* host_part(const esp_partition_t* p) {
+    for (HostPartition* h : s_parts) {
+        if (&h->part == p) return h;
+    }
+    return nullptr;
+}
+
+bool host_partition_create(const char* label, size_t size) {
+    FILE* f = tmpfile();   // removed when the process ends
+    if (!f) return false;
+    const std::vector<uint8_t> erased(HOST_FLASH_SECTOR, 0xFF);
+    for (size_t o = 0; o < size; o += HOST_FLASH_SECTOR) {
+        if (fwrite(erased.data(), 1, HOST_FLASH_SECTOR, f) != HOST_FLASH_SECTOR) {
+            fclose(f);
+            return false;
+        }
+    }
+    fflush(f);
+    HostPartition* h = new HostPartition();
+    h->part.type = ESP_PARTITION_TYPE_DATA;
+    h->part.subtype = ESP_PARTITION_SUBTYPE_ANY;
+    h->part.address = 0x400000u + (uint32_t)(s_parts.size() * 0x1000000u);
+    h->part.size = (uint32_t)(size / HOST_FLASH_SECTOR * HOST_FLASH_SECTOR);
+    snprintf(h->part.label, sizeof(h->part.label), "%s", label);
+    h->file = f;
+    s_parts.push_back(h);
+    return true;
+}
+
+void host_partition_set_timing(const HostFlashTiming& t) { s_flash_timing = t; }
+
+HostFlashStats host_partition_stats() { return s_flash_stats; }
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label) {
+    for (HostPartition* h : s_parts) {
+        if (h->part.type != type) continue;
+        if (subtype != ESP_PARTITION_SUBTYPE_ANY && h->part.subtype != subtype) continue;
+        if (label && strcmp(label, h->part.label) != 0) continue;
+        return &h->part;
+    }
+    return nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* p, size_t off, void* dst, size_t n) {
+    HostPartition* h = host_part(p);
+    if (!h || !dst) return ESP_ERR_INVALID_ARG;
+    if (off > p->size || n > p->size - off) return ESP_ERR_INVALID_ARG;
+    host_flash_busy(((uint64_t)n * s_flash_timing.read_us_per_kb + 1023) / 1024);
+    if (pread(fileno(h->file), dst, n, (off_t)off) != (ssize_t)n) return ESP_FAIL;
+    s_flash_stats.bytes_read += n;
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* p, size_t off, const void* src, size_t n) {
+    HostPartition* h = host_part(p);
+    if (!h || !src) return ESP_ERR_INVALID_ARG;
+    if (off > p->size || n > p->size - off) return ESP_ERR_INVALID_ARG;
+    // One program operation per 256-byte page touched
+    const size_t pages = n ? (off + n - 1) / HOST_FLASH_PAGE - off / HOST_FLASH_PAGE + 1 : 0;
+    host_flash_busy((uint64_t)pages * s_flash_timing.page_us);
+    // Programming only clears bits
+    std::vector<uint8_t> cell(n);
+    if (pread(fileno(h->file), cell.data(), n, (off_t)off) != (ssize_t)n) return ESP_FAIL;
+    const uint8_t* s = static_cast<const uint8_t*>(src);
+    for (size_t i = 0; i < n; ++i) {
+        if (s[i] & ~cell[i]) s_flash_stats.unerased_writes++;
+        cell[i] &= s[i];
+    }
+    if (pwrite(fileno(h->file), cell.data(), n, (off_t)off) != (ssize_t)n) return ESP_FAIL;
+    s_flash_stats.bytes_written += n;
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* p, size_t off, size_t n) {
+    HostPartition* h = host_part(p);
+    if (!h) return ESP_ERR_INVALID_ARG;
+    if (off % HOST_FLASH_SECTOR || n % HOST_FLASH_SECTOR || off > p->size || n > p->size - off) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    host_flash_busy((uint64_t)(n / HOST_FLASH_SECTOR) * s_flash_timing.erase_us);
+    const std::vector<uint8_t> erased(n, 0xFF);
+    if (pwrite(fileno(h->file), erased.data(), n, (off_t)off) != (ssize_t)n) return ESP_FAIL;
+    s_flash_stats.erases += (uint32_t)(n / HOST_FLASH_SECTOR);
+    return ESP_OK;
+}
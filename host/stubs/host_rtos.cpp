@@ -0,0 +1,191 @@
+// Host stand-ins for FreeRTOS tasks / queues / notifications / mutexes and esp_timer on the host scheduler
+// (host_sched.h): one thread runs at a time, so their state needs no locks of its own.
+// タスクは生成したまま終わらない（ファームウェアと同じ）。プロセス終了時はスレッドを待たずに _Exit する。
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include <Arduino.h>
+#include <deque>
+#include <vector>
+#include "host_sched.h"
+#include "host_sim.h"
+
+struct HostTask {
+    uint32_t notify = 0;
+};
+
+struct HostQueue {
+    size_t len;
+    size_t item_size;
+    std::deque<std::vector<uint8_t>> items;
+};
+
+struct HostMutex {
+    bool held = false;
+};
+
+struct HostTimer {
+    esp_timer_cb_t cb;
+    void* arg;
+    bool armed = false;
+    uint64_t due_us = 0;
+};
+
+static thread_local HostTask* t_self = nullptr;
+
+static uint64_t host_deadline(TickType_t ticks) {
+    return (ticks == portMAX_DELAY) ? HOST_SCHED_NEVER : host_sched_peek() + (uint64_t)ticks * 1000u;
+}
+
+// --- Tasks ---
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t, void* arg,
+                                   UBaseType_t, TaskHandle_t* out, BaseType_t) {
+    HostTask* t = new HostTask();
+    if (out) *out = t;
+    host_sched_spawn([t, fn, arg]() {
+        t_self = t;
+        fn(arg);
+    }, name);
+    return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks) { delay(ticks); }
+
+void host_task_stall(const char* name, uint32_t at_ms, uint32_t ms) {
+    host_sched_stall(name, (uint64_t)at_ms * 1000u, (uint64_t)ms * 1000u);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+    // loop() is not a created task: give it a notification slot of its own
+    if (!t_self) t_self = new HostTask();
+    HostTask* t = t_self;
+    const uint64_t deadline = host_deadline(ticks);
+    while (t->notify == 0 && host_sched_wait(t, deadline)) {}
+    const uint32_t v = t->notify;
+    if (v) t->notify = clear ? 0 : v - 1;
+    return v;
+}
+
+void xTaskNotifyGive(TaskHandle_t t) {
+    if (!t) return;
+    t->notify++;
+    host_sched_wake(t);
+}
+
+// --- Queues ---
+QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t item_size) {
+    HostQueue* q = new HostQueue();
+    q->len = len;
+    q->item_size = item_size;
+    return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t ticks) {
+    const uint64_t deadline = host_deadline(ticks);
+    while (q->items.size() >= q->len) {
+        if (!host_sched_wait(q, deadline) && q->items.size() >= q->len) return pdFALSE;
+    }
+    const uint8_t* p = static_cast<const uint8_t*>(item);
+    q->items.emplace_back(p, p + q->item_size);
+    host_sched_wake(q);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t ticks) {
+    const uint64_t deadline = host_deadline(ticks);
+    while (q->items.empty()) {
+        if (!host_sched_wait(q, deadline) && q->items.empty()) return pdFALSE;
+    }
+    memcpy(item, q->items.front().data(), q->item_size);
+    q->items.pop_front();
+    host_sched_wake(q);
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+    return (UBaseType_t)q->items.size();
+}
+
+BaseType_t xQueueReset(QueueHandle_t q) {
+    q->items.clear();
+    host_sched_wake(q);
+    return pdPASS;
+}
+
+// --- Mutexes ---
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return new HostMutex();
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t m, TickType_t ticks) {
+    const uint64_t deadline = host_deadline(ticks);
+    while (m->held) {
+        if (!host_sched_wait(m, deadline) && m->held) return pdFALSE;
+    }
+    m->held = true;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t m) {
+    if (!m->held) return pdFALSE;
+    m->held = false;
+    host_sched_wake(m);
+    return pdTRUE;
+}
+
+// --- esp_timer: callbacks run in one timer task, like the ESP_TIMER_TASK dispatch ---
+static std::vector<HostTimer*> s_timers;
+static bool s_timer_task = false;
+
+int64_t esp_timer_get_time() {
+    return (int64_t)host_micros64();
+}
+
+static void host_timer_task() {
+    for (;;) {
+        HostTimer* next = nullptr;
+        for (HostTimer* t : s_timers) {
+            if (t->armed && (!next || t->due_us < next->due_us)) next = t;
+        }
+        if (!next) {
+            host_sched_wait(&s_timers);
+            continue;
+        }
+        if (host_sched_peek() < next->due_us) {
+            host_sched_wait(&s_timers, next->due_us);
+            continue;  // re-check: stopped, re-armed or due
+        }
+        next->armed = false;
+        next->cb(next->arg);
+    }
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out) {
+    HostTimer* t = new HostTimer();
+    t->cb = args->callback;
+    t->arg = args->arg;
+    s_timers.push_back(t);
+    if (!s_timer_task) {
+        s_timer_task = true;
+        host_sched_spawn(host_timer_task, "esp_timer");
+    }
+    *out = t;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t t, uint64_t timeout_us) {
+    if (t->armed) return ESP_ERR_INVALID_STATE;
+    t->armed = true;
+    t->due_us = host_sched_peek() + timeout_us;
+    host_sched_wake(&s_timers);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t t) {
+    if (!t->armed) return ESP_ERR_INVALID_STATE;
+    t->armed = false;
+    host_sched_wake(&s_timers);
+    return ESP_OK;
+}
@@ -0,0 +1,241 @@
+// Virtual clock and run-one-thread-at-a-time scheduler of the host stand-ins (host_sched.h)
+#include "host_sched.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <condition_variable>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct HostThread {
+    std::condition_variable cv;
+    const char* name;
+    bool go = false;                        // holds the run token
+    bool ready = false;                     // in the ready queue
+    const void* chan = nullptr;             // waiting for host_sched_wake(chan)
+    uint64_t wake_us = HOST_SCHED_NEVER;    // waiting for the clock
+    bool timed_out = false;
+    bool stalled = false;                   // held off by host_sched_stall(): wake_us ends the stall
+    uint32_t clock_reads = 0;               // since it last blocked
+};
+
+struct HostStall {
+    std::string name;
+    uint64_t at_us;
+    uint64_t us;
+};
+
+struct HostSched {
+    std::mutex mu;
+    std::vector<HostThread*> threads;       // creation order: ties are resolved in this order
+    std::deque<HostThread*> ready;
+    std::vector<HostStall> stalls;          // not begun yet
+    uint64_t now_us = 0;
+    bool realtime = false;                  // host_sched_realtime(): now_us follows the wall clock
+    std::chrono::steady_clock::time_point wall0;   // wall time of now_us == 0
+};
+
+static HostSched& sched() {
+    static HostSched* s = new HostSched();  // never destroyed: threads outlive main()
+    return *s;
+}
+
+static thread_local HostThread* t_cur = nullptr;
+
+// The thread calling in; the first one (main) starts out holding the token
+static HostThread* host_self() {
+    if (!t_cur) {
+        HostSched& s = sched();
+        std::lock_guard<std::mutex> lk(s.mu);
+        t_cur = new HostThread();
+        t_cur->name = "main";
+        t_cur->go = true;
+        s.threads.push_back(t_cur);
+    }
+    return t_cur;
+}
+
+static void host_make_ready(HostSched& s, HostThread* t) {
+    if (t->ready) return;
+    t->ready = true;
+    t->chan = nullptr;
+    t->wake_us = HOST_SCHED_NEVER;
+    s.ready.push_back(t);
+}
+
+// A due stall of `t`: it sleeps through it instead of running, like a preempted task
+static bool host_stall_begin(HostSched& s, HostThread* t) {
+    for (size_t i = 0; i < s.stalls.size(); ++i) {
+        const HostStall& st = s.stalls[i];
+        if (st.at_us > s.now_us || st.name != t->name) continue;
+        t->wake_us = s.now_us + st.us;
+        t->stalled = true;
+        s.stalls.erase(s.stalls.begin() + (long)i);
+        return true;
+    }
+    return false;
+}
+
+static uint64_t host_wall_us(const HostSched& s) {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - s.wall0).count();
+}
+
+// Threads whose deadline has come become ready
+static void host_wake_due(HostSched& s) {
+    for (HostThread* h : s.threads) {
+        if (!h->ready && h->wake_us <= s.now_us) {
+            // The end of a stall resumes whatever woke the thread before it
+            if (!h->stalled) h->timed_out = true;
+            h->stalled = false;
+            host_make_ready(s, h);
+        }
+    }
+}
+
+// Next thread to run: the first ready one, else the clock moves to the earliest deadline.
+// `who` only names the thread that blocked last when nothing can run any more.
+static HostThread* host_next(HostSched& s, const char* who) {
+    for (;;) {
+        if (s.ready.empty()) {
+            uint64_t t = HOST_SCHED_NEVER;
+            for (HostThread* h : s.threads) if (!h->ready && h->wake_us < t) t = h->wake_us;
+            if (t == HOST_SCHED_NEVER) {
+                fprintf(stderr, "host_sched: every thread waits forever (\"%s\" blocked last)\n", who);
+                fflush(stderr);
+                _Exit(3);
+            }
+            if (t > s.now_us) {
+                // Real time: nobody runs until then (the token holder is between threads, none can take it)
+                if (s.realtime) std::this_thread::sleep_until(s.wall0 + std::chrono::microseconds(t));
+                s.now_us = t;
+            }
+            host_wake_due(s);
+        }
+        HostThread* next = s.ready.front();
+        s.ready.pop_front();
+        next->ready = false;
+        if (!host_stall_begin(s, next)) return next;
+    }
+}
+
+// The running thread `me` has recorded what it waits for (or queued itself as ready):
+// hand the token to the next thread and wait to get it back
+static void host_switch(HostSched& s, std::unique_lock<std::mutex>& lk, HostThread* me) {
+    const uint64_t t0 = s.now_us;
+    HostThread* next = host_next(s, me->name);
+    // A yield straight back with the clock unmoved is still polling (delay(0) in a wait loop)
+    if (next != me || s.now_us != t0) me->clock_reads = 0;
+    if (next == me) return;
+    me->go = false;
+    next->go = true;
+    next->cv.notify_one();
+    me->cv.wait(lk, [me] { return me->go; });
+}
+
+uint64_t host_sched_now() {
+    HostThread* me = host_self();
+    HostSched& s = sched();
+    std::unique_lock<std::mutex> lk(s.mu);
+    if (++me->clock_reads > HOST_SCHED_SPIN_READS) {
+        // Polling the clock: let it move and the others run (the ones it got to as well)
+        s.now_us++;
+        if (s.realtime) s.now_us = std::max(s.now_us, host_wall_us(s));
+        host_wake_due(s);
+        host_make_ready(s, me);
+        host_switch(s, lk, me);
+    }
+    return s.now_us;
+}
+
+uint64_t host_sched_peek() {
+    HostSched& s = sched();
+    std::lock_guard<std::mutex> lk(s.mu);
+    return s.now_us;
+}
+
+void host_sched_sleep_until(uint64_t t_us) {
+    HostThread* me = host_self();
+    HostSched& s = sched();
+    std::unique_lock<std::mutex> lk(s.mu);
+    if (t_us <= s.now_us) {
+        host_make_ready(s, me);
+    } else {
+        me->wake_us = t_us;
+    }
+    host_switch(s, lk, me);
+}
+
+void host_sched_yield() {
+    HostThread* me = host_self();
+    HostSched& s = sched();
+    std::unique_lock<std::mutex> lk(s.mu);
+    host_make_ready(s, me);
+    host_switch(s, lk, me);
+}
+
+bool host_sched_wait(const void* chan, uint64_t deadline_us) {
+    HostThread* me = host_self();
+    HostSched& s = sched();
+    std::unique_lock<std::mutex> lk(s.mu);
+    if (deadline_us <= s.now_us) return false;
+    me->chan = chan;
+    me->wake_us = deadline_us;
+    me->timed_out = false;
+    host_switch(s, lk, me);
+    return !me->timed_out;
+}
+
+void host_sched_wake(const void* chan) {
+    HostSched& s = sched();
+    std::lock_guard<std::mutex> lk(s.mu);
+    for (HostThread* h : s.threads) {
+        if (!h->ready && h->chan == chan && chan) host_make_ready(s, h);
+    }
+}
+
+void host_sched_stall(const char* name, uint64_t at_us, uint64_t us) {
+    HostSched& s = sched();
+    std::lock_guard<std::mutex> lk(s.mu);
+    s.stalls.push_back({ name, at_us, us });
+}
+
+void host_sched_realtime() {
+    HostSched& s = sched();
+    std::lock_guard<std::mutex> lk(s.mu);
+    s.wall0 = std::chrono::steady_clock::now() - std::chrono::microseconds(s.now_us);
+    s.realtime = true;
+}
+
+void host_sched_spawn(std::function<void()> fn, const char* name) {
+    host_self();
+    HostSched& s = sched();
+    HostThread* t = new HostThread();
+    t->name = name;
+    {
+        std::lock_guard<std::mutex> lk(s.mu);
+        s.threads.push_back(t);
+        host_make_ready(s, t);
+    }
+    std::thread([t, fn]() {
+        t_cur = t;
+        {
+            std::unique_lock<std::mutex> lk(sched().mu);
+            t->cv.wait(lk, [t] { return t->go; });
+        }
+        fn();
+        // Tasks do not return on the device; if one does, it just leaves the schedule
+        HostSched& s = sched();
+        std::unique_lock<std::mutex> lk(s.mu);
+        for (size_t i = 0; i < s.threads.size(); ++i) {
+            if (s.threads[i] == t) s.threads.erase(s.threads.begin() + (long)i);
+        }
+        HostThread* next = host_next(s, t->name);
+        next->go = true;
+        next->cv.notify_one();
+    }).detach();
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+#include <functional>
+
+// Virtual clock and scheduler behind the host stand-ins (host_sched.cpp; used by the stubs only).
+// FreeRTOS タスク・esp_timer・loop() はそれぞれ std::thread だが、同時に動くのは常に1つだけ
+// （実行権を持つスレッド）。実行中のスレッドがブロック（delay / キュー / 通知 / タイマ待ち）すると、
+// 待ち状態から起きたスレッドへ起きた順に実行権を渡す。誰も動けなければ仮想時計を一番早い期限まで
+// 進める。時間は delay と期限付きの待ちでしか進まないので、同じ入力なら毎回同じ順序・時刻で動く。
+// 時計を読み続けるだけのループ（ポーリング）は HOST_SCHED_SPIN_READS 回目から1回 1 µs 進めて譲る
+// （期限の来たスレッドもそこで動く）。
+
+constexpr uint64_t HOST_SCHED_NEVER = ~0ull;
+constexpr uint32_t HOST_SCHED_SPIN_READS = 1000;
+
+// Virtual microseconds since start (a clock read: see HOST_SCHED_SPIN_READS)
+uint64_t host_sched_now();
+// Without counting as a read (stubs measuring their own state)
+uint64_t host_sched_peek();
+
+// Block the running thread until t_us / let every ready thread run first
+void host_sched_sleep_until(uint64_t t_us);
+void host_sched_yield();
+
+// Block until host_sched_wake(chan) or deadline_us; false on timeout. Callers re-check their condition.
+bool host_sched_wait(const void* chan, uint64_t deadline_us = HOST_SCHED_NEVER);
+// Make every thread waiting on chan ready (they run once the caller blocks)
+void host_sched_wake(const void* chan);
+
+// Injected stall: the first time thread `name` would run at or after at_us, it sleeps for us first
+// (a long interrupt / preemption; blocking waits it was woken from still return true afterwards)
+void host_sched_stall(const char* name, uint64_t at_us, uint64_t us);
+
+// Real-time pacing, for a real client on the other end of a pty (host_serial_open_pty()): from now on the
+// virtual clock never runs ahead of the wall clock. Moving it to the next deadline waits for the wall
+// clock, and a thread polling the clock sees it move with the wall clock.
+void host_sched_realtime();
+
+// New thread, ready to run after the threads already ready
+void host_sched_spawn(std::function<void()> fn, const char* name);
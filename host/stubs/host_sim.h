@@ -0,0 +1,107 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+// Controls of the host stand-ins for benchmarks and tests (not part of the Arduino API)
+
+// Virtual microseconds since start, the clock behind millis() / micros() / esp_timer_get_time()
+uint64_t host_micros64();
+
+// Task `name` (xTaskCreatePinnedToCore, "esp_timer", or "main" for setup()/loop()) is held off for ms
+// the first time it would run at or after at_ms (virtual time, host_sched_stall())
+void host_task_stall(const char* name, uint32_t at_ms, uint32_t ms);
+
+// Bytes the firmware will read from Serial
+void host_serial_feed(const char* s);
+void host_serial_feed(const uint8_t* buf, size_t n);
+// Everything the firmware wrote to Serial since the last call
+std::string host_serial_take();
+// Serial becomes a UART on a new pty: a real client opens client_path (its termios rate must match the
+// firmware's Serial rate, else both directions arrive garbled), bytes move at the baud rate, write() blocks
+// on a full TX buffer. The virtual clock follows the wall clock from now on (host_sched_realtime()).
+bool host_serial_open_pty(std::string& client_path);
+// Line fault on the pty: n bytes starting `after` bytes from now in one direction (to_host: what the
+// firmware writes, else what the client sends) are lost (drop) or arrive with a bit flipped
+void host_serial_fault(bool to_host, uint64_t after, uint32_t n, bool drop);
+struct HostSerialStats {
+    uint64_t tx_bytes;          // put on the line
+    uint64_t rx_bytes;
+    uint32_t rx_overflow;       // bytes lost on a full RX buffer
+};
+HostSerialStats host_serial_stats();
+
+// Empty LittleFS of `total` bytes (used bytes are rounded up to 4 KB blocks per file, like LittleFS)
+void host_fs_reset(size_t total = 16u * 1024u * 1024u);
+bool host_fs_read(const char* path, std::vector<uint8_t>& out);
+// Every File::write takes us virtual microseconds from now on (a slow / erasing flash; 0 = instant)
+void host_fs_set_write_us(uint32_t us);
+// Power cut: every file goes back to its contents as of its last flush() / close() (LittleFS commits).
+// Returns the File::write calls cut short (taking their --fs-write-us time, nothing written yet).
+uint32_t host_fs_power_cut();
+// The committed files to / from a host directory (one file each): a flash image for the next boot
+bool host_fs_save(const char* dir);
+bool host_fs_load(const char* dir, size_t total = 16u * 1024u * 1024u);
+// Bytes read through File::read() since start
+uint64_t host_fs_bytes_read();
+
+// LittleFS.usedBytes() calls since start. Each one walks the blocks in use (host: 20 µs per 4 KB block of
+// virtual time, like lfs_fs_size() following the files' block lists).
+uint32_t host_fs_used_scans();
+
+// M5.Display traffic since start. Every fillRect / fillScreen / glyph is one SPI window write of its pixels
+// at 16 bits per pixel, 40 MHz (0.4 µs per pixel) plus 10 µs of window setup, taken on the virtual clock
+// by the drawing thread. A glyph is an 8 x fontHeight() cell (text drawn with a background colour).
+struct HostDisplayStats {
+    uint32_t writes;            // fills and glyphs
+    uint32_t glyphs;
+    uint64_t pixels;
+    uint64_t busy_us;
+};
+HostDisplayStats host_display_stats();
+
+// Forget all NVS keys
+void host_nvs_clear();
+
+// Data partition `label` of `size` bytes (whole 4 KB sectors) on a temp file, erased (0xFF);
+// esp_partition_find_first() finds it from now on
+bool host_partition_create(const char* label, size_t size);
+// Virtual time of the flash operations (defaults: 45 ms sector erase, 0.5 ms per 256-byte page, 25 µs per KB read)
+struct HostFlashTiming {
+    uint32_t erase_us;          // per 4 KB sector
+    uint32_t page_us;           // per 256-byte page programmed
+    uint32_t read_us_per_kb;
+};
+void host_partition_set_timing(const HostFlashTiming& t);
+struct HostFlashStats {
+    uint32_t erases;            // sectors
+    uint64_t bytes_written;
+    uint64_t bytes_read;
+    uint32_t unerased_writes;   // bytes that tried to set a bit without an erase (a bug in the caller)
+};
+HostFlashStats host_partition_stats();
+
+// I2C device for the host Wire (bus 0) / Wire1 (bus 1): a register file with an address pointer that a
+// write transaction sets (its first byte) and every byte written or read advances (next_reg()).
+struct HostI2cDevice {
+    virtual ~HostI2cDevice() {}
+    virtual uint8_t read_reg(uint8_t reg) = 0;
+    virtual void write_reg(uint8_t reg, uint8_t v) = 0;
+    // Register after reg in a burst (a FIFO data register returns itself)
+    virtual uint8_t next_reg(uint8_t reg) { return (uint8_t)(reg + 1); }
+    // A write transaction starting at reg (sets the pointer)
+    virtual void select(uint8_t reg) { ptr = reg; }
+    uint8_t ptr = 0;
+};
+// Answer at addr on bus (nullptr: remove)
+void host_i2c_attach(int bus, uint8_t addr, HostI2cDevice* dev);
+
+// Traffic of a bus since the last reset: transactions (one per START: endTransmission / requestFrom) and
+// bytes on the wire (address bytes included)
+struct HostI2cStats {
+    uint32_t transactions;
+    uint32_t bytes;
+};
+HostI2cStats host_i2c_stats(int bus);
+void host_i2c_stats_reset(int bus);
@@ -0,0 +1,5 @@
+#pragma once
+#include <stdint.h>
+
+// IEEE 802.3 CRC32 (zlib-compatible), as the ESP32 ROM provides it
+extern "C" uint32_t crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len);
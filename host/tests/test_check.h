@@ -0,0 +1,30 @@
+#pragma once
+#include <stdio.h>
+
+// Minimal checks for the host unit tests: a failed check prints its location and the values,
+// the test keeps going and test_result() makes the exit code 1.
+
+static int s_test_failures = 0;
+
+#define CHECK(cond)                                                                     \
+    do {                                                                                \
+        if (!(cond)) {                                                                  \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);    \
+            s_test_failures++;                                                          \
+        }                                                                               \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                                  \
+    do {                                                                                \
+        const long long _a = (long long)(a), _b = (long long)(b);                       \
+        if (_a != _b) {                                                                 \
+            fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n",           \
+                    __FILE__, __LINE__, #a, #b, _a, _b);                                \
+            s_test_failures++;                                                          \
+        }                                                                               \
+    } while (0)
+
+inline int test_result(const char* name) {
+    printf("%s: %s (%d failed)\n", name, s_test_failures ? "FAIL" : "OK", s_test_failures);
+    return s_test_failures ? 1 : 0;
+}
@@ -0,0 +1,108 @@
+// CmdLine (cmd_line.h): lines fed one byte at a time, trimming, "\r\n", CMD_TOOLONG and CMD_GARBAGE,
+// and cmd_line_split().
+#include "cmd_line.h"
+#include "test_check.h"
+#include <string>
+#include <vector>
+
+struct Fed {
+    CmdLineResult r;
+    std::string line;   // buf when r == CMD_LINE
+};
+
+// Feed s byte by byte; every result other than CMD_NONE is collected
+template <size_t N>
+static std::vector<Fed> feed(CmdLine<N>& l, const std::string& s) {
+    std::vector<Fed> out;
+    for (char c : s) {
+        const CmdLineResult r = cmd_line_feed(l, c);
+        if (r != CMD_NONE) out.push_back({ r, (r == CMD_LINE) ? std::string(l.buf) : std::string() });
+    }
+    return out;
+}
+
+static void test_lines() {
+    CmdLine<32> l;
+    cmd_line_reset(l);
+    CHECK(feed(l, "INF").empty());   // incomplete: nothing yet
+    auto r = feed(l, "O\n");
+    CHECK_EQ(r.size(), 1);
+    CHECK(r.size() == 1 && r[0].r == CMD_LINE && r[0].line == "INFO");
+
+    // "\r\n" gives one line (the '\n' after '\r' is an empty line), blank lines are ignored
+    r = feed(l, "START\r\n\n   \r\nSTOP\r");
+    CHECK_EQ(r.size(), 2);
+    CHECK(r.size() == 2 && r[0].line == "START" && r[1].line == "STOP");
+
+    // Leading / trailing spaces trimmed, tabs become spaces
+    r = feed(l, "  CONFIG\tSET odr=200  \n");
+    CHECK(r.size() == 1 && r[0].r == CMD_LINE && r[0].line == "CONFIG SET odr=200");
+}
+
+static void test_toolong() {
+    CmdLine<8> l;   // up to 7 characters
+    cmd_line_reset(l);
+    auto r = feed(l, "1234567\n");
+    CHECK(r.size() == 1 && r[0].r == CMD_LINE && r[0].line == "1234567");
+
+    // One byte too many: the rest of the line is skipped and TOOLONG is reported once at its end
+    r = feed(l, "12345678\n");
+    CHECK(r.size() == 1 && r[0].r == CMD_TOOLONG);
+    r = feed(l, std::string(300, 'A') + "\r\n");
+    CHECK_EQ(r.size(), 1);
+    CHECK(r.size() == 1 && r[0].r == CMD_TOOLONG);
+
+    // The next line is read normally
+    r = feed(l, "PERF\n");
+    CHECK(r.size() == 1 && r[0].r == CMD_LINE && r[0].line == "PERF");
+
+    // Overlong wins over garbage on the same line
+    r = feed(l, std::string("\x01") + std::string(20, 'x') + "\n");
+    CHECK(r.size() == 1 && r[0].r == CMD_TOOLONG);
+}
+
+static void test_garbage() {
+    CmdLine<32> l;
+    cmd_line_reset(l);
+    const char* bad[] = { "IN\x01FO\n", "\x80\xA5STATS\n", "LIST\x7F\n" };
+    for (const char* b : bad) {
+        auto r = feed(l, b);
+        CHECK(r.size() == 1 && r[0].r == CMD_GARBAGE);
+    }
+    // NUL inside a line
+    auto r = feed(l, std::string("DU\0MP\n", 6));
+    CHECK(r.size() == 1 && r[0].r == CMD_GARBAGE);
+    // A binary burst (e.g. a STREAM frame echoed back) followed by a real command
+    std::string burst;
+    for (int i = 0; i < 64; ++i) burst += (char)(0xA5 ^ i);
+    r = feed(l, burst + "\nINFO\n");
+    bool only_last_is_line = !r.empty() && r.back().r == CMD_LINE && r.back().line == "INFO";
+    for (size_t i = 0; i + 1 < r.size(); ++i) only_last_is_line = only_last_is_line && r[i].r != CMD_LINE;
+    CHECK(only_last_is_line);
+    // Printable ASCII with spaces and tabs is fine
+    r = feed(l, "CONFIG SET\tdlpf=44 odr=100\n");
+    CHECK(r.size() == 1 && r[0].r == CMD_LINE && r[0].line == "CONFIG SET dlpf=44 odr=100");
+}
+
+static void test_split() {
+    char a[] = "DUMPX 3 0 4096";
+    const char* args = cmd_line_split(a);
+    CHECK(std::string(a) == "DUMPX");
+    CHECK(std::string(args) == "3 0 4096");
+    char b[] = "INFO";
+    args = cmd_line_split(b);
+    CHECK(std::string(b) == "INFO");
+    CHECK(*args == '\0');
+    char c[] = "STREAM   4 07";
+    args = cmd_line_split(c);
+    CHECK(std::string(c) == "STREAM");
+    CHECK(std::string(args) == "4 07");
+}
+
+int main() {
+    test_lines();
+    test_toolong();
+    test_garbage();
+    test_split();
+    return test_result("test_cmd_line");
+}
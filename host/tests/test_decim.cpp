@@ -0,0 +1,153 @@
+// Anti-aliasing decimator (decim.h), built with DECIM_FACTOR_OVERRIDE=4 (config.h: 512 Hz in, 128 Hz out,
+// 64 taps, -6 dB at 80 % of 64 Hz). Test vectors:
+//   - the constexpr Q15 taps: symmetric, DC gain exactly 1, the -6 dB point where config.h puts it;
+//   - impulses at each of the DECIM_FACTOR input phases: the outputs are the taps themselves, in order
+//     (history ring, window position and the polyphase output instants);
+//   - sines from 1 Hz to the input Nyquist: the gain of the logged (aliased) tone matches the response of the
+//     Q15 taps, the passband is flat and everything that would fold into the log is attenuated;
+//   - constants at full scale (no INT16_MIN = gap marker), and a missing input turning exactly the outputs whose
+//     window holds it into gaps.
+// 周波数応答は DECIM_FR 行に出す（gain_db: 実測、expected_db: 係数から計算した値）。
+#include "decim.h"
+#include "test_check.h"
+#include <math.h>
+
+static_assert(DECIM_FACTOR == 4, "build with -DDECIM_FACTOR_OVERRIDE=4");
+
+constexpr double IN_HZ = (double)ODR_HZ * DECIM_FACTOR;
+
+static ImuSample uniform(int16_t v) { return { v, v, v, v, v, v }; }
+
+// |H(f)| of the Q15 taps at f Hz of the input rate
+static double tap_gain(double f) {
+    double re = 0.0, im = 0.0;
+    for (int k = 0; k < DECIM_TAPS; ++k) {
+        re += DecimFir::q15[k] * cos(2.0 * M_PI * f * k / IN_HZ);
+        im -= DecimFir::q15[k] * sin(2.0 * M_PI * f * k / IN_HZ);
+    }
+    return sqrt(re * re + im * im) / 32768.0;
+}
+
+static double db(double g) { return 20.0 * log10(g > 1e-9 ? g : 1e-9); }
+
+static void test_taps() {
+    int32_t sum = 0;
+    for (int k = 0; k < DECIM_TAPS; ++k) {
+        sum += DecimFir::q15[k];
+        CHECK_EQ(DecimFir::q15[k], DecimFir::q15[DECIM_TAPS - 1 - k]);
+    }
+    CHECK_EQ(DECIM_TAPS, 64);
+    CHECK_EQ(sum, 32768);
+    const double fc = ODR_HZ / 2.0 * DECIM_CUTOFF_PCT / 100.0;
+    CHECK(fabs(db(tap_gain(fc)) + 6.0) < 0.5);
+}
+
+// One impulse per channel (ax = +32767, gz = -32768) at each input phase: every output is the tap at the
+// impulse's position in its window (oldest first), i.e. q[TAPS - 1 - j] for an impulse j inputs old
+static void test_impulse() {
+    for (uint32_t pre = 0; pre < DECIM_FACTOR; ++pre) {
+        decim_reset();
+        ImuSample out;
+        const ImuSample zero = uniform(0);
+        uint32_t n = 0;
+        for (; n < DECIM_FACTOR * 4 + pre; ++n) decim_push(&zero, out);
+        ImuSample imp = zero;
+        imp.ax = 32767;
+        imp.gz = -32768;
+        const uint32_t at = n;
+        uint32_t outputs = 0;
+        for (; n < at + DECIM_TAPS + 2 * DECIM_FACTOR; ++n) {
+            if (decim_push((n == at) ? &imp : &zero, out) != DECIM_OUT) continue;
+            const uint32_t j = n - at;
+            const int32_t q = (j < DECIM_TAPS) ? DecimFir::q15[DECIM_TAPS - 1 - j] : 0;
+            CHECK_EQ(out.ax, (int16_t)(((int32_t)q * 32767 + (1 << 14)) >> 15));
+            CHECK_EQ(out.gz, -q);
+            CHECK(out.ay == 0 && out.az == 0 && out.gx == 0 && out.gy == 0);
+            outputs++;
+        }
+        CHECK_EQ(outputs, (DECIM_TAPS + 2 * DECIM_FACTOR) / DECIM_FACTOR);
+    }
+}
+
+// Gain of a sine at f Hz (input rate) as logged: fit the aliased tone over whole output periods
+static double sine_gain(double f) {
+    const double amp = 8000.0;
+    const uint32_t settle = DECIM_TAPS / DECIM_FACTOR + 1;
+    const uint32_t m = 4 * ODR_HZ;
+    double fa = fmod(f, (double)ODR_HZ);
+    if (fa > ODR_HZ / 2.0) fa = ODR_HZ - fa;
+    decim_reset();
+    double s = 0.0, c = 0.0;
+    uint32_t k = 0;
+    for (uint32_t n = 0; k < settle + m; ++n) {
+        const ImuSample in = uniform((int16_t)lround(amp * sin(2.0 * M_PI * f * n / IN_HZ)));
+        ImuSample out;
+        if (decim_push(&in, out) != DECIM_OUT) continue;
+        if (k++ < settle) continue;
+        // the tone's phase offset (FIR delay included) drops out of the amplitude
+        const double ph = 2.0 * M_PI * fa * (k - 1 - settle) / ODR_HZ;
+        s += out.ax * sin(ph);
+        c += out.ax * cos(ph);
+    }
+    return 2.0 * sqrt(s * s + c * c) / m / amp;
+}
+
+static void test_response() {
+    const double fc = ODR_HZ / 2.0 * DECIM_CUTOFF_PCT / 100.0;
+    const double freqs[] = { 1, 5, 10, 20, 30, 38, 45, 51, 58, 70, 77, 90, 100, 150, 200, 250 };
+    for (double f : freqs) {
+        const double g = sine_gain(f);
+        const double e = tap_gain(f);
+        printf("DECIM_FR f:%.0f gain_db:%.2f expected_db:%.2f\n", f, db(g), db(e));
+        CHECK(fabs(g - e) < 0.002);
+        if (f <= 0.6 * ODR_HZ / 2.0) CHECK(fabs(db(g)) < 0.1);               // passband: up to 38 Hz
+        if (f >= ODR_HZ - fc) CHECK(db(g) < -50.0);                          // would alias below the cutoff
+        if (f >= ODR_HZ / 2.0 && f < ODR_HZ - fc) CHECK(db(g) < -12.0);      // would alias above it
+    }
+}
+
+static void test_limits() {
+    const int16_t vals[] = { 0, 1, -1, 1234, -32768, 32767 };
+    for (int16_t v : vals) {
+        decim_reset();
+        const ImuSample in = uniform(v);
+        ImuSample out;
+        for (uint32_t n = 0; n < 3 * DECIM_TAPS; ++n) {
+            if (decim_push(&in, out) != DECIM_OUT) continue;
+            const int16_t want = (v == -32768) ? -32767 : v;
+            CHECK(out.ax == want && out.ay == want && out.az == want && out.gx == want && out.gy == want
+                  && out.gz == want);
+        }
+    }
+}
+
+// A missing input (filled with the previous one) makes every output whose window holds it a gap
+static void test_gap() {
+    decim_reset();
+    const ImuSample in = uniform(1000);
+    ImuSample out;
+    const uint32_t miss = 5 * DECIM_FACTOR + 2;
+    uint32_t gaps = 0, first_out_after = 0;
+    for (uint32_t n = 0; n < miss + 2 * DECIM_TAPS; ++n) {
+        const DecimResult r = decim_push((n == miss) ? nullptr : &in, out);
+        if (r == DECIM_GAP) {
+            CHECK(n >= miss && n < miss + DECIM_TAPS);
+            gaps++;
+        } else if (r == DECIM_OUT) {
+            CHECK(n < miss || n >= miss + DECIM_TAPS);
+            CHECK_EQ(out.ax, 1000);
+            if (n > miss && !first_out_after) first_out_after = n;
+        }
+    }
+    CHECK_EQ(gaps, DECIM_TAPS / DECIM_FACTOR);
+    CHECK(first_out_after >= miss + DECIM_TAPS && first_out_after < miss + DECIM_TAPS + DECIM_FACTOR);
+}
+
+int main() {
+    test_taps();
+    test_impulse();
+    test_response();
+    test_limits();
+    test_gap();
+    return test_result("decim");
+}
@@ -0,0 +1,222 @@
+// dev_config.h: CONFIG SET parsing (unknown key, value > 65535, missing '='), and the checks against
+// the IMU tables: ODR above max_sample_hz after decimation, FIFO-mode ODR rounding through odr_fn
+// (whole-Hz rates only, divisible by decim), and the DLPF nearest rule (the earlier entry on a tie).
+#include "dev_config.h"
+#include "test_check.h"
+
+// Tables as the MPU6886 driver lists them
+static const uint16_t ACC[] = { 2, 4, 8, 16 };
+static const uint16_t GYRO[] = { 250, 500, 1000, 2000 };
+static const uint16_t DLPF[] = { 250, 176, 92, 41, 20, 10, 5 };
+
+// MPU6886 with DLPF on: 1000 / (1 + SMPLRT_DIV), 0 when not a whole number of Hz
+static uint16_t mpu_odr_fn(uint16_t hz) {
+    uint32_t div = (hz >= 1000) ? 0 : 1000 / hz - 1;
+    if (div > 255) div = 255;
+    return (1000 % (div + 1) == 0) ? (uint16_t)(1000 / (div + 1)) : 0;
+}
+
+// A sensor with a fixed ODR table (nearest entry)
+static uint16_t table_odr_fn(uint16_t hz) {
+    static const uint16_t odrs[] = { 1024, 512, 256, 128, 64, 32, 16, 8 };
+    return odrs[dev_config_nearest(odrs, 8, hz)];
+}
+
+static DevConfigLimits limits(uint16_t decim = 1, uint16_t (*odr_fn)(uint16_t) = nullptr) {
+    DevConfigLimits l;
+    l.acc_ranges = ACC;
+    l.n_acc = 4;
+    l.gyro_ranges = GYRO;
+    l.n_gyro = 4;
+    l.dlpf_hz = DLPF;
+    l.n_dlpf = 7;
+    l.max_sample_hz = 1000;
+    l.max_odr_hz = 1024;
+    l.decim = decim;
+    l.odr_fn = odr_fn;
+    return l;
+}
+
+static const DevConfig BASE = { 128, 8, 2000, 0 };
+
+static bool same(const DevConfig& a, const DevConfig& b) {
+    return a.odr_hz == b.odr_hz && a.range_g == b.range_g && a.gyro_dps == b.gyro_dps && a.dlpf_hz == b.dlpf_hz;
+}
+
+static void test_parse() {
+    DevConfig c = BASE;
+    CHECK_EQ(dev_config_parse(c, "odr=200"), DEVCFG_OK);
+    CHECK_EQ(c.odr_hz, 200);
+    CHECK_EQ(c.range_g, 8);   // keys not given keep their value
+    CHECK_EQ(dev_config_parse(c, "  range_g=16   gyro_dps=500 dlpf=44 "), DEVCFG_OK);
+    CHECK(c.range_g == 16 && c.gyro_dps == 500 && c.dlpf_hz == 44 && c.odr_hz == 200);
+    CHECK_EQ(dev_config_parse(c, "odr=65535"), DEVCFG_OK);
+    CHECK_EQ(c.odr_hz, 65535);
+
+    // Errors leave c unchanged, also when an earlier key in the line was fine
+    const char* bad[] = {
+        "foo=1",              // unknown key
+        "odr=100 rate=5",     // unknown key after a good one
+        "od=100",             // prefix of a key
+        "odrx=100",           // key with extra characters
+        "odr=65536",          // > 65535
+        "dlpf=4294967296",    // would wrap a 32-bit value
+        "odr",                // missing '='
+        "odr 100",
+        "odr =100",
+        "=100",
+        "odr=",               // no digits
+        "odr=-1",
+        "odr=12x",
+        "odr=1.5",
+        "",
+        "   ",
+    };
+    for (const char* b : bad) {
+        DevConfig d = BASE;
+        const DevConfigErr e = dev_config_parse(d, b);
+        if (e != DEVCFG_SYNTAX || !same(d, BASE)) {
+            fprintf(stderr, "parse \"%s\": err %u\n", b, (unsigned)e);
+            s_test_failures++;
+        }
+    }
+    CHECK(strcmp(DEVCFG_KEYS[DEVCFG_SYNTAX], "syntax") == 0);
+    CHECK(strcmp(DEVCFG_KEYS[DEVCFG_ODR], "odr") == 0);
+}
+
+// c after a successful check, or the error (c must then be unchanged)
+static DevConfigErr check(DevConfig& c, const DevConfigLimits& l) {
+    const DevConfig before = c;
+    const DevConfigErr e = dev_config_check(c, l);
+    if (e != DEVCFG_OK) CHECK(same(c, before));
+    return e;
+}
+
+static void test_odr_limits() {
+    DevConfig c = BASE;
+    c.odr_hz = 1000;
+    CHECK_EQ(check(c, limits()), DEVCFG_OK);
+    c.odr_hz = 1001;   // IMU reads faster than max_sample_hz
+    CHECK_EQ(check(c, limits()), DEVCFG_ODR);
+    c.odr_hz = 0;
+    CHECK_EQ(check(c, limits()), DEVCFG_ODR);
+
+    // With decimation the IMU runs at odr * decim: 250 * 4 = 1000 fits, 251 * 4 does not
+    c.odr_hz = 250;
+    CHECK_EQ(check(c, limits(4)), DEVCFG_OK);
+    CHECK_EQ(c.odr_hz, 250);
+    c.odr_hz = 251;
+    CHECK_EQ(check(c, limits(4)), DEVCFG_ODR);
+    // odr * decim beyond 16 bits
+    DevConfigLimits wide = limits(64);
+    wide.max_sample_hz = 100000;
+    c.odr_hz = 1024;
+    CHECK_EQ(check(c, wide), DEVCFG_ODR);
+    // Above the logged-rate limit (buffers) even if the IMU could
+    DevConfigLimits fast = limits();
+    fast.max_sample_hz = 4000;
+    c.odr_hz = 1025;
+    CHECK_EQ(check(c, fast), DEVCFG_ODR);
+
+    c = BASE;
+    c.range_g = 3;
+    CHECK_EQ(check(c, limits()), DEVCFG_RANGE_G);
+    c = BASE;
+    c.gyro_dps = 300;
+    CHECK_EQ(check(c, limits()), DEVCFG_GYRO_DPS);
+}
+
+static void test_odr_fn() {
+    // Sample-clock paced (no odr_fn): the rate is kept as asked
+    DevConfig c = BASE;
+    c.odr_hz = 240;
+    CHECK_EQ(check(c, limits()), DEVCFG_OK);
+    CHECK_EQ(c.odr_hz, 240);
+
+    // FIFO mode: rounded to what the sensor runs at
+    struct Case { uint16_t asked; uint16_t decim; uint16_t expect; };   // expect 0: DEVCFG_ODR
+    const Case mpu[] = {
+        { 1000, 1, 1000 }, { 240, 1, 250 }, { 200, 1, 200 }, { 125, 1, 125 }, { 100, 1, 100 },
+        { 4, 1, 4 },
+        { 128, 1, 0 },     // SMPLRT_DIV 6 -> 142.857 Hz: not a whole number of Hz
+        { 300, 1, 0 },     // 333.3 Hz
+        { 3, 1, 0 },       // SMPLRT_DIV clamps at 255 -> 3.906 Hz
+        { 50, 4, 50 },     // 200 Hz sensor, / 4
+        { 60, 4, 0 },      // 240 -> 250 Hz sensor, not divisible by 4
+        { 50, 3, 0 },      // 150 -> 166.7 Hz
+        { 125, 2, 125 },   // 250 Hz sensor, / 2
+    };
+    for (const Case& k : mpu) {
+        DevConfig d = BASE;
+        d.odr_hz = k.asked;
+        const DevConfigErr e = check(d, limits(k.decim, mpu_odr_fn));
+        const bool ok = k.expect ? (e == DEVCFG_OK && d.odr_hz == k.expect) : (e == DEVCFG_ODR);
+        if (!ok) {
+            fprintf(stderr, "mpu odr %u decim %u: err %u odr %u (expected %u)\n", (unsigned)k.asked,
+                    (unsigned)k.decim, (unsigned)e, (unsigned)d.odr_hz, (unsigned)k.expect);
+            s_test_failures++;
+        }
+    }
+    const Case table[] = {
+        { 300, 1, 256 }, { 1000, 1, 1024 }, { 100, 1, 128 }, { 5, 1, 8 },
+        { 96, 1, 128 },    // tie between 128 and 64: the earlier table entry
+        { 100, 2, 128 },   // 200 -> 256 Hz sensor, / 2
+        { 20, 3, 0 },      // 60 -> 64 Hz, not divisible by 3
+    };
+    for (const Case& k : table) {
+        DevConfig d = BASE;
+        d.odr_hz = k.asked;
+        DevConfigLimits l = limits(k.decim, table_odr_fn);
+        const DevConfigErr e = check(d, l);
+        const bool ok = k.expect ? (e == DEVCFG_OK && d.odr_hz == k.expect) : (e == DEVCFG_ODR);
+        if (!ok) {
+            fprintf(stderr, "table odr %u decim %u: err %u odr %u (expected %u)\n", (unsigned)k.asked,
+                    (unsigned)k.decim, (unsigned)e, (unsigned)d.odr_hz, (unsigned)k.expect);
+            s_test_failures++;
+        }
+    }
+}
+
+static void test_dlpf() {
+    struct Case { uint16_t asked; uint16_t expect; };
+    const Case cases[] = {
+        { 0, 0 },          // automatic
+        { 250, 250 }, { 1000, 250 }, { 1, 5 }, { 44, 41 }, { 100, 92 },
+        { 134, 176 },      // tie between 176 and 92: the earlier entry
+        { 15, 20 },        // tie between 20 and 10
+        { 213, 250 },      // tie between 250 and 176
+        { 133, 92 }, { 135, 176 },
+    };
+    for (const Case& k : cases) {
+        DevConfig d = BASE;
+        d.dlpf_hz = k.asked;
+        const DevConfigErr e = check(d, limits());
+        if (e != DEVCFG_OK || d.dlpf_hz != k.expect) {
+            fprintf(stderr, "dlpf %u: err %u -> %u (expected %u)\n", (unsigned)k.asked, (unsigned)e,
+                    (unsigned)d.dlpf_hz, (unsigned)k.expect);
+            s_test_failures++;
+        }
+    }
+    // An IMU without selectable bandwidths only takes automatic
+    DevConfigLimits none = limits();
+    none.n_dlpf = 0;
+    DevConfig d = BASE;
+    d.dlpf_hz = 50;
+    CHECK_EQ(check(d, none), DEVCFG_DLPF);
+    d.dlpf_hz = 0;
+    CHECK_EQ(check(d, none), DEVCFG_OK);
+
+    // dev_config_nearest on its own: ties go to the lower index whatever the order
+    const uint16_t up[] = { 10, 20, 30 };
+    CHECK_EQ(dev_config_nearest(up, 3, 15), 0);
+    CHECK_EQ(dev_config_nearest(up, 3, 25), 1);
+    CHECK_EQ(dev_config_nearest(up, 3, 65535), 2);
+}
+
+int main() {
+    test_parse();
+    test_odr_limits();
+    test_odr_fn();
+    test_dlpf();
+    return test_result("test_dev_config");
+}
@@ -0,0 +1,181 @@
+// MPU6886 FIFO burst path (imu_mpu6886_unified.h) against a fake sensor on the host Wire bus:
+// mpu_fifo_parse() on partial frames, Mpu6886Driver::fifo_read() reading in 9-frame (126-byte) chunks
+// within the 128-byte Wire buffer, `max`, a FIFO count ending in a partial frame, and the reset after an
+// overflow (FIFO_MODE=1 stops at 1024 bytes = 73 frames + 2 bytes, so the next frame would be misaligned).
+// フレーム k の各軸は k から導いた値なので、欠落・重複・ずれ（フレーム境界の取り違え）を検出できる。
+#include "imu_driver.h"
+#include "host_sim.h"
+#include "test_check.h"
+#include <deque>
+
+// Axis a of frame k (big-endian on the wire), temperature in between
+static int16_t frame_val(uint32_t k, int a) { return (int16_t)(k * 7u + (uint32_t)a * 1000u - 3000u); }
+
+static void put_frame(std::vector<uint8_t>& out, uint32_t k) {
+    for (int a = 0; a < 6; ++a) {
+        if (a == 3) {
+            out.push_back(0x12);  // TEMP
+            out.push_back(0x34);
+        }
+        const uint16_t v = (uint16_t)frame_val(k, a);
+        out.push_back((uint8_t)(v >> 8));
+        out.push_back((uint8_t)v);
+    }
+}
+
+static bool sample_is(const ImuSample& s, uint32_t k) {
+    return s.ax == frame_val(k, 0) && s.ay == frame_val(k, 1) && s.az == frame_val(k, 2)
+        && s.gx == frame_val(k, 3) && s.gy == frame_val(k, 4) && s.gz == frame_val(k, 5);
+}
+
+// FIFO registers of an MPU6886 with accel + gyro enabled (14-byte frames, 1024-byte FIFO, stop when full)
+struct FakeMpu : HostI2cDevice {
+    std::deque<uint8_t> fifo;
+    bool oflow = false;          // INT_STATUS.FIFO_OFLOW, cleared by reading INT_STATUS
+    uint32_t resets = 0;         // USER_CTRL.FIFO_RST
+    uint32_t next_frame = 0;
+    std::vector<size_t> data_reads;  // bytes of each burst read of FIFO_R_W
+    uint8_t regs[128] = {};
+
+    // n frames arrive; bytes beyond 1024 are lost (the last frame may be cut short)
+    void produce(uint32_t n) {
+        for (uint32_t i = 0; i < n; ++i) {
+            std::vector<uint8_t> f;
+            put_frame(f, next_frame++);
+            for (uint8_t b : f) {
+                if (fifo.size() >= 1024) {
+                    oflow = true;
+                    break;
+                }
+                fifo.push_back(b);
+            }
+        }
+    }
+    uint8_t read_reg(uint8_t reg) override {
+        if (reg == MPU6886_REG_FIFO_R_W) {
+            data_reads.back()++;
+            if (fifo.empty()) return 0xFF;
+            const uint8_t b = fifo.front();
+            fifo.pop_front();
+            return b;
+        }
+        if (reg == MPU6886_REG_INT_STATUS) {
+            const uint8_t v = oflow ? 0x10 : 0x00;
+            oflow = false;
+            return v;
+        }
+        if (reg == MPU6886_REG_FIFO_COUNTH) return (uint8_t)(fifo.size() >> 8);
+        if (reg == MPU6886_REG_FIFO_COUNTH + 1) return (uint8_t)fifo.size();
+        return regs[reg & 0x7F];
+    }
+    void write_reg(uint8_t reg, uint8_t v) override {
+        regs[reg & 0x7F] = v;
+        if (reg == MPU6886_REG_USER_CTRL && (v & 0x04)) {
+            fifo.clear();
+            resets++;
+        }
+    }
+    uint8_t next_reg(uint8_t reg) override {
+        return (reg == MPU6886_REG_FIFO_R_W) ? reg : (uint8_t)(reg + 1);
+    }
+    void select(uint8_t reg) override {
+        ptr = reg;
+        if (reg == MPU6886_REG_FIFO_R_W) data_reads.push_back(0);
+    }
+};
+
+static FakeMpu s_mpu;
+
+static size_t drain(ImuSample* out, size_t max, bool& overflow) {
+    s_mpu.data_reads.clear();
+    return Mpu6886Driver::fifo_read(out, max, overflow);
+}
+
+static void test_parse_partial() {
+    std::vector<uint8_t> buf;
+    for (uint32_t k = 0; k < 3; ++k) put_frame(buf, k);
+    ImuSample s[4] = {};
+    CHECK_EQ(mpu_fifo_parse(buf.data(), 13, s), 0);               // less than a frame
+    CHECK_EQ(mpu_fifo_parse(buf.data(), buf.size() - 1, s), 2);   // the cut frame is not parsed
+    CHECK(sample_is(s[0], 0) && sample_is(s[1], 1));
+    CHECK_EQ(mpu_fifo_parse(buf.data(), buf.size(), s), 3);
+    CHECK(sample_is(s[2], 2));
+}
+
+static void test_chunks() {
+    ImuSample out[MPU6886_FIFO_FRAMES];
+    bool ovf = true;
+    // Multiples of 9 frames and the remainder: one burst read per 9 frames, none over the Wire buffer
+    for (uint32_t n : { 1u, 9u, 10u, 18u, 20u, 73u }) {
+        const uint32_t first = s_mpu.next_frame;
+        s_mpu.produce(n);
+        CHECK_EQ(drain(out, MPU6886_FIFO_FRAMES, ovf), n);
+        CHECK(!ovf);
+        CHECK_EQ(s_mpu.data_reads.size(), (n + 8) / 9);
+        for (size_t b : s_mpu.data_reads) CHECK(b <= 9 * MPU6886_FIFO_FRAME && b % MPU6886_FIFO_FRAME == 0);
+        bool seq = true;
+        for (uint32_t i = 0; i < n; ++i) seq = seq && sample_is(out[i], first + i);
+        CHECK(seq);
+        CHECK(s_mpu.fifo.empty());
+    }
+    CHECK_EQ(drain(out, MPU6886_FIFO_FRAMES, ovf), 0);
+    CHECK(s_mpu.data_reads.empty());
+}
+
+static void test_max_and_partial_count() {
+    ImuSample out[MPU6886_FIFO_FRAMES];
+    bool ovf = false;
+    const uint32_t first = s_mpu.next_frame;
+    s_mpu.produce(20);
+    // At most max frames; the rest stays for the next read, in order
+    CHECK_EQ(drain(out, 5, ovf), 5);
+    CHECK(sample_is(out[0], first) && sample_is(out[4], first + 4));
+    CHECK_EQ(drain(out, MPU6886_FIFO_FRAMES, ovf), 15);
+    CHECK(sample_is(out[0], first + 5) && sample_is(out[14], first + 19));
+
+    // A count caught mid-frame: only whole frames are read, the rest completes later
+    std::vector<uint8_t> f;
+    put_frame(f, s_mpu.next_frame);
+    put_frame(f, s_mpu.next_frame + 1);
+    s_mpu.fifo.insert(s_mpu.fifo.end(), f.begin(), f.begin() + 20);
+    CHECK_EQ(drain(out, MPU6886_FIFO_FRAMES, ovf), 1);
+    CHECK(sample_is(out[0], s_mpu.next_frame));
+    s_mpu.fifo.insert(s_mpu.fifo.end(), f.begin() + 20, f.end());
+    CHECK_EQ(drain(out, MPU6886_FIFO_FRAMES, ovf), 1);
+    CHECK(sample_is(out[0], s_mpu.next_frame + 1));
+    s_mpu.next_frame += 2;
+    CHECK(!ovf);
+}
+
+static void test_overflow_reset() {
+    ImuSample out[MPU6886_FIFO_FRAMES];
+    bool ovf = false;
+    const uint32_t first = s_mpu.next_frame;
+    const uint32_t resets = s_mpu.resets;
+    s_mpu.produce(80);   // 1120 bytes: stops at 73 frames + 2 bytes of the 74th
+    CHECK_EQ(s_mpu.fifo.size(), 1024);
+    CHECK_EQ(drain(out, MPU6886_FIFO_FRAMES, ovf), MPU6886_FIFO_FRAMES);
+    CHECK(ovf);
+    CHECK(sample_is(out[0], first) && sample_is(out[72], first + 72));
+    // The cut frame is gone with the reset: the next frames start on a frame boundary
+    CHECK_EQ(s_mpu.resets, resets + 1);
+    CHECK(s_mpu.fifo.empty());
+    const uint32_t next = s_mpu.next_frame;
+    s_mpu.produce(3);
+    CHECK_EQ(drain(out, MPU6886_FIFO_FRAMES, ovf), 3);
+    CHECK(!ovf);
+    CHECK(sample_is(out[0], next) && sample_is(out[2], next + 2));
+    CHECK_EQ(s_mpu.resets, resets + 1);
+}
+
+int main() {
+    host_i2c_attach(0, MPU6886_ADDR, &s_mpu);
+    CHECK(Mpu6886Driver::fifo_begin());
+    CHECK_EQ(s_mpu.resets, 1);
+    CHECK_EQ(s_mpu.regs[MPU6886_REG_FIFO_EN], 0x18);
+    test_parse_partial();
+    test_chunks();
+    test_max_and_partial_count();
+    test_overflow_reset();
+    return test_result("mpu_fifo");
+}
@@ -0,0 +1,155 @@
+// SpscQueue (spsc_queue.h): capacity / overflow / clear on one thread, then a producer and a consumer
+// std::thread hammering small rings so the slot index wraps over a hundred thousand times.
+// 各要素は通し番号とそこから導いた検査値を持ち、消費側は順序・欠落・重複・書きかけの要素を検出する。
+#include "spsc_queue.h"
+#include "test_check.h"
+#include <thread>
+
+struct Item {
+    uint32_t seq;
+    uint32_t check;   // derived from seq: a torn (half-written) element shows up as a mismatch
+    uint64_t pad[2];
+};
+
+static Item make_item(uint32_t seq) {
+    Item it;
+    it.seq = seq;
+    it.check = seq * 2654435761u ^ 0x5A5A5A5Au;
+    it.pad[0] = ~(uint64_t)seq;
+    it.pad[1] = (uint64_t)seq << 32 | seq;
+    return it;
+}
+
+static bool item_ok(const Item& it) {
+    const Item ref = make_item(it.seq);
+    return it.check == ref.check && it.pad[0] == ref.pad[0] && it.pad[1] == ref.pad[1];
+}
+
+static void test_single_thread() {
+    SpscQueue<uint32_t, 8> q;
+    uint32_t v = 0;
+    CHECK(q.empty());
+    CHECK(q.front() == nullptr);
+    CHECK(!q.pop(v));
+    for (uint32_t i = 0; i < 8; ++i) CHECK(q.push(i));   // all N slots are usable
+    CHECK_EQ(q.size(), 8);
+    CHECK(!q.push(99));
+    CHECK_EQ(q.overflow(), 1);
+    CHECK(q.front() && *q.front() == 0);
+    for (uint32_t i = 0; i < 8; ++i) {
+        CHECK(q.pop(v));
+        CHECK_EQ(v, i);
+    }
+    CHECK(q.empty());
+    // Slot index wraps: keep the ring half full for many rounds
+    uint32_t next_in = 0, next_out = 0;
+    for (int round = 0; round < 1000; ++round) {
+        while (q.size() < 5) CHECK(q.push(next_in++));
+        for (int k = 0; k < 3; ++k) {
+            CHECK(q.pop(v));
+            CHECK_EQ(v, next_out++);
+        }
+    }
+    CHECK_EQ(q.overflow(), 1);
+    q.clear();
+    CHECK(q.empty());
+    CHECK_EQ(q.overflow(), 0);
+    CHECK(q.push(7) && q.pop(v) && v == 7);
+}
+
+// Lossless: the producer retries a full ring, so every item must arrive once, in order
+template <size_t N>
+static void test_threads_lossless(uint32_t count) {
+    static SpscQueue<Item, N> q;
+    q.clear();
+    uint32_t refused = 0;
+    std::thread prod([&] {
+        for (uint32_t i = 0; i < count; ++i) {
+            const Item it = make_item(i);
+            while (!q.push(it)) {
+                refused++;
+                std::this_thread::yield();
+            }
+        }
+    });
+    uint32_t expect = 0, bad_order = 0, torn = 0;
+    while (expect < count) {
+        // Alternate front()+pop() and pop() so both consumer paths run concurrently with push()
+        if (expect & 1) {
+            const Item* f = q.front();
+            if (!f) {
+                std::this_thread::yield();
+                continue;
+            }
+            const Item seen = *f;
+            Item it;
+            if (!q.pop(it)) {
+                bad_order++;
+                break;
+            }
+            if (seen.seq != it.seq) bad_order++;
+            if (it.seq != expect) bad_order++;
+            if (!item_ok(it)) torn++;
+        } else {
+            Item it;
+            if (!q.pop(it)) {
+                std::this_thread::yield();
+                continue;
+            }
+            if (it.seq != expect) bad_order++;
+            if (!item_ok(it)) torn++;
+        }
+        expect++;
+    }
+    prod.join();
+    CHECK_EQ(expect, count);
+    CHECK_EQ(bad_order, 0);
+    CHECK_EQ(torn, 0);
+    CHECK(q.empty());
+    CHECK_EQ(q.overflow(), refused);
+}
+
+// Lossy like acq_push(): a full ring refuses the item. What arrives is strictly increasing (no
+// duplicates), and arrived + refused == pushed.
+template <size_t N>
+static void test_threads_lossy(uint32_t count) {
+    static SpscQueue<Item, N> q;
+    q.clear();
+    uint32_t accepted = 0;
+    bool done = false;
+    std::atomic<bool> prod_done{false};
+    std::thread prod([&] {
+        for (uint32_t i = 0; i < count; ++i) {
+            if (q.push(make_item(i))) accepted++;
+            if ((i & 255) == 0) std::this_thread::yield();   // let the consumer in on a single core
+        }
+        prod_done.store(true, std::memory_order_release);
+    });
+    uint32_t got = 0, bad_order = 0, torn = 0;
+    int64_t last = -1;
+    while (!done) {
+        done = prod_done.load(std::memory_order_acquire);   // drain once more after the producer ends
+        Item it;
+        while (q.pop(it)) {
+            if ((int64_t)it.seq <= last) bad_order++;
+            if (!item_ok(it)) torn++;
+            last = it.seq;
+            got++;
+        }
+        std::this_thread::yield();
+    }
+    prod.join();
+    CHECK_EQ(bad_order, 0);
+    CHECK_EQ(torn, 0);
+    CHECK_EQ(got, accepted);
+    CHECK_EQ((uint64_t)accepted + q.overflow(), count);
+}
+
+int main() {
+    test_single_thread();
+    test_threads_lossless<4>(500000);
+    test_threads_lossless<512>(500000);
+    test_threads_lossy<4>(500000);
+    test_threads_lossy<64>(500000);
+    return test_result("test_spsc_queue");
+}
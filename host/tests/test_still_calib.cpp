@@ -0,0 +1,165 @@
+// still_calib.h on synthetic traces: a still trace converges to the injected gyro bias, motion windows
+// are rejected without touching the estimate, a slow drift is tracked, and the integer stillness test
+// stays exact at the largest window (4096) with full-scale samples.
+#include "still_calib.h"
+#include "test_check.h"
+#include <math.h>
+#include <initializer_list>
+
+// Deterministic noise in [-amp, amp]
+static uint32_t s_rng = 12345;
+static int16_t noise(int amp) {
+    s_rng = s_rng * 1664525u + 1013904223u;
+    return (int16_t)((int32_t)(s_rng >> 16) % (2 * amp + 1) - amp);
+}
+
+static const StillCalibParams P = { 256, 4, 3, 8, 20 };   // window, min_windows, shift, gyro/acc std max
+
+// One sample of a device lying flat (1 g = 4096 counts on z) with gyro bias b
+static bool feed_still(StillCalib& c, const StillCalibParams& p, int bx, int by, int bz) {
+    return still_calib_feed(c, p, noise(6), noise(6), (int16_t)(4096 + noise(6)),
+                            (int16_t)(bx + noise(3)), (int16_t)(by + noise(3)), (int16_t)(bz + noise(3)));
+}
+
+static void test_still_converges() {
+    StillCalib c;
+    still_calib_reset(c);
+    int updates = 0;
+    for (int i = 0; i < P.window * (P.min_windows - 1); ++i) updates += feed_still(c, P, 37, -12, 5);
+    CHECK_EQ(updates, 0);   // not before min_windows still windows
+    CHECK(!c.valid);
+    for (int i = 0; i < P.window; ++i) updates += feed_still(c, P, 37, -12, 5);
+    CHECK_EQ(updates, 1);
+    CHECK(c.valid && c.still);
+    CHECK(abs(still_calib_bias(c, 0) - 37) <= 1);
+    CHECK(abs(still_calib_bias(c, 1) + 12) <= 1);
+    CHECK(abs(still_calib_bias(c, 2) - 5) <= 1);
+    CHECK(abs(c.acc_mean[2] - 4096) <= 2);
+    CHECK_EQ(c.windows, (uint32_t)P.min_windows);
+    CHECK_EQ(c.still_windows, (uint32_t)P.min_windows);
+}
+
+static void test_motion_rejected() {
+    StillCalib c;
+    still_calib_reset(c);
+    // Rotation on x (gyro swings by 300 counts): no window is still, nothing is estimated
+    for (int i = 0; i < P.window * 8; ++i) {
+        const int16_t g = (int16_t)(300 * sin(i * 0.05));
+        still_calib_feed(c, P, noise(6), noise(6), 4096, (int16_t)(20 + g), 0, 0);
+    }
+    CHECK_EQ(c.windows, 8);
+    CHECK_EQ(c.still_windows, 0);
+    CHECK(!c.valid);
+
+    // Shaking (accel only) is rejected as well, and resets the run of still windows
+    for (int i = 0; i < P.window * (P.min_windows - 1); ++i) feed_still(c, P, 20, 0, 0);
+    for (int i = 0; i < P.window; ++i) {
+        still_calib_feed(c, P, (int16_t)((i & 1) ? 800 : -800), 0, 4096, (int16_t)(20 + noise(3)), 0, 0);
+    }
+    CHECK(!c.still);
+    for (int i = 0; i < P.window; ++i) feed_still(c, P, 20, 0, 0);
+    CHECK(!c.valid);   // the run restarted: 1 still window after the shaking, not min_windows
+
+    // A motion window does not move an existing estimate
+    still_calib_seed(c, 20, 0, 0);
+    const int32_t before = c.bias_q8[0];
+    for (int i = 0; i < P.window * 4; ++i) {
+        still_calib_feed(c, P, 0, 0, 4096, (int16_t)(500 + (int16_t)(400 * sin(i * 0.1))), 0, 0);
+    }
+    CHECK_EQ(c.bias_q8[0], before);
+}
+
+static void test_tracks_drift() {
+    StillCalib c;
+    still_calib_reset(c);
+    still_calib_seed(c, 10, -10, 0);
+    // Bias x drifts 10 -> 60 and y -10 -> -40 over 400 windows (temperature), z stays
+    const int windows = 400;
+    double bx = 10, by = -10;
+    int max_err = 0;
+    for (int w = 0; w < windows; ++w) {
+        bx += 50.0 / windows;
+        by -= 30.0 / windows;
+        for (int i = 0; i < P.window; ++i) feed_still(c, P, (int)lround(bx), (int)lround(by), 0);
+        // Exponential tracking lags by about drift_per_window * 2^shift (1 count here)
+        if (w >= 50) {
+            const int ex = abs(still_calib_bias(c, 0) - (int)lround(bx));
+            const int ey = abs(still_calib_bias(c, 1) - (int)lround(by));
+            if (ex > max_err) max_err = ex;
+            if (ey > max_err) max_err = ey;
+        }
+    }
+    CHECK(max_err <= 3);
+    CHECK(abs(still_calib_bias(c, 0) - 60) <= 2);
+    CHECK(abs(still_calib_bias(c, 1) + 40) <= 2);
+    CHECK(abs(still_calib_bias(c, 2)) <= 1);
+    CHECK_EQ(c.still_windows, (uint32_t)windows);
+}
+
+// n * sq - sum^2 <= n^2 * std_max^2 in 128-bit arithmetic
+static bool quiet_ref(const int16_t* v, uint32_t n, uint32_t std_max) {
+    __int128 s = 0, sq = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        s += v[i];
+        sq += (__int128)v[i] * v[i];
+    }
+    return (__int128)n * sq - s * s <= (__int128)n * n * std_max * std_max;
+}
+
+// window = 4096 with full-scale gyro x: the stillness decision matches the 128-bit reference
+static void test_quiet_bound_4096() {
+    const StillCalibParams p = { 4096, 1, 3, 0, 0xFFFF };
+    static int16_t v[4096];
+    struct Case { const char* name; int kind; };
+    const Case cases[] = { { "alternating +-32767", 0 }, { "constant -32768", 1 },
+                           { "one +32767 among -32768", 2 }, { "random full scale", 3 } };
+    for (const Case& k : cases) {
+        for (uint32_t i = 0; i < 4096; ++i) {
+            switch (k.kind) {
+            case 0: v[i] = (i & 1) ? 32767 : -32767; break;
+            case 1: v[i] = -32768; break;
+            case 2: v[i] = (i == 4095) ? 32767 : -32768; break;
+            default: v[i] = (int16_t)(noise(32767)); break;
+            }
+        }
+        // Exact standard deviation (floor) and its neighbours: quiet flips exactly at the true value
+        __int128 s = 0, sq = 0;
+        for (int16_t x : v) {
+            s += x;
+            sq += (__int128)x * x;
+        }
+        const double var = (double)(4096 * sq - s * s) / (4096.0 * 4096.0);
+        const uint32_t sd = (uint32_t)sqrt(var);
+        CHECK(quiet_ref(v, 4096, sd + 1));
+        CHECK(sd == 0 || !quiet_ref(v, 4096, sd - 1));
+        for (uint32_t std_max : { sd > 0 ? sd - 1 : 0u, sd, sd + 1, 65535u }) {
+            StillCalibParams q = p;
+            q.gyro_std_max = std_max;
+            StillCalib c;
+            still_calib_reset(c);
+            for (uint32_t i = 0; i < 4096; ++i) still_calib_feed(c, q, 0, 0, 0, v[i], 0, 0);
+            CHECK_EQ(c.windows, 1);
+            if (c.still != quiet_ref(v, 4096, std_max)) {
+                fprintf(stderr, "%s std_max %u: still %d\n", k.name, (unsigned)std_max, (int)c.still);
+                s_test_failures++;
+            }
+        }
+    }
+    // Constant full-scale input is still even with std_max = 0
+    StillCalibParams z = p;
+    z.acc_std_max = 0;
+    StillCalib c;
+    still_calib_reset(c);
+    for (uint32_t i = 0; i < 4096; ++i) still_calib_feed(c, z, -32768, 32767, -32768, -32768, 32767, 0);
+    CHECK(c.still && c.valid);
+    CHECK_EQ(still_calib_bias(c, 0), -32768);
+    CHECK_EQ(still_calib_bias(c, 1), 32767);
+}
+
+int main() {
+    test_still_converges();
+    test_motion_rejected();
+    test_tracks_drift();
+    test_quiet_bound_4096();
+    return test_result("test_still_calib");
+}
@@ -0,0 +1,111 @@
+// STREAM output (stream_out.h): frame layout, decimation / mask, ring overflow, and a frame the sampler
+// built for the previous stream reaching the ring after stream_start() drained it (pushed here by hand:
+// the window between the sampler's generation load and its push). That frame must never be sent, nor anything
+// still in the ring after stream_stop() (STREAM OFF's reply ends the stream).
+#include "stream_out.h"
+#include "host_sim.h"
+#include "test_check.h"
+#include <string>
+
+static ImuSample sample(int16_t k) {
+    return { k, (int16_t)(k + 1), (int16_t)(k + 2), (int16_t)-k, (int16_t)(-k - 1), (int16_t)(-k - 2) };
+}
+
+// Frames of `out` as (seq, first value); false on a bad sync, length or checksum
+static bool parse(const std::string& out, size_t values, std::vector<std::pair<uint16_t, int16_t>>& frames) {
+    const size_t len = 2 + 2 + 2 * values + 1;
+    frames.clear();
+    if (out.size() % len) return false;
+    for (size_t o = 0; o < out.size(); o += len) {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(out.data()) + o;
+        if (p[0] != 0xA5 || p[1] != 0x5B) return false;
+        uint8_t x = 0;
+        for (size_t i = 2; i < len - 1; ++i) x ^= p[i];
+        if (x != p[len - 1]) return false;
+        frames.push_back({ (uint16_t)(p[2] | p[3] << 8), (int16_t)(p[4] | p[5] << 8) });
+    }
+    return true;
+}
+
+static void test_frames() {
+    std::vector<std::pair<uint16_t, int16_t>> f;
+    stream_start(1, 0x3F);
+    for (int16_t k = 0; k < 5; ++k) stream_push(sample(k));
+    stream_poll();
+    CHECK(parse(host_serial_take(), 6, f));
+    CHECK_EQ(f.size(), 5);
+    for (size_t i = 0; i < f.size(); ++i) CHECK(f[i].first == i && f[i].second == (int16_t)i);
+
+    // Every 3rd sample, gz only (bit 5): sequence restarts at 0
+    stream_start(3, 0x20);
+    for (int16_t k = 0; k < 9; ++k) stream_push(sample(k));
+    stream_poll();
+    CHECK(parse(host_serial_take(), 1, f));
+    CHECK_EQ(f.size(), 3);
+    CHECK(f[0].first == 0 && f[0].second == -4 && f[2].first == 2 && f[2].second == -10);
+    CHECK_EQ(stream_frames(), 3);
+    CHECK_EQ(stream_dropped(), 0);
+}
+
+static void test_overflow() {
+    std::vector<std::pair<uint16_t, int16_t>> f;
+    stream_start(1, 0x01);
+    for (int16_t k = 0; k < STREAM_RING_FRAMES + 10; ++k) stream_push(sample(k));
+    CHECK_EQ(stream_dropped(), 10);
+    stream_poll();
+    CHECK(parse(host_serial_take(), 1, f));
+    CHECK_EQ(f.size(), STREAM_RING_FRAMES);
+    CHECK(f.back().first == STREAM_RING_FRAMES - 1);
+}
+
+static void test_stale_generation() {
+    std::vector<std::pair<uint16_t, int16_t>> f;
+    stream_start(1, 0x3F);
+    stream_push(sample(100));
+    // The sampler builds one more 6-value frame for this stream...
+    StreamFrame stale = *s_st_q.front();
+    stale.b[4] = 0x77;
+    // ...while loop() restarts the stream with one value per frame; the old frame lands after the drain
+    stream_start(1, 0x01);
+    CHECK(s_st_q.push(stale));
+    stream_push(sample(200));
+    stream_push(sample(201));
+    stream_poll();
+    const std::string out = host_serial_take();
+    CHECK(parse(out, 1, f));
+    CHECK_EQ(f.size(), 2);
+    CHECK(f.size() == 2 && f[0].first == 0 && f[0].second == 200 && f[1].second == 201);
+    CHECK_EQ(stream_frames(), 2);
+    CHECK(s_st_q.front() == nullptr);
+}
+
+static void test_stop() {
+    std::vector<std::pair<uint16_t, int16_t>> f;
+    stream_start(1, 0x01);
+    for (int16_t k = 0; k < 3; ++k) stream_push(sample(k));
+    stream_poll();
+    CHECK(parse(host_serial_take(), 1, f));
+    CHECK_EQ(f.size(), 3);
+    // Pushed, not sent yet, when STREAM OFF arrives
+    for (int16_t k = 3; k < 6; ++k) stream_push(sample(k));
+    stream_stop();
+    stream_push(sample(6));
+    stream_poll();
+    CHECK(host_serial_take().empty());
+    CHECK_EQ(stream_frames(), 3);
+    // The next stream starts clean
+    stream_start(1, 0x01);
+    stream_push(sample(50));
+    stream_poll();
+    CHECK(parse(host_serial_take(), 1, f));
+    CHECK(f.size() == 1 && f[0].first == 0 && f[0].second == 50);
+}
+
+int main() {
+    host_serial_take();
+    test_frames();
+    test_overflow();
+    test_stale_generation();
+    test_stop();
+    return test_result("stream_out");
+}
@@ -0,0 +1,201 @@
+// Motion trigger (trigger.h), built with TRIGGER_MODE_OVERRIDE=1 / LOG_FRAMED_OVERRIDE=1, on synthetic traces
+// at 128 Hz, ±8 g / ±2000 dps unless noted (1 g = 4096 counts; trigger 150 mg / 30 dps, release at 50 %,
+// pre 1 s = 128 samples, post 2 s = 256 samples). The traces are a resting device with sensor noise plus:
+// a drop (free fall, impact), a tilt that stays between the release and trigger levels, a rotation, gap
+// markers, two events 2.3 s apart, an event right after the start, other ranges and 1 kHz (full pre ring).
+// 各トレースはファームウェアの log_sample() と同じ手順で trigger_feed() に通し、書かれるサンプル番号の区間と、
+// TRIG_START 時のトリガ前サンプル（番号・時刻・値・ギャップ）がトレースのものと一致することを確かめる。
+#include "trigger.h"
+#include "test_check.h"
+#include <vector>
+
+static_assert(TRIGGER_MODE && TRIG_RING_SAMPLES == 1024, "build with -DTRIGGER_MODE_OVERRIDE=1 -DLOG_FRAMED_OVERRIDE=1");
+
+struct Trace {
+    std::vector<ImuSample> s;
+    std::vector<uint8_t> gap;
+    uint32_t rng = 7;
+    int16_t lsb_g = 4096;
+
+    int16_t noise(int16_t amp) {
+        rng = rng * 1103515245u + 12345u;
+        return (int16_t)((int32_t)((rng >> 16) % (2u * amp + 1)) - amp);
+    }
+    // n samples of (ax, ay, az) in mg and gz in counts, with about 10 mg / 2 dps of noise
+    Trace& add(uint32_t n, int32_t ax_mg, int32_t ay_mg, int32_t az_mg, int16_t gz = 0, int16_t gx = 0) {
+        for (uint32_t i = 0; i < n; ++i) {
+            s.push_back({ (int16_t)(ax_mg * lsb_g / 1000 + noise(40)), (int16_t)(ay_mg * lsb_g / 1000 + noise(40)),
+                          (int16_t)(az_mg * lsb_g / 1000 + noise(40)), (int16_t)(gx + noise(30)), noise(30),
+                          (int16_t)(gz + noise(30)) });
+            gap.push_back(0);
+        }
+        return *this;
+    }
+    Trace& still(uint32_t n) { return add(n, 0, 0, 1000); }
+    Trace& gaps(uint32_t n) {
+        for (uint32_t i = 0; i < n; ++i) {
+            s.push_back({ INT16_MIN, INT16_MIN, INT16_MIN, INT16_MIN, INT16_MIN, INT16_MIN });
+            gap.push_back(1);
+        }
+        return *this;
+    }
+};
+
+struct Seg {
+    uint32_t start, end;  // logged sample numbers [start, end)
+    bool operator==(const Seg& o) const { return start == o.start && end == o.end; }
+};
+
+static bool same(const ImuSample& a, const ImuSample& b) {
+    return a.ax == b.ax && a.ay == b.ay && a.az == b.az && a.gx == b.gx && a.gy == b.gy && a.gz == b.gz;
+}
+
+// Feed the trace as log_sample() does; the logged ranges, checking the pre-trigger samples on the way
+static std::vector<Seg> run(const Trace& tr, uint16_t odr = 128, uint16_t range_g = 8, uint16_t dps = 2000) {
+    trigger_reset(odr, range_g, dps);
+    std::vector<Seg> segs;
+    bool open = false;
+    uint32_t next = 0;  // next sample number the log expects inside a segment
+    for (uint32_t i = 0; i < tr.s.size(); ++i) {
+        const uint32_t t_us = (uint32_t)((uint64_t)i * 1000000u / odr);
+        const TrigAction a = trigger_feed(tr.s[i], tr.gap[i] != 0, t_us);
+        if (a == TRIG_HOLD) {
+            CHECK(!open);
+            continue;
+        }
+        if (a == TRIG_START) {
+            CHECK(!open);
+            const uint32_t first = trig_pre_first();
+            CHECK_EQ(first + trig_pre_count(), i);
+            CHECK(segs.empty() || first >= segs.back().end);
+            for (uint32_t k = 0; k < trig_pre_count(); ++k) {
+                const TrigEntry& e = trig_pre(k);
+                const uint32_t j = first + k;
+                CHECK(same(e.s, tr.s[j]) && e.gap == (tr.gap[j] != 0)
+                      && e.t_us == (uint32_t)((uint64_t)j * 1000000u / odr));
+            }
+            trigger_pre_clear();
+            segs.push_back({ first, 0 });
+            open = true;
+            next = i;
+        }
+        CHECK(open);
+        CHECK_EQ(i, next);
+        next = i + 1;
+        if (a == TRIG_END) {
+            segs.back().end = i + 1;
+            open = false;
+        }
+    }
+    if (open) segs.back().end = (uint32_t)tr.s.size();
+    return segs;
+}
+
+static void expect(const char* name, const std::vector<Seg>& got, const std::vector<Seg>& want) {
+    bool ok = got == want;
+    if (!ok) {
+        fprintf(stderr, "%s: got", name);
+        for (const Seg& s : got) fprintf(stderr, " [%u,%u)", (unsigned)s.start, (unsigned)s.end);
+        fprintf(stderr, "\n");
+    }
+    CHECK(ok);
+    CHECK_EQ(trigger_segments(), want.size());
+}
+
+// Resting noise never triggers; the pre ring holds the latest second
+static void test_still() {
+    Trace tr;
+    tr.still(5000);
+    expect("still", run(tr), {});
+    CHECK_EQ(trig_pre_count(), 128);
+    // Tilted at rest: gravity moves between axes, the magnitude stays at 1 g
+    Trace tilt;
+    tilt.add(2000, 707, 0, 707).add(2000, 0, -1000, 0);
+    expect("tilt", run(tilt), {});
+}
+
+// Free fall starts the segment (|a| < 0.85 g), the impact keeps it; it ends 256 quiet samples after
+static void test_drop() {
+    Trace tr;
+    tr.still(1000).add(20, 0, 0, 50).add(5, 300, -200, 3000).still(1000);
+    expect("drop", run(tr), { { 1000 - 128, 1025 + 256 } });
+}
+
+// 100 mg off 1 g: above the release level (75 mg), below the trigger (150 mg). Never starts a segment on its
+// own, but keeps one open for as long as it lasts.
+static void test_hysteresis() {
+    Trace tr;
+    tr.still(500).add(400, 0, 0, 1100).still(100).add(3, 0, 0, 1500).add(600, 0, 0, 1100).still(1000);
+    expect("hysteresis", run(tr), { { 1000 - 128, 1603 + 256 } });
+    // The same 100 mg below 1 g
+    Trace under;
+    under.still(500).add(400, 0, 0, 900).still(100).add(3, 0, 0, 1500).add(600, 0, 0, 900).still(1000);
+    expect("hysteresis below 1 g", run(under), { { 1000 - 128, 1603 + 256 } });
+    // Just below the release level the segment ends on time
+    Trace low;
+    low.still(500).add(3, 0, 0, 1500).add(600, 0, 0, 1050).still(100);
+    expect("below release", run(low), { { 500 - 128, 503 + 256 } });
+}
+
+// Rotation: 40 dps starts it, 20 dps (above the 15 dps release) keeps it; 25 dps alone never starts one
+static void test_gyro() {
+    const int16_t dps = 2000;
+    auto counts = [&](int v) { return (int16_t)(v * 32768 / dps); };
+    Trace tr;
+    tr.still(20).add(40, 0, 0, 1000, counts(25)).still(240).add(40, 0, 0, 1000, counts(40))
+      .add(400, 0, 0, 1000, 0, counts(20)).still(600);
+    expect("gyro", run(tr), { { 300 - 128, 740 + 256 } });
+}
+
+// Gap markers never trigger and count as quiet inside a segment; the pre ring keeps them as gaps
+static void test_gaps() {
+    Trace tr;
+    tr.still(200).gaps(10).still(40).add(2, 0, 0, 2000).gaps(400).still(100);
+    expect("gaps", run(tr), { { 250 - 128, 252 + 256 } });
+}
+
+// Two events 2.3 s apart: the second one's pre window only goes back to the end of the first segment
+static void test_close_events() {
+    Trace tr;
+    tr.still(400).add(1, 0, 0, 2000).still(299).add(1, 0, 0, 2000).still(600);
+    expect("close events", run(tr), { { 400 - 128, 401 + 256 }, { 401 + 256, 701 + 256 } });
+    // An event right after the start has only what was sampled before it
+    Trace early;
+    early.still(10).add(1, 0, 0, 2000).still(300);
+    expect("early event", run(early), { { 0, 11 + 256 } });
+    // Still moving when the recording stops: the segment runs to the end
+    Trace cut;
+    cut.still(300).add(50, 0, 0, 2000);
+    expect("cut", run(cut), { { 300 - 128, 350 } });
+}
+
+// ±16 g / ±500 dps: the same milli-g / dps thresholds in other counts
+static void test_ranges() {
+    Trace tr;
+    tr.lsb_g = 2048;
+    tr.still(300).add(50, 0, 0, 1120).still(300).add(1, 0, 0, 1200).still(300);
+    expect("16 g", run(tr, 128, 16, 500), { { 650 - 128, 651 + 256 } });
+    Trace gy;
+    gy.still(300).add(50, 0, 0, 1000, (int16_t)(25 * 32768 / 500)).still(300)
+      .add(1, 0, 0, 1000, (int16_t)(35 * 32768 / 500)).still(600);
+    expect("500 dps", run(gy, 128, 8, 500), { { 650 - 128, 651 + 256 } });
+}
+
+// 1 kHz: the pre window is the whole ring (ODR_HZ_MAX samples) after it wrapped several times
+static void test_full_ring() {
+    Trace tr;
+    tr.still(5000).add(1, 0, 0, 2000).still(2500);
+    expect("1 kHz", run(tr, 1024), { { 5000 - 1024, 5001 + 2048 } });
+}
+
+int main() {
+    test_still();
+    test_drop();
+    test_hysteresis();
+    test_gyro();
+    test_gaps();
+    test_close_events();
+    test_ranges();
+    test_full_ring();
+    return test_result("trigger");
+}
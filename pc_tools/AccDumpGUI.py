@@ -230,7 +230,7 @@ class AccDumpGUI(tk.Tk):
             if self.csv_var.get():
                 self._append_log('CSV変換開始')
                 csv_path = out_file.with_suffix('.csv')
-                decoder.bin_to_csv(out_file, csv_path)
+                decoder.bin_to_csv_stream(out_file, csv_path)
                 self._append_log(f'CSV変換完了: {csv_path}')
                 self.last_csv_path = csv_path
         except Exception:
@@ -1,14 +1,17 @@
 import argparse
+import time
 from pathlib import Path
 
-from serial_common import list_serial_ports, dump_bin, get_info
+from serial_common import (list_serial_ports, dump_bin, dump_summary, get_info, stream_samples, list_sessions,
+                           get_stats, STREAM_CHANNELS, FAST_BAUDRATE)
 from info_format import format_info_line
 import decoder
 
 
-def dump_one(port: str, out_dir: Path, do_csv: bool):
+def dump_one(port: str, out_dir: Path, do_csv: bool, session: int = 0, fast_baud=FAST_BAUDRATE):
     out_dir.mkdir(parents=True, exist_ok=True)
-    out_file = out_dir / f'{port.replace("/", "_")}_ACCLOG.bin'
+    suffix = f'_S{session}' if session else ''
+    out_file = out_dir / f'{port.replace("/", "_")}_ACCLOG{suffix}.bin'
     print(f'Dumping {port} -> {out_file}')
     def cb(read_bytes, total_bytes):
         pct = 100 * read_bytes / total_bytes if total_bytes else 0
@@ -19,21 +22,82 @@ def dump_one(port: str, out_dir: Path, do_csv: bool):
         print(f'INFO: {format_info_line(info)}')
     except Exception as exc:
         print(f'INFO failed: {exc}')
-    meta = dump_bin(port, out_file, progress_cb=cb)
+    t0 = time.monotonic()
+    meta = dump_bin(port, out_file, progress_cb=cb, session=session, fast_baud=fast_baud)
+    elapsed = time.monotonic() - t0
     baud = meta.get('baud') if isinstance(meta, dict) else None
-    print(f"\nDONE" + (f" (baud={baud})" if baud else ""))
+    size = meta.get('total_bytes') if isinstance(meta, dict) else None
+    rate = f", {size / elapsed / 1024:.1f} KiB/s" if size and elapsed > 0 else ""
+    print(f"\nDONE ({elapsed:.1f} s" + (f", baud={baud}" if baud else "") + rate + ")")
     if do_csv:
         csv_path = out_file.with_suffix('.csv')
-        decoder.bin_to_csv(out_file, csv_path)
+        decoder.bin_to_csv_stream(out_file, csv_path)
         print(f'CSV written: {csv_path}')
 
 
+def summary_one(port: str, out_dir: Path, do_csv: bool, session: int = 0):
+    out_dir.mkdir(parents=True, exist_ok=True)
+    suffix = f'_S{session}' if session else ''
+    out_file = out_dir / f'{port.replace("/", "_")}_ACCLOG{suffix}.sum'
+    print(f'Fetching summary {port} -> {out_file}')
+    dump_summary(port, out_file, session=session)
+    header, df = decoder.bin_to_csv(out_file, out_file.with_suffix('.sum.csv') if do_csv else None)
+    print(f"DONE ({header.get('windows', 0)} windows)")
+    if do_csv:
+        print(f"CSV written: {out_file.with_suffix('.sum.csv')}")
+
+
+def list_one(port: str):
+    print(f'{port}:')
+    for s in list_sessions(port):
+        samples = 'recording' if s['samples'] is None else s['samples']
+        print(f"  session {s['id']:4d}  {s['size']:10d}B  samples={samples}  start_ms={s['start_ms']}  fmt={s['format']}")
+
+
+def stream_one(port: str, seconds: float, decim: int, mask: int, show: bool):
+    names = [c for i, c in enumerate(STREAM_CHANNELS) if mask & (1 << i)]
+    def cb(seq, values):
+        if show:
+            print(f'{seq:5d} ' + ' '.join(f'{n}:{v:6d}' for n, v in zip(names, values)))
+    stats = stream_samples(port, seconds, decim=decim, mask=mask, sample_cb=cb)
+    print('STREAM ' + ' '.join(f'{k}:{v:.1f}' if isinstance(v, float) else f'{k}:{v}' for k, v in stats.items()))
+
+
+def stats_one(port: str, reset: bool):
+    st = get_stats(port, reset=reset)
+    if not st:
+        print(f'{port}: STATS disabled in firmware (STATS_ENABLE)')
+        return
+    print(f"{port}: cpu {st['cpu_mhz']} MHz, {st['since_ms'] / 1000:.1f} s since reset")
+    for name, s in st['stages'].items():
+        hist = ' '.join(f'{(1 << k) / st["cpu_mhz"]:.1f}us:{c}' for k, c in sorted(s['hist'].items()))
+        print(f"  {name:7s} n={s['n']:8d}  us min/mean/max {s['min_us']:.1f}/{s['mean_us']:.1f}/{s['max_us']:.1f}  {hist}")
+    t = st.get('tick')
+    if t:
+        hist = ' '.join(f'{1 << k}us:{c}' for k, c in sorted(t['hist'].items()))
+        print(f"  tick    n={t['n']:8d}  missed={t['missed']} overrun={t['overrun']}  "
+              f"jitter us mean/max {t['jitter_mean_us']}/{t['jitter_max_us']}  {hist}")
+    if reset:
+        print('  (reset)')
+
+
 def main():
     p = argparse.ArgumentParser(description='M5Stick ACCLOG dumper')
     p.add_argument('--port', help='serial port to use')
     p.add_argument('--all', action='store_true', help='dump from all available ports')
     p.add_argument('--out', type=Path, default=Path('.'), help='output directory')
     p.add_argument('--csv', action='store_true', help='convert to CSV after dump')
+    p.add_argument('--list', action='store_true', help='list recordings stored on the device')
+    p.add_argument('--session', type=int, default=0, help='session id to dump (default: newest)')
+    p.add_argument('--summary', action='store_true', help='fetch the windowed summary file (firmware SUMMARY_ENABLE) instead of the log')
+    p.add_argument('--stream', type=float, metavar='SEC', help='receive live STREAM frames for SEC seconds instead of dumping (device must be recording)')
+    p.add_argument('--decim', type=int, default=1, help='STREAM: send every N-th sample')
+    p.add_argument('--mask', type=lambda x: int(x, 16), default=0x3F, help='STREAM: channel mask in hex (bit0..5 = ax..gz)')
+    p.add_argument('--show', action='store_true', help='STREAM: print every received sample')
+    p.add_argument('--stats', action='store_true', help='print the hot-path stage timing counters (STATS)')
+    p.add_argument('--baud', type=int, default=FAST_BAUDRATE,
+                   help=f'dump: switch the link to this rate with BAUD before the transfer (0: keep the probed rate, default {FAST_BAUDRATE})')
+    p.add_argument('--stats-reset', action='store_true', help='with --stats: clear the counters after reading')
     args = p.parse_args()
 
     if args.all:
@@ -44,7 +108,16 @@ def main():
         p.error('specify --port or --all')
 
     for port in ports:
-        dump_one(port, args.out, args.csv)
+        if args.list:
+            list_one(port)
+        elif args.stats:
+            stats_one(port, args.stats_reset)
+        elif args.stream:
+            stream_one(port, args.stream, args.decim, args.mask, args.show)
+        elif args.summary:
+            summary_one(port, args.out, args.csv, args.session)
+        else:
+            dump_one(port, args.out, args.csv, args.session, args.baud or None)
 
 
 if __name__ == '__main__':
@@ -0,0 +1,89 @@
+"""ctypes bindings of the native decoder (pc_tools/native, libacclog_decode).
+
+decoder.bin_to_csv_stream() uses it when the library is found, so the GUI and
+accdump_cli.py get the native CSV conversion without changes; without it the
+numpy path writes the same CSV. The library is looked up in $ACCLOG_NATIVE_LIB,
+next to this file, then in native/build/.
+"""
+from pathlib import Path
+import ctypes
+import os
+
+_NAMES = ('libacclog_decode.so', 'libacclog_decode.dylib', 'acclog_decode.dll')
+# AcclogErr (acclog_decode.h)
+OK, E_OPEN, E_NO_HEADER, E_SUMMARY, E_FORMAT, E_WRITE = range(6)
+
+
+class Stats(ctypes.Structure):
+    """AcclogStats (acclog_decode.h)."""
+    _fields_ = [
+        ('header_offset', ctypes.c_uint64),
+        ('samples', ctypes.c_uint64),
+        ('gap_samples', ctypes.c_uint64),
+        ('lost_samples', ctypes.c_uint64),
+        ('frames', ctypes.c_uint64),
+        ('segments', ctypes.c_uint64),
+        ('odr_measured', ctypes.c_double),
+        ('bytes_in', ctypes.c_uint64),
+        ('bytes_out', ctypes.c_uint64),
+    ]
+
+
+class NativeError(Exception):
+    def __init__(self, code: int, message: str):
+        super().__init__(message)
+        self.code = code
+
+
+_lib = None
+_tried = False
+
+
+def _candidates():
+    env = os.environ.get('ACCLOG_NATIVE_LIB')
+    if env:
+        yield Path(env)
+    here = Path(__file__).resolve().parent
+    for d in (here, here / 'native' / 'build'):
+        for name in _NAMES:
+            yield d / name
+
+
+def load():
+    """The loaded library, or None if it was not built."""
+    global _lib, _tried
+    if _tried:
+        return _lib
+    _tried = True
+    for path in _candidates():
+        if not path.is_file():
+            continue
+        try:
+            lib = ctypes.CDLL(str(path))
+        except OSError:
+            continue
+        lib.acclog_csv_file.argtypes = [ctypes.c_char_p, ctypes.c_char_p, ctypes.c_uint32, ctypes.c_char_p,
+                                        ctypes.POINTER(Stats)]
+        lib.acclog_csv_file.restype = ctypes.c_int
+        lib.acclog_strerror.argtypes = [ctypes.c_int]
+        lib.acclog_strerror.restype = ctypes.c_char_p
+        _lib = lib
+        break
+    return _lib
+
+
+def available() -> bool:
+    return load() is not None
+
+
+def csv_file(bin_path, csv_path, chunk: int, eol: str = os.linesep) -> Stats:
+    """Write the CSV of a sample log; raises NativeError (see the E_* codes)."""
+    lib = load()
+    if lib is None:
+        raise NativeError(E_OPEN, 'native decoder library not found')
+    st = Stats()
+    err = lib.acclog_csv_file(os.fsencode(bin_path), os.fsencode(csv_path), chunk, eol.encode(),
+                              ctypes.byref(st))
+    if err != OK:
+        raise NativeError(err, f'{bin_path}: {lib.acclog_strerror(err).decode()}')
+    return st
@@ -1,16 +1,44 @@
 from pathlib import Path
+import mmap
 import struct
+import zlib
 import numpy as np
 import pandas as pd
+import acclog_native
 
 # Header formats
 HEADER_FMT_V1 = '<8sHQQHHII26s'          # accel-only
 HEADER_FMT_V2 = '<8sHQQHHHII24s'         # adds gyro_range_dps (uint16)
 HEADER_FMT_V2_1 = '<8sHQQHHHHHffII12s'   # adds imu_type, device_model, lsb_per_g, lsb_per_dps
+HEADER_FMT_V2_2 = '<8sHQQHHHHHffIIhhh6s'  # adds gyro_bias_x/y/z (raw counts)
+HEADER_FMT_V3 = '<8sHQQHHHHHffIIhhhH4s'   # adds block_size (0x03xx block payload)
 HEADER_PREFIX_FMT = '<8sHQQHH'           # common prefix up to range_g
 HEADER_PREFIX_SIZE = struct.calcsize(HEADER_PREFIX_FMT)
 HEADER_SIZE = 64
 HEADER_FMT = HEADER_FMT_V2  # use v2 format for unpacking; v1 compatible
+# Gap marker written by firmware for missed ticks: all channels == INT16_MIN
+GAP_WORD = -32768
+# 0x03xx block payload: low byte flags
+FMT_FLAG_COMPRESSED = 0x01
+FMT_FLAG_FRAMED = 0x02
+FMT_FLAG_TRIGGER = 0x04  # framed blocks hold motion-triggered segments only
+BLOCK_HDR_SIZE = 4  # uint16 sample_count, uint16 payload_len
+# Framed blocks: sync, crc32 (first_sample..payload end), first_sample, t_us, count, len
+BLOCK_SYNC = b'ABLK'
+FRAME_HDR_FMT = '<4sIIIHH'
+FRAME_HDR_SIZE = struct.calcsize(FRAME_HDR_FMT)
+# Anti-aliasing decimation parameters (firmware DECIM_FACTOR > 1), bytes 60..62 of the header
+DECIM_OFFSET = 60
+# uint8 IMU low-pass bandwidth in Hz (0 = unknown / older firmware)
+DLPF_OFFSET = 63
+# Windowed summary records (format 0x0400: SUMMARY_ONLY log or the .SUM file next to a log)
+SUMMARY_FORMAT_VER = 0x0400
+SUMMARY_AXES = ('ax', 'ay', 'az', 'gx', 'gy', 'gz')
+SUMMARY_DTYPE = np.dtype([('first_sample', '<u4'), ('count', '<u2'), ('gaps', '<u2'),
+                          ('mean', '<i2', 6), ('min', '<i2', 6), ('max', '<i2', 6),
+                          ('rms', '<u2', 6), ('zc', '<u2', 6)])
+FRAME_INDEX_DTYPE = np.dtype([('offset', np.int64), ('first_sample', np.int64),
+                              ('t_us', np.int64), ('count', np.int64)])
 
 
 def parse_header(data: bytes) -> dict:
@@ -22,7 +50,23 @@ def parse_header(data: bytes) -> dict:
     )
     if not magic.startswith(b'ACCLOG'):
         raise ValueError('invalid magic')
-    if fmt_ver >= 0x0201:
+    gyro_bias = (0, 0, 0)
+    block_size = 0
+    if fmt_ver >= 0x0300:
+        (magic, fmt_ver, device_uid, start_ms, odr, range_g,
+         gyro_range_dps, imu_type, device_model, lsb_per_g, lsb_per_dps,
+         total_samples, dropped, gbx, gby, gbz, block_size, _reserved) = struct.unpack(
+            HEADER_FMT_V3, data[:HEADER_SIZE]
+        )
+        gyro_bias = (gbx, gby, gbz)
+    elif fmt_ver >= 0x0202:
+        (magic, fmt_ver, device_uid, start_ms, odr, range_g,
+         gyro_range_dps, imu_type, device_model, lsb_per_g, lsb_per_dps,
+         total_samples, dropped, gbx, gby, gbz, _reserved) = struct.unpack(
+            HEADER_FMT_V2_2, data[:HEADER_SIZE]
+        )
+        gyro_bias = (gbx, gby, gbz)
+    elif fmt_ver >= 0x0201:
         (magic, fmt_ver, device_uid, start_ms, odr, range_g,
          gyro_range_dps, imu_type, device_model, lsb_per_g, lsb_per_dps,
          total_samples, dropped, _reserved) = struct.unpack(
@@ -44,6 +88,9 @@ def parse_header(data: bytes) -> dict:
         device_model = 0
         lsb_per_g = 0.0
         lsb_per_dps = 0.0
+    decim_factor, decim_taps, decim_cutoff_pct = (data[DECIM_OFFSET:DECIM_OFFSET + 3]
+                                                  if fmt_ver >= 0x0202 else (0, 0, 0))
+    dlpf_hz = data[DLPF_OFFSET] if fmt_ver >= 0x0202 else 0
     return {
         'format_ver': fmt_ver,
         'device_uid': device_uid,
@@ -57,8 +104,341 @@ def parse_header(data: bytes) -> dict:
         'lsb_per_dps': lsb_per_dps,
         'total_samples': total_samples,
         'dropped_samples': dropped,
+        'gyro_bias': gyro_bias,
+        'block_size': block_size,
+        'decim_factor': decim_factor,
+        'decim_taps': decim_taps,
+        'decim_cutoff_pct': decim_cutoff_pct,
+        'dlpf_hz': dlpf_hz,
+    }
+
+
+def decim_filter(header: dict):
+    """On-device anti-aliasing FIR of a log, or None if it was sampled directly.
+
+    Returns the Q15 taps exactly as the firmware builds them (Hamming-windowed
+    sinc, -6 dB at ``decim_cutoff_pct`` % of odr_hz / 2, DC gain fixed to 1) and
+    the group delay in seconds of logged data relative to the IMU readings.
+    Frequency response: ``np.fft.rfft(taps / 32768, n)`` at the internal rate
+    ``odr_hz * decim_factor``.
+    """
+    n = header.get('decim_factor', 0)
+    taps = header.get('decim_taps', 0)
+    if n <= 1 or taps < 2:
+        return None
+    fc = 0.5 * header['decim_cutoff_pct'] / 100.0 / n
+    i = np.arange(taps)
+    h = 2 * fc * np.sinc(2 * fc * (i - (taps - 1) / 2.0)) * (0.54 - 0.46 * np.cos(2 * np.pi * i / (taps - 1)))
+    v = h * 32768.0 / h.sum()
+    q = np.where(v < 0, np.ceil(v - 0.5), np.floor(v + 0.5)).astype(np.int64)
+    q[(taps - 1) // 2] += 32768 - q.sum()
+    delay_s = (taps - 1) / 2.0 / (header['odr_hz'] * n) if header['odr_hz'] else 0.0
+    return q.astype(np.int16), delay_s
+
+
+def iter_blocks(payload, block_size: int):
+    """Yield (sample_count, encoded_bytes) for each 0x03xx payload block.
+
+    Blocks are fixed-size (the last one may be short); iteration stops at the
+    first empty or truncated block.
+    """
+    mv = memoryview(payload)
+    for off in range(0, len(mv), block_size):
+        blk = mv[off:off + block_size]
+        if len(blk) < BLOCK_HDR_SIZE:
+            break
+        count, length = struct.unpack_from('<HH', blk, 0)
+        if count == 0 or BLOCK_HDR_SIZE + length > len(blk):
+            break
+        yield count, blk[BLOCK_HDR_SIZE:BLOCK_HDR_SIZE + length]
+
+
+def decode_varint_block(enc, count: int) -> np.ndarray:
+    """Decode one compressed block into an (count, 6) int16 array.
+
+    Each value is a zigzag varint (<= 3 bytes) of the int16 delta to the
+    previous sample; the first sample of a block is a delta from zero.
+    """
+    b = np.frombuffer(enc, dtype=np.uint8)
+    ends = np.flatnonzero(b < 0x80)
+    n_vals = (min(len(ends), count * 6) // 6) * 6
+    ends = ends[:n_vals]
+    if n_vals == 0:
+        return np.empty((0, 6), dtype=np.int16)
+    starts = np.empty_like(ends)
+    starts[0] = 0
+    starts[1:] = ends[:-1] + 1
+    lens = ends - starts + 1
+    zz = (b[starts] & 0x7F).astype(np.uint32)
+    m = lens >= 2
+    zz[m] |= (b[starts[m] + 1] & 0x7F).astype(np.uint32) << 7
+    m = lens >= 3
+    zz[m] |= (b[starts[m] + 2] & 0x7F).astype(np.uint32) << 14
+    d = (zz >> 1).astype(np.int64) ^ -(zz & 1).astype(np.int64)
+    vals = np.cumsum(d.reshape(-1, 6), axis=0)
+    return vals.astype(np.uint16).view(np.int16)
+
+
+def iter_decoded_blocks(payload, block_size: int):
+    """Stream decoded (n, 6) int16 sample arrays block by block."""
+    for count, enc in iter_blocks(payload, block_size):
+        yield decode_varint_block(enc, count)
+
+
+def iter_frames(payload: bytes, block_size: int, start: int = 0):
+    """Yield (offset, first_sample, t_us, count, body) for each valid framed block.
+
+    A block is accepted only if its sync word and CRC32 match. After a bad or
+    truncated block the next sync word is searched byte by byte, so a flipped,
+    inserted or missing byte costs only the blocks it touches. A block short of
+    its padding is followed by a search from the end of its body.
+    """
+    mv = memoryview(payload)
+    off = start
+    n = len(payload)
+    while off + FRAME_HDR_SIZE <= n:
+        if payload[off:off + 4] == BLOCK_SYNC:
+            _sync, crc, first, t_us, count, length = struct.unpack_from(FRAME_HDR_FMT, payload, off)
+            end = off + FRAME_HDR_SIZE + length
+            if (count and FRAME_HDR_SIZE + length <= block_size and end <= n
+                    and zlib.crc32(mv[off + 8:end]) == crc):
+                yield off, first, t_us, count, mv[off + FRAME_HDR_SIZE:end]
+                nxt = off + block_size
+                if payload[nxt:nxt + 4] != BLOCK_SYNC:
+                    nxt = payload.find(BLOCK_SYNC, end)   # off the block grid (padding lost)
+                    if nxt < 0:
+                        break
+                off = nxt
+                continue
+        nxt = payload.find(BLOCK_SYNC, off + 1)
+        if nxt < 0:
+            break
+        off = nxt
+
+
+def frame_index(payload: bytes, block_size: int) -> np.ndarray:
+    """Table of valid frames (offset, first_sample, t_us, count) without decoding them.
+
+    Use with np.searchsorted(idx['first_sample'], n, 'right') - 1 to seek to
+    sample n (or to a time, n = t * odr_hz) and iter_frames(..., start=offset).
+    """
+    rows = [(o, f, t, c) for o, f, t, c, _ in iter_frames(payload, block_size)]
+    return np.array(rows, dtype=FRAME_INDEX_DTYPE)
+
+
+def measured_odr(idx: np.ndarray) -> float:
+    """Achieved ODR from the device micros() of each frame (0.0 if unknown)."""
+    if len(idx) < 2:
+        return 0.0
+    # micros() is uint32 on the device and wraps every ~71.6 min
+    t = np.concatenate(([0], np.cumsum(np.diff(idx['t_us']) % (1 << 32)))).astype(np.float64)
+    n = idx['first_sample'].astype(np.float64)
+    if t[-1] <= 0:
+        return 0.0
+    slope = np.polyfit(t, n, 1)[0]
+    return float(slope * 1e6)
+
+
+def decode_frame_body(body, count: int, compressed: bool) -> np.ndarray:
+    """Decode the payload of one framed block into (count, 6) int16."""
+    if compressed:
+        return decode_varint_block(body, count)
+    raw = np.frombuffer(body, dtype='>i2')
+    count = min(count, raw.size // 6)
+    return raw[:count * 6].reshape(-1, 6).astype(np.int16)
+
+
+def decode_frames(payload: bytes, block_size: int, compressed: bool, fill_gaps: bool = True):
+    """Decode framed blocks in sample order.
+
+    Samples missing between frames (dropped on the device or lost to
+    corruption) are filled with gap markers so n / odr_hz stays the timeline.
+    With fill_gaps=False (trigger segments) nothing is inserted; the sample
+    numbers are frame_sample_numbers(index). Returns (data, lost_samples, index).
+    """
+    parts = []
+    rows = []
+    expected = 0
+    lost = 0
+    for off, first, t_us, count, body in iter_frames(payload, block_size):
+        if first < expected:
+            continue  # stale or duplicated block
+        blk = decode_frame_body(body, count, compressed)
+        if first > expected:
+            if fill_gaps:
+                parts.append(np.full((first - expected, 6), GAP_WORD, dtype=np.int16))
+            lost += first - expected
+        parts.append(blk)
+        rows.append((off, first, t_us, len(blk)))
+        expected = first + len(blk)
+    idx = np.array(rows, dtype=FRAME_INDEX_DTYPE)
+    data = np.concatenate(parts) if parts else np.empty((0, 6), dtype=np.int16)
+    return data, lost, idx
+
+
+
+def frame_sample_numbers(idx: np.ndarray) -> np.ndarray:
+    """Sample number of every sample decoded by decode_frames(..., fill_gaps=False)."""
+    if not len(idx):
+        return np.empty(0, dtype=np.int64)
+    start = np.concatenate(([0], np.cumsum(idx['count'])[:-1]))
+    return np.repeat(idx['first_sample'] - start, idx['count']) + np.arange(int(idx['count'].sum()))
+
+
+def trigger_levels(acc, gyro, header: dict, acc_mg: int, gyro_dps: int, release_pct: int) -> np.ndarray:
+    """Firmware trig_level() for raw-count arrays: 2 trigger, 1 above release, 0 quiet."""
+    rng = int(header.get('range_g') or 4)
+    g_rng = int(header.get('gyro_range_dps') or 2000)
+
+    def bounds(mg, dps_x100):
+        lo = (32768 * (1000 - mg) // (1000 * rng)) ** 2 if mg < 1000 else 0
+        hi = (32768 * (1000 + mg) // (1000 * rng)) ** 2
+        return lo, hi, (32768 * dps_x100 // (100 * g_rng)) ** 2
+
+    a = np.sum(acc.astype(np.int64) ** 2, axis=1)
+    g = np.sum(gyro.astype(np.int64) ** 2, axis=1)
+    lo, hi, gs = bounds(acc_mg, gyro_dps * 100)
+    rlo, rhi, rgs = bounds(acc_mg * release_pct // 100, gyro_dps * release_pct)
+    lvl = np.where((a > rhi) | (a < rlo) | (g > rgs), 1, 0)
+    lvl[(a > hi) | (a < lo) | (g > gs)] = 2
+    return lvl
+
+
+def trigger_segments(df: pd.DataFrame, header: dict, acc_mg: int = 150, gyro_dps: int = 30,
+                     release_pct: int = 50, pre_ms: int = 1000, post_ms: int = 2000) -> np.ndarray:
+    """Replay the firmware motion trigger (TRIGGER_MODE, trigger.h) on a continuous log.
+
+    Use a log recorded without the trigger to tune the firmware TRIG_* settings: returns
+    the (start, end) sample ranges [start, end) the device would have written, including
+    the pre-trigger window. Gap rows (NaN) never trigger, as on the device.
+    """
+    lsb_g = float(header.get('lsb_per_g') or 32768 / int(header.get('range_g') or 4))
+    lsb_dps = float(header.get('lsb_per_dps') or 32768 / int(header.get('gyro_range_dps') or 2000))
+    acc = df[['ax_g', 'ay_g', 'az_g']].to_numpy(dtype=np.float64) * lsb_g
+    gyro = df[['gx_dps', 'gy_dps', 'gz_dps']].to_numpy(dtype=np.float64) * lsb_dps
+    gap = np.isnan(acc).any(axis=1)
+    acc = np.rint(np.nan_to_num(acc)).astype(np.int64)
+    gyro = np.rint(np.nan_to_num(gyro)).astype(np.int64)
+    lvl = trigger_levels(acc, gyro, header, acc_mg, gyro_dps, release_pct)
+    lvl[gap] = 0
+    pre = header['odr_hz'] * pre_ms // 1000
+    post = header['odr_hz'] * post_ms // 1000
+    segs = []
+    held_from = 0  # first sample not logged since the last segment
+    i, n = 0, len(lvl)
+    while i < n:
+        hits = np.flatnonzero(lvl[i:] == 2)
+        if not len(hits):
+            break
+        k = i + int(hits[0])
+        start = max(held_from, k - pre)
+        # Inside a segment: end after `post` consecutive quiet samples
+        quiet = 0
+        j = k + 1
+        while j < n:
+            if lvl[j]:
+                quiet = 0
+            else:
+                quiet += 1
+                if quiet >= post:
+                    break
+            j += 1
+        end = min(j + 1, n)
+        segs.append((start, end))
+        held_from = i = end
+    return np.array(segs, dtype=np.int64).reshape(-1, 2)
+
+
+def decode_summary(payload, header: dict) -> pd.DataFrame:
+    """Decode summary records (format 0x0400) into one row per window.
+
+    Columns: n (first sample of the window), t_sec, count (valid samples),
+    gaps, and per axis ``<axis>_{mean,min,max,rms,p2p}`` in g / dps plus
+    ``<axis>_zc`` (crossings of the previous window's mean). p2p = max - min;
+    windows without valid samples have NaN statistics.
+    """
+    n_rec = len(payload) // SUMMARY_DTYPE.itemsize
+    rec = np.frombuffer(payload, dtype=SUMMARY_DTYPE, count=n_rec)
+    lsb_g = float(header.get('lsb_per_g') or 32768 / (header.get('range_g') or 4))
+    lsb_dps = float(header.get('lsb_per_dps') or 32768 / (header.get('gyro_range_dps') or 2000))
+    empty = rec['count'] == 0
+    n = rec['first_sample'].astype(np.int64)
+    cols = {
+        'n': n,
+        't_sec': n / header['odr_hz'],
+        'count': rec['count'].astype(np.int64),
+        'gaps': rec['gaps'].astype(np.int64),
     }
+    for i, axis in enumerate(SUMMARY_AXES):
+        scale = lsb_g if i < 3 else lsb_dps
+        unit = 'g' if i < 3 else 'dps'
+        for key in ('mean', 'min', 'max', 'rms'):
+            v = rec[key][:, i] / scale
+            v[empty] = np.nan
+            cols[f'{axis}_{key}_{unit}'] = v
+        cols[f'{axis}_p2p_{unit}'] = cols[f'{axis}_max_{unit}'] - cols[f'{axis}_min_{unit}']
+        cols[f'{axis}_zc'] = rec['zc'][:, i].astype(np.int64)
+    header['windows'] = n_rec
+    return pd.DataFrame(cols)
+
+
+def sample_scales(header: dict):
+    """(lsb_per_g, lsb_per_dps) used to scale raw samples of this log.
 
+    Prefers the header LSBs; older headers fall back to the ranges (filled in
+    with the historical defaults when missing). Early SH200Q logs store gyro
+    in dps already (lsb_per_dps 1.0).
+    """
+    lsb_per_g = float(header.get('lsb_per_g') or 0.0)
+    rng = int(header.get('range_g', 0) or 0)
+    if lsb_per_g <= 0.0:
+        if rng <= 0:
+            rng = 4
+            header['range_g'] = rng
+        lsb_per_g = 32768 / rng
+    # 0x0200 and 0x0201 on SH200Q store gyro as int16 cast from dps;
+    # 0x0202+ (and MPU6886 logs) store bias-subtracted raw counts.
+    fmt_ver = header['format_ver']
+    gyro_is_dps = fmt_ver < 0x0201 or (fmt_ver == 0x0201 and header.get('imu_type') == 1)
+    lsb_per_dps = float(header.get('lsb_per_dps') or 0.0)
+    g_rng = int(header.get('gyro_range_dps', 0) or 0)
+    if gyro_is_dps:
+        lsb_per_dps = 1.0
+    elif lsb_per_dps <= 0.0:
+        if g_rng <= 0:
+            g_rng = 2000
+            header['gyro_range_dps'] = g_rng
+        lsb_per_dps = 32768 / g_rng
+    return lsb_per_g, lsb_per_dps
+
+
+def samples_frame(data: np.ndarray, n: np.ndarray, header: dict, scales):
+    """Scale (k, 3|6) int16 samples numbered n into the CSV columns.
+
+    Gap markers keep the timeline (n / odr_hz) and become NaN rows.
+    Returns (DataFrame, number of gap rows).
+    """
+    channels = data.shape[1]
+    lsb_per_g, lsb_per_dps = scales
+    gap = np.all(data == GAP_WORD, axis=1) if channels == 6 else np.zeros(len(data), dtype=bool)
+    acc_g = data[:, :3] / lsb_per_g
+    acc_g[gap] = np.nan
+    cols = {
+        'n': n,
+        't_sec': n / header['odr_hz'],
+        'ax_g': acc_g[:, 0],
+        'ay_g': acc_g[:, 1],
+        'az_g': acc_g[:, 2],
+    }
+    if channels == 6:
+        gyro_dps = data[:, 3:6].astype(np.float32) / lsb_per_dps
+        gyro_dps[gap] = np.nan
+        cols.update({
+            'gx_dps': gyro_dps[:, 0],
+            'gy_dps': gyro_dps[:, 1],
+            'gz_dps': gyro_dps[:, 2],
+        })
+    return pd.DataFrame(cols), int(gap.sum())
 
 
 def bin_to_csv(bin_path: Path, csv_path: Path | None = None):
@@ -128,63 +508,205 @@ def bin_to_csv(bin_path: Path, csv_path: Path | None = None):
         header['header_offset'] = int(idx)
         payload = buf[idx + HEADER_SIZE:]
 
-    # Ensure even number of bytes (int16-aligned); drop any trailing odd byte
-    if len(payload) % 2 != 0:
-        payload = payload[:-1]
-
-    # Firmware writes MSB first (big-endian) for each int16
-    raw = np.frombuffer(payload, dtype='>i2')
+    if header['format_ver'] >= SUMMARY_FORMAT_VER:
+        df = decode_summary(payload, header)
+        if csv_path:
+            df.to_csv(csv_path, index=False)
+        return header, df
 
     # Determine channels per sample: v1=3 (acc), v2+=6 (acc+gyro)
     channels = 6 if header['format_ver'] >= 0x0200 else 3
-    if raw.size % channels != 0:
-        raw = raw[: (raw.size // channels) * channels]
-    data = raw.reshape(-1, channels)
-
-    # Accelerometer scaling (prefer header LSB if present)
-    lsb_per_g = float(header.get('lsb_per_g') or 0.0)
-    rng = int(header.get('range_g', 0) or 0)
-    if lsb_per_g <= 0.0:
-        if rng <= 0:
-            rng = 4
-            header['range_g'] = rng
-        lsb_per_g = 32768 / rng
-    acc_g = data[:, :3] / lsb_per_g
+    sample_n = None
+    if header['format_ver'] >= 0x0300:
+        flags = header['format_ver'] & 0xFF
+        if not (flags & (FMT_FLAG_COMPRESSED | FMT_FLAG_FRAMED)) or header['block_size'] <= 0:
+            raise ValueError(f"unsupported block format 0x{header['format_ver']:04X}")
+        if flags & FMT_FLAG_FRAMED:
+            data, lost, idx = decode_frames(payload, header['block_size'],
+                                            bool(flags & FMT_FLAG_COMPRESSED),
+                                            fill_gaps=not flags & FMT_FLAG_TRIGGER)
+            header['frames'] = len(idx)
+            header['odr_measured'] = round(measured_odr(idx), 3)
+            if not flags & FMT_FLAG_TRIGGER:
+                header['lost_samples'] = lost
+            else:
+                # Samples outside any segment (not logged, or lost)
+                header['skipped_samples'] = lost
+                sample_n = frame_sample_numbers(idx)
+                header['segments'] = int(np.count_nonzero(
+                    idx['first_sample'][1:] != idx['first_sample'][:-1] + idx['count'][:-1])) + (len(idx) > 0)
+        else:
+            blocks = list(iter_decoded_blocks(payload, header['block_size']))
+            data = np.concatenate(blocks) if blocks else np.empty((0, 6), dtype=np.int16)
+    else:
+        # Ensure even number of bytes (int16-aligned); drop any trailing odd byte
+        if len(payload) % 2 != 0:
+            payload = payload[:-1]
 
-    # Timebase
-    n = np.arange(len(acc_g), dtype=np.int64)
-    t_sec = n / header['odr_hz']
+        # Firmware writes MSB first (big-endian) for each int16
+        raw = np.frombuffer(payload, dtype='>i2')
 
-    # Build dataframe columns
-    cols = {
-        'n': n,
-        't_sec': t_sec,
-        'ax_g': acc_g[:, 0],
-        'ay_g': acc_g[:, 1],
-        'az_g': acc_g[:, 2],
-    }
-    if data.shape[1] == 6:
-        # Firmware v2 stores gyro values as int16 cast from dps
-        # Scaling (prefer header lsb_per_dps if present)
-        lsb_per_dps = float(header.get('lsb_per_dps') or 0.0)
-        g_rng = int(header.get('gyro_range_dps', 0) or 0)
-        if lsb_per_dps <= 0.0:
-            if g_rng <= 0:
-                g_rng = 2000
-                header['gyro_range_dps'] = g_rng
-            lsb_per_dps = 32768 / g_rng
-        gyro_dps = data[:, 3:6].astype(np.float32) / lsb_per_dps
-        cols.update({
-            'gx_dps': gyro_dps[:, 0],
-            'gy_dps': gyro_dps[:, 1],
-            'gz_dps': gyro_dps[:, 2],
-        })
-
-    df = pd.DataFrame(cols)
+        if raw.size % channels != 0:
+            raw = raw[: (raw.size // channels) * channels]
+        data = raw.reshape(-1, channels)
+    scales = sample_scales(header)
+    # Timebase (trigger segments keep their own sample numbers)
+    n = sample_n if sample_n is not None else np.arange(len(data), dtype=np.int64)
+    df, gaps = samples_frame(data, n, header, scales)
+    header['gap_samples'] = gaps
     if csv_path:
         df.to_csv(csv_path, index=False)
     return header, df
 
+# Streaming conversion: rows per DataFrame / CSV write (bounds memory independently of the file size)
+STREAM_CHUNK_SAMPLES = 1 << 18
+# The header normally sits at offset 0; only this far is searched for the magic before falling back
+MAGIC_SCAN_BYTES = 1 << 16
+
+
+def _iter_raw_chunks(buf, off: int, channels: int, chunk: int):
+    """Big-endian int16 samples of a 0x01xx/0x02xx payload as (data, n) chunks, views of buf."""
+    total = (len(buf) - off) // (2 * channels)
+    for start in range(0, total, chunk):
+        k = min(chunk, total - start)
+        raw = np.frombuffer(buf, dtype='>i2', count=k * channels, offset=off + start * 2 * channels)
+        yield raw.reshape(-1, channels), np.arange(start, start + k, dtype=np.int64)
+
+
+def _iter_frame_chunks(buf, off: int, header: dict, chunk: int):
+    """decode_frames() as a stream of (data, n) pieces; fills header like bin_to_csv()."""
+    flags = header['format_ver'] & 0xFF
+    compressed = bool(flags & FMT_FLAG_COMPRESSED)
+    trigger = bool(flags & FMT_FLAG_TRIGGER)
+    rows = []
+    expected = 0
+    lost = 0
+    for frame_off, first, t_us, count, body in iter_frames(buf, header['block_size'], start=off):
+        if first < expected:
+            continue  # stale or duplicated block
+        blk = decode_frame_body(body, count, compressed)
+        if first > expected:
+            lost += first - expected
+            if not trigger:
+                # Gap markers for the missing samples, in bounded pieces
+                for g in range(expected, first, chunk):
+                    k = min(chunk, first - g)
+                    yield (np.full((k, 6), GAP_WORD, dtype=np.int16),
+                           np.arange(g, g + k, dtype=np.int64))
+        yield blk, np.arange(first, first + len(blk), dtype=np.int64)
+        rows.append((frame_off - off, first, t_us, len(blk)))
+        expected = first + len(blk)
+    idx = np.array(rows, dtype=FRAME_INDEX_DTYPE)
+    header['frames'] = len(idx)
+    header['odr_measured'] = round(measured_odr(idx), 3)
+    if not trigger:
+        header['lost_samples'] = lost
+    else:
+        header['skipped_samples'] = lost
+        header['segments'] = int(np.count_nonzero(
+            idx['first_sample'][1:] != idx['first_sample'][:-1] + idx['count'][:-1])) + (len(idx) > 0)
+
+
+def _iter_block_chunks(buf, off: int, block_size: int):
+    """Compressed (unframed) blocks as (data, n) pieces."""
+    n0 = 0
+    for blk in iter_decoded_blocks(memoryview(buf)[off:], block_size):
+        yield blk, np.arange(n0, n0 + len(blk), dtype=np.int64)
+        n0 += len(blk)
+
+
+def _rechunk(pieces, chunk: int):
+    """Merge small (data, n) pieces (one per block) into about chunk rows each."""
+    parts, ns, rows = [], [], 0
+    for data, n in pieces:
+        parts.append(data)
+        ns.append(n)
+        rows += len(data)
+        if rows >= chunk:
+            yield np.concatenate(parts), np.concatenate(ns)
+            parts, ns, rows = [], [], 0
+    if parts:
+        yield np.concatenate(parts), np.concatenate(ns)
+
+
+def bin_to_csv_stream(bin_path: Path, csv_path: Path, chunk: int = STREAM_CHUNK_SAMPLES,
+                      native: bool | None = None) -> dict:
+    """Convert a log to CSV in bounded memory; same CSV as bin_to_csv().
+
+    The file is memory-mapped instead of read, the header is looked for near
+    the start only, and samples are scaled and written ``chunk`` rows at a
+    time (one vectorised big-endian convert per chunk), so multi-GB logs need
+    no more RAM than one chunk. Summary logs and files without a header near
+    the start go through bin_to_csv(). Returns the header (with
+    ``samples`` and ``gap_samples`` counted while writing).
+
+    Sample logs are converted by the native decoder (acclog_native.py) when
+    its library is built; native=False forces numpy, native=True requires it.
+    """
+    bin_path = Path(bin_path)
+    with open(bin_path, 'rb') as f:
+        size = f.seek(0, 2)
+        if size < HEADER_SIZE:
+            return bin_to_csv(bin_path, csv_path)[0]
+        mm = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+    try:
+        idx = mm.find(b'ACCLOG', 0, MAGIC_SCAN_BYTES)
+        if idx < 0 or size - idx < HEADER_SIZE:
+            return bin_to_csv(bin_path, csv_path)[0]
+        header = parse_header(mm[idx:idx + HEADER_SIZE])
+        if header['format_ver'] >= SUMMARY_FORMAT_VER:
+            return bin_to_csv(bin_path, csv_path)[0]
+        header['header_found'] = True
+        header['header_offset'] = int(idx)
+        off = idx + HEADER_SIZE
+        channels = 6 if header['format_ver'] >= 0x0200 else 3
+        if header['format_ver'] >= 0x0300:
+            flags = header['format_ver'] & 0xFF
+            if not (flags & (FMT_FLAG_COMPRESSED | FMT_FLAG_FRAMED)) or header['block_size'] <= 0:
+                raise ValueError(f"unsupported block format 0x{header['format_ver']:04X}")
+            if flags & FMT_FLAG_FRAMED:
+                pieces = _iter_frame_chunks(mm, off, header, chunk)
+            else:
+                pieces = _iter_block_chunks(mm, off, header['block_size'])
+            chunks = _rechunk(pieces, chunk)
+        else:
+            chunks = _iter_raw_chunks(mm, off, channels, chunk)
+        if native is not False and acclog_native.available():
+            st = acclog_native.csv_file(bin_path, csv_path, chunk)
+            sample_scales(header)  # fills in missing ranges like the numpy path
+            if header['format_ver'] >= 0x0300 and header['format_ver'] & FMT_FLAG_FRAMED:
+                header['frames'] = st.frames
+                header['odr_measured'] = round(st.odr_measured, 3)
+                if header['format_ver'] & FMT_FLAG_TRIGGER:
+                    header['skipped_samples'] = st.lost_samples
+                    header['segments'] = st.segments
+                else:
+                    header['lost_samples'] = st.lost_samples
+            header['samples'] = st.samples
+            header['gap_samples'] = st.gap_samples
+            return header
+        if native:
+            raise RuntimeError('native decoder library not found (build pc_tools/native)')
+        scales = sample_scales(header)
+        samples = gaps = 0
+        with open(csv_path, 'w', newline='') as out:
+            for data, n in chunks:
+                df, g = samples_frame(data, n, header, scales)
+                df.to_csv(out, index=False, header=(samples == 0))
+                samples += len(df)
+                gaps += g
+                del data, df
+            if samples == 0:
+                samples_frame(np.empty((0, channels), dtype=np.int16), np.empty(0, dtype=np.int64),
+                              header, scales)[0].to_csv(out, index=False)
+        header['samples'] = samples
+        header['gap_samples'] = gaps
+        return header
+    finally:
+        try:
+            mm.close()
+        except BufferError:
+            pass  # a view is still referenced; the map goes away with it
 
 
 
@@ -193,9 +715,14 @@ if __name__ == '__main__':
     p = argparse.ArgumentParser(description='Convert ACCLOG.BIN to CSV')
     p.add_argument('bin_file', type=Path, help='input .bin file')
     p.add_argument('--csv', action='store_true', help='also output CSV file')
+    p.add_argument('--chunk', type=int, default=STREAM_CHUNK_SAMPLES,
+                   help='rows converted per step when writing CSV (memory bound)')
     args = p.parse_args()
     out_csv = args.bin_file.with_suffix('.csv') if args.csv else None
-    header, _df = bin_to_csv(args.bin_file, out_csv)
+    if out_csv:
+        header = bin_to_csv_stream(args.bin_file, out_csv, chunk=args.chunk)
+    else:
+        header, _df = bin_to_csv(args.bin_file, None)
     for k, v in header.items():
         print(f'{k}: {v}')
     if out_csv:
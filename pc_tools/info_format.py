@@ -21,6 +21,8 @@ def format_info_line(info: dict) -> str:
         parts.append(f"Gyro=±{gdr}dps")
     if fs_used_pct is not None:
         parts.append(f"FS={fs_used_pct}%")
+    if info.get('calib'):
+        parts.append(f"Calib={info['calib']}")
     return ' '.join(parts)
 
 def enrich_info_defaults(info: dict) -> dict:
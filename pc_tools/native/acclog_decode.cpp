@@ -0,0 +1,710 @@
+// acclog_decode.h: header parsing, block / frame decoding (log_codec.h formats), SIMD kernels and the
+// CSV writer. Every rule here follows pc_tools/decoder.py so both write the same CSV bytes.
+#include "acclog_decode.h"
+#include <charconv>
+#include <fcntl.h>
+#include <math.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// 0x03xx block payload (format_ver low byte)
+static const uint16_t ACCLOG_FLAG_COMPRESSED = 0x01;
+static const uint16_t ACCLOG_FLAG_FRAMED = 0x02;
+static const uint16_t ACCLOG_FLAG_TRIGGER = 0x04;
+static const uint16_t ACCLOG_SUMMARY_VER = 0x0400;
+static const size_t ACCLOG_BLOCK_HDR = 4;     // uint16 count, uint16 len
+static const size_t ACCLOG_FRAME_HDR = 20;    // "ABLK", crc32, first_sample, t_us, count, len
+// Mapped input already decoded is dropped from the page cache mapping every this many bytes, so the
+// resident size stays bounded on multi-GB logs
+static const size_t ACCLOG_RELEASE_BYTES = 16u << 20;
+
+static inline uint16_t _acclog_u16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline uint32_t _acclog_u32(const uint8_t* p) { return (uint32_t)_acclog_u16(p) | ((uint32_t)_acclog_u16(p + 2) << 16); }
+static inline uint64_t _acclog_u64(const uint8_t* p) { return (uint64_t)_acclog_u32(p) | ((uint64_t)_acclog_u32(p + 4) << 32); }
+static inline float _acclog_f32(const uint8_t* p) {
+    const uint32_t u = _acclog_u32(p);
+    float f;
+    memcpy(&f, &u, 4);
+    return f;
+}
+
+// ---- Header ----------------------------------------------------------------------------------------
+
+bool acclog_parse_header(const uint8_t* p, AcclogHeader& h) {
+    if (memcmp(p, "ACCLOG", 6) != 0) return false;
+    memset(&h, 0, sizeof(h));
+    h.format_ver = _acclog_u16(p + 8);
+    h.device_uid = _acclog_u64(p + 10);
+    h.start_unix_ms = _acclog_u64(p + 18);
+    h.odr_hz = _acclog_u16(p + 26);
+    h.range_g = _acclog_u16(p + 28);
+    if (h.format_ver >= 0x0201) {
+        // HEADER_FMT_V2_1 and later: gyro range, imu_type, device_model, LSBs, counts, bias, block_size
+        h.gyro_range_dps = _acclog_u16(p + 30);
+        h.imu_type = _acclog_u16(p + 32);
+        h.device_model = _acclog_u16(p + 34);
+        h.lsb_per_g = _acclog_f32(p + 36);
+        h.lsb_per_dps = _acclog_f32(p + 40);
+        h.total_samples = _acclog_u32(p + 44);
+        h.dropped_samples = _acclog_u32(p + 48);
+        if (h.format_ver >= 0x0202) {
+            for (int i = 0; i < 3; ++i) h.gyro_bias[i] = (int16_t)_acclog_u16(p + 52 + 2 * i);
+            h.decim_factor = p[60];
+            h.decim_taps = p[61];
+            h.decim_cutoff_pct = p[62];
+            h.dlpf_hz = p[63];
+        }
+        if (h.format_ver >= 0x0300) h.block_size = _acclog_u16(p + 58);
+    } else if (h.format_ver >= 0x0200) {
+        h.gyro_range_dps = _acclog_u16(p + 30);
+        h.total_samples = _acclog_u32(p + 32);
+        h.dropped_samples = _acclog_u32(p + 36);
+    } else {
+        h.total_samples = _acclog_u32(p + 30);
+        h.dropped_samples = _acclog_u32(p + 34);
+    }
+    return true;
+}
+
+// decoder.sample_scales()
+static void _acclog_scales(AcclogFile& f) {
+    const AcclogHeader& h = f.hdr;
+    f.lsb_per_g = h.lsb_per_g;
+    if (!(f.lsb_per_g > 0.0)) f.lsb_per_g = 32768.0 / (h.range_g ? h.range_g : 4);
+    // 0x0200 and SH200Q 0x0201 store gyro as int16 dps; later logs bias-subtracted raw counts
+    const bool gyro_is_dps = h.format_ver < 0x0201 || (h.format_ver == 0x0201 && h.imu_type == 1);
+    f.lsb_per_dps = h.lsb_per_dps;
+    if (gyro_is_dps) f.lsb_per_dps = 1.0;
+    else if (!(f.lsb_per_dps > 0.0)) f.lsb_per_dps = 32768.0 / (h.gyro_range_dps ? h.gyro_range_dps : 2000);
+}
+
+int acclog_open(AcclogFile& f, const char* path) {
+    memset(&f, 0, sizeof(f));
+    f.fd = open(path, O_RDONLY);
+    if (f.fd < 0) return ACCLOG_E_OPEN;
+    struct stat st;
+    if (fstat(f.fd, &st) != 0) {
+        acclog_close(f);
+        return ACCLOG_E_OPEN;
+    }
+    f.size = (size_t)st.st_size;
+    if (f.size < ACCLOG_HEADER_SIZE) {
+        acclog_close(f);
+        return ACCLOG_E_NO_HEADER;
+    }
+    void* m = mmap(nullptr, f.size, PROT_READ, MAP_PRIVATE, f.fd, 0);
+    if (m == MAP_FAILED) {
+        acclog_close(f);
+        return ACCLOG_E_OPEN;
+    }
+    f.data = (const uint8_t*)m;
+    madvise(m, f.size, MADV_SEQUENTIAL);
+    // The magic must end within the first ACCLOG_MAGIC_SCAN bytes and a whole header must follow
+    const size_t scan = f.size < ACCLOG_MAGIC_SCAN ? f.size : ACCLOG_MAGIC_SCAN;
+    const void* hit = memmem(f.data, scan, "ACCLOG", 6);
+    if (!hit || f.size - ((const uint8_t*)hit - f.data) < ACCLOG_HEADER_SIZE) {
+        acclog_close(f);
+        return ACCLOG_E_NO_HEADER;
+    }
+    f.header_offset = (const uint8_t*)hit - f.data;
+    acclog_parse_header(f.data + f.header_offset, f.hdr);
+    if (f.hdr.format_ver >= ACCLOG_SUMMARY_VER) {
+        acclog_close(f);
+        return ACCLOG_E_SUMMARY;
+    }
+    f.channels = f.hdr.format_ver >= 0x0200 ? 6 : 3;
+    _acclog_scales(f);
+    return ACCLOG_OK;
+}
+
+void acclog_close(AcclogFile& f) {
+    if (f.data) munmap((void*)f.data, f.size);
+    if (f.fd >= 0) close(f.fd);
+    f.data = nullptr;
+    f.fd = -1;
+}
+
+// ---- Kernels ---------------------------------------------------------------------------------------
+
+void acclog_bswap16(const uint8_t* src, int16_t* dst, size_t n) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(src + 2 * i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + 2 * i + 16));
+        a = _mm_or_si128(_mm_slli_epi16(a, 8), _mm_srli_epi16(a, 8));
+        b = _mm_or_si128(_mm_slli_epi16(b, 8), _mm_srli_epi16(b, 8));
+        _mm_storeu_si128((__m128i*)(dst + i), a);
+        _mm_storeu_si128((__m128i*)(dst + i + 8), b);
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= n; i += 8) vst1q_s16(dst + i, vreinterpretq_s16_u8(vrev16q_u8(vld1q_u8(src + 2 * i))));
+#endif
+    for (; i < n; ++i) dst[i] = (int16_t)(uint16_t)(src[2 * i] << 8 | src[2 * i + 1]);
+}
+
+void acclog_scale_f32(const int16_t* v, size_t n, float lsb, float* dst) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128 d = _mm_set1_ps(lsb);
+    for (; i + 8 <= n; i += 8) {
+        const __m128i x = _mm_loadu_si128((const __m128i*)(v + i));
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);   // sign-extend to int32
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+        _mm_storeu_ps(dst + i, _mm_div_ps(_mm_cvtepi32_ps(lo), d));
+        _mm_storeu_ps(dst + i + 4, _mm_div_ps(_mm_cvtepi32_ps(hi), d));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const float32x4_t d = vdupq_n_f32(lsb);
+    for (; i + 8 <= n; i += 8) {
+        const int16x8_t x = vld1q_s16(v + i);
+        vst1q_f32(dst + i, vdivq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), d));
+        vst1q_f32(dst + i + 4, vdivq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), d));
+    }
+#endif
+    for (; i < n; ++i) dst[i] = (float)v[i] / lsb;
+}
+
+void acclog_scale_f64(const int16_t* v, size_t n, double lsb, double* dst) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128d d = _mm_set1_pd(lsb);
+    for (; i + 4 <= n; i += 4) {
+        const __m128i x = _mm_loadl_epi64((const __m128i*)(v + i));
+        const __m128i w = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+        _mm_storeu_pd(dst + i, _mm_div_pd(_mm_cvtepi32_pd(w), d));
+        _mm_storeu_pd(dst + i + 2, _mm_div_pd(_mm_cvtepi32_pd(_mm_srli_si128(w, 8)), d));
+    }
+#endif
+    for (; i < n; ++i) dst[i] = (double)v[i] / lsb;
+}
+
+// zlib-compatible CRC32 (IEEE, reflected), slicing by 4
+static uint32_t s_crc_table[4][256];
+
+static void _acclog_crc_init() {
+    if (s_crc_table[0][1]) return;
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        s_crc_table[0][i] = c;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+        for (int t = 1; t < 4; ++t) s_crc_table[t][i] = (s_crc_table[t - 1][i] >> 8) ^ s_crc_table[0][s_crc_table[t - 1][i] & 0xFF];
+    }
+}
+
+static uint32_t _acclog_crc32(const uint8_t* p, size_t n) {
+    uint32_t c = 0xFFFFFFFFu;
+    for (; n >= 4; n -= 4, p += 4) {
+        c ^= _acclog_u32(p);
+        c = s_crc_table[3][c & 0xFF] ^ s_crc_table[2][(c >> 8) & 0xFF] ^ s_crc_table[1][(c >> 16) & 0xFF] ^ s_crc_table[0][c >> 24];
+    }
+    while (n--) c = s_crc_table[0][(c ^ *p++) & 0xFF] ^ (c >> 8);
+    return ~c;
+}
+
+// decoder.decode_varint_block(): zigzag varint deltas (<= 3 bytes used per value) into rows x 6,
+// whole samples only. Returns the rows decoded (<= count).
+static size_t _acclog_varint_block(const uint8_t* p, size_t len, size_t count, int16_t* out) {
+    uint16_t acc[6] = { 0, 0, 0, 0, 0, 0 };
+    const size_t vals = count * 6;
+    size_t done = 0, i = 0;
+    while (done < vals && i < len) {
+        uint32_t zz = 0;
+        int k = 0;
+        for (;;) {
+            const uint8_t b = p[i++];
+            if (k < 3) zz |= (uint32_t)(b & 0x7F) << (7 * k);
+            ++k;
+            if (b < 0x80) break;
+            if (i == len) return done / 6;   // unterminated value
+        }
+        const int32_t d = (int32_t)(zz >> 1) ^ -(int32_t)(zz & 1);
+        const int ch = (int)(done % 6);
+        acc[ch] = (uint16_t)(acc[ch] + (uint16_t)d);
+        out[done++] = (int16_t)acc[ch];
+    }
+    return done / 6;
+}
+
+// ---- Decoding --------------------------------------------------------------------------------------
+
+// Output side of acclog_decode(): rows collected into chunks of cap rows
+struct AcclogBatch {
+    const AcclogFile* f;
+    AcclogSink sink;
+    void* ctx;
+    AcclogStats* st;
+    size_t cap;
+    bool numbered;              // trigger logs: sample numbers per row
+    std::vector<int16_t> v;
+    std::vector<int64_t> n;
+    size_t rows;
+    int64_t n0;
+    bool failed;
+};
+
+static void _acclog_count_gaps(AcclogBatch& b, const int16_t* v, size_t rows) {
+    if (b.f->channels != 6) return;
+    uint64_t gaps = 0;
+    for (size_t r = 0; r < rows; ++r, v += 6) {
+        gaps += v[0] == ACCLOG_GAP_WORD && v[1] == ACCLOG_GAP_WORD && v[2] == ACCLOG_GAP_WORD &&
+                v[3] == ACCLOG_GAP_WORD && v[4] == ACCLOG_GAP_WORD && v[5] == ACCLOG_GAP_WORD;
+    }
+    b.st->gap_samples += gaps;
+}
+
+static void _acclog_emit(AcclogBatch& b, const int16_t* v, const int64_t* n, int64_t n0, size_t rows) {
+    if (b.failed || rows == 0) return;
+    _acclog_count_gaps(b, v, rows);
+    b.st->samples += rows;
+    const AcclogChunk c = { v, n, n0, rows };
+    if (!b.sink(c, b.ctx)) b.failed = true;
+}
+
+static void _acclog_flush(AcclogBatch& b) {
+    _acclog_emit(b, b.v.data(), b.numbered ? b.n.data() : nullptr, b.n0, b.rows);
+    b.rows = 0;
+}
+
+// Append rows (gap rows if v is null) numbered first, first + 1, ...
+static void _acclog_put(AcclogBatch& b, const int16_t* v, size_t rows, int64_t first) {
+    const int ch = b.f->channels;
+    while (rows) {
+        if (b.rows == 0) b.n0 = first;
+        const size_t k = rows < b.cap - b.rows ? rows : b.cap - b.rows;
+        int16_t* dst = b.v.data() + b.rows * ch;
+        if (v) {
+            memcpy(dst, v, k * ch * sizeof(int16_t));
+            v += k * ch;
+        } else {
+            for (size_t i = 0; i < k * ch; ++i) dst[i] = ACCLOG_GAP_WORD;
+        }
+        if (b.numbered) {
+            for (size_t i = 0; i < k; ++i) b.n[b.rows + i] = first + (int64_t)i;
+        }
+        b.rows += k;
+        first += (int64_t)k;
+        rows -= k;
+        if (b.rows == b.cap) _acclog_flush(b);
+    }
+}
+
+// Drop decoded input pages below `upto` from this mapping (re-read from the page cache if needed)
+static void _acclog_release(const AcclogFile& f, size_t& released, size_t upto) {
+    if (upto < released + ACCLOG_RELEASE_BYTES) return;
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t end = upto / page * page;
+    madvise((void*)(f.data + released), end - released, MADV_DONTNEED);
+    released = end;
+}
+
+// 0x01xx / 0x02xx: big-endian int16 x channels straight from the map
+static void _acclog_decode_raw(const AcclogFile& f, AcclogBatch& b, size_t off) {
+    const size_t row_bytes = 2 * (size_t)f.channels;
+    const size_t total = (f.size - off) / row_bytes;
+    size_t released = 0;
+    for (size_t start = 0; start < total && !b.failed; start += b.cap) {
+        const size_t k = total - start < b.cap ? total - start : b.cap;
+        acclog_bswap16(f.data + off + start * row_bytes, b.v.data(), k * f.channels);
+        _acclog_emit(b, b.v.data(), nullptr, (int64_t)start, k);
+        _acclog_release(f, released, off + (start + k) * row_bytes);
+    }
+    b.st->bytes_in = total * row_bytes;
+}
+
+// 0x0301: fixed-size blocks [count][len][varints]; stops at the first empty or truncated block
+static void _acclog_decode_blocks(const AcclogFile& f, AcclogBatch& b, size_t off, int16_t* tmp) {
+    const size_t bs = f.hdr.block_size;
+    int64_t n = 0;
+    size_t released = 0;
+    for (size_t o = off; o < f.size && !b.failed; o += bs) {
+        const size_t avail = f.size - o < bs ? f.size - o : bs;
+        if (avail < ACCLOG_BLOCK_HDR) break;
+        const uint16_t count = _acclog_u16(f.data + o);
+        const uint16_t len = _acclog_u16(f.data + o + 2);
+        if (count == 0 || ACCLOG_BLOCK_HDR + len > avail) break;
+        const size_t rows = _acclog_varint_block(f.data + o + ACCLOG_BLOCK_HDR, len, count, tmp);
+        _acclog_put(b, tmp, rows, n);
+        n += (int64_t)rows;
+        b.st->bytes_in = o + avail - off;
+        _acclog_release(f, released, o);
+    }
+}
+
+// 0x0302 / 0x0303 (/ trigger 0x0306 / 0x0307): decoder.iter_frames() + _iter_frame_chunks()
+static void _acclog_decode_frames(const AcclogFile& f, AcclogBatch& b, size_t off, int16_t* tmp) {
+    const size_t bs = f.hdr.block_size;
+    const bool compressed = f.hdr.format_ver & ACCLOG_FLAG_COMPRESSED;
+    const bool trigger = f.hdr.format_ver & ACCLOG_FLAG_TRIGGER;
+    const uint8_t* d = f.data;
+    const size_t size = f.size;
+    int64_t expected = 0;
+    // Least-squares slope of first_sample over the unwrapped frame micros() (decoder.measured_odr())
+    double t = 0, mean_t = 0, mean_n = 0, m2_t = 0, c_tn = 0;
+    uint32_t last_t_us = 0;
+    int64_t prev_end = -1;
+    size_t released = 0;
+    _acclog_crc_init();
+    size_t o = off;
+    while (o + ACCLOG_FRAME_HDR <= size && !b.failed) {
+        if (memcmp(d + o, "ABLK", 4) == 0) {
+            const uint32_t crc = _acclog_u32(d + o + 4);
+            const uint32_t first = _acclog_u32(d + o + 8);
+            const uint32_t t_us = _acclog_u32(d + o + 12);
+            const uint16_t count = _acclog_u16(d + o + 16);
+            const uint16_t len = _acclog_u16(d + o + 18);
+            const size_t end = o + ACCLOG_FRAME_HDR + len;
+            if (count && ACCLOG_FRAME_HDR + len <= bs && end <= size && _acclog_crc32(d + o + 8, end - o - 8) == crc) {
+                if ((int64_t)first >= expected) {   // else a stale or duplicated block
+                    const uint8_t* body = d + o + ACCLOG_FRAME_HDR;
+                    size_t rows;
+                    if (compressed) {
+                        rows = _acclog_varint_block(body, len, count, tmp);
+                    } else {
+                        rows = (size_t)len / 12 < count ? (size_t)len / 12 : count;
+                        acclog_bswap16(body, tmp, rows * 6);
+                    }
+                    if ((int64_t)first > expected) {
+                        b.st->lost_samples += (uint64_t)((int64_t)first - expected);
+                        if (!trigger) _acclog_put(b, nullptr, (size_t)((int64_t)first - expected), expected);
+                    }
+                    _acclog_put(b, tmp, rows, first);
+                    const uint64_t k = ++b.st->frames;
+                    if (k > 1) t += (double)(uint32_t)(t_us - last_t_us);
+                    last_t_us = t_us;
+                    const double dt = t - mean_t;
+                    mean_t += dt / (double)k;
+                    mean_n += ((double)first - mean_n) / (double)k;
+                    m2_t += dt * (t - mean_t);
+                    c_tn += dt * ((double)first - mean_n);
+                    if ((int64_t)first != prev_end) b.st->segments++;
+                    prev_end = (int64_t)first + (int64_t)rows;
+                    expected = (int64_t)first + (int64_t)rows;
+                }
+                o += bs;
+                if (o + 4 > size || memcmp(d + o, "ABLK", 4) != 0) {
+                    // Off the block grid (padding lost): the next sync word from the end of this body
+                    const void* nxt = memmem(d + end, size - end, "ABLK", 4);
+                    if (!nxt) break;
+                    o = (const uint8_t*)nxt - d;
+                }
+                _acclog_release(f, released, o < size ? o : size);
+                continue;
+            }
+        }
+        const void* nxt = memmem(d + o + 1, size - o - 1, "ABLK", 4);
+        if (!nxt) break;
+        o = (const uint8_t*)nxt - d;
+    }
+    b.st->bytes_in = size - off;
+    if (b.st->frames >= 2 && t > 0 && m2_t > 0) b.st->odr_measured = c_tn / m2_t * 1e6;
+}
+
+int acclog_decode(const AcclogFile& f, uint32_t chunk_rows, AcclogSink sink, void* ctx, AcclogStats& st) {
+    memset(&st, 0, sizeof(st));
+    st.header_offset = f.header_offset;
+    const uint16_t fmt = f.hdr.format_ver;
+    const bool blocks = fmt >= 0x0300;
+    if (blocks && (!(fmt & (ACCLOG_FLAG_COMPRESSED | ACCLOG_FLAG_FRAMED)) || f.hdr.block_size == 0)) return ACCLOG_E_FORMAT;
+    AcclogBatch b;
+    b.f = &f;
+    b.sink = sink;
+    b.ctx = ctx;
+    b.st = &st;
+    b.cap = chunk_rows ? chunk_rows : ACCLOG_CHUNK_ROWS;
+    b.numbered = blocks && (fmt & ACCLOG_FLAG_FRAMED) && (fmt & ACCLOG_FLAG_TRIGGER);
+    b.v.resize(b.cap * f.channels);
+    if (b.numbered) b.n.resize(b.cap);
+    b.rows = 0;
+    b.n0 = 0;
+    b.failed = false;
+    const size_t off = f.header_offset + ACCLOG_HEADER_SIZE;
+    if (!blocks) {
+        _acclog_decode_raw(f, b, off);
+    } else {
+        std::vector<int16_t> tmp((size_t)0xFFFF * 6);   // one block: up to 65535 samples
+        if (fmt & ACCLOG_FLAG_FRAMED) _acclog_decode_frames(f, b, off, tmp.data());
+        else _acclog_decode_blocks(f, b, off, tmp.data());
+        _acclog_flush(b);
+    }
+    return b.failed ? ACCLOG_E_WRITE : ACCLOG_OK;
+}
+
+// ---- Number formatting (numpy str()) ---------------------------------------------------------------
+
+template <typename T>
+static size_t _acclog_format(char* out, T v, double positional_max) {
+    char* p = out;
+    if (isnan(v)) {
+        memcpy(p, "nan", 3);
+        return 3;
+    }
+    if (signbit(v)) *p++ = '-';
+    if (isinf(v)) {
+        memcpy(p, "inf", 3);
+        return p - out + 3;
+    }
+    if (v == 0) {
+        memcpy(p, "0.0", 3);
+        return p - out + 3;
+    }
+    // Shortest round-trip digits of this type: "d[.ddd]e[+-]xx"
+    char sci[48];
+    const char* s = sci;
+    const char* end = std::to_chars(sci, sci + sizeof(sci), v < 0 ? -v : v, std::chars_format::scientific).ptr;
+    char digits[32];
+    int nd = 0;
+    for (; *s != 'e'; ++s) {
+        if (*s != '.') digits[nd++] = *s;
+    }
+    int exp10 = 0;
+    std::from_chars(s + (s[1] == '+' ? 2 : 1), end, exp10);
+    const double a = fabs((double)v);
+    if (a >= 1e-4 && a < positional_max) {
+        if (exp10 >= 0) {
+            for (int i = 0; i <= exp10; ++i) *p++ = i < nd ? digits[i] : '0';
+            *p++ = '.';
+            if (nd > exp10 + 1) {
+                memcpy(p, digits + exp10 + 1, nd - exp10 - 1);
+                p += nd - exp10 - 1;
+            } else {
+                *p++ = '0';
+            }
+        } else {
+            *p++ = '0';
+            *p++ = '.';
+            for (int i = 0; i < -exp10 - 1; ++i) *p++ = '0';
+            memcpy(p, digits, nd);
+            p += nd;
+        }
+    } else {
+        *p++ = digits[0];
+        if (nd > 1) {
+            *p++ = '.';
+            memcpy(p, digits + 1, nd - 1);
+            p += nd - 1;
+        }
+        *p++ = 'e';
+        *p++ = exp10 < 0 ? '-' : '+';
+        const int e = exp10 < 0 ? -exp10 : exp10;
+        if (e >= 100) *p++ = (char)('0' + e / 100);
+        *p++ = (char)('0' + e / 10 % 10);
+        *p++ = (char)('0' + e % 10);
+    }
+    return p - out;
+}
+
+size_t acclog_format_f64(char* out, double v) { return _acclog_format(out, v, 1e16); }
+size_t acclog_format_f32(char* out, float v) { return _acclog_format(out, v, 1e6); }
+
+// ---- CSV -------------------------------------------------------------------------------------------
+
+// Text of every int16 value after scaling, computed once per log: a CSV field is then a copy
+static const size_t ACCLOG_LUT_SLOT = 32;
+static const size_t ACCLOG_FRAC_SLOT = 16;
+static const size_t ACCLOG_OUT_FLUSH = 1u << 20;
+static const size_t ACCLOG_ROW_MAX = 24 + 32 + 6 * (ACCLOG_LUT_SLOT + 1) + 8;   // n, t_sec, fields, eol
+
+struct AcclogCsv {
+    FILE* out;
+    const char* eol;
+    size_t eol_len;
+    int channels;
+    double odr;
+    std::vector<char> lut[2];       // [0] acc (float64), [1] gyro (float32): 65536 x ACCLOG_LUT_SLOT
+    std::vector<uint8_t> lut_len[2];
+    // t_sec = n / odr as "q.<frac[n % odr]>" when that decimal is exact and has <= 15 significant
+    // digits: it is then the only such decimal within the double's rounding interval, i.e. the
+    // shortest round-trip text. Other rows go through acclog_format_f64().
+    std::vector<char> frac;         // odr x ACCLOG_FRAC_SLOT
+    std::vector<uint8_t> frac_len;  // 0: does not end within ACCLOG_FRAC_SLOT digits
+    std::vector<char> buf;
+    size_t pos;
+    uint64_t bytes;
+    bool ok;
+};
+
+static void _acclog_csv_lut(AcclogCsv& c, const AcclogFile& f) {
+    std::vector<int16_t> all(65536);
+    for (int i = 0; i < 65536; ++i) all[i] = (int16_t)(i - 32768);
+    std::vector<double> acc(65536);
+    std::vector<float> gyro(65536);
+    acclog_scale_f64(all.data(), all.size(), f.lsb_per_g, acc.data());
+    acclog_scale_f32(all.data(), all.size(), (float)f.lsb_per_dps, gyro.data());
+    for (int t = 0; t < 2; ++t) {
+        c.lut[t].assign(65536 * ACCLOG_LUT_SLOT, 0);
+        c.lut_len[t].assign(65536, 0);
+        for (int i = 0; i < 65536; ++i) {
+            char* s = c.lut[t].data() + (size_t)i * ACCLOG_LUT_SLOT;
+            c.lut_len[t][i] = (uint8_t)(t == 0 ? acclog_format_f64(s, acc[i]) : acclog_format_f32(s, gyro[i]));
+        }
+    }
+}
+
+static char* _acclog_put_int(char* p, int64_t v) {
+    char tmp[24];
+    int k = 0;
+    uint64_t u = v < 0 ? (uint64_t)0 - (uint64_t)v : (uint64_t)v;
+    do {
+        tmp[k++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u);
+    if (v < 0) *p++ = '-';
+    while (k) *p++ = tmp[--k];
+    return p;
+}
+
+static void _acclog_csv_frac(AcclogCsv& c, uint32_t odr) {
+    c.frac.assign((size_t)odr * ACCLOG_FRAC_SLOT, 0);
+    c.frac_len.assign(odr, 0);
+    for (uint32_t r = 0; r < odr; ++r) {
+        char* d = c.frac.data() + (size_t)r * ACCLOG_FRAC_SLOT;
+        if (r == 0) {
+            d[0] = '0';
+            c.frac_len[r] = 1;
+            continue;
+        }
+        uint32_t rem = r;
+        size_t k = 0;
+        while (rem && k < ACCLOG_FRAC_SLOT) {
+            rem *= 10;
+            d[k++] = (char)('0' + rem / odr);
+            rem %= odr;
+        }
+        if (!rem) c.frac_len[r] = (uint8_t)k;
+    }
+}
+
+// t_sec of sample n through the exact-decimal table; 0 if the row needs acclog_format_f64()
+static size_t _acclog_csv_t(const AcclogCsv& c, char* p, int64_t n) {
+    const uint32_t odr = (uint32_t)c.frac_len.size();
+    if (n < 0) return 0;
+    const uint64_t q = (uint64_t)n / odr;
+    const uint32_t r = (uint32_t)((uint64_t)n % odr);
+    const size_t k = c.frac_len[r];
+    if (!k) return 0;
+    const char* d = c.frac.data() + (size_t)r * ACCLOG_FRAC_SLOT;
+    char* s = _acclog_put_int(p, (int64_t)q);
+    size_t sig = (size_t)(s - p) + (r ? k : 0);
+    if (!q) {
+        if (r && (uint64_t)r * 10000 < odr) return 0;   // below 1e-4: scientific
+        size_t lead = 0;
+        while (lead < k && d[lead] == '0') ++lead;
+        sig = k - lead;
+    }
+    if (sig > 15) return 0;
+    *s++ = '.';
+    memcpy(s, d, k);
+    return s + k - p;
+}
+
+static void _acclog_csv_flush(AcclogCsv& c) {
+    if (c.pos && fwrite(c.buf.data(), 1, c.pos, c.out) != c.pos) c.ok = false;
+    c.bytes += c.pos;
+    c.pos = 0;
+}
+
+static bool _acclog_csv_sink(const AcclogChunk& ch, void* ctx) {
+    AcclogCsv& c = *(AcclogCsv*)ctx;
+    const int nc = c.channels;
+    const int16_t* v = ch.v;
+    for (size_t r = 0; r < ch.rows; ++r, v += nc) {
+        if (c.pos + ACCLOG_ROW_MAX > c.buf.size()) {
+            _acclog_csv_flush(c);
+            if (!c.ok) return false;
+        }
+        char* p = c.buf.data() + c.pos;
+        const int64_t n = ch.n ? ch.n[r] : ch.n0 + (int64_t)r;
+        p = _acclog_put_int(p, n);
+        *p++ = ',';
+        const size_t tl = c.frac_len.empty() ? 0 : _acclog_csv_t(c, p, n);
+        if (tl) {
+            p += tl;
+        } else {
+            const double t = (double)n / c.odr;
+            if (!isnan(t)) p += acclog_format_f64(p, t);
+        }
+        const bool gap = nc == 6 && v[0] == ACCLOG_GAP_WORD && v[1] == ACCLOG_GAP_WORD && v[2] == ACCLOG_GAP_WORD &&
+                         v[3] == ACCLOG_GAP_WORD && v[4] == ACCLOG_GAP_WORD && v[5] == ACCLOG_GAP_WORD;
+        for (int i = 0; i < nc; ++i) {
+            *p++ = ',';
+            if (gap) continue;   // NaN: empty field
+            const int tab = i < 3 ? 0 : 1;
+            const size_t k = (size_t)(uint16_t)(v[i] + 32768);
+            memcpy(p, c.lut[tab].data() + k * ACCLOG_LUT_SLOT, ACCLOG_LUT_SLOT);
+            p += c.lut_len[tab][k];
+        }
+        memcpy(p, c.eol, c.eol_len);
+        c.pos = p + c.eol_len - c.buf.data();
+    }
+    return c.ok;
+}
+
+int acclog_write_csv(const AcclogFile& f, FILE* out, uint32_t chunk_rows, const char* eol, AcclogStats& st) {
+    AcclogCsv c;
+    c.out = out;
+    c.eol = eol ? eol : "\n";
+    c.eol_len = strlen(c.eol);
+    if (c.eol_len > 4) return ACCLOG_E_WRITE;
+    c.channels = f.channels;
+    c.odr = f.hdr.odr_hz;
+    c.buf.resize(ACCLOG_OUT_FLUSH + ACCLOG_ROW_MAX);
+    c.pos = 0;
+    c.bytes = 0;
+    c.ok = true;
+    _acclog_csv_lut(c, f);
+    if (f.hdr.odr_hz) _acclog_csv_frac(c, f.hdr.odr_hz);
+    const char* cols = f.channels == 6 ? "n,t_sec,ax_g,ay_g,az_g,gx_dps,gy_dps,gz_dps" : "n,t_sec,ax_g,ay_g,az_g";
+    c.pos = strlen(cols);
+    memcpy(c.buf.data(), cols, c.pos);
+    memcpy(c.buf.data() + c.pos, c.eol, c.eol_len);
+    c.pos += c.eol_len;
+    int err = acclog_decode(f, chunk_rows, _acclog_csv_sink, &c, st);
+    _acclog_csv_flush(c);
+    if (fflush(out) != 0) c.ok = false;
+    st.bytes_out = c.bytes;
+    if (err == ACCLOG_OK && !c.ok) err = ACCLOG_E_WRITE;
+    return err;
+}
+
+// ---- C API (ctypes) --------------------------------------------------------------------------------
+
+int acclog_csv_file(const char* in, const char* out, uint32_t chunk_rows, const char* eol, AcclogStats* st) {
+    AcclogStats local;
+    AcclogStats& s = st ? *st : local;
+    memset(&s, 0, sizeof(s));
+    AcclogFile f;
+    int err = acclog_open(f, in);
+    if (err != ACCLOG_OK) return err;
+    FILE* fp = fopen(out, "wb");
+    if (!fp) {
+        acclog_close(f);
+        return ACCLOG_E_WRITE;
+    }
+    err = acclog_write_csv(f, fp, chunk_rows, eol, s);
+    if (fclose(fp) != 0 && err == ACCLOG_OK) err = ACCLOG_E_WRITE;
+    acclog_close(f);
+    return err;
+}
+
+const char* acclog_strerror(int err) {
+    switch (err) {
+    case ACCLOG_OK: return "ok";
+    case ACCLOG_E_OPEN: return "cannot open or map the input";
+    case ACCLOG_E_NO_HEADER: return "no ACCLOG header in the first 64 KiB";
+    case ACCLOG_E_SUMMARY: return "summary log (0x0400): use decoder.py";
+    case ACCLOG_E_FORMAT: return "unsupported block format";
+    case ACCLOG_E_WRITE: return "cannot write the output";
+    default: return "unknown error";
+    }
+}
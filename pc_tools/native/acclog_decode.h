@@ -0,0 +1,108 @@
+#pragma once
+// Native decoder of ACCLOG sample logs (the formats of decoder.py): the file is memory-mapped,
+// samples are byte-swapped / scaled with SIMD kernels and written as CSV a bounded chunk at a time.
+// CSV は decoder.bin_to_csv() / bin_to_csv_stream() とバイト単位で同じ（数値の書式も numpy / pandas に合わせる）。
+// 要約ログ (0x0400) と先頭 64 KiB にヘッダの無いファイルは扱わない（decoder.py 側で変換）。
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// 64-byte LogHeader, every version parse_header() reads (0x0100 / 0x0200 / 0x0201 / 0x0202 / 0x03xx)
+struct AcclogHeader {
+    uint16_t format_ver;
+    uint64_t device_uid;
+    uint64_t start_unix_ms;
+    uint16_t odr_hz;
+    uint16_t range_g;
+    uint16_t gyro_range_dps;    // 0x0200+
+    uint16_t imu_type;          // 0x0201+
+    uint16_t device_model;
+    float lsb_per_g;            // 0x0201+ (0: from range_g)
+    float lsb_per_dps;
+    uint32_t total_samples;
+    uint32_t dropped_samples;
+    int16_t gyro_bias[3];       // 0x0202+
+    uint16_t block_size;        // 0x03xx
+    uint8_t decim_factor;       // 0x0202+
+    uint8_t decim_taps;
+    uint8_t decim_cutoff_pct;
+    uint8_t dlpf_hz;
+};
+
+static const size_t ACCLOG_HEADER_SIZE = 64;
+// Only this far into the file is searched for the magic (decoder.MAGIC_SCAN_BYTES)
+static const size_t ACCLOG_MAGIC_SCAN = 1 << 16;
+static const uint32_t ACCLOG_CHUNK_ROWS = 1 << 18;
+static const int16_t ACCLOG_GAP_WORD = -32768;
+
+enum AcclogErr {
+    ACCLOG_OK = 0,
+    ACCLOG_E_OPEN,          // input cannot be opened / mapped
+    ACCLOG_E_NO_HEADER,     // no magic in the first ACCLOG_MAGIC_SCAN bytes (decoder.bin_to_csv() searches all)
+    ACCLOG_E_SUMMARY,       // summary log (0x0400): decoder.decode_summary()
+    ACCLOG_E_FORMAT,        // 0x03xx without a known block flag or block_size
+    ACCLOG_E_WRITE,         // output cannot be created / written
+};
+
+// Counts filled in while decoding. Plain C layout: the ctypes bindings (acclog_native.py) mirror it.
+struct AcclogStats {
+    uint64_t header_offset;
+    uint64_t samples;           // rows written
+    uint64_t gap_samples;       // rows with all channels == ACCLOG_GAP_WORD (NaN in the CSV)
+    uint64_t lost_samples;      // framed: missing between frames (filled with gap rows); trigger: not logged
+    uint64_t frames;            // framed: valid frames used
+    uint64_t segments;          // trigger: runs of consecutive sample numbers
+    double odr_measured;        // framed: sample numbers over device micros() (0 if unknown)
+    uint64_t bytes_in;          // payload bytes read
+    uint64_t bytes_out;         // CSV bytes written
+};
+
+// A mapped log; the payload starts at header_offset + ACCLOG_HEADER_SIZE
+struct AcclogFile {
+    const uint8_t* data;
+    size_t size;
+    int fd;
+    size_t header_offset;
+    AcclogHeader hdr;
+    int channels;               // 3 (0x01xx) or 6
+    double lsb_per_g;           // decoder.sample_scales()
+    double lsb_per_dps;
+};
+
+// One decoded piece: rows x channels native int16, row i is sample n[i] (n0 + i if n is null)
+struct AcclogChunk {
+    const int16_t* v;
+    const int64_t* n;
+    int64_t n0;
+    size_t rows;
+};
+
+// Called for each chunk in sample order; return false to stop (the decode then returns ACCLOG_E_WRITE)
+typedef bool (*AcclogSink)(const AcclogChunk& c, void* ctx);
+
+bool acclog_parse_header(const uint8_t* p, AcclogHeader& h);
+int acclog_open(AcclogFile& f, const char* path);
+void acclog_close(AcclogFile& f);
+// Decode every sample of f into chunks of up to chunk_rows rows (bounded memory)
+int acclog_decode(const AcclogFile& f, uint32_t chunk_rows, AcclogSink sink, void* ctx, AcclogStats& st);
+// CSV of f (decoder.bin_to_csv() layout) to out, eol after each line
+int acclog_write_csv(const AcclogFile& f, FILE* out, uint32_t chunk_rows, const char* eol, AcclogStats& st);
+
+// Kernels (SSE2 / NEON, scalar elsewhere)
+// dst[i] = src[2i] << 8 | src[2i+1]: big-endian int16 to native
+void acclog_bswap16(const uint8_t* src, int16_t* dst, size_t n);
+// dst[i] = v[i] / lsb in float32 (numpy: int16 array .astype(float32) / lsb)
+void acclog_scale_f32(const int16_t* v, size_t n, float lsb, float* dst);
+// dst[i] = v[i] / lsb in float64 (numpy: int16 array / lsb)
+void acclog_scale_f64(const int16_t* v, size_t n, double lsb, double* dst);
+
+// numpy str() of a float64 / float32 (what pandas writes): shortest round-trip digits, positional
+// between 1e-4 and 1e16 (float32: 1e6), else "1.5e-05" / "1e+16". Returns the length (no NUL).
+size_t acclog_format_f64(char* out, double v);
+size_t acclog_format_f32(char* out, float v);
+
+extern "C" {
+// in -> CSV file out (eol: "\n", or os.linesep as pandas uses). st may be null. Returns an AcclogErr.
+int acclog_csv_file(const char* in, const char* out, uint32_t chunk_rows, const char* eol, AcclogStats* st);
+const char* acclog_strerror(int err);
+}
@@ -0,0 +1,87 @@
+// acclog_decode: CSV of an ACCLOG sample log with the native decoder (same CSV as `decoder.py --csv`).
+//
+//   acclog_decode <log.bin> [out.csv|-] [--chunk ROWS] [--crlf]
+//     out.csv: default <log>.csv next to the input, "-" for stdout
+//     --chunk: rows decoded per step (memory bound, default 262144)
+//     --crlf:  "\r\n" line ends (pandas on Windows)
+// 要約ログ (0x0400) や先頭 64 KiB にヘッダの無いファイルは終了コード 3（decoder.py で変換する）。
+#include "acclog_decode.h"
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+static void print_header(const AcclogFile& f) {
+    const AcclogHeader& h = f.hdr;
+    printf("format_ver: 0x%04X\n", h.format_ver);
+    printf("device_uid: %llu\n", (unsigned long long)h.device_uid);
+    printf("start_unix_ms: %llu\n", (unsigned long long)h.start_unix_ms);
+    printf("odr_hz: %u\nrange_g: %u\ngyro_range_dps: %u\n", h.odr_hz, h.range_g, h.gyro_range_dps);
+    printf("imu_type: %u\ndevice_model: %u\n", h.imu_type, h.device_model);
+    printf("lsb_per_g: %g (used %g)\nlsb_per_dps: %g (used %g)\n", h.lsb_per_g, f.lsb_per_g, h.lsb_per_dps, f.lsb_per_dps);
+    printf("total_samples: %u\ndropped_samples: %u\n", h.total_samples, h.dropped_samples);
+    printf("gyro_bias: (%d, %d, %d)\n", h.gyro_bias[0], h.gyro_bias[1], h.gyro_bias[2]);
+    printf("block_size: %u\n", h.block_size);
+    printf("decim_factor: %u\ndecim_taps: %u\ndecim_cutoff_pct: %u\ndlpf_hz: %u\n", h.decim_factor, h.decim_taps,
+           h.decim_cutoff_pct, h.dlpf_hz);
+    printf("header_offset: %zu\n", f.header_offset);
+}
+
+int main(int argc, char** argv) {
+    const char* in = nullptr;
+    std::string out;
+    uint32_t chunk = ACCLOG_CHUNK_ROWS;
+    const char* eol = "\n";
+    bool usage = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--chunk") == 0 && i + 1 < argc) chunk = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--crlf") == 0) eol = "\r\n";
+        else if (!in) in = argv[i];
+        else if (out.empty()) out = argv[i];
+        else usage = true;
+    }
+    if (usage || !in || chunk == 0) {
+        fprintf(stderr, "usage: acclog_decode <log.bin> [out.csv|-] [--chunk ROWS] [--crlf]\n");
+        return 2;
+    }
+    if (out.empty()) {
+        out = in;
+        const size_t slash = out.find_last_of('/');
+        const size_t dot = out.find_last_of('.');
+        if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) out.erase(dot);
+        out += ".csv";
+    }
+    AcclogFile f;
+    int err = acclog_open(f, in);
+    if (err != ACCLOG_OK) {
+        fprintf(stderr, "%s: %s\n", in, acclog_strerror(err));
+        return (err == ACCLOG_E_NO_HEADER || err == ACCLOG_E_SUMMARY) ? 3 : 1;
+    }
+    const bool to_stdout = out == "-";
+    // With the CSV on stdout the header goes to stderr
+    FILE* info = to_stdout ? stderr : stdout;
+    FILE* fp = to_stdout ? stdout : fopen(out.c_str(), "wb");
+    if (!fp) {
+        fprintf(stderr, "%s: cannot create\n", out.c_str());
+        acclog_close(f);
+        return 1;
+    }
+    if (!to_stdout) print_header(f);
+    AcclogStats st;
+    err = acclog_write_csv(f, fp, chunk, eol, st);
+    if (!to_stdout && fclose(fp) != 0 && err == ACCLOG_OK) err = ACCLOG_E_WRITE;
+    acclog_close(f);
+    if (err != ACCLOG_OK) {
+        fprintf(stderr, "%s: %s\n", in, acclog_strerror(err));
+        return 1;
+    }
+    fprintf(info, "samples: %llu\ngap_samples: %llu\n", (unsigned long long)st.samples,
+            (unsigned long long)st.gap_samples);
+    if (f.hdr.format_ver >= 0x0300 && (f.hdr.format_ver & 0x02)) {
+        const bool trigger = f.hdr.format_ver & 0x04;
+        fprintf(info, "frames: %llu\nodr_measured: %.3f\n%s: %llu\n", (unsigned long long)st.frames, st.odr_measured,
+                trigger ? "skipped_samples" : "lost_samples", (unsigned long long)st.lost_samples);
+        if (trigger) fprintf(info, "segments: %llu\n", (unsigned long long)st.segments);
+    }
+    if (!to_stdout) printf("CSV written: %s\n", out.c_str());
+    return 0;
+}
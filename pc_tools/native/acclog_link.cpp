@@ -0,0 +1,538 @@
+// Serial client of the logger (acclog_link.h)
+#include "acclog_link.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <chrono>
+#include <map>
+#include <set>
+#include <thread>
+
+static const uint8_t DUMPX_SYNC[2] = { 0xA5, 0x5A };
+static const uint8_t STREAM_SYNC[2] = { 0xA5, 0x5B };
+static const size_t DUMPX_HDR = 2 + 4 + 2;
+
+static int64_t link_now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void link_sleep_ms(int ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// zlib / ROM crc32_le: reflected 0xEDB88320, init and final inversion
+static uint32_t link_crc32(const uint8_t* p, size_t n) {
+    static uint32_t table[256];
+    static bool init = false;
+    if (!init) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        init = true;
+    }
+    uint32_t c = 0xFFFFFFFFu;
+    for (size_t i = 0; i < n; ++i) c = table[(c ^ p[i]) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
+
+static uint32_t rd_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool link_speed(uint32_t baud, speed_t& sp) {
+    switch (baud) {
+        case 9600: sp = B9600; return true;
+        case 19200: sp = B19200; return true;
+        case 38400: sp = B38400; return true;
+        case 57600: sp = B57600; return true;
+        case 115200: sp = B115200; return true;
+        case 230400: sp = B230400; return true;
+#ifdef B460800
+        case 460800: sp = B460800; return true;
+#endif
+#ifdef B921600
+        case 921600: sp = B921600; return true;
+#endif
+#ifdef B1500000
+        case 1500000: sp = B1500000; return true;
+#endif
+        default: return false;
+    }
+}
+
+int acclog_link_open(AcclogLink& l, const char* path, uint32_t baud) {
+    acclog_link_close(l);
+    l.fd = ::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (l.fd < 0) return ACCLOG_LINK_E_OPEN;
+    termios t;
+    if (tcgetattr(l.fd, &t) != 0) {
+        acclog_link_close(l);
+        return ACCLOG_LINK_E_OPEN;
+    }
+    cfmakeraw(&t);
+    t.c_cflag |= CLOCAL | CREAD;
+    t.c_cflag &= ~(tcflag_t)CRTSCTS;
+    t.c_cc[VMIN] = 0;
+    t.c_cc[VTIME] = 0;
+    if (tcsetattr(l.fd, TCSANOW, &t) != 0) {
+        acclog_link_close(l);
+        return ACCLOG_LINK_E_OPEN;
+    }
+    const int err = acclog_link_set_baud(l, baud);
+    if (err != ACCLOG_LINK_OK) acclog_link_close(l);
+    return err;
+}
+
+void acclog_link_close(AcclogLink& l) {
+    if (l.fd >= 0) ::close(l.fd);
+    l.fd = -1;
+    l.rx.clear();
+}
+
+int acclog_link_set_baud(AcclogLink& l, uint32_t baud) {
+    speed_t sp;
+    termios t;
+    if (!link_speed(baud, sp) || tcgetattr(l.fd, &t) != 0) return ACCLOG_LINK_E_OPEN;
+    cfsetispeed(&t, sp);
+    cfsetospeed(&t, sp);
+    if (tcsetattr(l.fd, TCSADRAIN, &t) != 0) return ACCLOG_LINK_E_OPEN;
+    l.baud = baud;
+    return ACCLOG_LINK_OK;
+}
+
+int acclog_link_write(AcclogLink& l, const void* buf, size_t n) {
+    const uint8_t* p = static_cast<const uint8_t*>(buf);
+    while (n) {
+        const ssize_t k = ::write(l.fd, p, n);
+        if (k > 0) {
+            p += k;
+            n -= (size_t)k;
+            continue;
+        }
+        if (k < 0 && errno != EAGAIN && errno != EINTR) return ACCLOG_LINK_E_IO;
+        pollfd pf = { l.fd, POLLOUT, 0 };
+        if (poll(&pf, 1, 2000) <= 0) return ACCLOG_LINK_E_TIMEOUT;
+    }
+    return ACCLOG_LINK_OK;
+}
+
+int acclog_link_send(AcclogLink& l, const char* line) {
+    std::string s(line);
+    s += '\n';
+    return acclog_link_write(l, s.data(), s.size());
+}
+
+int acclog_link_fill(AcclogLink& l, int timeout_ms) {
+    pollfd pf = { l.fd, POLLIN, 0 };
+    const int r = poll(&pf, 1, timeout_ms);
+    if (r == 0) return ACCLOG_LINK_E_TIMEOUT;
+    if (r < 0) return (errno == EINTR) ? ACCLOG_LINK_E_TIMEOUT : ACCLOG_LINK_E_IO;
+    uint8_t buf[65536];
+    const ssize_t k = ::read(l.fd, buf, sizeof(buf));
+    if (k < 0 && (errno == EAGAIN || errno == EINTR)) return ACCLOG_LINK_E_TIMEOUT;
+    if (k <= 0) return ACCLOG_LINK_E_IO;
+    l.rx.insert(l.rx.end(), buf, buf + k);
+    return ACCLOG_LINK_OK;
+}
+
+int acclog_link_read_line(AcclogLink& l, std::string& line, int timeout_ms) {
+    const int64_t deadline = link_now_ms() + timeout_ms;
+    size_t scanned = 0;
+    for (;;) {
+        for (; scanned < l.rx.size(); ++scanned) {
+            if (l.rx[scanned] != '\n') continue;
+            size_t end = scanned;
+            if (end && l.rx[end - 1] == '\r') end--;
+            line.assign(l.rx.begin(), l.rx.begin() + (long)end);
+            l.rx.erase(l.rx.begin(), l.rx.begin() + (long)scanned + 1);
+            return ACCLOG_LINK_OK;
+        }
+        const int64_t left = deadline - link_now_ms();
+        if (left <= 0) return ACCLOG_LINK_E_TIMEOUT;
+        const int err = acclog_link_fill(l, (int)left);
+        if (err == ACCLOG_LINK_E_IO) return err;
+    }
+}
+
+void acclog_link_discard(AcclogLink& l) {
+    tcflush(l.fd, TCIFLUSH);
+    while (acclog_link_fill(l, 0) == ACCLOG_LINK_OK) {}
+    l.rx.clear();
+}
+
+int acclog_link_ping(AcclogLink& l, int attempts, int timeout_ms) {
+    for (int i = 0; i < attempts; ++i) {
+        acclog_link_discard(l);
+        int err = acclog_link_send(l, "PING");
+        if (err == ACCLOG_LINK_E_IO) return err;
+        const int64_t deadline = link_now_ms() + timeout_ms;
+        std::string line;
+        // Garbage lines (a rate change, the rest of a transfer) come first
+        while (err == ACCLOG_LINK_OK || err == ACCLOG_LINK_E_REPLY) {
+            const int64_t left = deadline - link_now_ms();
+            if (left <= 0) break;
+            err = acclog_link_read_line(l, line, (int)left);
+            if (err == ACCLOG_LINK_OK && line == "PONG") return ACCLOG_LINK_OK;
+            if (err == ACCLOG_LINK_OK) err = ACCLOG_LINK_E_REPLY;
+        }
+        if (err == ACCLOG_LINK_E_IO) return err;
+    }
+    return ACCLOG_LINK_E_TIMEOUT;
+}
+
+// Read until nothing arrives for quiet_ms (at most max_ms), dropping it
+static void link_drain(AcclogLink& l, int quiet_ms, int max_ms) {
+    const int64_t end = link_now_ms() + max_ms;
+    while (link_now_ms() < end && acclog_link_fill(l, quiet_ms) == ACCLOG_LINK_OK) {}
+    l.rx.clear();
+}
+
+int acclog_link_resync(AcclogLink& l) {
+    // The leading newline ends whatever line the device was assembling
+    int err = acclog_link_write(l, "\nX\n", 3);
+    if (err != ACCLOG_LINK_OK) return err;
+    link_drain(l, 200, 3000);
+    err = acclog_link_send(l, "STREAM OFF");
+    if (err != ACCLOG_LINK_OK) return err;
+    link_drain(l, 200, 3000);
+    return acclog_link_ping(l);
+}
+
+int acclog_link_command(AcclogLink& l, const char* cmd, const char* prefix, std::string& reply, int timeout_ms) {
+    int err = acclog_link_send(l, cmd);
+    if (err != ACCLOG_LINK_OK) return err;
+    const int64_t deadline = link_now_ms() + timeout_ms;
+    for (;;) {
+        const int64_t left = deadline - link_now_ms();
+        if (left <= 0) return ACCLOG_LINK_E_TIMEOUT;
+        err = acclog_link_read_line(l, reply, (int)left);
+        if (err != ACCLOG_LINK_OK) return err;
+        if (reply.compare(0, strlen(prefix), prefix) == 0) return ACCLOG_LINK_OK;
+        if (reply == "UNKNOWN") return ACCLOG_LINK_E_UNSUPPORTED;
+        if (reply.compare(0, 3, "ERR") == 0) return ACCLOG_LINK_E_REPLY;
+    }
+}
+
+int acclog_link_baud(AcclogLink& l, uint32_t rate) {
+    if (rate == l.baud) return ACCLOG_LINK_OK;
+    speed_t sp;
+    if (!link_speed(rate, sp)) return ACCLOG_LINK_E_OPEN;
+    const uint32_t old = l.baud;
+    acclog_link_discard(l);
+    char cmd[32];
+    snprintf(cmd, sizeof(cmd), "BAUD %u", (unsigned)rate);
+    std::string line;
+    int err = acclog_link_command(l, cmd, "BAUD SWITCH ", line);
+    if (err != ACCLOG_LINK_OK) return err;
+    unsigned got = 0, confirm_ms = 2000;
+    if (sscanf(line.c_str(), "BAUD SWITCH %u %u", &got, &confirm_ms) < 1 || got != rate) return ACCLOG_LINK_E_REPLY;
+    const int64_t deadline = link_now_ms() + confirm_ms;
+    err = acclog_link_set_baud(l, rate);
+    if (err != ACCLOG_LINK_OK) return err;
+    link_sleep_ms(ACCLOG_LINK_SETTLE_MS);
+    acclog_link_discard(l);
+    // The leading newline ends whatever the device assembled from bytes seen during the switch
+    err = acclog_link_write(l, "\nBAUD OK\n", 9);
+    if (err != ACCLOG_LINK_OK) return err;
+    snprintf(cmd, sizeof(cmd), "OK BAUD %u", (unsigned)rate);
+    for (;;) {
+        const int64_t left = deadline - link_now_ms();
+        if (left <= 0 || acclog_link_read_line(l, line, (int)left) != ACCLOG_LINK_OK) break;
+        if (line == cmd) return ACCLOG_LINK_OK;
+    }
+    // No confirmation: the device reverts at the deadline; wait for it
+    const int64_t left = deadline - link_now_ms();
+    link_sleep_ms((int)(left > 0 ? left : 0) + 200);
+    acclog_link_set_baud(l, old);
+    link_sleep_ms(ACCLOG_LINK_SETTLE_MS);
+    if (acclog_link_ping(l, 2) == ACCLOG_LINK_OK) return ACCLOG_LINK_E_TIMEOUT;
+    // Our BAUD OK arrived but its reply was lost: the device stays at the new rate
+    acclog_link_set_baud(l, rate);
+    link_sleep_ms(ACCLOG_LINK_SETTLE_MS);
+    if (acclog_link_ping(l, 2) == ACCLOG_LINK_OK) return ACCLOG_LINK_OK;
+    acclog_link_set_baud(l, old);
+    return ACCLOG_LINK_E_IO;
+}
+
+int acclog_link_dump(AcclogLink& l, uint32_t id, std::vector<uint8_t>& out) {
+    out.clear();
+    char cmd[32];
+    snprintf(cmd, sizeof(cmd), "DUMP %u", (unsigned)id);
+    std::string line;
+    int err = acclog_link_command(l, cmd, "OK ", line);
+    if (err != ACCLOG_LINK_OK) return err;
+    const size_t size = strtoul(line.c_str() + 3, nullptr, 10);
+    while (l.rx.size() < size) {
+        err = acclog_link_fill(l, 2000);
+        if (err != ACCLOG_LINK_OK) return err;
+    }
+    out.assign(l.rx.begin(), l.rx.begin() + (long)size);
+    l.rx.erase(l.rx.begin(), l.rx.begin() + (long)size);
+    // "\nDONE"
+    for (;;) {
+        err = acclog_link_read_line(l, line, 2000);
+        if (err != ACCLOG_LINK_OK) return err;
+        if (line == "DONE") return ACCLOG_LINK_OK;
+    }
+}
+
+// Whether s lies within b[from, to)
+static bool link_find(const std::vector<uint8_t>& b, size_t from, size_t to, const char* s) {
+    const size_t n = strlen(s);
+    for (size_t i = from; i + n <= to; ++i) {
+        if (memcmp(&b[i], s, n) == 0) return true;
+    }
+    return false;
+}
+
+// Good frames at the front of l.rx into `frames`; a bad one is skipped by resynchronising on the next
+// sync word. Keeps an incomplete frame (or the tail that may start one, or a trailer) for the next call.
+// Text between frames is only looked at for the trailers: DONEX / ABORTX.
+static void dumpx_parse(AcclogLink& l, uint32_t frame_size, std::map<uint32_t, std::vector<uint8_t>>& frames,
+                        AcclogDumpxStats& st, uint32_t expected, bool& done, bool& aborted) {
+    static const size_t KEEP = sizeof("ABORTX\n") - 2;
+    std::vector<uint8_t>& b = l.rx;
+    auto skipped = [&](size_t from, size_t to) {
+        if (link_find(b, from, to, "DONEX\n")) done = true;
+        if (link_find(b, from, to, "ABORTX\n")) aborted = true;
+    };
+    size_t i = 0;
+    for (;;) {
+        size_t j = i;
+        while (j + 1 < b.size() && !(b[j] == DUMPX_SYNC[0] && b[j + 1] == DUMPX_SYNC[1])) j++;
+        if (j + 1 >= b.size()) {
+            skipped(i, b.size());
+            if (b.size() - i > KEEP) i = b.size() - KEEP;
+            break;
+        }
+        skipped(i, j);
+        if (j + DUMPX_HDR > b.size()) {
+            i = j;
+            break;
+        }
+        const uint32_t seq = rd_u32(&b[j + 2]);
+        const uint32_t len = (uint32_t)b[j + 6] | ((uint32_t)b[j + 7] << 8);
+        if (len > frame_size) {
+            st.bad_frames++;
+            i = j + 1;
+            continue;
+        }
+        const size_t end = j + DUMPX_HDR + len + 4;
+        if (end > b.size()) {
+            i = j;
+            break;
+        }
+        if (link_crc32(&b[j + 2], 6 + len) != rd_u32(&b[end - 4])) {
+            st.bad_frames++;
+            i = j + 1;
+            continue;
+        }
+        if (seq < expected || frames.count(seq)) {
+            st.duplicates++;
+        } else {
+            frames[seq].assign(b.begin() + (long)(j + DUMPX_HDR), b.begin() + (long)(j + DUMPX_HDR + len));
+        }
+        i = end;
+    }
+    b.erase(b.begin(), b.begin() + (long)i);
+}
+
+int acclog_link_dumpx(AcclogLink& l, uint32_t id, std::vector<uint8_t>& out, AcclogDumpxStats& st, uint32_t length,
+                      AcclogDumpxProgress progress, void* ctx) {
+    st = {};
+    const uint32_t have = (uint32_t)out.size();
+    if (length && have >= length) return ACCLOG_LINK_OK;
+    char cmd[48];
+    snprintf(cmd, sizeof(cmd), "DUMPX %u %u %u", (unsigned)have, (unsigned)(length ? length - have : 0), (unsigned)id);
+    std::string line;
+    int err = acclog_link_command(l, cmd, "OKX ", line);
+    if (err != ACCLOG_LINK_OK) return err;
+    unsigned size = 0, offset = 0, len = 0, frame_size = 0, window = 0, dev_ms = 0;
+    if (sscanf(line.c_str(), "OKX %u %u %u %u %u %u", &size, &offset, &len, &frame_size, &window, &dev_ms) != 6
+        || frame_size == 0) {
+        return ACCLOG_LINK_E_REPLY;
+    }
+    st.file_size = size;
+    st.offset = offset;
+    st.device_ms = dev_ms;
+    // A file shorter than what we have (another log, caller's check skipped): keep the device's view
+    out.resize(offset);
+    const uint32_t nframes = (len + frame_size - 1) / frame_size;
+    std::map<uint32_t, std::vector<uint8_t>> pending;
+    std::set<uint32_t> nacked;
+    uint32_t expected = 0;
+    int stalls = 0;
+    bool done = false, aborted = false;
+    while (expected < nframes) {
+        err = acclog_link_fill(l, ACCLOG_DUMPX_READ_TIMEOUT_MS);
+        if (err == ACCLOG_LINK_E_IO) return err;
+        if (err == ACCLOG_LINK_E_TIMEOUT) {
+            st.stalls++;
+            if (++stalls > ACCLOG_DUMPX_MAX_STALLS) {
+                acclog_link_send(l, "X");
+                return ACCLOG_LINK_E_TIMEOUT;
+            }
+            snprintf(cmd, sizeof(cmd), "N %u", (unsigned)expected);
+            if ((err = acclog_link_send(l, cmd)) != ACCLOG_LINK_OK) return err;
+            st.nacks++;
+            continue;
+        }
+        stalls = 0;
+        const uint32_t dups = st.duplicates;
+        dumpx_parse(l, frame_size, pending, st, expected, done, aborted);
+        if (aborted) {
+            l.rx.clear();
+            return ACCLOG_LINK_E_ABORTED;
+        }
+        // A frame we had came again: our ACK was lost (the device resends its oldest frame), say it again
+        bool ack = st.duplicates != dups;
+        for (auto it = pending.find(expected); it != pending.end(); it = pending.find(expected)) {
+            out.insert(out.end(), it->second.begin(), it->second.end());
+            pending.erase(it);
+            nacked.erase(expected);
+            expected++;
+            st.frames++;
+            ack = true;
+            if (progress && !progress(ctx, out.size(), size)) return ACCLOG_LINK_E_CANCELLED;
+        }
+        if (ack) {
+            snprintf(cmd, sizeof(cmd), "A %u", (unsigned)expected);
+            if ((err = acclog_link_send(l, cmd)) != ACCLOG_LINK_OK) return err;
+        }
+        // Later frames arrived but an earlier one is missing: ask for just that one
+        if (!pending.empty() && !nacked.count(expected)) {
+            nacked.insert(expected);
+            snprintf(cmd, sizeof(cmd), "N %u", (unsigned)expected);
+            if ((err = acclog_link_send(l, cmd)) != ACCLOG_LINK_OK) return err;
+            st.nacks++;
+        }
+    }
+    // Frames resent before our last ACK arrived may come ahead of the trailer
+    const int64_t deadline = link_now_ms() + 2000;
+    while (!done && !aborted) {
+        const int64_t left = deadline - link_now_ms();
+        if (left <= 0 || acclog_link_fill(l, (int)left) == ACCLOG_LINK_E_IO) break;
+        const uint32_t dups = st.duplicates;
+        dumpx_parse(l, frame_size, pending, st, expected, done, aborted);
+        // The last ACK was lost
+        if (st.duplicates != dups) {
+            snprintf(cmd, sizeof(cmd), "A %u", (unsigned)expected);
+            acclog_link_send(l, cmd);
+        }
+    }
+    l.rx.clear();
+    return ACCLOG_LINK_OK;
+}
+
+static void stream_parse(const uint8_t* b, size_t n, size_t& used, int channels, AcclogStreamStats& st,
+                         int& last_seq, AcclogStreamSample cb, void* ctx) {
+    const size_t size = 2 + 2 + 2 * (size_t)channels + 1;
+    size_t i = 0;
+    for (;;) {
+        size_t j = i;
+        while (j + 1 < n && !(b[j] == STREAM_SYNC[0] && b[j + 1] == STREAM_SYNC[1])) j++;
+        if (j + 1 >= n) {
+            i = (j < n && b[j] == STREAM_SYNC[0]) ? j : n;
+            break;
+        }
+        if (j + size > n) {
+            i = j;
+            break;
+        }
+        uint8_t x = 0;
+        for (size_t k = j + 2; k < j + size - 1; ++k) x ^= b[k];
+        if (x != b[j + size - 1]) {
+            st.bad_frames++;
+            i = j + 1;
+            continue;
+        }
+        const uint16_t seq = (uint16_t)(b[j + 2] | (b[j + 3] << 8));
+        if (last_seq >= 0) st.missing += (uint16_t)(seq - (uint16_t)last_seq - 1);
+        last_seq = seq;
+        st.frames++;
+        if (cb) {
+            int16_t v[6];
+            for (int c = 0; c < channels; ++c) v[c] = (int16_t)(b[j + 4 + 2 * c] | (b[j + 5 + 2 * c] << 8));
+            cb(ctx, seq, v, channels);
+        }
+        i = j + size;
+    }
+    used = i;
+}
+
+int acclog_link_stream(AcclogLink& l, double seconds, uint16_t decim, uint8_t mask, AcclogStreamStats& st,
+                       AcclogStreamSample cb, void* ctx) {
+    st = {};
+    mask &= 0x3F;
+    if (!mask) mask = 0x3F;
+    int channels = 0;
+    for (int i = 0; i < 6; ++i) channels += (mask >> i) & 1;
+    char cmd[32];
+    snprintf(cmd, sizeof(cmd), "STREAM %u %x", (unsigned)decim, (unsigned)mask);
+    std::string line;
+    int err = acclog_link_command(l, cmd, "OK STREAM", line);
+    if (err != ACCLOG_LINK_OK) return err;
+    int last_seq = -1;
+    const auto t0 = std::chrono::steady_clock::now();
+    const int64_t end = link_now_ms() + (int64_t)(seconds * 1000.0);
+    while (link_now_ms() < end) {
+        const size_t before = l.rx.size();
+        err = acclog_link_fill(l, 200);
+        if (err == ACCLOG_LINK_E_IO) return err;
+        st.rx_bytes += l.rx.size() - before;
+        size_t used = 0;
+        stream_parse(l.rx.data(), l.rx.size(), used, channels, st, last_seq, cb, ctx);
+        l.rx.erase(l.rx.begin(), l.rx.begin() + (long)used);
+    }
+    st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    if ((err = acclog_link_send(l, "STREAM OFF")) != ACCLOG_LINK_OK) return err;
+    // Frames still on their way come before the reply: keep everything until it is complete
+    static const char REPLY[] = "OK STREAM frames:";
+    const int64_t deadline = link_now_ms() + 2000;
+    for (;;) {
+        size_t k = 0;
+        while (k + sizeof(REPLY) - 1 <= l.rx.size() && memcmp(&l.rx[k], REPLY, sizeof(REPLY) - 1) != 0) k++;
+        if (k + sizeof(REPLY) - 1 > l.rx.size()) k = l.rx.size();
+        size_t nl = k;
+        while (nl < l.rx.size() && l.rx[nl] != '\n') nl++;
+        if (nl < l.rx.size()) {
+            size_t used = 0;
+            stream_parse(l.rx.data(), k, used, channels, st, last_seq, cb, ctx);
+            const std::string reply(l.rx.begin() + (long)k, l.rx.begin() + (long)nl);
+            unsigned frames = 0, dropped = 0;
+            sscanf(reply.c_str(), "OK STREAM frames:%u dropped:%u", &frames, &dropped);
+            st.device_frames = frames;
+            st.device_dropped = dropped;
+            l.rx.erase(l.rx.begin(), l.rx.begin() + (long)nl + 1);
+            return ACCLOG_LINK_OK;
+        }
+        const int64_t left = deadline - link_now_ms();
+        if (left <= 0) return ACCLOG_LINK_E_TIMEOUT;
+        const size_t before = l.rx.size();
+        err = acclog_link_fill(l, (int)left);
+        if (err == ACCLOG_LINK_E_IO) return err;
+        st.rx_bytes += l.rx.size() - before;
+    }
+}
+
+const char* acclog_link_strerror(int err) {
+    switch (err) {
+        case ACCLOG_LINK_OK: return "ok";
+        case ACCLOG_LINK_E_OPEN: return "cannot open / configure the port";
+        case ACCLOG_LINK_E_IO: return "read / write failed";
+        case ACCLOG_LINK_E_TIMEOUT: return "no answer in time";
+        case ACCLOG_LINK_E_REPLY: return "unexpected answer";
+        case ACCLOG_LINK_E_UNSUPPORTED: return "command not supported by the firmware";
+        case ACCLOG_LINK_E_ABORTED: return "transfer aborted by the device";
+        case ACCLOG_LINK_E_CANCELLED: return "cancelled";
+        default: return "unknown error";
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+// Serial client of the logger (the protocol serial_common.py speaks): PING, the BAUD switch-and-confirm
+// handshake, the raw DUMP, the framed DUMPX with selective retransmission and resume, and the live STREAM
+// receiver. POSIX tty (Linux / macOS), raw 8N1.
+// 各関数はファームウェア側（serial_proto.h / stream_out.h）のコメントにある書式どおりに話す。
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// The logger's UART rates (config.h SERIAL_BAUD_RATES; INFO "baud_rates" has the device's own list)
+static const uint32_t ACCLOG_LINK_RATES[] = { 115200, 230400, 460800, 921600, 1500000 };
+static const uint32_t ACCLOG_LINK_DEFAULT_BAUD = 115200;
+// Time the tty is given after a rate change before anything is sent (serial_common.BAUD_SETTLE_SEC)
+static const int ACCLOG_LINK_SETTLE_MS = 50;
+// DUMPX: no data for this long NACKs the oldest missing frame; that many such stalls in a row give up
+static const int ACCLOG_DUMPX_READ_TIMEOUT_MS = 500;
+static const int ACCLOG_DUMPX_MAX_STALLS = 20;
+
+enum AcclogLinkErr {
+    ACCLOG_LINK_OK = 0,
+    ACCLOG_LINK_E_OPEN,         // port cannot be opened / configured
+    ACCLOG_LINK_E_IO,           // read / write failed (port gone)
+    ACCLOG_LINK_E_TIMEOUT,      // no (complete) answer in time
+    ACCLOG_LINK_E_REPLY,        // unexpected answer ("ERR", another command's output)
+    ACCLOG_LINK_E_UNSUPPORTED,  // "UNKNOWN": older firmware without the command
+    ACCLOG_LINK_E_ABORTED,      // the device gave up ("ABORTX"); call again to resume
+    ACCLOG_LINK_E_CANCELLED,    // the progress callback stopped the transfer
+};
+
+struct AcclogLink {
+    int fd = -1;
+    uint32_t baud = 0;
+    std::vector<uint8_t> rx;    // received, not consumed yet
+};
+
+// Open the port at `baud` (raw, no flow control)
+int acclog_link_open(AcclogLink& l, const char* path, uint32_t baud = ACCLOG_LINK_DEFAULT_BAUD);
+void acclog_link_close(AcclogLink& l);
+// This end only (the device is moved with acclog_link_baud())
+int acclog_link_set_baud(AcclogLink& l, uint32_t baud);
+int acclog_link_write(AcclogLink& l, const void* buf, size_t n);
+int acclog_link_send(AcclogLink& l, const char* line);   // line + "\n"
+// Append what arrives within timeout_ms to l.rx (returns as soon as something did)
+int acclog_link_fill(AcclogLink& l, int timeout_ms);
+// Next "\n"-terminated line without the line end; bytes before it (binary output) are part of it
+int acclog_link_read_line(AcclogLink& l, std::string& line, int timeout_ms);
+// Drop pending input: the tty's and l.rx
+void acclog_link_discard(AcclogLink& l);
+// PING until "PONG" (attempts x timeout_ms)
+int acclog_link_ping(AcclogLink& l, int attempts = 5, int timeout_ms = 1000);
+// Leave a transfer the device may still be in ("X" ends a DUMPX, STREAM OFF a stream), then PING
+int acclog_link_resync(AcclogLink& l);
+// Command line whose answer is the next line starting with `prefix` (other lines are skipped)
+int acclog_link_command(AcclogLink& l, const char* cmd, const char* prefix, std::string& reply,
+                        int timeout_ms = 1000);
+
+// Move the link to `rate`: BAUD <rate>, both ends switch, BAUD OK at the new rate. Without the
+// confirmation the device reverts by itself after the time it announced; then this end goes back too and
+// the result is ACCLOG_LINK_E_TIMEOUT with the link working at the old rate (E_IO if it works at neither).
+int acclog_link_baud(AcclogLink& l, uint32_t rate);
+
+// Raw DUMP of session `id` (0 = newest): "OK <size> <millis>", size bytes, "\nDONE"
+int acclog_link_dump(AcclogLink& l, uint32_t id, std::vector<uint8_t>& out);
+
+struct AcclogDumpxStats {
+    uint32_t file_size;         // of the session on the device
+    uint32_t offset;            // where this transfer started (bytes already in `out`)
+    uint32_t frames;            // good frames kept
+    uint32_t bad_frames;        // skipped: CRC / length errors, resynchronised on the next sync word
+    uint32_t duplicates;        // good frames already had (resent after a lost ACK: the ACK is repeated)
+    uint32_t nacks;             // "N <seq>" sent
+    uint32_t stalls;            // read timeouts
+    uint32_t device_ms;         // device millis() in the OKX line
+};
+// Called after each frame written to `out`; return false to stop at once (a dropped link: nothing is sent)
+typedef bool (*AcclogDumpxProgress)(void* ctx, size_t have, size_t total);
+// DUMPX of session `id` (0 = newest) from out.size() to the end of the file, appended to `out`. `length`
+// (0 = to the end) limits the range. The caller checks that bytes already in `out` belong to the same log
+// (HEAD). After E_ABORTED / E_TIMEOUT / E_IO / E_CANCELLED `out` holds every byte received in order: call
+// acclog_link_resync() and this again to resume.
+int acclog_link_dumpx(AcclogLink& l, uint32_t id, std::vector<uint8_t>& out, AcclogDumpxStats& st,
+                      uint32_t length = 0, AcclogDumpxProgress progress = nullptr, void* ctx = nullptr);
+
+struct AcclogStreamStats {
+    uint64_t frames;            // good frames received
+    uint64_t missing;           // gaps in the sequence numbers (dropped on the device or lost on the link)
+    uint64_t bad_frames;        // checksum errors
+    uint64_t rx_bytes;
+    double seconds;
+    uint32_t device_frames;     // "OK STREAM frames:<n> dropped:<n>" at STREAM OFF
+    uint32_t device_dropped;
+};
+// Called for each sample: seq and the popcount(mask) channel values (ax..gz order)
+typedef void (*AcclogStreamSample)(void* ctx, uint16_t seq, const int16_t* v, int channels);
+// STREAM <decim> <mask> for `seconds` (the device records), then STREAM OFF. Everything up to the OFF
+// reply is parsed, so frames == device_frames on a clean link.
+int acclog_link_stream(AcclogLink& l, double seconds, uint16_t decim, uint8_t mask, AcclogStreamStats& st,
+                       AcclogStreamSample cb = nullptr, void* ctx = nullptr);
+
+const char* acclog_link_strerror(int err);
@@ -0,0 +1,160 @@
+// acclog_link: the logger's serial commands from C++ (acclog_link.h), what serial_common.py does for the GUI.
+//
+//   acclog_link <port> [--baud B] [--fast-baud F] ping | info | baud RATE
+//   acclog_link <port> [--baud B] [--fast-baud F] dump OUT [--session N] [--raw]
+//   acclog_link <port> [--baud B] [--fast-baud F] stream SECONDS [--decim D] [--mask HEX]
+//     --baud: the device's current rate (default 115200); --fast-baud: BAUD to this rate first
+//     dump: DUMPX into OUT.part, renamed to OUT when complete. A .part left by a cut link is resumed when its
+//           first 64 bytes match HEAD of the session on the device. --raw: plain DUMP (firmware without DUMPX).
+//     stream: STREAM D MASK for SECONDS, one CSV line per sample (seq, channels) on stdout
+// 統計（転送時間・kB/s・NACK 数・取りこぼし）は stderr に出す。
+#include "acclog_link.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+
+static int fail(const char* what, int err) {
+    fprintf(stderr, "%s: %s\n", what, acclog_link_strerror(err));
+    return 1;
+}
+
+static void hex(const uint8_t* p, size_t n, std::string& out) {
+    static const char* digits = "0123456789abcdef";
+    out.clear();
+    for (size_t i = 0; i < n; ++i) {
+        out += digits[p[i] >> 4];
+        out += digits[p[i] & 15];
+    }
+}
+
+static bool read_file(const std::string& path, std::vector<uint8_t>& out) {
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (!fp) return false;
+    uint8_t buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) out.insert(out.end(), buf, buf + n);
+    fclose(fp);
+    return true;
+}
+
+static bool write_file(const std::string& path, const std::vector<uint8_t>& data) {
+    FILE* fp = fopen(path.c_str(), "wb");
+    if (!fp) return false;
+    const bool ok = fwrite(data.data(), 1, data.size(), fp) == data.size();
+    return fclose(fp) == 0 && ok;
+}
+
+static void print_sample(void*, uint16_t seq, const int16_t* v, int channels) {
+    printf("%u", (unsigned)seq);
+    for (int i = 0; i < channels; ++i) printf(",%d", v[i]);
+    printf("\n");
+}
+
+static int cmd_dump(AcclogLink& l, const std::string& out, uint32_t session, bool raw) {
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<uint8_t> data;
+    int err;
+    if (raw) {
+        err = acclog_link_dump(l, session, data);
+        if (err != ACCLOG_LINK_OK) return fail("DUMP", err);
+    } else {
+        const std::string part = out + ".part";
+        if (read_file(part, data) && !data.empty()) {
+            // Resume only if the partial file belongs to the log on the device
+            char cmd[32];
+            snprintf(cmd, sizeof(cmd), "HEAD %u", (unsigned)session);
+            std::string reply, local;
+            hex(data.data(), data.size() < 64 ? data.size() : 64, local);
+            if (acclog_link_command(l, cmd, "HEAD ", reply) != ACCLOG_LINK_OK || reply.substr(5) != local) {
+                fprintf(stderr, "partial file is from another log; starting over\n");
+                data.clear();
+            }
+        }
+        AcclogDumpxStats st;
+        err = acclog_link_dumpx(l, session, data, st);
+        if (err != ACCLOG_LINK_OK) {
+            // What arrived in order is kept for the next run
+            write_file(part, data);
+            fprintf(stderr, "DUMPX stopped at %zu/%u; rerun to resume\n", data.size(), (unsigned)st.file_size);
+            return fail("DUMPX", err);
+        }
+        fprintf(stderr, "resumed_from: %u\nframes: %u\nbad_frames: %u\nduplicates: %u\nnacks: %u\n",
+                (unsigned)st.offset, (unsigned)st.frames, (unsigned)st.bad_frames, (unsigned)st.duplicates,
+                (unsigned)st.nacks);
+        remove(part.c_str());
+    }
+    if (!write_file(out, data)) {
+        fprintf(stderr, "%s: cannot write\n", out.c_str());
+        return 1;
+    }
+    const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    fprintf(stderr, "bytes: %zu\nseconds: %.2f\nkB_s: %.1f\nbaud: %u\n", data.size(), s,
+            s > 0 ? data.size() / 1024.0 / s : 0.0, (unsigned)l.baud);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    const char* port = nullptr;
+    const char* cmd = nullptr;
+    const char* arg = nullptr;
+    uint32_t baud = ACCLOG_LINK_DEFAULT_BAUD, fast = 0, session = 0;
+    unsigned decim = 1, mask = 0x3F;
+    bool raw = false, usage = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--baud") == 0 && i + 1 < argc) baud = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--fast-baud") == 0 && i + 1 < argc) fast = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--session") == 0 && i + 1 < argc) session = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--decim") == 0 && i + 1 < argc) decim = (unsigned)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--mask") == 0 && i + 1 < argc) mask = (unsigned)strtoul(argv[++i], nullptr, 16);
+        else if (strcmp(argv[i], "--raw") == 0) raw = true;
+        else if (!port) port = argv[i];
+        else if (!cmd) cmd = argv[i];
+        else if (!arg) arg = argv[i];
+        else usage = true;
+    }
+    const bool needs_arg = cmd && (!strcmp(cmd, "baud") || !strcmp(cmd, "dump") || !strcmp(cmd, "stream"));
+    if (usage || !cmd || (needs_arg && !arg)) {
+        fprintf(stderr, "usage: acclog_link <port> [--baud B] [--fast-baud F] ping | info | baud RATE |\n"
+                        "       dump OUT [--session N] [--raw] | stream SECONDS [--decim D] [--mask HEX]\n");
+        return 2;
+    }
+    AcclogLink l;
+    int err = acclog_link_open(l, port, baud);
+    if (err != ACCLOG_LINK_OK) return fail(port, err);
+    if ((err = acclog_link_ping(l)) != ACCLOG_LINK_OK) return fail("PING", err);
+    if (fast && (err = acclog_link_baud(l, fast)) != ACCLOG_LINK_OK) {
+        // Reverted: the transfer still works at the old rate
+        fprintf(stderr, "BAUD %u: %s, staying at %u\n", (unsigned)fast, acclog_link_strerror(err), (unsigned)l.baud);
+        if (err != ACCLOG_LINK_E_TIMEOUT) return 1;
+    }
+    int rc = 0;
+    std::string reply;
+    if (!strcmp(cmd, "ping")) {
+        printf("PONG\n");
+    } else if (!strcmp(cmd, "info")) {
+        if ((err = acclog_link_command(l, "INFO", "{", reply)) != ACCLOG_LINK_OK) return fail("INFO", err);
+        printf("%s\n", reply.c_str());
+    } else if (!strcmp(cmd, "baud")) {
+        err = acclog_link_baud(l, (uint32_t)strtoul(arg, nullptr, 10));
+        printf("baud: %u\n", (unsigned)l.baud);
+        if (err != ACCLOG_LINK_OK) rc = fail("BAUD", err);
+    } else if (!strcmp(cmd, "dump")) {
+        rc = cmd_dump(l, arg, session, raw);
+    } else if (!strcmp(cmd, "stream")) {
+        AcclogStreamStats st;
+        err = acclog_link_stream(l, atof(arg), (uint16_t)decim, (uint8_t)mask, st, print_sample);
+        if (err != ACCLOG_LINK_OK) return fail("STREAM", err);
+        fprintf(stderr, "frames: %llu\nmissing: %llu\nbad_frames: %llu\ndevice_frames: %u\ndevice_dropped: %u\n"
+                        "kB_s: %.1f\n",
+                (unsigned long long)st.frames, (unsigned long long)st.missing, (unsigned long long)st.bad_frames,
+                (unsigned)st.device_frames, (unsigned)st.device_dropped,
+                st.seconds > 0 ? st.rx_bytes / 1024.0 / st.seconds : 0.0);
+    } else {
+        fprintf(stderr, "unknown command %s\n", cmd);
+        rc = 2;
+    }
+    acclog_link_close(l);
+    return rc;
+}
@@ -0,0 +1,281 @@
+// Benchmark of the native decoder on synthetic logs: raw 0x0202 (12 bytes per sample) and framed,
+// compressed 0x0303 (4096-byte blocks, CRC32) of the given sizes, written to --dir and removed after.
+// 各サイズで子プロセスを起こし、(1) 変換のみ（バイトスワップ + スケールの SIMD カーネル、出力なし）と
+// (2) CSV 書き出し（/dev/null へ）を計る。ピーク RSS は子プロセスの ru_maxrss。
+// 生成直後のファイルはページキャッシュに載っているので、ディスクではなく CPU 側の速度になる。
+//
+//   bench_acclog_decode [--sizes 1M,64M,1G,4G] [--format raw|framed|all] [--dir /tmp] [--chunk ROWS]
+// 出力（サイズ・形式ごとに 1 行）:
+//   BENCH fmt:0x<ver> bytes:<n> samples:<n> convert_gbps:<g> convert_rss_mb:<m> csv_gbps:<g>
+//         csv_mb:<m> csv_rss_mb:<m> OK|MISMATCH
+//   gbps は入力ファイルのバイト数 / 秒、csv_mb は書き出した CSV の大きさ。
+// 復号したサンプル数が生成した数と違えば終了コード 1。
+#include "acclog_decode.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+static const size_t BENCH_BLOCK = 4096;   // firmware LOG_BUF_SIZE
+
+static double bench_now() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint32_t s_rng = 1;
+static inline uint32_t bench_rand() {
+    s_rng = s_rng * 1664525u + 1013904223u;
+    return s_rng >> 8;
+}
+
+// Device lying still with noise, and now and then a shake (varint lengths vary like real logs)
+static void bench_sample(int16_t* v, uint64_t i) {
+    const bool shake = (i / 2000) % 10 == 0;
+    const int amp = shake ? 4000 : 24;
+    for (int c = 0; c < 6; ++c) v[c] = (int16_t)((c == 2 ? 4096 : 0) + (int)(bench_rand() % (2 * amp + 1)) - amp);
+}
+
+static void bench_put_le(uint8_t* p, uint32_t v, int n) {
+    for (int i = 0; i < n; ++i) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint32_t bench_crc32(const uint8_t* p, size_t n) {
+    static uint32_t table[256];
+    if (!table[1]) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+    }
+    uint32_t c = 0xFFFFFFFFu;
+    while (n--) c = table[(c ^ *p++) & 0xFF] ^ (c >> 8);
+    return ~c;
+}
+
+static void bench_header(uint8_t* h, uint16_t fmt) {
+    memset(h, 0, ACCLOG_HEADER_SIZE);
+    memcpy(h, "ACCLOG", 6);
+    bench_put_le(h + 8, fmt, 2);
+    bench_put_le(h + 26, 200, 2);       // odr_hz
+    bench_put_le(h + 28, 8, 2);         // range_g
+    bench_put_le(h + 30, 2000, 2);      // gyro_range_dps
+    bench_put_le(h + 32, 2, 2);         // imu_type MPU6886
+    const float lsb_g = 4096.0f, lsb_dps = 16.4f;
+    memcpy(h + 36, &lsb_g, 4);
+    memcpy(h + 40, &lsb_dps, 4);
+    if (fmt >= 0x0300) bench_put_le(h + 58, BENCH_BLOCK, 2);
+}
+
+// Synthetic log of about `bytes` bytes; returns the number of samples written (0 on error)
+static uint64_t bench_make_log(const char* path, uint16_t fmt, uint64_t bytes) {
+    FILE* fp = fopen(path, "wb");
+    if (!fp) return 0;
+    uint8_t h[ACCLOG_HEADER_SIZE];
+    bench_header(h, fmt);
+    fwrite(h, 1, sizeof(h), fp);
+    std::vector<uint8_t> buf(1 << 20);
+    size_t pos = 0;
+    uint64_t written = ACCLOG_HEADER_SIZE, samples = 0;
+    int16_t v[6];
+    s_rng = 1;
+    if (fmt == 0x0202) {
+        while (written + 12 <= bytes) {
+            bench_sample(v, samples++);
+            for (int c = 0; c < 6; ++c) {
+                buf[pos++] = (uint8_t)((uint16_t)v[c] >> 8);
+                buf[pos++] = (uint8_t)v[c];
+            }
+            written += 12;
+            if (pos + 12 > buf.size()) {
+                fwrite(buf.data(), 1, pos, fp);
+                pos = 0;
+            }
+        }
+    } else {
+        // log_codec.h: one block per LOG_BUF_SIZE, zigzag varint deltas, CRC32 from first_sample
+        uint8_t blk[BENCH_BLOCK];
+        while (written + BENCH_BLOCK <= bytes) {
+            memset(blk, 0, sizeof(blk));
+            size_t p = 20;
+            uint16_t count = 0;
+            int16_t prev[6] = { 0, 0, 0, 0, 0, 0 };
+            const uint64_t first = samples;
+            while (p + 18 <= BENCH_BLOCK) {
+                bench_sample(v, samples++);
+                for (int c = 0; c < 6; ++c) {
+                    const int16_t d = (int16_t)(uint16_t)(v[c] - prev[c]);
+                    uint16_t zz = (uint16_t)(((uint16_t)d << 1) ^ (uint16_t)(d >> 15));
+                    while (zz >= 0x80) {
+                        blk[p++] = (uint8_t)(zz | 0x80);
+                        zz >>= 7;
+                    }
+                    blk[p++] = (uint8_t)zz;
+                    prev[c] = v[c];
+                }
+                count++;
+            }
+            memcpy(blk, "ABLK", 4);
+            bench_put_le(blk + 8, (uint32_t)first, 4);
+            bench_put_le(blk + 12, (uint32_t)(first * 5000), 4);   // micros() at 200 Hz
+            bench_put_le(blk + 16, count, 2);
+            bench_put_le(blk + 18, (uint32_t)(p - 20), 2);
+            bench_put_le(blk + 4, bench_crc32(blk + 8, p - 8), 4);
+            memcpy(buf.data() + pos, blk, BENCH_BLOCK);
+            pos += BENCH_BLOCK;
+            written += BENCH_BLOCK;
+            if (pos + BENCH_BLOCK > buf.size()) {
+                fwrite(buf.data(), 1, pos, fp);
+                pos = 0;
+            }
+        }
+    }
+    fwrite(buf.data(), 1, pos, fp);
+    if (fclose(fp) != 0) return 0;
+    return samples;
+}
+
+// Convert-only sink: every chunk through the scale kernels, results folded into a checksum
+struct BenchConvert {
+    const AcclogFile* f;
+    std::vector<int16_t> split[2];
+    std::vector<double> acc;
+    std::vector<float> gyro;
+    double sum;
+};
+
+static bool bench_convert_sink(const AcclogChunk& c, void* ctx) {
+    BenchConvert& b = *(BenchConvert*)ctx;
+    const int nc = b.f->channels;
+    // Rows are interleaved (ax ay az gx gy gz); the kernels take the acc and gyro halves
+    b.split[0].resize(c.rows * 3);
+    b.split[1].resize(c.rows * 3);
+    for (size_t r = 0; r < c.rows; ++r) {
+        memcpy(&b.split[0][r * 3], c.v + r * nc, 3 * sizeof(int16_t));
+        if (nc == 6) memcpy(&b.split[1][r * 3], c.v + r * nc + 3, 3 * sizeof(int16_t));
+    }
+    b.acc.resize(c.rows * 3);
+    b.gyro.resize(c.rows * 3);
+    acclog_scale_f64(b.split[0].data(), c.rows * 3, b.f->lsb_per_g, b.acc.data());
+    if (nc == 6) acclog_scale_f32(b.split[1].data(), c.rows * 3, (float)b.f->lsb_per_dps, b.gyro.data());
+    b.sum += b.acc[c.rows * 3 - 1] + b.gyro[c.rows * 3 - 1];
+    return true;
+}
+
+struct BenchResult {
+    double seconds;
+    uint64_t samples;
+    uint64_t bytes_out;
+    int err;
+};
+
+// Run one pass in a child process; rss_mb: its peak resident size
+static BenchResult bench_run(const char* path, bool csv, uint32_t chunk, double& rss_mb) {
+    BenchResult r = { 0, 0, 0, -1 };
+    int fds[2];
+    if (pipe(fds) != 0) return r;
+    const pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        BenchResult c = { 0, 0, 0, 0 };
+        AcclogFile f;
+        AcclogStats st;
+        const double t0 = bench_now();
+        c.err = acclog_open(f, path);
+        if (c.err == ACCLOG_OK) {
+            if (csv) {
+                FILE* out = fopen("/dev/null", "wb");
+                c.err = acclog_write_csv(f, out, chunk, "\n", st);
+                fclose(out);
+            } else {
+                BenchConvert b;
+                b.f = &f;
+                b.sum = 0;
+                c.err = acclog_decode(f, chunk, bench_convert_sink, &b, st);
+                if (isnan(b.sum)) c.err = -2;
+            }
+            acclog_close(f);
+        }
+        c.seconds = bench_now() - t0;
+        c.samples = st.samples;
+        c.bytes_out = st.bytes_out;
+        if (write(fds[1], &c, sizeof(c)) != (ssize_t)sizeof(c)) _exit(1);
+        _exit(0);
+    }
+    close(fds[1]);
+    if (pid > 0 && read(fds[0], &r, sizeof(r)) != (ssize_t)sizeof(r)) r.err = -1;
+    close(fds[0]);
+    int status = 0;
+    struct rusage ru;
+    memset(&ru, 0, sizeof(ru));
+    if (pid > 0) wait4(pid, &status, 0, &ru);
+    rss_mb = ru.ru_maxrss / 1024.0;   // KiB on Linux
+    return r;
+}
+
+static uint64_t bench_parse_size(const char* s) {
+    char* end;
+    double v = strtod(s, &end);
+    if (*end == 'K' || *end == 'k') v *= 1024;
+    else if (*end == 'M' || *end == 'm') v *= 1024 * 1024;
+    else if (*end == 'G' || *end == 'g') v *= 1024.0 * 1024 * 1024;
+    return (uint64_t)v;
+}
+
+int main(int argc, char** argv) {
+    std::string sizes = "1M,64M";
+    std::string format = "all";
+    std::string dir = "/tmp";
+    uint32_t chunk = ACCLOG_CHUNK_ROWS;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--sizes") == 0) sizes = argv[i + 1];
+        else if (strcmp(argv[i], "--format") == 0) format = argv[i + 1];
+        else if (strcmp(argv[i], "--dir") == 0) dir = argv[i + 1];
+        else if (strcmp(argv[i], "--chunk") == 0) chunk = (uint32_t)strtoul(argv[i + 1], nullptr, 10);
+    }
+    std::vector<uint16_t> fmts;
+    if (format == "raw" || format == "all") fmts.push_back(0x0202);
+    if (format == "framed" || format == "all") fmts.push_back(0x0303);
+    bool ok = true;
+    for (uint16_t fmt : fmts) {
+        size_t p = 0;
+        while (p < sizes.size()) {
+            size_t q = sizes.find(',', p);
+            if (q == std::string::npos) q = sizes.size();
+            const uint64_t bytes = bench_parse_size(sizes.substr(p, q - p).c_str());
+            p = q + 1;
+            char path[512];
+            snprintf(path, sizeof(path), "%s/bench_acclog_%04x_%d.bin", dir.c_str(), fmt, (int)getpid());
+            const uint64_t samples = bench_make_log(path, fmt, bytes);
+            if (!samples) {
+                printf("cannot write %s\n", path);
+                remove(path);
+                return 1;
+            }
+            FILE* fp = fopen(path, "rb");
+            fseek(fp, 0, SEEK_END);
+            const double size = (double)ftell(fp);
+            fclose(fp);
+            double rss_conv = 0, rss_csv = 0;
+            const BenchResult conv = bench_run(path, false, chunk, rss_conv);
+            const BenchResult csv = bench_run(path, true, chunk, rss_csv);
+            remove(path);
+            const bool match = conv.err == 0 && csv.err == 0 && conv.samples == samples && csv.samples == samples;
+            ok = ok && match;
+            printf("BENCH fmt:0x%04X bytes:%.0f samples:%llu convert_gbps:%.3f convert_rss_mb:%.1f csv_gbps:%.3f "
+                   "csv_mb:%.1f csv_rss_mb:%.1f %s\n",
+                   fmt, size, (unsigned long long)samples, size / conv.seconds / 1e9, rss_conv,
+                   size / csv.seconds / 1e9, csv.bytes_out / 1e6, rss_csv, match ? "OK" : "MISMATCH");
+            fflush(stdout);
+        }
+    }
+    return ok ? 0 : 1;
+}
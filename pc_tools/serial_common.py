@@ -4,18 +4,38 @@ from serial.tools import list_ports
 from pathlib import Path
 from typing import Optional, Callable
 import json
+import struct
+import zlib
 from info_format import enrich_info_defaults
 
 BAUDRATE = 115_200
 """Default preferred baud rate for high-speed dump."""
 
-# Fallback candidates (fast -> slow). The code will auto-try these.
-# memo: M5stickの個体によっては115200しか動作せず、そのため115200に固定
-# CANDIDATE_BAUDRATES = [1_500_000, 921_600, 460_800, 230_400, 115_200]
-CANDIDATE_BAUDRATES = [115_200]
+# Rates the link is probed at. The firmware boots at the rate last confirmed with BAUD
+# (kept in its NVS), so every rate it accepts is a candidate; the default comes first.
+# memo: M5stickの個体によっては115200しか動作しない。BAUD の切り替えは確認が取れなければ
+# デバイス側で元に戻るので、速いレートは dump_bin() が BAUD で交渉する。
+CANDIDATE_BAUDRATES = [115_200, 921_600, 1_500_000, 460_800, 230_400]
+FAST_BAUDRATE = 921_600
+"""Rate dump_bin() switches the link to (BAUD handshake) before a transfer; None keeps the probed rate."""
+BAUD_SETTLE_SEC = 0.05
 TIMEOUT = 15
 MAX_ATTEMPTS = 2
 HEADER_MAX_ATTEMPTS = 4096
+# DUMPX framing: [A5 5A][u32 seq][u16 len][payload][u32 crc32(seq..payload)]
+DUMPX_SYNC = b'\xa5\x5a'
+DUMPX_HDR = struct.Struct('<IH')
+DUMPX_READ_TIMEOUT = 0.5   # seconds without data before NACKing the oldest missing frame
+DUMPX_MAX_STALLS = 20      # consecutive timeouts before giving up (partial file kept)
+
+
+# STREAM frames: [A5 5B][u16 seq][int16 x popcount(mask)][u8 xor(seq..data)]
+STREAM_SYNC = b'\xa5\x5b'
+STREAM_CHANNELS = ('ax', 'ay', 'az', 'gx', 'gy', 'gz')
+
+
+class DumpxUnsupported(RuntimeError):
+    """Firmware does not know DUMPX; fall back to the raw DUMP."""
 
 
 def list_serial_ports():
@@ -198,8 +218,75 @@ def _try_ping(ser: serial.Serial, log_cb: Optional[Callable[[str], None]] = None
             pass
 
 
-def _dump_bin_impl(port: str, out_path: Path, baud: int, progress_cb=None, log_cb=None):
-    """Single-baud dump implementation. Returns metadata dict on success."""
+def negotiate_baud(ser: serial.Serial, rate: int, log_cb: Optional[Callable[[str], None]] = None) -> bool:
+    """Move a working link to `rate` with the firmware BAUD handshake.
+
+    BAUD <rate> is sent at the current rate; once the device answers
+    BAUD SWITCH <rate> <confirm_ms> both ends switch and the host confirms
+    with BAUD OK at the new rate. The device keeps a confirmed rate across
+    reboots and falls back by itself when the confirmation does not arrive.
+    Returns True when the link runs at `rate`; on False the port is back at
+    its old rate (older firmware answers UNKNOWN and nothing changes).
+    """
+    import time as _time
+    old = ser.baudrate
+    if rate == old:
+        return True
+    orig_timeout = ser.timeout
+    try:
+        ser.timeout = 1.0
+        ser.reset_input_buffer()
+        ser.write(f'BAUD {rate}\n'.encode('ascii'))
+        ser.flush()
+        line = ser.readline().decode('ascii', errors='ignore').strip()
+        if log_cb:
+            log_cb(f'[baud] {rate}: {line!r}')
+        parts = line.split()
+        if len(parts) < 3 or parts[:2] != ['BAUD', 'SWITCH'] or parts[2] != str(rate):
+            return False
+        confirm_sec = int(parts[3]) / 1000.0 if len(parts) > 3 else 2.0
+        ser.baudrate = rate
+        _time.sleep(BAUD_SETTLE_SEC)
+        ser.reset_input_buffer()
+        # The leading newline ends whatever the device assembled from bytes seen during the switch
+        ser.write(b'\nBAUD OK\n')
+        ser.flush()
+        deadline = _time.monotonic() + confirm_sec
+        while _time.monotonic() < deadline:
+            line = ser.readline().decode('ascii', errors='ignore').strip()
+            if line == f'OK BAUD {rate}':
+                if log_cb:
+                    log_cb(f'[baud] Switched to {rate}')
+                return True
+        # No confirmation: the device reverts after confirm_ms; wait for it
+        _time.sleep(max(0.0, deadline - _time.monotonic()) + 0.2)
+        ser.baudrate = old
+        _time.sleep(BAUD_SETTLE_SEC)
+        if _try_ping(ser, log_cb=log_cb, attempts=2):
+            if log_cb:
+                log_cb(f'[baud] {rate} not confirmed, staying at {old}')
+            return False
+        # Our BAUD OK arrived but its reply was lost: the device stays at the new rate
+        ser.baudrate = rate
+        _time.sleep(BAUD_SETTLE_SEC)
+        if _try_ping(ser, log_cb=log_cb, attempts=2):
+            return True
+        ser.baudrate = old
+        return False
+    finally:
+        try:
+            ser.timeout = orig_timeout
+        except Exception:
+            pass
+
+
+def _dump_bin_impl(port: str, out_path: Path, baud: int, progress_cb=None, log_cb=None, session: int = 0,
+                   cmd: str = 'DUMP', fast_baud: Optional[int] = None):
+    """Single-baud dump implementation. Returns metadata dict on success.
+
+    cmd: DUMP (session log) or SUMDUMP (session summary file), same framing.
+    fast_baud: switch the link to this rate (BAUD) before the transfer.
+    """
     with open_serial(port, baudrate=baud, log_cb=log_cb) as ser:
         if log_cb:
             log_cb(f'[dump] Opened {port} at {baud} baud')
@@ -211,9 +298,11 @@ def _dump_bin_impl(port: str, out_path: Path, baud: int, progress_cb=None, log_c
             if log_cb:
                 log_cb('[dump] PING failed – treating this baud as unusable')
             raise RuntimeError('No PONG at this baud')
+        if fast_baud and fast_baud != baud and negotiate_baud(ser, fast_baud, log_cb):
+            baud = fast_baud
         # Debug: request file head hex if supported
         try:
-            ser.write(b'HEAD\n')
+            ser.write(f'HEAD {session}\n'.encode('ascii'))
             ser.flush()
             head_line = ser.readline().decode('ascii', errors='ignore').strip()
             if log_cb:
@@ -223,10 +312,10 @@ def _dump_bin_impl(port: str, out_path: Path, baud: int, progress_cb=None, log_c
                     log_cb(f'[dump] HEAD response: {head_line!r}')
         except Exception:
             pass
-        ser.write(b'DUMP\n')
+        ser.write(f'{cmd} {session}\n'.encode('ascii') if session else f'{cmd}\n'.encode('ascii'))
         ser.flush()
         if log_cb:
-            log_cb('[dump] Sent DUMP, waiting for OK <size> [now_ms]')
+            log_cb(f'[dump] Sent {cmd}, waiting for OK <size> [now_ms]')
         # Read first response line and record PC receipt time
         first_line = ser.readline().decode('ascii', errors='ignore').strip()
         import time as _time
@@ -358,10 +447,154 @@ def _dump_bin_impl(port: str, out_path: Path, baud: int, progress_cb=None, log_c
         }
 
 
-def dump_bin(port: str, out_path: Path, progress_cb=None, log_cb=None):
+def _dumpx_parse_frames(buf: bytearray, frame_size: int):
+    """Pop complete frames from buf. Returns a list of (seq, payload) with good CRC.
+
+    Corrupted frames are skipped by resynchronising on the next sync word; the
+    caller notices the missing sequence number and NACKs it.
+    """
+    frames = []
+    i = 0
+    while True:
+        j = buf.find(DUMPX_SYNC, i)
+        if j < 0:
+            i = max(i, len(buf) - 1)
+            break
+        if j + 2 + DUMPX_HDR.size > len(buf):
+            i = j
+            break
+        seq, length = DUMPX_HDR.unpack_from(buf, j + 2)
+        if length > frame_size:
+            i = j + 1
+            continue
+        end = j + 2 + DUMPX_HDR.size + length + 4
+        if end > len(buf):
+            i = j
+            break
+        body = bytes(buf[j + 2:end - 4])
+        (crc,) = struct.unpack_from('<I', buf, end - 4)
+        if zlib.crc32(body) == crc:
+            frames.append((seq, body[DUMPX_HDR.size:]))
+            i = end
+        else:
+            i = j + 1
+    del buf[:i]
+    return frames
+
+
+def _dumpx_impl(port: str, out_path: Path, baud: int, progress_cb=None, log_cb=None, session: int = 0,
+                fast_baud: Optional[int] = None):
+    """Framed dump (DUMPX) with selective retransmission.
+
+    Data is written to `<out_path>.part`; if the link drops, the next call
+    resumes from the bytes already in that file instead of restarting.
+    fast_baud: switch the link to this rate (BAUD) before the transfer.
+    """
+    import time as _time
+    part = out_path.with_name(out_path.name + '.part')
+    out_path.parent.mkdir(parents=True, exist_ok=True)
+    have = part.stat().st_size if part.exists() else 0
+    with open_serial(port, baudrate=baud, log_cb=log_cb) as ser:
+        ser.reset_input_buffer()
+        if not _try_ping(ser, log_cb=log_cb):
+            raise RuntimeError('No PONG at this baud')
+        if fast_baud and fast_baud != baud and negotiate_baud(ser, fast_baud, log_cb):
+            baud = fast_baud
+        if have:
+            # Resume only if the partial file belongs to the log on the device
+            ser.write(f'HEAD {session}\n'.encode('ascii'))
+            ser.flush()
+            head_line = ser.readline().decode('ascii', errors='ignore').strip()
+            with open(part, 'rb') as f:
+                local_head = f.read(64)
+            if head_line[5:] != local_head.hex():
+                if log_cb:
+                    log_cb('[dumpx] Partial file is from another log; starting over')
+                have = 0
+        ser.write(f'DUMPX {have} 0 {session}\n'.encode('ascii'))
+        ser.flush()
+        first_line = ser.readline().decode('ascii', errors='ignore').strip()
+        pc_ok_rx_time = _time.time()
+        if log_cb:
+            log_cb(f'[dumpx] First line: {first_line!r}')
+        if first_line == 'UNKNOWN':
+            raise DumpxUnsupported('DUMPX not supported by firmware')
+        parts = first_line.split()
+        if len(parts) < 7 or parts[0] != 'OKX':
+            raise RuntimeError(f'Unexpected response: {first_line!r}')
+        total, offset, length, frame_size, window, device_now_ms = (int(x) for x in parts[1:7])
+        if log_cb:
+            log_cb(f'[dumpx] total={total} resume_at={offset} frame={frame_size} window={window}')
+        nframes = (length + frame_size - 1) // frame_size
+        pending = {}
+        expected = 0
+        stalls = 0
+        nacked = set()
+        buf = bytearray()
+        ser.timeout = DUMPX_READ_TIMEOUT
+        with open(part, 'r+b' if part.exists() else 'wb') as f:
+            f.seek(offset)
+            f.truncate()
+            while expected < nframes:
+                chunk = ser.read(max(1, ser.in_waiting))
+                if not chunk:
+                    stalls += 1
+                    if stalls > DUMPX_MAX_STALLS:
+                        ser.write(b'X\n')
+                        raise RuntimeError(f'DUMPX stalled at {offset + expected * frame_size}/{total}; rerun to resume')
+                    ser.write(f'N {expected}\n'.encode('ascii'))
+                    continue
+                stalls = 0
+                buf += chunk
+                progressed = False
+                for seq, payload in _dumpx_parse_frames(buf, frame_size):
+                    if seq >= expected and seq not in pending:
+                        pending[seq] = payload
+                    else:
+                        # Had it already: our ACK was lost and the device resends its oldest frame
+                        progressed = True
+                while expected in pending:
+                    f.write(pending.pop(expected))
+                    nacked.discard(expected)
+                    expected += 1
+                    progressed = True
+                if progressed:
+                    ser.write(f'A {expected}\n'.encode('ascii'))
+                    if progress_cb:
+                        progress_cb(offset + expected * frame_size if expected < nframes else total, total)
+                # Later frames arrived but an earlier one is missing: ask for just that one
+                if pending and expected not in nacked:
+                    nacked.add(expected)
+                    ser.write(f'N {expected}\n'.encode('ascii'))
+        tail = b''
+        for _ in range(MAX_ATTEMPTS * 4):
+            tail += ser.read(max(1, ser.in_waiting))
+            if b'DONEX' in tail or b'ABORTX' in tail:
+                break
+        if log_cb:
+            log_cb(f'[dumpx] Trailer: {tail[-16:]!r}')
+    part.replace(out_path)
+    if progress_cb:
+        progress_cb(total, total)
+    return {
+        'total_bytes': total,
+        'device_now_ms': device_now_ms,
+        'pc_ok_rx_time': pc_ok_rx_time,
+        'baud': baud,
+        'resumed_from': offset,
+    }
+
+
+def dump_bin(port: str, out_path: Path, progress_cb=None, log_cb=None, session: int = 0,
+             fast_baud: Optional[int] = FAST_BAUDRATE):
     """Dump binary log with auto-baud selection.
 
-    Tries CANDIDATE_BAUDRATES from fastest to slowest until successful.
+    session: session id from list_sessions(); 0 = newest recording.
+
+    Tries CANDIDATE_BAUDRATES in order until the link answers, then moves it to
+    fast_baud with the BAUD handshake (kept at the probed rate if that fails).
+    Uses the framed DUMPX transfer when the firmware supports it, otherwise
+    the raw DUMP stream. The returned metadata's 'baud' is the transfer rate.
     """
     last_exc: Optional[Exception] = None
     if log_cb:
@@ -370,7 +603,10 @@ def dump_bin(port: str, out_path: Path, progress_cb=None, log_cb=None):
         try:
             if log_cb:
                 log_cb(f'[dump] Trying baud {baud}...')
-            meta = _dump_bin_impl(port, out_path, baud, progress_cb, log_cb)
+            try:
+                meta = _dumpx_impl(port, out_path, baud, progress_cb, log_cb, session, fast_baud=fast_baud)
+            except DumpxUnsupported:
+                meta = _dump_bin_impl(port, out_path, baud, progress_cb, log_cb, session, fast_baud=fast_baud)
             if log_cb:
                 log_cb(f'[dump] Succeeded at {baud} baud')
             return meta
@@ -383,7 +619,217 @@ def dump_bin(port: str, out_path: Path, progress_cb=None, log_cb=None):
     raise last_exc
 
 
-__all__ = ['list_serial_ports', 'open_serial', 'dump_bin', 'get_info']
+def dump_summary(port: str, out_path: Path, progress_cb=None, log_cb=None, session: int = 0):
+    """Fetch the windowed summary file of a session (firmware SUMMARY_ENABLE).
+
+    The file is small, so it always uses the plain SUMDUMP transfer; decode it
+    with decoder.bin_to_csv() like a log (format 0x0400).
+    """
+    last_exc: Optional[Exception] = None
+    for baud in CANDIDATE_BAUDRATES:
+        try:
+            return _dump_bin_impl(port, out_path, baud, progress_cb, log_cb, session, cmd='SUMDUMP')
+        except Exception as exc:
+            last_exc = exc
+            if log_cb:
+                log_cb(f'[dump] SUMDUMP failed at {baud} baud: {exc!r}')
+    assert last_exc is not None
+    raise last_exc
+
+
+def parse_stream_frames(buf: bytearray, mask: int = 0x3F):
+    """Pop complete STREAM frames from buf. Returns a list of (seq, values).
+
+    Frames with a bad checksum are skipped by resynchronising on the next sync
+    word; text lines (e.g. the OK reply) between frames are skipped the same way.
+    """
+    nch = bin(mask & 0x3F).count('1')
+    size = 2 + 2 + 2 * nch + 1
+    frames = []
+    i = 0
+    while True:
+        j = buf.find(STREAM_SYNC, i)
+        if j < 0:
+            i = max(i, len(buf) - 1)
+            break
+        if j + size > len(buf):
+            i = j
+            break
+        body = buf[j + 2:j + size - 1]
+        x = 0
+        for b in body:
+            x ^= b
+        if x == buf[j + size - 1]:
+            seq = body[0] | (body[1] << 8)
+            frames.append((seq, struct.unpack_from(f'<{nch}h', body, 2)))
+            i = j + size
+        else:
+            i = j + 1
+    del buf[:i]
+    return frames
+
+
+def stream_samples(port: str, seconds: float, decim: int = 1, mask: int = 0x3F,
+                   baud: int = BAUDRATE, sample_cb=None, log_cb=None) -> dict:
+    """Receive live STREAM frames for `seconds` (device must be recording).
+
+    sample_cb(seq, values) is called for every frame. Returns counters: frames
+    received, frames missing by sequence number (dropped on the device or
+    corrupted on the link), and the device's own frames/dropped counts.
+    """
+    import time as _time
+    with open_serial(port, baudrate=baud, log_cb=log_cb) as ser:
+        ser.reset_input_buffer()
+        if not _try_ping(ser, log_cb=log_cb):
+            raise RuntimeError('No PONG at this baud')
+        ser.write(f'STREAM {decim} {mask:x}\n'.encode('ascii'))
+        ser.flush()
+        line = ser.readline().decode('ascii', errors='ignore').strip()
+        if log_cb:
+            log_cb(f'[stream] {line!r}')
+        if not line.startswith('OK STREAM'):
+            raise RuntimeError(f'Unexpected response: {line!r}')
+        ser.timeout = 0.2
+        buf = bytearray()
+        received = 0
+        missing = 0
+        last_seq = None
+        rx_bytes = 0
+        t0 = _time.time()
+        while _time.time() - t0 < seconds:
+            chunk = ser.read(max(1, ser.in_waiting))
+            rx_bytes += len(chunk)
+            buf += chunk
+            for seq, values in parse_stream_frames(buf, mask):
+                if last_seq is not None:
+                    missing += (seq - last_seq - 1) & 0xFFFF
+                last_seq = seq
+                received += 1
+                if sample_cb:
+                    sample_cb(seq, values)
+        elapsed = _time.time() - t0
+        ser.write(b'STREAM OFF\n')
+        ser.flush()
+        dev = {}
+        ser.timeout = 1.0
+        for _ in range(8):
+            tail = ser.readline().decode('ascii', errors='ignore')
+            k = tail.find('OK STREAM frames:')
+            if k >= 0:
+                for kv in tail[k + len('OK STREAM '):].split():
+                    key, _, val = kv.partition(':')
+                    dev[f'device_{key}'] = int(val)
+                break
+    return {
+        'frames': received,
+        'missing': missing,
+        'rate_hz': received / elapsed if elapsed > 0 else 0.0,
+        'rx_bytes_per_sec': rx_bytes / elapsed if elapsed > 0 else 0.0,
+        'baud': baud,
+        **dev,
+    }
+
+
+def list_sessions(port: str, baud: int = BAUDRATE, log_cb=None) -> list:
+    """Return the recordings stored on the device (LIST), oldest first.
+
+    Each entry: {'id', 'size', 'samples' (None while recording), 'start_ms', 'format'}.
+    """
+    sessions = []
+    with open_serial(port, baudrate=baud, log_cb=log_cb) as ser:
+        ser.reset_input_buffer()
+        if not _try_ping(ser, log_cb=log_cb):
+            raise RuntimeError('No PONG at this baud')
+        ser.write(b'LIST\n')
+        ser.flush()
+        while True:
+            line = ser.readline().decode('ascii', errors='ignore').strip()
+            if not line:
+                raise RuntimeError('Timeout waiting for LIST')
+            if line == 'UNKNOWN':
+                return sessions  # single-file firmware
+            if line.startswith('END'):
+                break
+            parts = line.split()
+            if len(parts) >= 6 and parts[0] == 'S':
+                samples = int(parts[3])
+                sessions.append({
+                    'id': int(parts[1]),
+                    'size': int(parts[2]),
+                    'samples': None if samples < 0 else samples,
+                    'start_ms': int(parts[4]),
+                    'format': parts[5],
+                })
+    return sessions
+
+
+def parse_stats(lines) -> dict:
+    """Parse the STATS reply lines (firmware stage_stats.h).
+
+    Returns {'cpu_mhz', 'since_ms', 'stages': {name: {'n', 'min_us', 'mean_us', 'max_us', 'hist'}},
+    'tick': {'n', 'missed', 'overrun', 'jitter_mean_us', 'jitter_max_us', 'hist'}}.
+    Stage hist maps k -> count for durations in [2^k, 2^(k+1)) CPU cycles, tick hist
+    the same for the jitter in microseconds. An empty dict means STATS_ENABLE is off.
+    """
+    def fields(parts):
+        return dict(p.split(':', 1) for p in parts if ':' in p)
+
+    def hist(text):
+        if text in ('', '-'):
+            return {}
+        return {int(k): int(v) for k, v in (e.split(':') for e in text.split(','))}
+
+    out = {}
+    for line in lines:
+        parts = line.split()
+        if not parts or parts[0] == 'END':
+            continue
+        f = fields(parts[1:])
+        if parts[0] == 'STATS' and 'cpu_mhz' in f:
+            out['cpu_mhz'] = int(f['cpu_mhz'])
+            out['since_ms'] = int(f['since_ms'])
+            out['stages'] = {}
+        elif parts[0] == 'STAGE' and len(parts) > 1:
+            g = fields(parts[2:])
+            mn, mean, mx = (float(v) for v in g['us'].split('/'))
+            out.setdefault('stages', {})[parts[1]] = {
+                'n': int(g['n']), 'min_us': mn, 'mean_us': mean, 'max_us': mx, 'hist': hist(g.get('hist', '')),
+            }
+        elif parts[0] == 'TICK':
+            mean, mx = (int(v) for v in f['jitter_us'].split('/'))
+            out['tick'] = {
+                'n': int(f['n']), 'missed': int(f['missed']), 'overrun': int(f['overrun']),
+                'jitter_mean_us': mean, 'jitter_max_us': mx, 'hist': hist(f.get('hist', '')),
+            }
+    return out
+
+
+def get_stats(port: str, reset: bool = False, baud: int = BAUDRATE, log_cb=None) -> dict:
+    """Read the hot-path stage counters (STATS), optionally clearing them afterwards (STATS RESET)."""
+    lines = []
+    with open_serial(port, baudrate=baud, log_cb=log_cb) as ser:
+        ser.reset_input_buffer()
+        if not _try_ping(ser, log_cb=log_cb):
+            raise RuntimeError('No PONG at this baud')
+        ser.write(b'STATS\n')
+        ser.flush()
+        while True:
+            line = ser.readline().decode('ascii', errors='ignore').strip()
+            if not line:
+                raise RuntimeError('Timeout waiting for STATS')
+            if line == 'UNKNOWN':
+                raise RuntimeError('Firmware has no STATS command')
+            if line == 'STATS OFF':
+                break
+            lines.append(line)
+            if line.startswith('END'):
+                break
+        if reset:
+            ser.write(b'STATS RESET\n')
+            ser.flush()
+            ser.readline()
+    return parse_stats(lines)
+
 
 def _get_info_impl(port: str, baud: int, log_cb: Optional[Callable[[str], None]] = None) -> dict:
     if log_cb:
@@ -466,4 +912,5 @@ def get_info(port: str, log_cb: Optional[Callable[[str], None]] = None) -> dict:
     raise last_exc
 
 
-__all__ = ['list_serial_ports', 'open_serial', 'dump_bin', 'get_info']
+__all__ = ['list_serial_ports', 'open_serial', 'dump_bin', 'dump_summary', 'get_info', 'stream_samples',
+           'list_sessions', 'get_stats', 'parse_stats', 'negotiate_baud']
@@ -0,0 +1,205 @@
+"""bin_to_csv_stream() must write the same CSV bytes as bin_to_csv() for every sample format.
+
+Synthetic logs are built here the way the firmware writes them (log_codec.h): raw big-endian
+payloads (0x01xx/0x02xx), compressed blocks (0x0301), framed blocks (0x0302/0x0303, with dropped,
+corrupted, shifted and truncated frames) and trigger segments (0x0306/0x0307).
+Run from the repository root: python -m pytest pc_tools/tests
+"""
+from pathlib import Path
+import struct
+import sys
+import zlib
+
+import numpy as np
+import pytest
+
+sys.path.insert(0, str(Path(__file__).resolve().parents[1]))
+import decoder  # noqa: E402
+
+BLOCK_SIZE = 512
+# Header fields both decoders fill in (bin_to_csv_stream adds 'samples')
+COMMON_KEYS = ('format_ver', 'odr_hz', 'range_g', 'gyro_range_dps', 'lsb_per_g', 'lsb_per_dps',
+               'block_size', 'header_found', 'header_offset', 'gap_samples', 'frames',
+               'odr_measured', 'lost_samples', 'skipped_samples', 'segments')
+
+
+def make_header(fmt: int, odr: int = 200, range_g: int = 8, gyro_dps: int = 2000, imu_type: int = 2,
+                lsb_per_g: float = 4096.0, lsb_per_dps: float = 16.4, block_size: int = 0) -> bytes:
+    """64-byte LogHeader of format fmt (the layouts of decoder.HEADER_FMT_*)."""
+    magic = b'ACCLOG\x00\x00'
+    if fmt >= 0x0300:
+        h = struct.pack(decoder.HEADER_FMT_V3, magic, fmt, 0x1234, 1700000000000, odr, range_g, gyro_dps,
+                        imu_type, 2, lsb_per_g, lsb_per_dps, 0, 0, 3, -4, 5, block_size, b'')
+    elif fmt >= 0x0202:
+        h = struct.pack(decoder.HEADER_FMT_V2_2, magic, fmt, 0x1234, 1700000000000, odr, range_g, gyro_dps,
+                        imu_type, 2, lsb_per_g, lsb_per_dps, 0, 0, 3, -4, 5, b'')
+    elif fmt >= 0x0201:
+        h = struct.pack(decoder.HEADER_FMT_V2_1, magic, fmt, 0x1234, 1700000000000, odr, range_g, gyro_dps,
+                        imu_type, 1, lsb_per_g, lsb_per_dps, 0, 0, b'')
+    elif fmt >= 0x0200:
+        h = struct.pack(decoder.HEADER_FMT_V2, magic, fmt, 0x1234, 1700000000000, odr, range_g, gyro_dps,
+                        0, 0, b'')
+    else:
+        h = struct.pack(decoder.HEADER_FMT_V1, magic, fmt, 0x1234, 1700000000000, odr, range_g, 0, 0, b'')
+    assert len(h) == decoder.HEADER_SIZE
+    return h
+
+
+def make_samples(count: int, channels: int = 6, seed: int = 1) -> np.ndarray:
+    """Random walk over the full int16 range (wraps like the firmware deltas)."""
+    rng = np.random.default_rng(seed)
+    steps = rng.integers(-300, 301, size=(count, channels))
+    steps[::97] = rng.integers(-32768, 32768, size=(len(steps[::97]), channels))   # full-scale jumps
+    return np.cumsum(steps, axis=0).astype(np.uint16).view(np.int16)
+
+
+def encode_raw(samples: np.ndarray) -> bytes:
+    return samples.astype('>i2').tobytes()
+
+
+def encode_varint(samples: np.ndarray) -> bytes:
+    """LOG_COMPRESS payload: zigzag varint of the int16 delta to the previous sample, from zero."""
+    out = bytearray()
+    prev = [0] * 6
+    for row in samples.tolist():
+        for i, v in enumerate(row):
+            d = (v - prev[i] + 32768) % 65536 - 32768
+            zz = ((d << 1) ^ (d >> 15)) & 0xFFFF
+            while zz >= 0x80:
+                out.append((zz & 0x7F) | 0x80)
+                zz >>= 7
+            out.append(zz)
+            prev[i] = v
+    return bytes(out)
+
+
+def per_block(compressed: bool, hdr_size: int) -> int:
+    """Samples per block so that the worst case (18 bytes each) still fits."""
+    return (BLOCK_SIZE - hdr_size) // (18 if compressed else 12)
+
+
+def make_blocks(samples: np.ndarray) -> bytes:
+    """0x0301: [uint16 count][uint16 len] + varints, zero-padded to BLOCK_SIZE (the last one short)."""
+    out = bytearray()
+    k = per_block(True, decoder.BLOCK_HDR_SIZE)
+    for s in range(0, len(samples), k):
+        enc = encode_varint(samples[s:s + k])
+        blk = struct.pack('<HH', len(samples[s:s + k]), len(enc)) + enc
+        out += blk if s + k >= len(samples) else blk.ljust(BLOCK_SIZE, b'\x00')
+    return bytes(out)
+
+
+def make_frame(samples: np.ndarray, first: int, t_us: int, compressed: bool, last: bool = False) -> bytes:
+    body = encode_varint(samples) if compressed else encode_raw(samples)
+    tail = struct.pack('<IIHH', first, t_us & 0xFFFFFFFF, len(samples), len(body)) + body
+    blk = decoder.BLOCK_SYNC + struct.pack('<I', zlib.crc32(tail)) + tail
+    return blk if last else blk.ljust(BLOCK_SIZE, b'\x00')
+
+
+def make_frames(samples: np.ndarray, compressed: bool, odr: int, first0: int = 0) -> list:
+    """One frame per block (the last one short); the device micros() runs at odr and wraps."""
+    k = per_block(compressed, decoder.FRAME_HDR_SIZE)
+    return [make_frame(samples[s:s + k], first0 + s, 0xFFF00000 + (first0 + s) * 1000000 // odr, compressed,
+                       last=s + k >= len(samples))
+            for s in range(0, len(samples), k)]
+
+
+def write_log(path: Path, header: bytes, payload: bytes, lead: bytes = b'') -> Path:
+    path.write_bytes(lead + header + payload)
+    return path
+
+
+def build_log(tmp_path: Path, kind: str) -> Path:
+    p = tmp_path / f'{kind}.bin'
+    if kind == 'raw_0100':
+        return write_log(p, make_header(0x0100), encode_raw(make_samples(1000, 3)) + b'\x01\x02\x03')
+    if kind == 'raw_0200':
+        return write_log(p, make_header(0x0200, gyro_dps=0, range_g=0), encode_raw(make_samples(1000)))
+    if kind == 'raw_0201_sh200q':
+        # SH200Q 0x0201: gyro already in dps; header 4 bytes into the file (serial preamble)
+        return write_log(p, make_header(0x0201, imu_type=1), encode_raw(make_samples(999)) + b'\x7f',
+                         lead=b'\x00\xff\x10\x0d')
+    if kind == 'raw_0202_gaps':
+        s = make_samples(2000)
+        s[100:103] = decoder.GAP_WORD
+        s[1500:1800] = decoder.GAP_WORD
+        s[1900, :3] = decoder.GAP_WORD   # partial: not a gap marker
+        return write_log(p, make_header(0x0202, lsb_per_g=16384.0, lsb_per_dps=131.0), encode_raw(s))
+    if kind == 'raw_empty':
+        return write_log(p, make_header(0x0202), b'')
+    if kind == 'blocks_0301':
+        return write_log(p, make_header(0x0301, block_size=BLOCK_SIZE), make_blocks(make_samples(1500)))
+    if kind in ('framed_0302', 'framed_0303'):
+        compressed = kind == 'framed_0303'
+        s = make_samples(3000)
+        s[700:710] = decoder.GAP_WORD   # gap markers written by the device
+        frames = make_frames(s, compressed, 200)
+        del frames[3]                                     # dropped on the device: gap rows
+        frames[5] = frames[5][:30] + bytes([frames[5][30] ^ 0x40]) + frames[5][31:]   # bad CRC
+        frames[7] = b'\x55\xaa\x01' + frames[7]            # shifted by inserted bytes
+        frames.insert(9, frames[8])                       # duplicated (stale) block
+        frames[-1] = frames[-1][:-5]                       # truncated at the end of the file
+        fmt = 0x0303 if compressed else 0x0302
+        return write_log(p, make_header(fmt, block_size=BLOCK_SIZE), b''.join(frames))
+    if kind in ('trigger_0306', 'trigger_0307'):
+        compressed = kind == 'trigger_0307'
+        fmt = 0x0307 if compressed else 0x0306
+        frames = []
+        # Segments of different lengths, with numbering gaps between them (not logged)
+        for first, count, seed in ((0, 100, 2), (5000, 450, 3), (5450, 30, 4), (123456, 260, 5)):
+            seg = make_frames(make_samples(count, seed=seed), compressed, 400, first0=first)
+            seg[-1] = seg[-1].ljust(BLOCK_SIZE, b'\x00')   # segment end: the block is closed early
+            frames += seg
+        frames[2] = frames[2][:12] + b'\x00' + frames[2][13:]   # a corrupted frame inside a segment
+        return write_log(p, make_header(fmt, odr=400, block_size=BLOCK_SIZE), b''.join(frames))
+    raise ValueError(kind)
+
+
+KINDS = ('raw_0100', 'raw_0200', 'raw_0201_sh200q', 'raw_0202_gaps', 'raw_empty', 'blocks_0301',
+         'framed_0302', 'framed_0303', 'trigger_0306', 'trigger_0307')
+
+
+@pytest.mark.parametrize('kind', KINDS)
+@pytest.mark.parametrize('chunk', (7, 100, decoder.STREAM_CHUNK_SAMPLES))
+def test_stream_matches_bin_to_csv(tmp_path, kind, chunk):
+    log = build_log(tmp_path, kind)
+    ref_csv = tmp_path / 'ref.csv'
+    out_csv = tmp_path / 'stream.csv'
+    ref_header, ref_df = decoder.bin_to_csv(log, ref_csv)
+    header = decoder.bin_to_csv_stream(log, out_csv, chunk=chunk, native=False)
+    assert out_csv.read_bytes() == ref_csv.read_bytes()
+    assert header['samples'] == len(ref_df)
+    for key in COMMON_KEYS:
+        assert header.get(key) == ref_header.get(key), key
+
+
+def test_logs_exercise_the_cases(tmp_path):
+    """The synthetic logs really contain what the comparison is meant to cover."""
+    h, df = decoder.bin_to_csv(build_log(tmp_path, 'raw_0202_gaps'), None)
+    assert h['gap_samples'] == 303
+    h, df = decoder.bin_to_csv(build_log(tmp_path, 'framed_0303'), None)
+    # dropped frame + bad CRC + truncated tail are lost; the shifted and duplicated ones are not
+    k = per_block(True, decoder.FRAME_HDR_SIZE)
+    assert h['lost_samples'] == 2 * k
+    assert len(df) == 3000 - 3000 % k
+    assert h['gap_samples'] == 10 + 2 * k
+    h, df = decoder.bin_to_csv(build_log(tmp_path, 'trigger_0307'), None)
+    assert h['segments'] == 4
+    assert df['n'].iloc[-1] == 123456 + 259
+    assert h['skipped_samples'] > 0
+    h, df = decoder.bin_to_csv(build_log(tmp_path, 'blocks_0301'), None)
+    assert len(df) == 1500
+
+
+def test_summary_log_falls_back(tmp_path):
+    """Summary logs (0x0400) are converted by bin_to_csv() inside bin_to_csv_stream()."""
+    rec = np.zeros(5, dtype=decoder.SUMMARY_DTYPE)
+    rec['first_sample'] = np.arange(5) * 200
+    rec['count'] = 200
+    rec['mean'][:, 2] = 4096
+    log = write_log(tmp_path / 'sum.bin', make_header(0x0400), rec.tobytes())
+    ref_csv = tmp_path / 'ref.csv'
+    out_csv = tmp_path / 'stream.csv'
+    decoder.bin_to_csv(log, ref_csv)
+    decoder.bin_to_csv_stream(log, out_csv, native=False)
+    assert out_csv.read_bytes() == ref_csv.read_bytes()
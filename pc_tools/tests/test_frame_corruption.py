@@ -0,0 +1,160 @@
+"""Framed blocks (0x0302/0x0303) with flipped bits and truncations.
+
+Every single-bit flip inside a frame (sync word, header fields, CRC, body) must make its CRC
+check fail so the frame is rejected, and the decoder must pick up again at the next block:
+the frames around it decode unchanged and the lost samples become gap markers at their sample
+numbers. A frame cut short (bytes missing, later blocks shifted) costs only that frame, and
+one that only lost padding costs nothing.
+The native decoder, when built, must reject and resync the same way (same CSV bytes).
+Run from the repository root: python -m pytest pc_tools/tests
+"""
+from pathlib import Path
+import sys
+
+import numpy as np
+import pytest
+
+sys.path.insert(0, str(Path(__file__).resolve().parents[1]))
+import acclog_native  # noqa: E402
+import decoder  # noqa: E402
+from test_decoder_stream import BLOCK_SIZE, make_frames, make_header, make_samples, write_log  # noqa: E402
+
+N_SAMPLES = 400
+VICTIM = 3      # frame that gets corrupted; frames before and after it must survive
+
+
+def frames_of(compressed: bool):
+    s = make_samples(N_SAMPLES, seed=11)
+    return s, make_frames(s, compressed, 200)
+
+
+def first_of(frames, i: int) -> int:
+    return decoder.iter_frames(frames[i], BLOCK_SIZE).__next__()[1]
+
+
+def count_of(frames, i: int) -> int:
+    return decoder.iter_frames(frames[i], BLOCK_SIZE).__next__()[3]
+
+
+def flip(frame: bytes, bit: int) -> bytes:
+    b = bytearray(frame)
+    b[bit // 8] ^= 1 << (bit % 8)
+    return bytes(b)
+
+
+def used_bits(frame: bytes):
+    """Bits of the header and body (the zero padding after the body is not covered by the CRC)."""
+    length = int.from_bytes(frame[18:20], 'little')
+    return range((decoder.FRAME_HDR_SIZE + length) * 8)
+
+
+def check_victim_lost(payload: bytes, samples: np.ndarray, frames, compressed: bool):
+    """Only frame VICTIM is missing: neighbours at their offsets, its samples are gap rows."""
+    first, count = first_of(frames, VICTIM), count_of(frames, VICTIM)
+    idx = decoder.frame_index(payload, BLOCK_SIZE)
+    assert first not in idx['first_sample']
+    assert len(idx) == len(frames) - 1
+    data, lost, _ = decoder.decode_frames(payload, BLOCK_SIZE, compressed)
+    assert lost == count
+    assert len(data) == len(samples)
+    assert (data[first:first + count] == decoder.GAP_WORD).all()
+    np.testing.assert_array_equal(data[:first], samples[:first])
+    np.testing.assert_array_equal(data[first + count:], samples[first + count:])
+
+
+@pytest.mark.parametrize('compressed', (False, True))
+def test_intact_frames_decode(compressed):
+    samples, frames = frames_of(compressed)
+    assert len(frames) > VICTIM + 2
+    data, lost, idx = decoder.decode_frames(b''.join(frames), BLOCK_SIZE, compressed)
+    assert lost == 0 and len(idx) == len(frames)
+    np.testing.assert_array_equal(data, samples)
+
+
+@pytest.mark.parametrize('compressed', (False, True))
+def test_every_header_bit_flip_is_rejected(compressed):
+    """Sync, CRC, first_sample, t_us, count and length: 20 bytes, every bit."""
+    samples, frames = frames_of(compressed)
+    for bit in range(decoder.FRAME_HDR_SIZE * 8):
+        bad = list(frames)
+        bad[VICTIM] = flip(frames[VICTIM], bit)
+        check_victim_lost(b''.join(bad), samples, frames, compressed)
+
+
+@pytest.mark.parametrize('compressed', (False, True))
+def test_body_bit_flips_are_rejected(compressed):
+    samples, frames = frames_of(compressed)
+    body_bits = used_bits(frames[VICTIM])[decoder.FRAME_HDR_SIZE * 8:]
+    for bit in list(body_bits[::13]) + [body_bits[-1]]:
+        bad = list(frames)
+        bad[VICTIM] = flip(frames[VICTIM], bit)
+        check_victim_lost(b''.join(bad), samples, frames, compressed)
+
+
+@pytest.mark.parametrize('compressed', (True,))   # 41 raw samples fill a block exactly
+def test_padding_bit_flip_is_harmless(compressed):
+    """The padding up to the block size is outside the CRC and must not cost the frame."""
+    samples, frames = frames_of(compressed)
+    assert len(used_bits(frames[VICTIM])) < BLOCK_SIZE * 8
+    bad = list(frames)
+    bad[VICTIM] = flip(frames[VICTIM], BLOCK_SIZE * 8 - 1)
+    data, lost, idx = decoder.decode_frames(b''.join(bad), BLOCK_SIZE, compressed)
+    assert lost == 0 and len(idx) == len(frames)
+    np.testing.assert_array_equal(data, samples)
+
+
+@pytest.mark.parametrize('compressed', (False, True))
+@pytest.mark.parametrize('keep', (0, 3, 8, decoder.FRAME_HDR_SIZE, decoder.FRAME_HDR_SIZE + 5, 200,
+                                  BLOCK_SIZE - 1))
+def test_truncated_frame_resyncs(compressed, keep):
+    """A block cut to `keep` bytes: the following blocks are shifted off the block grid."""
+    samples, frames = frames_of(compressed)
+    length = decoder.FRAME_HDR_SIZE + int.from_bytes(frames[VICTIM][18:20], 'little')
+    bad = list(frames)
+    bad[VICTIM] = frames[VICTIM][:keep]
+    payload = b''.join(bad)
+    if keep >= length:
+        # Only padding was cut: the frame is whole and the next one is found off the block grid
+        data, lost, idx = decoder.decode_frames(payload, BLOCK_SIZE, compressed)
+        assert lost == 0 and len(idx) == len(frames)
+        np.testing.assert_array_equal(data, samples)
+        return
+    check_victim_lost(payload, samples, frames, compressed)
+    # The next frame is found at its shifted offset
+    idx = decoder.frame_index(payload, BLOCK_SIZE)
+    nxt = idx[idx['first_sample'] == first_of(frames, VICTIM + 1)]
+    assert len(nxt) == 1 and nxt['offset'][0] == VICTIM * BLOCK_SIZE + keep
+
+
+@pytest.mark.parametrize('compressed', (False, True))
+def test_truncated_last_frame(compressed):
+    """The file ends inside the last frame (power cut mid-write): everything before it survives."""
+    samples, frames = frames_of(compressed)
+    last_first = first_of(frames, len(frames) - 1)
+    payload = b''.join(frames)[:-3]
+    data, lost, idx = decoder.decode_frames(payload, BLOCK_SIZE, compressed)
+    assert len(idx) == len(frames) - 1 and lost == 0
+    np.testing.assert_array_equal(data, samples[:last_first])
+
+
+@pytest.mark.parametrize('compressed', (False, True))
+def test_bin_to_csv_counts_lost_samples(tmp_path, compressed):
+    """Through the file API: a flipped and a truncated frame are counted as lost, the rest is converted."""
+    samples, frames = frames_of(compressed)
+    bad = list(frames)
+    bad[1] = flip(frames[1], 100)
+    bad[VICTIM] = frames[VICTIM][:50]
+    if compressed:
+        bad[5] = frames[5][:-10]   # padding only: nothing lost
+    lost = count_of(frames, 1) + count_of(frames, VICTIM)
+    fmt = 0x0303 if compressed else 0x0302
+    log = write_log(tmp_path / 'bad.bin', make_header(fmt, block_size=BLOCK_SIZE), b''.join(bad))
+    header, df = decoder.bin_to_csv(log, None)
+    assert header['lost_samples'] == lost
+    assert header['frames'] == len(frames) - 2
+    assert len(df) == N_SAMPLES
+    if acclog_native.available():
+        ref_csv, out_csv = tmp_path / 'ref.csv', tmp_path / 'native.csv'
+        decoder.bin_to_csv(log, ref_csv)
+        decoder.bin_to_csv_stream(log, out_csv, native=True)
+        assert out_csv.read_bytes() == ref_csv.read_bytes()
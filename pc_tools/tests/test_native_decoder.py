@@ -0,0 +1,86 @@
+"""The native decoder (pc_tools/native) must write the same CSV bytes as bin_to_csv().
+
+Skipped unless libacclog_decode is built (ACCLOG_NATIVE_LIB, or pc_tools/native/build);
+ctest of host/ runs this with the library it just built.
+"""
+from pathlib import Path
+import sys
+
+import numpy as np
+import pytest
+
+sys.path.insert(0, str(Path(__file__).resolve().parents[1]))
+import acclog_native  # noqa: E402
+import decoder  # noqa: E402
+from test_decoder_stream import (COMMON_KEYS, KINDS, build_log, encode_raw, make_frames, make_header,  # noqa: E402
+                                 make_samples, write_log)
+
+pytestmark = pytest.mark.skipif(not acclog_native.available(), reason='native decoder library not built')
+
+
+def convert_both(tmp_path, log, chunk=decoder.STREAM_CHUNK_SAMPLES):
+    ref_csv = tmp_path / 'ref.csv'
+    out_csv = tmp_path / 'native.csv'
+    ref_header, ref_df = decoder.bin_to_csv(log, ref_csv)
+    header = decoder.bin_to_csv_stream(log, out_csv, chunk=chunk, native=True)
+    return ref_header, ref_df, header, ref_csv.read_bytes(), out_csv.read_bytes()
+
+
+@pytest.mark.parametrize('kind', KINDS)
+@pytest.mark.parametrize('chunk', (7, 100, decoder.STREAM_CHUNK_SAMPLES))
+def test_native_matches_bin_to_csv(tmp_path, kind, chunk):
+    ref_header, ref_df, header, ref, out = convert_both(tmp_path, build_log(tmp_path, kind), chunk)
+    assert out == ref
+    assert header['samples'] == len(ref_df)
+    for key in COMMON_KEYS:
+        assert header.get(key) == ref_header.get(key), key
+
+
+def all_values() -> np.ndarray:
+    """Every int16 value on every channel (shuffled differently per channel)."""
+    rng = np.random.default_rng(7)
+    v = np.arange(-32768, 32768, dtype=np.int16)
+    return np.stack([rng.permutation(v) for _ in range(6)], axis=1)
+
+
+# (header fields): number formats of acc (float64) and gyro (float32) over every raw value
+@pytest.mark.parametrize('fields', (
+    dict(fmt=0x0202, lsb_per_g=4096.0, lsb_per_dps=16.4),
+    dict(fmt=0x0202, lsb_per_g=16384.0, lsb_per_dps=131.0),      # values below 1e-4: scientific
+    dict(fmt=0x0202, lsb_per_g=3.3, lsb_per_dps=0.01),           # gyro above 1e6 (float32 cut-off)
+    dict(fmt=0x0201, imu_type=1, lsb_per_g=0.0, range_g=16),     # SH200Q dps, acc from range_g
+    dict(fmt=0x0200, range_g=2, odr=1000),
+    dict(fmt=0x0202, odr=0),                                     # t_sec inf / nan
+    dict(fmt=0x0202, odr=3),                                     # t_sec with long fractions
+    dict(fmt=0x0202, odr=32768),                                 # 15 fraction digits
+    dict(fmt=0x0202, odr=60000),                                 # some fractions end, some do not
+))
+def test_native_number_format(tmp_path, fields):
+    fields = dict(fields)
+    fmt = fields.pop('fmt')
+    log = write_log(tmp_path / 'all.bin', make_header(fmt, **fields), encode_raw(all_values()))
+    with np.errstate(divide='ignore', invalid='ignore'):
+        _h, _df, _header, ref, out = convert_both(tmp_path, log)
+    assert out == ref
+
+
+@pytest.mark.parametrize('odr', (200, 256, 1000, 7))
+def test_native_large_sample_numbers(tmp_path, odr):
+    """Trigger segments late in a long session: t_sec with 10 integer digits."""
+    frames = make_frames(make_samples(500), False, odr, first0=4_294_000_000)
+    log = write_log(tmp_path / 'late.bin', make_header(0x0306, odr=odr, block_size=512), b''.join(frames))
+    _h, _df, _header, ref, out = convert_both(tmp_path, log)
+    assert out == ref
+
+
+def test_native_falls_back(tmp_path):
+    """Summary logs and headerless files still go through bin_to_csv()."""
+    rec = np.zeros(3, dtype=decoder.SUMMARY_DTYPE)
+    rec['count'] = 10
+    log = write_log(tmp_path / 'sum.bin', make_header(0x0400), rec.tobytes())
+    _h, _df, _header, ref, out = convert_both(tmp_path, log)
+    assert out == ref
+    log = tmp_path / 'noheader.bin'
+    log.write_bytes(encode_raw(all_values()[:100]))
+    _h, _df, _header, ref, out = convert_both(tmp_path, log)
+    assert out == ref